@@ -21,6 +21,7 @@ function(add_hdl_source hdl_file)
     SYNTHESIS
     LINT
     VERILATE
+    SAVABLE
   )
 
   set(multi_value_arguments
@@ -29,6 +30,7 @@ function(add_hdl_source hdl_file)
     DEPENDS
     INCLUDES
     LIBRARIES
+    PARAMETERS
   )
 
   # Resolve keywords into ARG_#
@@ -52,11 +54,13 @@ function(add_hdl_source hdl_file)
   init_arg(ARG_SYNTHESIS TRUE)
   init_arg(ARG_LINT TRUE)
   init_arg(ARG_VERILATE FALSE)
+  init_arg(ARG_SAVABLE FALSE)
   init_arg(ARG_SOURCES ${hdl_file})
   init_arg(ARG_DEFINES "")
   init_arg(ARG_DEPENDS "")
   init_arg(ARG_INCLUDES "${CMAKE_CURRENT_LIST_DIR}")
   init_arg(ARG_LIBRARIES "")
+  init_arg(ARG_PARAMETERS "")
 
   set_realpath(ARG_SOURCES)
   set_realpath(ARG_INCLUDES)
@@ -14,6 +14,7 @@ if (NOT VERILATOR_ENV_SETUP)
   add_library(verilated SHARED
     ${VERILATOR_INCLUDES}/verilated.cpp
     ${VERILATOR_INCLUDES}/verilated_vcd_c.cpp
+    ${VERILATOR_INCLUDES}/verilated_save.cpp
   )
 
   target_include_directories(verilated SYSTEM PUBLIC
@@ -90,6 +91,17 @@ function(verilate_hdl)
   set(working_dir "${VERILATOR_OUTPUT_DIR}/${ARG_NAME}")
   file(MAKE_DIRECTORY ${working_dir})
 
+  # Model state can be saved and restored (VerilatedSave/VerilatedRestore)
+  set(flags)
+  if (ARG_SAVABLE)
+    list(APPEND flags --savable)
+  endif()
+
+  # Top-level parameter overrides (NAME=VALUE)
+  foreach (param ${ARG_PARAMETERS})
+    list(APPEND flags "-G${param}")
+  endforeach()
+
   # Verilate HDL and compile it
   add_custom_command(
     OUTPUT
@@ -98,6 +110,7 @@ function(verilate_hdl)
       ${VERILATOR_BIN}
     ARGS
       -O3 -Wall -cc --trace -Mdir .
+      ${flags}
       --prefix ${ARG_NAME}
       --top-module ${ARG_NAME}
       ${includes}
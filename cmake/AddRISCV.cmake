@@ -15,6 +15,13 @@ if (NOT TESTDATA_ENV_SETUP)
     add_custom_target(testdata-all)
   endif()
 
+  # Default ISA for the riscv programs. Kronos can be configured with
+  # the Zba/Zbb/Zbs extensions, ex: -DRISCV_ARCH=rv32i_zba_zbb_zbs
+  set(RISCV_ARCH "rv32i" CACHE STRING "RISC-V ISA string for -march")
+
+  # Compress the KRZ applications with LZ4, decompressed by the bootloader
+  option(KRZ_PROG_LZ4 "Compress KRZ application images with LZ4" OFF)
+
   set(TESTDATA_ENV_SETUP 1)
 endif()
 
@@ -25,6 +32,7 @@ function(add_riscv_executable source)
   set(one_value_arguments
     LINKER_SCRIPT
     KRZ_APP
+    ARCH
   )
 
   set(multi_value_arguments
@@ -55,6 +63,7 @@ function(add_riscv_executable source)
   init_arg(ARG_DEFINES "")
   init_arg(ARG_LINKER_SCRIPT "${CMAKE_CURRENT_LIST_DIR}/link.ld")
   init_arg(ARG_KRZ_APP FALSE)
+  init_arg(ARG_ARCH ${RISCV_ARCH})
 
   set_realpath(ARG_SOURCES)
   set_realpath(ARG_INCLUDES)
@@ -87,7 +96,7 @@ function(add_riscv_executable source)
       ${RISCV_GCC}
     ARGS
       -O2
-      -march=rv32i
+      -march=${ARG_ARCH}
       -mabi=ilp32
       -static
       -nostartfiles
@@ -96,6 +105,7 @@ function(add_riscv_executable source)
       ${defines}
       ${includes}
       -T${ARG_LINKER_SCRIPT}
+      -Wl,--print-memory-usage
       ${ARG_SOURCES} ${source}
       -o ${elf}
     COMMAND
@@ -128,6 +138,11 @@ function(add_riscv_executable source)
 
     set(outputs)
 
+    set(krzprog_args)
+    if (KRZ_PROG_LZ4)
+      set(krzprog_args --lz4)
+    endif()
+
     add_custom_command(
       OUTPUT
         ${appfile}
@@ -136,6 +151,7 @@ function(add_riscv_executable source)
       ARGS
         ${UTILS}/krzprog.py
         --bin ${TESTDATA_OUTPUT_DIR}/${binary}
+        ${krzprog_args}
       COMMAND
         ${Python3_EXECUTABLE}
       ARGS
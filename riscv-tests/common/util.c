@@ -14,6 +14,7 @@
 #define KRZ_GPREG           0x800000
 #define KRZ_UART            0x800100
 #define KRZ_SPIM            0x800200
+#define KRZ_MBOX            0x800500
 
 #define KRZ_SCRATCH         MMPTR32(KRZ_GPREG | (0<<2))
 #define KRZ_BOOTVEC         MMPTR32(KRZ_GPREG | (1<<2))
@@ -25,8 +26,21 @@
 #define KRZ_SPIM_CTRL       MMPTR32(KRZ_GPREG | (7<<2))
 #define KRZ_SPIM_STATUS     MMPTR32(KRZ_GPREG | (8<<2))
 
-// 24MHz system clock - internal oscillator
+// Crossbar statistics: conflicts, instr/data grants, bootrom/mem0/mem1/sys busy,
+// dma grants
+#define KRZ_XBAR_STATS(n)   MMPTR32(KRZ_GPREG | ((9+(n))<<2))
+#define NUM_XBAR_STATS      8
+
+// Mailbox: semaphores, a message per core, messages pending and core run
+#define KRZ_MBOX_SEM(n)     MMPTR32(KRZ_MBOX | ((n)<<2))
+#define KRZ_MBOX_MSG(n)     MMPTR32(KRZ_MBOX | ((8+(n))<<2))
+#define KRZ_MBOX_STATUS     MMPTR32(KRZ_MBOX | (0x10<<2))
+#define KRZ_MBOX_RUN        MMPTR32(KRZ_MBOX | (0x11<<2))
+
+// 24MHz system clock - internal oscillator, unless the build says otherwise
+#ifndef F_CPU
 #define F_CPU               24000000
+#endif
 
 // UART TX Queue
 #define UART_TXQ_SIZE       128
@@ -37,11 +51,52 @@ static uint8_t uart_buffer[UART_BUFFER_SIZE];
 
 // ------------------------------------------------------------
 
-#define NUM_COUNTERS 2
+// mhpmcounter3 onwards, as per the core configuration
+#ifndef NUM_HPMCOUNTERS
+#define NUM_HPMCOUNTERS 0
+#endif
+
+// Only the first 10 are profiled, one for each event
+#if NUM_HPMCOUNTERS > 10
+#define NUM_HPM 10
+#else
+#define NUM_HPM NUM_HPMCOUNTERS
+#endif
+
+#define NUM_COUNTERS (2 + NUM_HPM)
 
 static int counters[NUM_COUNTERS];
 static char* counter_names[NUM_COUNTERS];
 
+static int xbar_counters[NUM_XBAR_STATS];
+
+// Events profiled by mhpmcounter3 onwards, in the order of their
+// contribution to the CPI
+static const char* hpm_names[10] = {
+  "fetch miss",
+  "fetch stall",
+  "hazard stall",
+  "lsu wait",
+  "branches",
+  "jumps",
+  "loads",
+  "stores",
+  "csr",
+  "traps"
+};
+
+// Crossbar statistics, in the order of the KRZ_XBAR registers
+static const char* xbar_names[NUM_XBAR_STATS] = {
+  "xbar conflicts",
+  "xbar instr grants",
+  "xbar data grants",
+  "xbar bootrom busy",
+  "xbar mem0 busy",
+  "xbar mem1 busy",
+  "xbar sys busy",
+  "xbar dma grants"
+};
+
 // ------------------------------------------------------------
 
 void delay_us(int count_us) {
@@ -51,8 +106,89 @@ void delay_us(int count_us) {
     while(read_csr(mcycle) - start < delay);
 }
 
+// ------------------------------------------------------------
+// Multi-core
+
+void start_core(int cid) {
+  // The core boots through crt0 into thread_entry
+  KRZ_MBOX_RUN |= 1 << cid;
+}
+
+void sem_acquire(int n) {
+  // Test-and-set, 0 when acquired
+  while (KRZ_MBOX_SEM(n));
+}
+
+void sem_release(int n) {
+  KRZ_MBOX_SEM(n) = 0;
+}
+
+void mbox_post(int cid, uint32_t msg) {
+  // Overwrites a message that's still pending
+  KRZ_MBOX_MSG(cid) = msg;
+}
+
+uint32_t mbox_wait(void) {
+  int cid = read_csr(mhartid);
+  while (!(KRZ_MBOX_STATUS & (1 << cid)));
+  return KRZ_MBOX_MSG(cid);
+}
+
+uint32_t mbox_sleep(void) {
+  int cid = read_csr(mhartid);
+
+  // Kronos only wakes from wfi on an interrupt that is taken. The message
+  // raises the software interrupt, and the trap handler returns past the
+  // wfi, with the interrupts disabled again
+  write_csr(mie, MIE_MSIE);
+  while (!(KRZ_MBOX_STATUS & (1 << cid))) {
+    asm volatile ("csrs mstatus, %0 \n wfi" :: "r"(MSTATUS_MIE));
+  }
+  return KRZ_MBOX_MSG(cid);
+}
+
+// Entry of the other cores, for the multi-core programs
+void __attribute__((weak)) thread_entry(int cid) {
+}
+
+static void setEvents(void) {
+  #if NUM_HPM > 0
+    write_csr(mhpmevent3, HPM_FETCH_MISS);
+  #endif
+  #if NUM_HPM > 1
+    write_csr(mhpmevent4, HPM_FETCH_STALL);
+  #endif
+  #if NUM_HPM > 2
+    write_csr(mhpmevent5, HPM_HAZARD_STALL);
+  #endif
+  #if NUM_HPM > 3
+    write_csr(mhpmevent6, HPM_LSU_WAIT);
+  #endif
+  #if NUM_HPM > 4
+    write_csr(mhpmevent7, HPM_BRANCH);
+  #endif
+  #if NUM_HPM > 5
+    write_csr(mhpmevent8, HPM_JUMP);
+  #endif
+  #if NUM_HPM > 6
+    write_csr(mhpmevent9, HPM_LOAD);
+  #endif
+  #if NUM_HPM > 7
+    write_csr(mhpmevent10, HPM_STORE);
+  #endif
+  #if NUM_HPM > 8
+    write_csr(mhpmevent11, HPM_CSR);
+  #endif
+  #if NUM_HPM > 9
+    write_csr(mhpmevent12, HPM_TRAP);
+  #endif
+}
+
 void setStats(int enable) {
   int i = 0;
+
+  if (enable) setEvents();
+
   #define READ_CTR(name) do { \
       while (i >= NUM_COUNTERS) ; \
       int csr = read_csr(name); \
@@ -63,7 +199,44 @@ void setStats(int enable) {
     READ_CTR(mcycle);
     READ_CTR(minstret);
 
+  #if NUM_HPM > 0
+    READ_CTR(mhpmcounter3);
+  #endif
+  #if NUM_HPM > 1
+    READ_CTR(mhpmcounter4);
+  #endif
+  #if NUM_HPM > 2
+    READ_CTR(mhpmcounter5);
+  #endif
+  #if NUM_HPM > 3
+    READ_CTR(mhpmcounter6);
+  #endif
+  #if NUM_HPM > 4
+    READ_CTR(mhpmcounter7);
+  #endif
+  #if NUM_HPM > 5
+    READ_CTR(mhpmcounter8);
+  #endif
+  #if NUM_HPM > 6
+    READ_CTR(mhpmcounter9);
+  #endif
+  #if NUM_HPM > 7
+    READ_CTR(mhpmcounter10);
+  #endif
+  #if NUM_HPM > 8
+    READ_CTR(mhpmcounter11);
+  #endif
+  #if NUM_HPM > 9
+    READ_CTR(mhpmcounter12);
+  #endif
+
   #undef READ_CTR
+
+  for (int j=0; j<NUM_XBAR_STATS; j++) {
+    int ctr = KRZ_XBAR_STATS(j);
+    if (!enable) ctr -= xbar_counters[j];
+    xbar_counters[j] = ctr;
+  }
 }
 
 void printStats(void) {
@@ -72,9 +245,30 @@ void printStats(void) {
 
   int cpi = (cycles * 100) /  instret;
 
+  // Throughput at the system clock, to weigh CPI against fmax
+  int mips = (F_CPU / 10000) / cpi;
+
   printk("cycles: %u\n", cycles);
   printk("instret: %u\n", instret);
   printk("CPI (x100): %u\n", cpi);
+  printk("MIPS @ %uMHz: %u\n", F_CPU / 1000000, mips);
+
+  // Event counts, and their share of the cycles
+  for (int i=0; i<NUM_HPM; i++) {
+    printk("%s: %u (%u%%)\n", hpm_names[i], counters[2+i], (counters[2+i] * 100) / cycles);
+  }
+
+  printXbarStats();
+}
+
+void printXbarStats(void) {
+  int cycles = counters[0];
+
+  // Conflicts and busy cycles as a share of the cycles, grants as is
+  for (int i=0; i<NUM_XBAR_STATS; i++) {
+    if (i == 1 || i == 2 || i == 7) printk("%s: %u\n", xbar_names[i], xbar_counters[i]);
+    else printk("%s: %u (%u%%)\n", xbar_names[i], xbar_counters[i], (xbar_counters[i] * 100) / cycles);
+  }
 }
 
 int verify(int n, const volatile int* test, const int* verify) {
@@ -176,6 +370,13 @@ void printk(const char *fmt, ...) {
 }
 
 void  trap_handler (int mcause, int mtval, int mepc) {
+  // Software interrupt of a message, in mbox_sleep
+  if (mcause == (int)(MCAUSE_INTERRUPT | MCAUSE_SOFTWARE)) {
+    write_csr(mepc, mepc + 4);
+    asm volatile ("csrc mstatus, %0" :: "r"(MSTATUS_MPIE));
+    return;
+  }
+
   printk("\n\n-= TRAP =-\n");
   printk("mcause = %x\n", mcause);
   printk("mtval = %x\n", mcause);
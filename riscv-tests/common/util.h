@@ -12,13 +12,45 @@
   asm volatile ("csrr %0, " #reg : "=r"(__tmp)); \
   __tmp; })
 
+#define write_csr(reg, val) ({ \
+  asm volatile ("csrw " #reg ", %0" :: "rK"(val)); })
+
+// Kronos hardware performance monitor events, for mhpmevent
+#define HPM_FETCH_MISS      1
+#define HPM_FETCH_STALL     2
+#define HPM_HAZARD_STALL    3
+#define HPM_BRANCH          4
+#define HPM_JUMP            5
+#define HPM_LOAD            6
+#define HPM_STORE           7
+#define HPM_LSU_WAIT        8
+#define HPM_CSR             9
+#define HPM_TRAP            10
+
 #define debug_printf printk
 
 void setStats(int enable);
 void printStats(void) ;
+void printXbarStats(void);
 int verify(int n, const volatile int* test, const int* verify);
 int verifyDouble(int n, const volatile double* test, const double* verify);
 void printk(const char *fmt, ...);
 void delay_us(int count_us);
 
+// Interrupts
+#define MSTATUS_MIE         (1<<3)
+#define MSTATUS_MPIE        (1<<7)
+#define MIE_MSIE            (1<<3)
+#define MCAUSE_INTERRUPT    (1u<<31)
+#define MCAUSE_SOFTWARE     3
+
+// Multi-core KRZ
+void start_core(int cid);
+void sem_acquire(int n);
+void sem_release(int n);
+void mbox_post(int cid, uint32_t msg);
+uint32_t mbox_wait(void);
+uint32_t mbox_sleep(void);
+void thread_entry(int cid);
+
 #endif //__UTIL_H
@@ -0,0 +1,99 @@
+// See LICENSE for license details.
+
+//**************************************************************************
+// Multi-core vector-vector add benchmark
+//--------------------------------------------------------------------------
+//
+// The vvadd benchmark, split across the cores of a multi-core KRZ
+// (CORES=2). core0 releases core1, and hands it the second half of the
+// vectors through the mailbox. core1 sleeps in wfi between the messages, so
+// that it doesn't contend with core0 for the crossbar. The vvadd is run on
+// one core, and then on both, to show the scaling. The input data (and reference data) is the
+// vvadd dataset.
+
+#include "util.h"
+
+//--------------------------------------------------------------------------
+// Input/Reference Data
+
+#include "dataset1-large.h"
+
+#define NUM_CORES 2
+
+// Mailbox messages
+#define MSG_READY 1
+#define MSG_START 2
+#define MSG_DONE  3
+
+static int results_data[DATA_SIZE];
+
+//--------------------------------------------------------------------------
+// vvadd function, over the share of the core
+
+void vvadd( int cid, int nc, int a[], int b[], int c[] )
+{
+  int i;
+  int start = cid * DATA_SIZE / nc;
+  int end = (cid + 1) * DATA_SIZE / nc;
+
+  for ( i = start; i < end; i++ )
+    c[i] = a[i] + b[i];
+}
+
+//--------------------------------------------------------------------------
+// Other cores
+
+void thread_entry( int cid )
+{
+  mbox_post(0, MSG_READY);
+
+  while (1) {
+    if (mbox_sleep() != MSG_START) continue;
+    vvadd( cid, NUM_CORES, input1_data, input2_data, results_data );
+    mbox_post(0, MSG_DONE);
+  }
+}
+
+//--------------------------------------------------------------------------
+// Main
+
+int main( int argc, char* argv[] )
+{
+  int i, cycles_1, cycles_n;
+
+  // Release the other cores, and wait until they are ready
+  for ( i = 1; i < NUM_CORES; i++ ) {
+    start_core(i);
+    while (mbox_wait() != MSG_READY);
+  }
+
+  // On core0 alone
+  cycles_1 = read_csr(mcycle);
+  vvadd( 0, 1, input1_data, input2_data, results_data );
+  cycles_1 = read_csr(mcycle) - cycles_1;
+
+  for ( i = 0; i < DATA_SIZE; i++ )
+    results_data[i] = 0;
+
+  // On all the cores
+  setStats(1);
+  cycles_n = read_csr(mcycle);
+
+  for ( i = 1; i < NUM_CORES; i++ )
+    mbox_post(i, MSG_START);
+
+  vvadd( 0, NUM_CORES, input1_data, input2_data, results_data );
+
+  for ( i = 1; i < NUM_CORES; i++ )
+    while (mbox_wait() != MSG_DONE);
+
+  cycles_n = read_csr(mcycle) - cycles_n;
+  setStats(0);
+
+  printk("1 core: %u cycles\n", cycles_1);
+  printk("%u cores: %u cycles\n", NUM_CORES, cycles_n);
+  printk("speedup (x100): %u\n", (cycles_1 * 100) / cycles_n);
+
+  // Check the results
+  return verify( DATA_SIZE, results_data, verify_data );
+}
@@ -3,6 +3,29 @@
 
 /*
 Kronos Execution Unit
+
+DUAL_ISSUE
+  - The second instruction of an issued pair (`decode1`) is a base ALU
+    instruction, and is executed by a second ALU. It retires with the first,
+    and is written back on the second register write port.
+  - If the first instruction jumps, or traps, then the second is dropped.
+
+DEEP_PIPELINE
+  - The branch redirect to the IF stage (and the pipeline flush) is registered.
+    The instruction that was decoded behind the jump is squashed in the cycle
+    of the redirect. Jumps take a cycle longer.
+
+EN_RVFI
+  - Reports every retired instruction on the `rvfi` trace (`rvfi1` for the
+    second instruction of a dual-issued pair), in the cycle of its write back.
+  - Instructions that trap (exception, ecall, ebreak), return (mret) or wait
+    (wfi) retire on the trap jump. Exceptions, including ecall and ebreak, are
+    flagged with `trap`.
+  - A fused pair retires as two entries, the first instruction on `rvfi` and
+    the second on `rvfi1`. The result of the first instruction, which isn't
+    written back, is reconstructed for the trace.
+  - The memory fields are word aligned, as presented on the data interface.
+    A split misaligned access is reported by its first word.
 */
 
 module kronos_EX
@@ -10,7 +33,15 @@ module kronos_EX
 #(
   parameter logic [31:0]  BOOT_ADDR = 32'h0,
   parameter EN_COUNTERS = 1,
-  parameter EN_COUNTERS64B = 1
+  parameter EN_COUNTERS64B = 1,
+  parameter EN_MISALIGNED_LDST = 0,
+  parameter EN_ZBB = 0,
+  parameter EN_ZBS = 0,
+  parameter DUAL_ISSUE = 0,
+  parameter DEEP_PIPELINE = 0,
+  parameter NUM_HPMCOUNTERS = 0,
+  parameter HART_ID = 0,
+  parameter EN_RVFI = 0
 )(
   input  logic        clk,
   input  logic        rstz,
@@ -36,7 +67,20 @@ module kronos_EX
   // Interrupt sources
   input  logic        software_interrupt,
   input  logic        timer_interrupt,
-  input  logic        external_interrupt
+  input  logic        external_interrupt,
+  // Performance events from the IF/ID stages
+  input  logic        hpm_fetch_miss,
+  input  logic        hpm_fetch_stall,
+  input  logic        hpm_hazard_stall,
+  // Second instruction
+  input  pipeIDEX_t   decode1,
+  input  logic        decode1_vld,
+  output logic [31:0] regwr1_data,
+  output logic [4:0]  regwr1_sel,
+  output logic        regwr1_en,
+  // Retirement trace
+  output rvfi_t       rvfi,
+  output rvfi_t       rvfi1
 );
 
 logic [31:0] result;
@@ -45,6 +89,9 @@ logic [4:0] rd;
 logic instr_vld;
 logic instr_jump;
 logic basic_rdy;
+logic squash;
+logic [31:0] jump_target;
+logic jump;
 
 logic lsu_vld, lsu_rdy;
 logic [31:0] load_data;
@@ -53,16 +100,20 @@ logic regwr_lsu;
 logic csr_vld,csr_rdy;
 logic [31:0] csr_data;
 logic regwr_csr;
-logic instret;
+logic [1:0] instret;
+logic [15:0] hpm_event;
 logic core_interrupt;
 logic [3:0] core_interrupt_cause;
 
 logic exception;
 
+logic retire1;
+
 logic activate_trap, return_trap;
 logic [31:0] trap_cause, trap_handle, trap_value;
 logic trap_jump;
 
+// Public for the simulation harness, which detects the core in WFINTR
 enum logic [2:0] {
   STEADY,
   LSU,
@@ -71,7 +122,7 @@ enum logic [2:0] {
   RETURN,
   WFINTR,
   JUMP
-} state, next_state;
+} state /*verilator public_flat*/, next_state;
 
 
 // ============================================================
@@ -89,7 +140,7 @@ always_comb begin
   next_state = state;
   /* verilator lint_off CASEINCOMPLETE */
   unique case (state)
-    STEADY: if (decode_vld) begin
+    STEADY: if (decode_vld && ~squash) begin
       if (core_interrupt) next_state = TRAP;
       else if (exception) next_state = TRAP;
       else if (decode.system) begin
@@ -121,7 +172,7 @@ always_comb begin
 end
 
 // Decoded instruction valid
-assign instr_vld = decode_vld && state == STEADY && ~exception && ~core_interrupt;
+assign instr_vld = decode_vld && ~squash && state == STEADY && ~exception && ~core_interrupt;
 
 // Basic instructions
 assign basic_rdy = instr_vld && decode.basic;
@@ -131,18 +182,68 @@ assign decode_rdy = |{basic_rdy, lsu_rdy, csr_rdy};
 
 // ============================================================
 // ALU
-kronos_alu u_alu (
+kronos_alu #(
+  .EN_ZBB(EN_ZBB),
+  .EN_ZBS(EN_ZBS)
+) u_alu (
   .op1   (decode.op1  ),
   .op2   (decode.op2  ),
   .aluop (decode.aluop),
   .result(result      )
 );
 
+// ============================================================
+// Second ALU
+generate
+  if (DUAL_ISSUE) begin
+    logic [31:0] result1;
+
+    kronos_alu u_alu1 (
+      .op1   (decode1.op1  ),
+      .op2   (decode1.op2  ),
+      .aluop (decode1.aluop),
+      .result(result1      )
+    );
+
+    // The second instruction retires along with the first, unless it is
+    // skipped by a jump
+    assign retire1 = decode_vld && decode_rdy && decode1_vld && ~instr_jump;
+
+    always_ff @(posedge clk or negedge rstz) begin
+      if (~rstz) begin
+        regwr1_en <= 1'b0;
+      end
+      else begin
+        regwr1_sel <= decode1.ir[11:7];
+        regwr1_data <= result1;
+        regwr1_en <= retire1 && decode1.regwr_alu;
+      end
+    end
+  end
+  else begin
+    assign retire1 = 1'b0;
+    assign regwr1_data = '0;
+    assign regwr1_sel = '0;
+    assign regwr1_en = 1'b0;
+
+    `ifdef verilator
+    logic _unused = &{1'b0
+      , decode1
+      , decode1_vld
+    };
+    `endif
+  end
+endgenerate
+
 // ============================================================
 // LSU
 assign lsu_vld = instr_vld || state == LSU;
 
-kronos_lsu u_lsu (
+kronos_lsu #(
+  .EN_MISALIGNED_LDST(EN_MISALIGNED_LDST)
+) u_lsu (
+  .clk         (clk         ),
+  .rstz        (rstz        ),
   .decode      (decode      ),
   .lsu_vld     (lsu_vld     ),
   .lsu_rdy     (lsu_rdy     ),
@@ -190,9 +291,31 @@ end
 
 // ============================================================
 // Jump and Branch
-assign branch_target = trap_jump ? trap_handle : decode.addr;
+assign jump_target = trap_jump ? trap_handle : decode.addr;
 assign instr_jump =  decode.jump || decode.branch;
-assign branch = (instr_vld && instr_jump) || trap_jump;
+assign jump = (instr_vld && instr_jump) || trap_jump;
+
+generate
+  if (DEEP_PIPELINE) begin
+    always_ff @(posedge clk or negedge rstz) begin
+      if (~rstz) begin
+        branch <= 1'b0;
+      end
+      else begin
+        branch <= jump;
+        branch_target <= jump_target;
+      end
+    end
+
+    // The instruction following the jump is in the EX stage, with the redirect
+    assign squash = branch;
+  end
+  else begin
+    assign branch = jump;
+    assign branch_target = jump_target;
+    assign squash = 1'b0;
+  end
+endgenerate
 
 // ============================================================
 // Trap Handling
@@ -201,7 +324,7 @@ assign exception = decode.illegal || decode.misaligned_ldst || (instr_jump && de
 
 // setup for trap
 always_ff @(posedge clk) begin
-  if (decode_vld && state == STEADY) begin
+  if (decode_vld && ~squash && state == STEADY) begin
     if (core_interrupt) begin
       trap_cause <= {1'b1, 27'b0, core_interrupt_cause};
       trap_value <= '0;
@@ -244,9 +367,11 @@ end
 assign csr_vld = instr_vld || state == CSR;
 
 kronos_csr #(
-  .BOOT_ADDR     (BOOT_ADDR     ),
-  .EN_COUNTERS   (EN_COUNTERS   ),
-  .EN_COUNTERS64B(EN_COUNTERS64B)
+  .BOOT_ADDR      (BOOT_ADDR      ),
+  .EN_COUNTERS    (EN_COUNTERS    ),
+  .EN_COUNTERS64B (EN_COUNTERS64B ),
+  .NUM_HPMCOUNTERS(NUM_HPMCOUNTERS),
+  .HART_ID        (HART_ID        )
 ) u_csr (
   .clk                 (clk                 ),
   .rstz                (rstz                ),
@@ -256,6 +381,7 @@ kronos_csr #(
   .csr_data            (csr_data            ),
   .regwr_csr           (regwr_csr           ),
   .instret             (instret             ),
+  .hpm_event           (hpm_event           ),
   .activate_trap       (activate_trap       ),
   .return_trap         (return_trap         ),
   .trap_cause          (trap_cause          ),
@@ -272,11 +398,168 @@ kronos_csr #(
 assign activate_trap = state == TRAP;
 assign return_trap = state == RETURN;
 
-// instruction retired event
+// Hardware performance monitor events
+always_comb begin
+  hpm_event = '0;
+  hpm_event[HPM_FETCH_MISS]   = hpm_fetch_miss;
+  hpm_event[HPM_FETCH_STALL]  = hpm_fetch_stall;
+  hpm_event[HPM_HAZARD_STALL] = hpm_hazard_stall;
+  hpm_event[HPM_BRANCH]       = instr_vld && decode.branch;
+  hpm_event[HPM_JUMP]         = instr_vld && decode.jump;
+  hpm_event[HPM_LOAD]         = lsu_rdy && decode.load;
+  hpm_event[HPM_STORE]        = lsu_rdy && decode.store;
+  hpm_event[HPM_LSU_WAIT]     = lsu_vld && (decode.load || decode.store) && ~lsu_rdy;
+  hpm_event[HPM_CSR]          = csr_rdy;
+  hpm_event[HPM_TRAP]         = activate_trap;
+end
+
+// instruction retired event, a fused or dual-issued pair retires two instructions
 always_ff @(posedge clk or negedge rstz) begin
-  if (~rstz) instret <= 1'b0;
-  else instret <= (decode_vld && decode_rdy)
-              || (decode.system && trap_jump);
+  if (~rstz) instret <= '0;
+  else if (decode_vld && decode_rdy) instret <= (decode.fused || retire1) ? 2'd2 : 2'd1;
+  else instret <= {1'b0, decode.system && trap_jump};
 end
 
+// ============================================================
+// Retirement Trace
+generate
+  if (EN_RVFI) begin
+    rvfi_t trace, trace1;
+    rvfi_t instr_trace, fuse_trace;
+    logic trace_fused;
+    logic [63:0] order;
+    logic retire, retire_trap;
+    logic trap_instr, trap_excp;
+    logic split_ack;
+    logic [31:0] split_rdata;
+    logic [3:0] size_mask;
+    logic [7:0] span_mask;
+
+    // The instruction held for a trap (or return) retires on the trap jump,
+    // unless the trap is an interrupt
+    always_ff @(posedge clk) begin
+      if (decode_vld && ~squash && state == STEADY) begin
+        trap_instr <= ~core_interrupt;
+        trap_excp <= (exception || (decode.system && (decode.sysop == ECALL || decode.sysop == EBREAK)))
+                    && ~core_interrupt;
+      end
+    end
+
+    // The first word of a split misaligned access, which is acked before
+    // the access is done
+    always_ff @(posedge clk or negedge rstz) begin
+      if (~rstz) split_ack <= 1'b0;
+      else if (data_ack) split_ack <= ~lsu_rdy;
+    end
+
+    always_ff @(posedge clk) begin
+      if (data_ack && ~lsu_rdy) split_rdata <= data_rd_data;
+    end
+
+    assign retire = decode_vld && decode_rdy;
+    assign retire_trap = trap_jump && trap_instr;
+
+    // The instruction in EX, which is the second of a fused pair
+    always_comb begin
+      instr_trace.valid = retire || retire_trap;
+      instr_trace.order = order + decode.fused;
+      instr_trace.insn = decode.ir;
+      instr_trace.trap = retire_trap && trap_excp;
+      instr_trace.pc_rdata = decode.pc + (decode.fused ? FOUR : ZERO);
+
+      if (retire_trap) instr_trace.pc_wdata = trap_handle;
+      else if (instr_vld && instr_jump) instr_trace.pc_wdata = decode.addr;
+      else instr_trace.pc_wdata = decode.pc + (decode.fused ? 32'h8 : FOUR);
+
+      // rd is picked up from the write back
+      instr_trace.rd_addr = '0;
+      instr_trace.rd_wdata = '0;
+
+      // Bytes of the access in the (first) word
+      if (decode.ir[13:12] == BYTE) size_mask = 4'h1;
+      else if (decode.ir[13:12] == HALF) size_mask = 4'h3;
+      else size_mask = 4'hF;
+      span_mask = {4'h0, size_mask} << decode.addr[1:0];
+
+      instr_trace.mem_addr = {decode.addr[31:2], 2'b0};
+      instr_trace.mem_rmask = (retire && decode.load) ? span_mask[3:0] : '0;
+      instr_trace.mem_wmask = (retire && decode.store) ? span_mask[3:0] : '0;
+      instr_trace.mem_rdata = split_ack ? split_rdata : data_rd_data;
+      instr_trace.mem_wdata = decode.op2;
+    end
+
+    // The first instruction of a fused pair (lui, auipc or slli), an ALU op
+    // that writes the same rd as the second
+    always_comb begin
+      fuse_trace = '0;
+      fuse_trace.valid = retire;
+      fuse_trace.order = order;
+      fuse_trace.insn = decode.fuse_ir;
+      fuse_trace.pc_rdata = decode.pc;
+      fuse_trace.pc_wdata = decode.pc + FOUR;
+      fuse_trace.rd_addr = decode.fuse_ir[11:7];
+
+      if (decode.fuse_ir[6:2] == INSTR_LUI) fuse_trace.rd_wdata = {decode.fuse_ir[31:12], 12'b0};
+      else if (decode.fuse_ir[6:2] == INSTR_AUIPC) fuse_trace.rd_wdata = decode.pc + {decode.fuse_ir[31:12], 12'b0};
+      else fuse_trace.rd_wdata = decode.op1 << decode.fuse_ir[24:20];
+    end
+
+    always_ff @(posedge clk or negedge rstz) begin
+      if (~rstz) begin
+        trace.valid <= 1'b0;
+        trace1.valid <= 1'b0;
+        trace_fused <= 1'b0;
+        order <= '0;
+      end
+      else begin
+        trace_fused <= decode.fused;
+
+        if (decode.fused) begin
+          trace <= fuse_trace;
+          trace1 <= instr_trace;
+        end
+        else begin
+          trace <= instr_trace;
+
+          // The second instruction is a base ALU op, without memory effects
+          trace1 <= '0;
+          trace1.valid <= retire1;
+          trace1.order <= order + 1'b1;
+          trace1.insn <= decode1.ir;
+          trace1.pc_rdata <= decode1.pc;
+          trace1.pc_wdata <= decode1.pc + FOUR;
+        end
+
+        if (retire || retire_trap) order <= order + ((decode.fused || retire1) ? 64'd2 : 64'd1);
+      end
+    end
+
+    always_comb begin
+      rvfi = trace;
+      rvfi1 = trace1;
+
+      // The write back of a fused pair belongs to the second instruction
+      if (regwr_en && regwr_sel != '0) begin
+        if (trace_fused) begin
+          rvfi1.rd_addr = regwr_sel;
+          rvfi1.rd_wdata = regwr_data;
+        end
+        else begin
+          rvfi.rd_addr = regwr_sel;
+          rvfi.rd_wdata = regwr_data;
+        end
+      end
+
+      if (regwr1_en && regwr1_sel != '0) begin
+        rvfi1.rd_addr = regwr1_sel;
+        rvfi1.rd_wdata = regwr1_data;
+      end
+    end
+  end
+  else begin
+    assign rvfi = '0;
+    assign rvfi1 = '0;
+  end
+endgenerate
+
 endmodule
@@ -9,6 +9,40 @@ Kronos RV32I Decoder
   - Generates store data and mask.
   - Detects misaligned jumps and memory access
   - Tracks hazards on register operands and stalls if necessary.
+
+Bit-Manipulation
+  - EN_ZBA: sh1add/sh2add/sh3add pre-shift OP1 and use the ALU adder.
+  - EN_ZBB: basic bit-manipulation, executed in the ALU.
+  - EN_ZBS: bset/bclr/binv place a one-hot mask in OP2 and use the ALU
+    OR/ANDN/XOR. bext is executed in the ALU.
+
+Macro-op Fusion (EN_FUSION)
+  - The instruction following the one being decoded is available as the
+    lookahead from the IF stage. Common adjacent pairs are fused and executed
+    as one operation in the EX stage, as the second instruction of the pair.
+    * lui rd, hi   + addi rd, rd, lo  -> rd = {hi,0} + lo
+    * auipc rd, hi + jalr rd, lo(rd)  -> rd = pc + 8, jump to pc + {hi,0} + lo
+    * auipc rd, hi + lw rd, lo(rd)    -> rd = mem[pc + {hi,0} + lo]
+    * slli rd, rs, k + srli rd, rd, k -> rd = rs & ('1 >> k)
+  - The pairs are only fused if they cannot trap, i.e. the fused jump target
+    and load address are aligned.
+
+Dual Issue (DUAL_ISSUE)
+  - The second instruction of the fetch block (`fetch1`) is issued alongside
+    the first, as `decode1`, when:
+    * it is a base ALU instruction (LUI, AUIPC, OP-IMM, OP),
+    * the first instruction is an ALU, branch or load/store instruction,
+    * it doesn't depend on, or write the same register as the first,
+    * and none of its operands have a pending write (HCU).
+  - Otherwise, only the first instruction is issued, and the second moves up
+    in the IF stage, to be decoded alone in the next cycle.
+  - Macro-op fusion is not available with dual issue.
+
+Deep Pipeline (DEEP_PIPELINE)
+  - The write back is not forwarded to the operands. Instead, the HCU stalls
+    until the register file has latched the write back. This takes the EX
+    result mux off the operand, AGU and branch comparator paths, at the
+    cost of a cycle for back-to-back dependent instructions.
 */
 
 module kronos_ID
@@ -16,7 +50,13 @@ module kronos_ID
 #(
   parameter CATCH_ILLEGAL_INSTR = 1,
   parameter CATCH_MISALIGNED_JMP = 1,
-  parameter CATCH_MISALIGNED_LDST = 1
+  parameter CATCH_MISALIGNED_LDST = 1,
+  parameter EN_ZBA = 0,
+  parameter EN_ZBB = 0,
+  parameter EN_ZBS = 0,
+  parameter EN_FUSION = 0,
+  parameter DUAL_ISSUE = 0,
+  parameter DEEP_PIPELINE = 0
 )(
   input  logic        clk,
   input  logic        rstz,
@@ -30,6 +70,10 @@ module kronos_ID
   input  logic        regrd_rs2_en,
   input  logic        fetch_vld,
   output logic        fetch_rdy,
+  // Lookahead
+  input  logic [31:0] lookahead,
+  input  logic        lookahead_vld,
+  output logic        fuse,
   // ID/EX
   output pipeIDEX_t   decode,
   output logic        decode_vld,
@@ -37,7 +81,23 @@ module kronos_ID
   // REG Write
   input  logic [31:0] regwr_data,
   input  logic [4:0]  regwr_sel,
-  input  logic        regwr_en
+  input  logic        regwr_en,
+  // Second instruction
+  input  pipeIFID_t   fetch1,
+  input  logic [31:0] immediate1,
+  input  logic [31:0] regrd1_rs1,
+  input  logic [31:0] regrd1_rs2,
+  input  logic        regrd1_rs1_en,
+  input  logic        regrd1_rs2_en,
+  input  logic        fetch1_vld,
+  output logic        fetch1_rdy,
+  output pipeIDEX_t   decode1,
+  output logic        decode1_vld,
+  input  logic [31:0] regwr1_data,
+  input  logic [4:0]  regwr1_sel,
+  input  logic        regwr1_en,
+  // Performance events
+  output logic        hpm_hazard_stall
 );
 
 logic [31:0] IR, PC;
@@ -49,7 +109,8 @@ logic [6:0] funct7;
 logic [1:0] data_size;
 
 logic [31:0] op1, op2;
-logic [3:0] aluop;
+logic [4:0] aluop;
+logic [31:0] bitsel;
 logic regwr_alu;
 logic branch;
 logic csr;
@@ -77,6 +138,19 @@ logic [31:0] rs1_data, rs2_data;
 // Stall Condition
 logic stall;
 
+// Fusion
+logic [31:0] IR_EX;
+logic [4:0] OP_EX;
+logic fuse_lui_addi, fuse_auipc_jalr, fuse_auipc_lw, fuse_slli_srli;
+logic [31:0] fuse_imm;
+
+// Dual Issue
+logic stall1;
+logic pair;
+logic [31:0] op1_1, op2_1;
+logic [4:0] aluop_1;
+logic regwr_alu_1;
+
 // ============================================================
 // Instruction Decoder
 
@@ -99,20 +173,94 @@ assign illegal_opcode = opcode[1:0] != 2'b11;
 // ============================================================
 // Register Write
 // Write the result of the ALU back into the Registers
-assign regwr_alu = (rd != '0) && (OP == INSTR_LUI
-                    || OP == INSTR_AUIPC
-                    || OP == INSTR_JAL
-                    || OP == INSTR_JALR
-                    || OP == INSTR_OPIMM 
-                    || OP == INSTR_OP);
+assign regwr_alu = (rd != '0) && (OP_EX == INSTR_LUI
+                    || OP_EX == INSTR_AUIPC
+                    || OP_EX == INSTR_JAL
+                    || OP_EX == INSTR_JALR
+                    || OP_EX == INSTR_OPIMM 
+                    || OP_EX == INSTR_OP);
 
 // ============================================================
 // Register Forwarding
-assign rs1_forward = regwr_en & (regwr_sel == rs1);
-assign rs2_forward = regwr_en & (regwr_sel == rs2);
+assign rs1_forward = ~DEEP_PIPELINE & regwr_en & (regwr_sel == rs1);
+assign rs2_forward = ~DEEP_PIPELINE & regwr_en & (regwr_sel == rs2);
+
+// The two write ports never write the same register in the same cycle
+always_comb begin
+  if (!DEEP_PIPELINE && DUAL_ISSUE && regwr1_en && regwr1_sel == rs1) rs1_data = regwr1_data;
+  else if (rs1_forward) rs1_data = regwr_data;
+  else rs1_data = regrd_rs1;
 
-assign rs1_data = rs1_forward ? regwr_data : regrd_rs1;
-assign rs2_data = rs2_forward ? regwr_data : regrd_rs2;
+  if (!DEEP_PIPELINE && DUAL_ISSUE && regwr1_en && regwr1_sel == rs2) rs2_data = regwr1_data;
+  else if (rs2_forward) rs2_data = regwr_data;
+  else rs2_data = regrd_rs2;
+end
+
+// ============================================================
+// Macro-op Fusion
+generate
+  if (EN_FUSION) begin
+    logic [4:0] la_OP, la_rd, la_rs1;
+    logic [2:0] la_funct3;
+    logic [31:0] la_imm;
+
+    assign la_OP = lookahead[6:2];
+    assign la_rd = lookahead[11:7];
+    assign la_rs1 = lookahead[19:15];
+    assign la_funct3 = lookahead[14:12];
+    assign la_imm = {{20{lookahead[31]}}, lookahead[31:20]};
+
+    // The second instruction only depends on the result of the first
+    always_comb begin
+      fuse_lui_addi = OP == INSTR_LUI
+                    && la_OP == INSTR_OPIMM && la_funct3 == 3'b000;
+
+      fuse_auipc_jalr = OP == INSTR_AUIPC
+                    && la_OP == INSTR_JALR && la_funct3 == 3'b000
+                    && la_imm[1] == 1'b0;
+
+      fuse_auipc_lw = OP == INSTR_AUIPC
+                    && la_OP == INSTR_LOAD && la_funct3 == 3'b010
+                    && la_imm[1:0] == 2'b00;
+
+      fuse_slli_srli = OP == INSTR_OPIMM && funct3 == 3'b001 && funct7 == 7'd0
+                    && la_OP == INSTR_OPIMM && la_funct3 == 3'b101 && lookahead[31:25] == 7'd0
+                    && lookahead[24:20] == IR[24:20];
+    end
+
+    assign fuse = fetch_vld && lookahead_vld && lookahead[1:0] == 2'b11
+                && rd != '0 && la_rd == rd && la_rs1 == rd
+                && (fuse_lui_addi || fuse_auipc_jalr || fuse_auipc_lw || fuse_slli_srli);
+
+    // The U-type immediate of the first instruction has its lower 12b blank,
+    // hence, only the upper 20b need to absorb the sign of the I-type immediate
+    assign fuse_imm = {immediate[31:12] - {19'b0, la_imm[11]}, la_imm[11:0]};
+
+    assign IR_EX = fuse ? lookahead : IR;
+  end
+  else begin
+    assign fuse = 1'b0;
+    assign fuse_lui_addi = 1'b0;
+    assign fuse_auipc_jalr = 1'b0;
+    assign fuse_auipc_lw = 1'b0;
+    assign fuse_slli_srli = 1'b0;
+    assign fuse_imm = '0;
+    assign IR_EX = IR;
+
+    `ifdef verilator
+    logic _unused = &{1'b0
+      , lookahead
+      , lookahead_vld
+    };
+    `endif
+  end
+endgenerate
+
+assign OP_EX = IR_EX[6:2];
+
+// ============================================================
+// Single-bit select for Zbs, from the shamt in the immediate or rs2
+assign bitsel = 32'h1 << (OP == INSTR_OPIMM ? immediate[4:0] : rs2_data[4:0]);
 
 // ============================================================
 // Operation Decoder
@@ -226,8 +374,8 @@ always_comb begin
     end
     // --------------------------------
     INSTR_OPIMM: begin
-      if (funct3 == 3'b001 || funct3 == 3'b101) aluop = {funct7[5], funct3};
-      else aluop = {1'b0, funct3};
+      if (funct3 == 3'b001 || funct3 == 3'b101) aluop = {1'b0, funct7[5], funct3};
+      else aluop = {2'b0, funct3};
 
       op1 = rs1_data;
       op2 = immediate;
@@ -242,16 +390,56 @@ always_comb begin
           instr_valid = 1'b1;
         3'b001: begin // SLLI
           if (funct7 == 7'd0) instr_valid = 1'b1;
+          else if (EN_ZBB && funct7 == 7'b0110000) begin
+            case(rs2)
+              5'd0: begin aluop = CLZ;   instr_valid = 1'b1; end
+              5'd1: begin aluop = CTZ;   instr_valid = 1'b1; end
+              5'd2: begin aluop = CPOP;  instr_valid = 1'b1; end
+              5'd4: begin aluop = SEXTB; instr_valid = 1'b1; end
+              5'd5: begin aluop = SEXTH; instr_valid = 1'b1; end
+            endcase // rs2
+          end
+          else if (EN_ZBS && funct7 == 7'b0010100) begin // BSETI
+            aluop = OR;
+            op2 = bitsel;
+            instr_valid = 1'b1;
+          end
+          else if (EN_ZBS && funct7 == 7'b0100100) begin // BCLRI
+            aluop = ANDN;
+            op2 = bitsel;
+            instr_valid = 1'b1;
+          end
+          else if (EN_ZBS && funct7 == 7'b0110100) begin // BINVI
+            aluop = XOR;
+            op2 = bitsel;
+            instr_valid = 1'b1;
+          end
         end
         3'b101: begin // SRLI/SRAI
           if (funct7 == 7'd0) instr_valid = 1'b1;
           else if (funct7 == 7'd32) instr_valid = 1'b1;
+          else if (EN_ZBB && funct7 == 7'b0110000) begin // RORI
+            aluop = ROR;
+            instr_valid = 1'b1;
+          end
+          else if (EN_ZBB && IR[31:20] == 12'h287) begin // ORC.B
+            aluop = ORCB;
+            instr_valid = 1'b1;
+          end
+          else if (EN_ZBB && IR[31:20] == 12'h698) begin // REV8
+            aluop = REV8;
+            instr_valid = 1'b1;
+          end
+          else if (EN_ZBS && funct7 == 7'b0100100) begin // BEXTI
+            aluop = BEXT;
+            instr_valid = 1'b1;
+          end
         end
       endcase // funct3
     end
     // --------------------------------
     INSTR_OP: begin
-      aluop = {funct7[5], funct3};
+      aluop = {1'b0, funct7[5], funct3};
       op1 = rs1_data;
       op2 = rs2_data;
 
@@ -283,6 +471,74 @@ always_comb begin
           if (funct7 == 7'd0) instr_valid = 1'b1;
         end
       endcase // funct3
+
+      // Zba: SH1ADD/SH2ADD/SH3ADD
+      if (EN_ZBA && funct7 == 7'b0010000) begin
+        case(funct3)
+          3'b010,
+          3'b100,
+          3'b110: begin
+            aluop = ADD;
+            op1 = rs1_data << funct3[2:1];
+            instr_valid = 1'b1;
+          end
+        endcase // funct3
+      end
+
+      // Zbb
+      if (EN_ZBB) begin
+        if (funct7 == 7'b0100000) begin
+          case(funct3)
+            3'b100, // XNOR
+            3'b110, // ORN
+            3'b111: // ANDN
+              instr_valid = 1'b1;
+          endcase // funct3
+        end
+        else if (funct7 == 7'b0000101) begin
+          case(funct3)
+            3'b100: begin aluop = MIN;  instr_valid = 1'b1; end
+            3'b101: begin aluop = MINU; instr_valid = 1'b1; end
+            3'b110: begin aluop = MAX;  instr_valid = 1'b1; end
+            3'b111: begin aluop = MAXU; instr_valid = 1'b1; end
+          endcase // funct3
+        end
+        else if (funct7 == 7'b0000100 && funct3 == 3'b100 && rs2 == '0) begin // ZEXT.H
+          aluop = ZEXTH;
+          instr_valid = 1'b1;
+        end
+        else if (funct7 == 7'b0110000) begin
+          case(funct3)
+            3'b001: begin aluop = ROL; instr_valid = 1'b1; end
+            3'b101: begin aluop = ROR; instr_valid = 1'b1; end
+          endcase // funct3
+        end
+      end
+
+      // Zbs
+      if (EN_ZBS && funct3 == 3'b001) begin
+        case(funct7)
+          7'b0010100: begin // BSET
+            aluop = OR;
+            op2 = bitsel;
+            instr_valid = 1'b1;
+          end
+          7'b0100100: begin // BCLR
+            aluop = ANDN;
+            op2 = bitsel;
+            instr_valid = 1'b1;
+          end
+          7'b0110100: begin // BINV
+            aluop = XOR;
+            op2 = bitsel;
+            instr_valid = 1'b1;
+          end
+        endcase // funct7
+      end
+      else if (EN_ZBS && funct3 == 3'b101 && funct7 == 7'b0100100) begin // BEXT
+        aluop = BEXT;
+        instr_valid = 1'b1;
+      end
     end
     // --------------------------------
     INSTR_MISC: begin
@@ -343,6 +599,23 @@ always_comb begin
     end
   endcase // OP
   /* verilator lint_on CASEINCOMPLETE */
+
+  // Fused pairs
+  if (fuse && fuse_lui_addi) begin
+    op1 = ZERO;
+    op2 = fuse_imm;
+  end
+  else if (fuse && fuse_auipc_jalr) begin
+    op2 = 32'h8;
+    offset = fuse_imm;
+  end
+  else if (fuse && fuse_auipc_lw) begin
+    offset = fuse_imm;
+  end
+  else if (fuse && fuse_slli_srli) begin
+    aluop = AND;
+    op2 = '1 >> immediate[4:0];
+  end
 end
 
 // Consolidate factors that deem an instruction as illegal
@@ -354,7 +627,7 @@ kronos_agu #(
   .CATCH_MISALIGNED_JMP (CATCH_MISALIGNED_JMP),
   .CATCH_MISALIGNED_LDST(CATCH_MISALIGNED_LDST)
 ) u_agu (
-  .instr          (IR             ),
+  .instr          (IR_EX          ),
   .base           (base           ),
   .offset         (offset         ),
   .addr           (addr           ),
@@ -371,20 +644,145 @@ kronos_branch u_branch (
   .branch(branch  )
 );
 
+// ============================================================
+// Second Instruction Decoder
+generate
+  if (DUAL_ISSUE) begin
+    logic [31:0] IR1;
+    logic [4:0] OP1, rs1_1, rs2_1, rd1;
+    logic [2:0] funct3_1;
+    logic [6:0] funct7_1;
+    logic [31:0] rs1_data1, rs2_data1;
+    logic valid1, pairable, wr0, raw, waw;
+
+    assign IR1 = fetch1.ir;
+    assign OP1 = IR1[6:2];
+    assign rs1_1 = IR1[19:15];
+    assign rs2_1 = IR1[24:20];
+    assign rd1 = IR1[11:7];
+    assign funct3_1 = IR1[14:12];
+    assign funct7_1 = IR1[31:25];
+
+    // Register Forwarding
+    always_comb begin
+      if (!DEEP_PIPELINE && regwr1_en && regwr1_sel == rs1_1) rs1_data1 = regwr1_data;
+      else if (!DEEP_PIPELINE && regwr_en && regwr_sel == rs1_1) rs1_data1 = regwr_data;
+      else rs1_data1 = regrd1_rs1;
+
+      if (!DEEP_PIPELINE && regwr1_en && regwr1_sel == rs2_1) rs2_data1 = regwr1_data;
+      else if (!DEEP_PIPELINE && regwr_en && regwr_sel == rs2_1) rs2_data1 = regwr_data;
+      else rs2_data1 = regrd1_rs2;
+    end
+
+    // Base ALU instructions only
+    always_comb begin
+      valid1 = 1'b0;
+      aluop_1 = ADD;
+      op1_1 = rs1_data1;
+      op2_1 = immediate1;
+
+      /* verilator lint_off CASEINCOMPLETE */
+      unique case(OP1)
+        INSTR_LUI: begin
+          op1_1 = ZERO;
+          valid1 = 1'b1;
+        end
+        INSTR_AUIPC: begin
+          op1_1 = fetch1.pc;
+          valid1 = 1'b1;
+        end
+        INSTR_OPIMM: begin
+          if (funct3_1 == 3'b001 || funct3_1 == 3'b101) aluop_1 = {1'b0, funct7_1[5], funct3_1};
+          else aluop_1 = {2'b0, funct3_1};
+
+          if (funct3_1 == 3'b001) valid1 = funct7_1 == 7'd0;
+          else if (funct3_1 == 3'b101) valid1 = funct7_1 == 7'd0 || funct7_1 == 7'd32;
+          else valid1 = 1'b1;
+        end
+        INSTR_OP: begin
+          aluop_1 = {1'b0, funct7_1[5], funct3_1};
+          op2_1 = rs2_data1;
+
+          if (funct3_1 == 3'b000 || funct3_1 == 3'b101) valid1 = funct7_1 == 7'd0 || funct7_1 == 7'd32;
+          else valid1 = funct7_1 == 7'd0;
+        end
+      endcase // OP1
+      /* verilator lint_on CASEINCOMPLETE */
+
+      valid1 = valid1 && IR1[1:0] == 2'b11;
+    end
+
+    // The first instruction can be anything that doesn't redirect the
+    // program flow unconditionally, or needs the CSR/trap sequencing
+    assign pairable = OP == INSTR_LUI
+                    || OP == INSTR_AUIPC
+                    || OP == INSTR_OPIMM
+                    || OP == INSTR_OP
+                    || OP == INSTR_BR
+                    || OP == INSTR_LOAD
+                    || OP == INSTR_STORE;
+
+    // Dependencies within the pair
+    assign wr0 = rd != '0 && (OP == INSTR_LUI
+                    || OP == INSTR_AUIPC
+                    || OP == INSTR_OPIMM
+                    || OP == INSTR_OP
+                    || OP == INSTR_LOAD);
+
+    assign raw = wr0 && ((regrd1_rs1_en && rs1_1 == rd) || (regrd1_rs2_en && rs2_1 == rd));
+    assign waw = wr0 && rd1 == rd;
+
+    assign pair = fetch1_vld && valid1 && pairable && ~raw && ~waw && ~stall1;
+    assign regwr_alu_1 = rd1 != '0;
+  end
+  else begin
+    assign pair = 1'b0;
+    assign aluop_1 = ADD;
+    assign op1_1 = '0;
+    assign op2_1 = '0;
+    assign regwr_alu_1 = 1'b0;
+
+    `ifdef verilator
+    logic _unused = &{1'b0
+      , fetch1
+      , immediate1
+      , regrd1_rs1
+      , regrd1_rs2
+      , regrd1_rs1_en
+      , regrd1_rs2_en
+      , fetch1_vld
+      , regwr1_data
+      , regwr1_sel
+      , regwr1_en
+    };
+    `endif
+  end
+endgenerate
+
 // ============================================================
 // Hazard Control
-kronos_hcu u_hcu (
-  .clk         (clk         ),
-  .rstz        (rstz        ),
-  .flush       (flush       ),
-  .instr       (IR          ),
-  .regrd_rs1_en(regrd_rs1_en),
-  .regrd_rs2_en(regrd_rs2_en),
-  .fetch_vld   (fetch_vld   ),
-  .fetch_rdy   (fetch_rdy   ),
-  .regwr_sel   (regwr_sel   ),
-  .regwr_en    (regwr_en    ),
-  .stall       (stall       )
+kronos_hcu #(
+  .DUAL_ISSUE(DUAL_ISSUE),
+  .DEEP_PIPELINE(DEEP_PIPELINE)
+) u_hcu (
+  .clk          (clk          ),
+  .rstz         (rstz         ),
+  .flush        (flush        ),
+  .instr        (IR           ),
+  .regrd_rs1_en (regrd_rs1_en ),
+  .regrd_rs2_en (regrd_rs2_en ),
+  .fetch_vld    (fetch_vld    ),
+  .fetch_rdy    (fetch_rdy    ),
+  .regwr_sel    (regwr_sel    ),
+  .regwr_en     (regwr_en     ),
+  .stall        (stall        ),
+  .instr1       (fetch1.ir    ),
+  .regrd1_rs1_en(regrd1_rs1_en),
+  .regrd1_rs2_en(regrd1_rs2_en),
+  .pair         (fetch1_rdy   ),
+  .regwr1_sel   (regwr1_sel   ),
+  .regwr1_en    (regwr1_en    ),
+  .stall1       (stall1       )
 );
 
 // ============================================================
@@ -402,16 +800,18 @@ always_ff @(posedge clk or negedge rstz) begin
       decode_vld <= 1'b1;
 
       decode.pc <= PC;
-      decode.ir <= IR;
-
-      decode.basic <= OP == INSTR_LUI
-                    || OP == INSTR_AUIPC
-                    || OP == INSTR_OPIMM
-                    || OP == INSTR_OP
-                    || OP == INSTR_BR
-                    || OP == INSTR_JAL
-                    || OP == INSTR_JALR
-                    || OP == INSTR_MISC;
+      decode.ir <= IR_EX;
+      decode.fused <= fuse;
+      decode.fuse_ir <= fuse ? IR : '0;
+
+      decode.basic <= OP_EX == INSTR_LUI
+                    || OP_EX == INSTR_AUIPC
+                    || OP_EX == INSTR_OPIMM
+                    || OP_EX == INSTR_OP
+                    || OP_EX == INSTR_BR
+                    || OP_EX == INSTR_JAL
+                    || OP_EX == INSTR_JALR
+                    || OP_EX == INSTR_MISC;
 
       decode.aluop <= aluop;
       decode.regwr_alu <= regwr_alu;
@@ -419,9 +819,9 @@ always_ff @(posedge clk or negedge rstz) begin
       decode.op2 <= op2;
 
       decode.addr <= addr;
-      decode.jump <= OP == INSTR_JAL || OP == INSTR_JALR || is_fencei;
+      decode.jump <= OP_EX == INSTR_JAL || OP_EX == INSTR_JALR || is_fencei;
       decode.branch <= branch && OP == INSTR_BR;
-      decode.load <= OP == INSTR_LOAD; 
+      decode.load <= OP_EX == INSTR_LOAD; 
       decode.store <= OP == INSTR_STORE;
       decode.mask  <= mask;
 
@@ -442,4 +842,35 @@ end
 
 assign fetch_rdy = (~decode_vld | decode_rdy) & ~stall;
 
+assign hpm_hazard_stall = fetch_vld & stall;
+
+// ============================================================
+// Second Instruction Decode Output
+// The second instruction is issued with the first, and retires with it
+assign fetch1_rdy = fetch_vld && fetch_rdy && pair;
+
+always_ff @(posedge clk or negedge rstz) begin
+  if (~rstz) begin
+    decode1_vld <= 1'b0;
+  end
+  else begin
+    if (flush) begin
+      decode1_vld <= 1'b0;
+    end
+    else if(fetch_vld && fetch_rdy) begin
+      decode1_vld <= fetch1_rdy;
+
+      decode1.pc <= fetch1.pc;
+      decode1.ir <= fetch1.ir;
+      decode1.aluop <= aluop_1;
+      decode1.regwr_alu <= regwr_alu_1;
+      decode1.op1 <= op1_1;
+      decode1.op2 <= op2_1;
+    end
+    else if (decode_vld && decode_rdy) begin
+      decode1_vld <= 1'b0;
+    end
+  end
+end
+
 endmodule
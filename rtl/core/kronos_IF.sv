@@ -20,19 +20,37 @@ FAST_BRANCH
   - Branch instructions take 2 cycles because the PC is set first. But, with FAST_BRANCH,
     the branch_target is forwarded for instruction fetch. Costs an extra adder, 
     but jumps are 1 cycle faster.
+
+Lookahead
+  - The instruction following the one in `fetch` is presented to the decoder
+    as `lookahead`, when it is available, i.e. it is either arriving from the
+    instruction memory or waiting in the skid buffer.
+  - If the decoder fuses it with the instruction in `fetch`, then it asserts `fuse`
+    and the lookahead instruction is consumed, i.e. it is never loaded into `fetch`.
+
+DUAL_ISSUE
+  - The instruction interface is 64b wide, and fetches an aligned block of two
+    instructions. The block is presented as `fetch` and `fetch1`, in program order.
+    If the block is entered at its upper word (ex: branch target), then only
+    `fetch` is valid.
+  - The decoder can consume either both instructions (`fetch_rdy` and `fetch1_rdy`),
+    or only the first. In the latter case, `fetch1` moves up to `fetch`.
+  - The next block is loaded only when the current block is consumed.
+  - The lookahead for instruction fusion is disabled.
 */
 
 module kronos_IF
   import kronos_types::*;
 #(
   parameter logic [31:0] BOOT_ADDR = 32'h0,
-  parameter FAST_BRANCH = 0
+  parameter FAST_BRANCH = 0,
+  parameter DUAL_ISSUE = 0
 )(
   input  logic        clk,
   input  logic        rstz,
   // Instruction interface
   output logic [31:0] instr_addr,
-  input  logic [31:0] instr_data,
+  input  logic [32*(DUAL_ISSUE+1)-1:0] instr_data,
   output logic        instr_req,
   input  logic        instr_ack,
   // IF/ID interface
@@ -44,20 +62,42 @@ module kronos_IF
   output logic        regrd_rs2_en,
   output logic        fetch_vld,
   input  logic        fetch_rdy,
+  // Lookahead for instruction fusion
+  output logic [31:0] lookahead,
+  output logic        lookahead_vld,
+  input  logic        fuse,
+  // Second instruction of the fetch block
+  output pipeIFID_t   fetch1,
+  output logic [31:0] immediate1,
+  output logic [31:0] regrd1_rs1,
+  output logic [31:0] regrd1_rs2,
+  output logic        regrd1_rs1_en,
+  output logic        regrd1_rs2_en,
+  output logic        fetch1_vld,
+  input  logic        fetch1_rdy,
   // BRANCH
   input logic [31:0]  branch_target,
   input logic         branch,
   // Write back
   input  logic [31:0] regwr_data,
   input  logic [4:0]  regwr_sel,
-  input  logic        regwr_en
+  input  logic        regwr_en,
+  input  logic [31:0] regwr1_data,
+  input  logic [4:0]  regwr1_sel,
+  input  logic        regwr1_en,
+  // Performance events
+  output logic        hpm_fetch_miss,
+  output logic        hpm_fetch_stall
 );
 
 logic [31:0] pc, pc_last;
-logic [31:0] skid_buffer;
-logic pipe_rdy;
-logic instr_vld;
-logic [31:0] next_instr;
+logic [63:0] instr_blk;
+logic [63:0] skid_buffer;
+logic pipe_rdy, blk_rdy;
+logic fetch_shift;
+logic instr_vld, instr1_vld;
+logic [31:0] next_instr, next_instr1;
+logic [31:0] fetch_addr;
 
 enum logic [1:0] {
   INIT,
@@ -76,7 +116,7 @@ always_ff @(posedge clk or negedge rstz) begin
   end
   else if (branch) begin
     if (FAST_BRANCH) begin
-      pc <= branch_target + 32'h4;
+      pc <= DUAL_ISSUE ? {branch_target[31:3], 3'b0} + 32'h8 : branch_target + 32'h4;
       pc_last <= branch_target;
     end
     else begin
@@ -84,7 +124,7 @@ always_ff @(posedge clk or negedge rstz) begin
     end
   end
   else if (next_state == FETCH) begin
-    pc <= pc + 32'h4;
+    pc <= DUAL_ISSUE ? {pc[31:3], 3'b0} + 32'h8 : pc + 32'h4;
     pc_last <= pc;
   end
 end
@@ -116,89 +156,147 @@ always_comb begin
       else next_state = STALL;
     end
 
-    STALL: if (fetch_rdy) next_state = FETCH;
+    STALL: if (blk_rdy) next_state = FETCH;
 
   endcase // state
   /* verilator lint_on CASEINCOMPLETE */
 end
 
+// The fetch block, upper word is unused for single issue
+generate
+  if (DUAL_ISSUE) assign instr_blk = instr_data;
+  else assign instr_blk = {32'b0, instr_data};
+endgenerate
+
 always_ff @(posedge clk or negedge rstz) begin
   if (~rstz) begin
     fetch_vld <= '0;
+    fetch1_vld <= '0;
   end
   else begin
     if (branch) begin
       fetch_vld <= 1'b0;
+      fetch1_vld <= 1'b0;
     end
     else if ((state == FETCH || state == MISS) && instr_ack) begin
       if (pipe_rdy) begin
         // Successful fetch if instruction is read and the pipeline can accept it
         fetch.pc <= pc_last;
-        fetch.ir <= instr_data;
-        fetch_vld <= 1'b1;
+        fetch.ir <= next_instr;
+        fetch_vld <= ~fuse;
+        fetch1.pc <= {pc_last[31:3], 3'b100};
+        fetch1.ir <= next_instr1;
+        fetch1_vld <= instr1_vld;
       end
       else begin
         // Instruction fetch is good, but pipeline is stalling, hence stow
         // fetched instruction in a skid buffer
-        skid_buffer <= instr_data;
+        skid_buffer <= instr_blk;
       end
     end
-    else if (state == STALL && fetch_rdy) begin
+    else if (state == STALL && blk_rdy) begin
       // Flush the skid buffer when the pipeline is ready
       fetch.pc <= pc_last;
-      fetch.ir <= skid_buffer;
-      fetch_vld <= 1'b1;
+      fetch.ir <= next_instr;
+      fetch_vld <= ~fuse;
+      fetch1.pc <= {pc_last[31:3], 3'b100};
+      fetch1.ir <= next_instr1;
+      fetch1_vld <= instr1_vld;
+    end
+    else if (fetch_shift) begin
+      // Only the first instruction of the block was consumed
+      fetch <= fetch1;
+      fetch1_vld <= 1'b0;
     end
     else if (fetch_vld && fetch_rdy) begin
       fetch_vld <= 1'b0;
+      fetch1_vld <= 1'b0;
     end
   end
 end
 
-assign pipe_rdy = ~fetch_vld || fetch_rdy;
+// The fetch block is consumed
+assign blk_rdy = fetch_rdy && (~fetch1_vld || fetch1_rdy);
+assign pipe_rdy = ~fetch_vld || blk_rdy;
+assign fetch_shift = fetch_vld && fetch_rdy && fetch1_vld && ~fetch1_rdy;
+
+// The next instruction, in program order
+assign lookahead = (state == STALL) ? skid_buffer[31:0] : instr_data[31:0];
+assign lookahead_vld = ~DUAL_ISSUE && fetch_vld
+                    && (((state == FETCH || state == MISS) && instr_ack) || state == STALL);
 
 
 // ============================================================
 // Instruction Memory Interface
 
 always_comb begin
-  if (FAST_BRANCH & branch) instr_addr = branch_target;
-  else instr_addr = ((state == FETCH || state == MISS) && ~instr_ack) ? pc_last : pc;
+  if (FAST_BRANCH & branch) fetch_addr = branch_target;
+  else fetch_addr = ((state == FETCH || state == MISS) && ~instr_ack) ? pc_last : pc;
+
+  // Fetch blocks are 64b aligned for dual issue
+  instr_addr = DUAL_ISSUE ? {fetch_addr[31:3], 3'b0} : fetch_addr;
 end
 assign instr_req = 1'b1;
 
+// Waiting on the instruction memory, or holding a fetched block for the pipeline
+assign hpm_fetch_miss = (state == FETCH || state == MISS) && ~instr_ack;
+assign hpm_fetch_stall = state == STALL;
+
 // ============================================================
 // Register File
 
 always_comb begin
   if ((state == FETCH || state == MISS) && instr_ack && pipe_rdy) begin
     instr_vld = 1'b1;
-    next_instr = instr_data;
   end
-  else if (state == STALL && fetch_rdy) begin
+  else if (state == STALL && blk_rdy) begin
     instr_vld = 1'b1;
-    next_instr = skid_buffer;
   end
   else begin
     instr_vld = 1'b0;
-    next_instr = instr_data;
   end
+
+  // Unpack the fetch block. If the block is entered at the upper word,
+  // then only the upper instruction is valid, and it goes first
+  if (state == STALL) begin
+    next_instr = (DUAL_ISSUE && pc_last[2]) ? skid_buffer[63:32] : skid_buffer[31:0];
+    next_instr1 = skid_buffer[63:32];
+  end
+  else begin
+    next_instr = (DUAL_ISSUE && pc_last[2]) ? instr_blk[63:32] : instr_blk[31:0];
+    next_instr1 = instr_blk[63:32];
+  end
+
+  instr1_vld = DUAL_ISSUE && ~pc_last[2];
 end
 
-kronos_RF u_rf (
-  .clk         (clk         ),
-  .rstz        (rstz        ),
-  .instr_data  (next_instr  ),
-  .instr_vld   (instr_vld   ),
-  .fetch_rdy   (fetch_rdy   ),
-  .immediate   (immediate   ),
-  .regrd_rs1   (regrd_rs1   ),
-  .regrd_rs2   (regrd_rs2   ),
-  .regrd_rs1_en(regrd_rs1_en),
-  .regrd_rs2_en(regrd_rs2_en),
-  .regwr_data  (regwr_data  ),
-  .regwr_sel   (regwr_sel   ),
-  .regwr_en    (regwr_en    )
+kronos_RF #(
+  .DUAL_ISSUE(DUAL_ISSUE)
+) u_rf (
+  .clk          (clk          ),
+  .rstz         (rstz         ),
+  .instr_data   (next_instr   ),
+  .instr_vld    (instr_vld    ),
+  .fetch_rdy    (blk_rdy      ),
+  .immediate    (immediate    ),
+  .regrd_rs1    (regrd_rs1    ),
+  .regrd_rs2    (regrd_rs2    ),
+  .regrd_rs1_en (regrd_rs1_en ),
+  .regrd_rs2_en (regrd_rs2_en ),
+  .regwr_data   (regwr_data   ),
+  .regwr_sel    (regwr_sel    ),
+  .regwr_en     (regwr_en     ),
+  .instr1_data  (next_instr1  ),
+  .instr1_vld   (instr1_vld   ),
+  .fetch_shift  (fetch_shift  ),
+  .immediate1   (immediate1   ),
+  .regrd1_rs1   (regrd1_rs1   ),
+  .regrd1_rs2   (regrd1_rs2   ),
+  .regrd1_rs1_en(regrd1_rs1_en),
+  .regrd1_rs2_en(regrd1_rs2_en),
+  .regwr1_data  (regwr1_data  ),
+  .regwr1_sel   (regwr1_sel   ),
+  .regwr1_en    (regwr1_en    )
 );
 
 endmodule
@@ -7,11 +7,21 @@ Kronos Integer Register File
   - Decodes 32b Immediate and Register Operands for the Decode stage.
   - Operates in parallel to the Fetch stage, such that when the fetch is valid, 
   so are the outputs of this block. 
+
+DUAL_ISSUE
+  - A second read lane for the second instruction of a fetch block, i.e. 4 read ports.
+    Only ALU instructions (OPIMM, OP, LUI, AUIPC) are paired by the decoder, but
+    the lane decodes the immediate and operands of every instruction.
+  - If only the first instruction of the block is consumed, then the operands of 
+    the second lane are shifted into the first lane, with their hazard tracking.
+  - A second write port for the write back of the second instruction.
 */
 
 module kronos_RF
   import kronos_types::*;
-(
+#(
+  parameter DUAL_ISSUE = 0
+)(
   input  logic        clk,
   input  logic        rstz,
   // Fetch
@@ -27,119 +37,143 @@ module kronos_RF
   // Write back
   input  logic [31:0] regwr_data,
   input  logic [4:0]  regwr_sel,
-  input  logic        regwr_en
+  input  logic        regwr_en,
+  // Second lane
+  input  logic [31:0] instr1_data,
+  input  logic        instr1_vld,
+  input  logic        fetch_shift,
+  output logic [31:0] immediate1,
+  output logic [31:0] regrd1_rs1,
+  output logic [31:0] regrd1_rs2,
+  output logic        regrd1_rs1_en,
+  output logic        regrd1_rs2_en,
+  input  logic [31:0] regwr1_data,
+  input  logic [4:0]  regwr1_sel,
+  input  logic        regwr1_en
 );
 
 logic reg_vld, instr_rdy;
 logic [4:0] reg_rs1, reg_rs2;
+logic [4:0] reg1_rs1, reg1_rs2;
 
 logic [31:0] IR;
-logic [4:0] OP;
 logic [4:0] rs1, rs2;
-logic [2:0] funct3;
-
-// Immediate Operand segments
-// A: [0]
-// B: [4:1]
-// C: [10:5]
-// D: [11]
-// E: [19:12]
-// F: [31:20]
-logic           ImmA;
-logic [3:0]     ImmB;
-logic [5:0]     ImmC;
-logic           ImmD;
-logic [7:0]     ImmE;
-logic [11:0]    ImmF;
-logic [31:0]    Imm;
-
-logic sign;
-logic format_I;
-logic format_J;
-logic format_S;
-logic format_B;
-logic format_U;
-
-logic csr_regrd;
+
+logic [31:0] Imm;
 logic is_regrd_rs1_en;
 logic is_regrd_rs2_en;
 
-
-// ============================================================
-// Instruction Decoder
-
-assign IR = instr_data;
-
-// Aliases to IR segments
-assign OP = IR[6:2];
-assign rs1 = IR[19:15];
-assign rs2 = IR[24:20];
-assign funct3 = IR[14:12];
-
 // ============================================================
 // Immediate Decoder
 
-assign sign = IR[31];
+function automatic logic [31:0] imm_decode(input logic [31:0] ir);
+  logic [4:0] op;
+  logic sign;
+  logic format_I, format_J, format_S, format_B, format_U;
+
+  // Immediate Operand segments
+  // A: [0]
+  // B: [4:1]
+  // C: [10:5]
+  // D: [11]
+  // E: [19:12]
+  // F: [31:20]
+  logic           ImmA;
+  logic [3:0]     ImmB;
+  logic [5:0]     ImmC;
+  logic           ImmD;
+  logic [7:0]     ImmE;
+  logic [11:0]    ImmF;
+
+  op = ir[6:2];
+  sign = ir[31];
 
-always_comb begin
   // Instruction format --- used to decode Immediate 
-  format_I = OP == INSTR_OPIMM || OP == INSTR_JALR || OP == INSTR_LOAD;
-  format_J = OP == INSTR_JAL;
-  format_S = OP == INSTR_STORE;
-  format_B = OP == INSTR_BR;
-  format_U = OP == INSTR_LUI || OP == INSTR_AUIPC;
+  format_I = op == INSTR_OPIMM || op == INSTR_JALR || op == INSTR_LOAD;
+  format_J = op == INSTR_JAL;
+  format_S = op == INSTR_STORE;
+  format_B = op == INSTR_BR;
+  format_U = op == INSTR_LUI || op == INSTR_AUIPC;
 
   // Immediate Segment A - [0]
-  if (format_I) ImmA = IR[20];
-  else if (format_S) ImmA = IR[7];
+  if (format_I) ImmA = ir[20];
+  else if (format_S) ImmA = ir[7];
   else ImmA = 1'b0; // B/J/U
   
   // Immediate Segment B - [4:1]
   if (format_U) ImmB = 4'b0;
-  else if (format_I || format_J) ImmB = IR[24:21];
-  else ImmB = IR[11:8]; // S/B
+  else if (format_I || format_J) ImmB = ir[24:21];
+  else ImmB = ir[11:8]; // S/B
 
   // Immediate Segment C - [10:5]
   if (format_U) ImmC = 6'b0;
-  else ImmC = IR[30:25];
+  else ImmC = ir[30:25];
 
   // Immediate Segment D - [11]
   if (format_U) ImmD = 1'b0;
-  else if (format_B) ImmD = IR[7];
-  else if (format_J) ImmD = IR[20];
+  else if (format_B) ImmD = ir[7];
+  else if (format_J) ImmD = ir[20];
   else ImmD = sign;
 
   // Immediate Segment E - [19:12]
-  if (format_U || format_J) ImmE = IR[19:12];
+  if (format_U || format_J) ImmE = ir[19:12];
   else ImmE = {8{sign}};
   
   // Immediate Segment F - [31:20]
-  if (format_U) ImmF = IR[31:20];
+  if (format_U) ImmF = ir[31:20];
   else ImmF = {12{sign}};
-end
 
-// As A-Team's Hannibal would say, "I love it when a plan comes together"
-assign Imm = {ImmF, ImmE, ImmD, ImmC, ImmB, ImmA};
+  // As A-Team's Hannibal would say, "I love it when a plan comes together"
+  return {ImmF, ImmE, ImmD, ImmC, ImmB, ImmA};
+endfunction
 
 // ============================================================
 // Hazard tracking
 
-assign csr_regrd = OP == INSTR_SYS && (funct3 == 3'b001
-                                    || funct3 == 3'b010
-                                    || funct3 == 3'b011);
-
 // RS1/RS2 register read conditions
-assign is_regrd_rs1_en = OP == INSTR_OPIMM 
-                || OP == INSTR_OP 
-                || OP == INSTR_JALR 
-                || OP == INSTR_BR
-                || OP == INSTR_LOAD
-                || OP == INSTR_STORE
-                || csr_regrd;
+function automatic logic rs1_read(input logic [31:0] ir);
+  logic [4:0] op;
+  logic [2:0] funct3;
+  logic csr_regrd;
+
+  op = ir[6:2];
+  funct3 = ir[14:12];
+
+  csr_regrd = op == INSTR_SYS && (funct3 == 3'b001
+                               || funct3 == 3'b010
+                               || funct3 == 3'b011);
 
-assign is_regrd_rs2_en = OP == INSTR_OP 
-                || OP == INSTR_BR
-                || OP == INSTR_STORE;
+  return op == INSTR_OPIMM 
+      || op == INSTR_OP 
+      || op == INSTR_JALR 
+      || op == INSTR_BR
+      || op == INSTR_LOAD
+      || op == INSTR_STORE
+      || csr_regrd;
+endfunction
+
+function automatic logic rs2_read(input logic [31:0] ir);
+  logic [4:0] op;
+
+  op = ir[6:2];
+
+  return op == INSTR_OP 
+      || op == INSTR_BR
+      || op == INSTR_STORE;
+endfunction
+
+// ============================================================
+// Instruction Decoder
+
+assign IR = instr_data;
+
+// Aliases to IR segments
+assign rs1 = IR[19:15];
+assign rs2 = IR[24:20];
+
+assign Imm = imm_decode(IR);
+assign is_regrd_rs1_en = rs1_read(IR);
+assign is_regrd_rs2_en = rs2_read(IR);
 
 
 // ============================================================
@@ -162,10 +196,12 @@ always_ff @(posedge clk or negedge rstz) begin
       
       if (rs1 == 0) regrd_rs1 <= '0;
       else if (regwr_en && rs1 == regwr_sel) regrd_rs1 <= regwr_data;
+      else if (DUAL_ISSUE && regwr1_en && rs1 == regwr1_sel) regrd_rs1 <= regwr1_data;
       else regrd_rs1 <= REG[rs1];
 
       if (rs2 == 0) regrd_rs2 <= '0;
       else if (regwr_en && rs2 == regwr_sel) regrd_rs2 <= regwr_data;
+      else if (DUAL_ISSUE && regwr1_en && rs2 == regwr1_sel) regrd_rs2 <= regwr1_data;
       else regrd_rs2 <= REG[rs2];
 
       regrd_rs1_en <= is_regrd_rs1_en;
@@ -174,11 +210,32 @@ always_ff @(posedge clk or negedge rstz) begin
       reg_rs1 <= rs1;
       reg_rs2 <= rs2;
     end
-    else if (reg_vld && regwr_en) begin
+    else if (DUAL_ISSUE && fetch_shift) begin
+      // The second instruction moves up to the first lane
+      immediate <= immediate1;
+
+      if (regwr_en && reg1_rs1 == regwr_sel) regrd_rs1 <= regwr_data;
+      else if (regwr1_en && reg1_rs1 == regwr1_sel) regrd_rs1 <= regwr1_data;
+      else regrd_rs1 <= regrd1_rs1;
+
+      if (regwr_en && reg1_rs2 == regwr_sel) regrd_rs2 <= regwr_data;
+      else if (regwr1_en && reg1_rs2 == regwr1_sel) regrd_rs2 <= regwr1_data;
+      else regrd_rs2 <= regrd1_rs2;
+
+      regrd_rs1_en <= regrd1_rs1_en;
+      regrd_rs2_en <= regrd1_rs2_en;
+
+      reg_rs1 <= reg1_rs1;
+      reg_rs2 <= reg1_rs2;
+    end
+    else if (reg_vld && (regwr_en || (DUAL_ISSUE && regwr1_en))) begin
       // Update register operands with latest data when stalling
       // i.e. latched register forwarding
-      if (reg_rs1 == regwr_sel) regrd_rs1 <= regwr_data;
-      if (reg_rs2 == regwr_sel) regrd_rs2 <= regwr_data;
+      if (regwr_en && reg_rs1 == regwr_sel) regrd_rs1 <= regwr_data;
+      else if (DUAL_ISSUE && regwr1_en && reg_rs1 == regwr1_sel) regrd_rs1 <= regwr1_data;
+
+      if (regwr_en && reg_rs2 == regwr_sel) regrd_rs2 <= regwr_data;
+      else if (DUAL_ISSUE && regwr1_en && reg_rs2 == regwr1_sel) regrd_rs2 <= regwr1_data;
     end
     else if (reg_vld && fetch_rdy) begin
       // drain
@@ -192,12 +249,73 @@ assign instr_rdy = ~reg_vld | fetch_rdy;
 // REG Write
 always_ff @(posedge clk) begin
   if (regwr_en) REG[regwr_sel] <= regwr_data;
+  // The decoder never pairs instructions writing to the same register
+  if (DUAL_ISSUE && regwr1_en) REG[regwr1_sel] <= regwr1_data;
 end
 
+// ============================================================
+// Second Lane
+generate
+  if (DUAL_ISSUE) begin
+    logic [31:0] IR1;
+    logic [4:0] rs1_1, rs2_1;
+
+    assign IR1 = instr1_data;
+    assign rs1_1 = IR1[19:15];
+    assign rs2_1 = IR1[24:20];
+
+    always_ff @(posedge clk) begin
+      if (instr_vld && instr_rdy) begin
+        // Fully decoded, as any instruction can be shifted to the first lane
+        immediate1 <= imm_decode(IR1);
+
+        if (rs1_1 == 0) regrd1_rs1 <= '0;
+        else if (regwr_en && rs1_1 == regwr_sel) regrd1_rs1 <= regwr_data;
+        else if (regwr1_en && rs1_1 == regwr1_sel) regrd1_rs1 <= regwr1_data;
+        else regrd1_rs1 <= REG[rs1_1];
+
+        if (rs2_1 == 0) regrd1_rs2 <= '0;
+        else if (regwr_en && rs2_1 == regwr_sel) regrd1_rs2 <= regwr_data;
+        else if (regwr1_en && rs2_1 == regwr1_sel) regrd1_rs2 <= regwr1_data;
+        else regrd1_rs2 <= REG[rs2_1];
+
+        regrd1_rs1_en <= instr1_vld && rs1_read(IR1);
+        regrd1_rs2_en <= instr1_vld && rs2_read(IR1);
+
+        reg1_rs1 <= rs1_1;
+        reg1_rs2 <= rs2_1;
+      end
+      else begin
+        // latched register forwarding
+        if (regwr_en && reg1_rs1 == regwr_sel) regrd1_rs1 <= regwr_data;
+        else if (regwr1_en && reg1_rs1 == regwr1_sel) regrd1_rs1 <= regwr1_data;
+
+        if (regwr_en && reg1_rs2 == regwr_sel) regrd1_rs2 <= regwr_data;
+        else if (regwr1_en && reg1_rs2 == regwr1_sel) regrd1_rs2 <= regwr1_data;
+      end
+    end
+  end
+  else begin
+    assign immediate1 = '0;
+    assign regrd1_rs1 = '0;
+    assign regrd1_rs2 = '0;
+    assign regrd1_rs1_en = 1'b0;
+    assign regrd1_rs2_en = 1'b0;
+    assign reg1_rs1 = '0;
+    assign reg1_rs2 = '0;
+  end
+endgenerate
+
 // ------------------------------------------------------------
 `ifdef verilator
 logic _unused = &{1'b0
     , IR[1:0]
+    , instr1_data
+    , instr1_vld
+    , fetch_shift
+    , regwr1_data
+    , regwr1_sel
+    , regwr1_en
 };
 `endif
 
@@ -26,24 +26,43 @@ Where r[0-5] are the intermediate results of these major functions
   3: XOR
   4: COMPARATOR
   5: BARREL SHIFTER
+
+Bit-Manipulation (EN_ZBB/EN_ZBS)
+  ANDN    : r[1] = op1 & ~op2
+  ORN     : r[2] = op1 | ~op2
+  XNOR    : r[3] = op1 ^ ~op2
+  MIN/MAX : r[4] ? op1 : op2, using the comparator
+  ROL/ROR : r[5], the barrel shifter wraps around the shifted out bits
+  BEXT    : r[5][0], shifter bit 0
+  CLZ/CTZ : r[6] = trailing zeros of the (reversed) shifter data
+  CPOP    : r[7] = count of set bits in op1
+  SEXT/ZEXT, ORC.B, REV8 : byte/half wiring of op1
+
+  The Zba shift-add and Zbs single-bit set/clear/invert are arranged by the
+  decoder as ADD, OR, ANDN and XOR.
 */
 
 module kronos_alu
   import kronos_types::*;
-(
+#(
+  parameter EN_ZBB = 0,
+  parameter EN_ZBS = 0
+)(
   input  logic [31:0] op1,
   input  logic [31:0] op2,
-  input  logic [3:0]  aluop,
+  input  logic [4:0]  aluop,
   output logic [31:0] result
 );
 
-logic cin, rev, uns;
+logic cin, rev, uns, inv, rot;
 
 logic [31:0] r_adder, r_and, r_or, r_xor, r_shift;
 
 logic [31:0] adder_A, adder_B;
 logic cout;
 
+logic [31:0] logic_B;
+
 logic A_sign, B_sign, R_sign;
 logic r_lt, r_ltu, r_comp;
 
@@ -52,11 +71,16 @@ logic [4:0] shamt;
 logic shift_in;
 logic [31:0] p0, p1, p2, p3, p4;
 
+logic [5:0] r_ctz, r_cpop;
+logic [31:0] r_minmax, r_orcb, r_rev8;
+
 // ============================================================
 //  Operation Decode
 assign cin = aluop[3] || aluop[1];
 assign rev = ~aluop[2];
 assign uns = aluop[0];
+assign inv = (EN_ZBB || EN_ZBS) && aluop[3];
+assign rot = (EN_ZBB || EN_ZBS) && aluop[4];
 
 // ============================================================
 // Operation Execution
@@ -75,21 +99,24 @@ end
 
 // LOGIC
 always_comb begin
-  r_and = op1 & op2;
-  r_or  = op1 | op2;
-  r_xor = op1 ^ op2;
+  // OP2 can be negated for ANDN/ORN/XNOR
+  logic_B = inv ? ~op2 : op2;
+
+  r_and = op1 & logic_B;
+  r_or  = op1 | logic_B;
+  r_xor = op1 ^ logic_B;
 end
 
 // COMPARATOR
 always_comb begin
-  // Use adder to subtract operands: op1(A) - op2(B), 
+  // Use adder to subtract operands: op1(A) - op2(B),
   //  and obtain the sign of the result
   A_sign = op1[31];
   B_sign = op2[31];
   R_sign = r_adder[31];
 
   // Signed Less Than (LT)
-  // 
+  //
   // If the operands have the same sign, we use r_sign
   // The result is negative if op1<op2
   // Subtraction of two positive or two negative signed integers (2's complement)
@@ -107,6 +134,10 @@ always_comb begin
 
   // Aggregate comparator results as per ALUOP
   r_comp = (uns) ? r_ltu : r_lt;
+
+  // MIN/MAX pick an operand based on the comparison
+  // aluop[2] indicates MAX
+  r_minmax = (r_comp ^ aluop[2]) ? op1 : op2;
 end
 
 // BARREL SHIFTER
@@ -118,21 +149,49 @@ always_comb begin
 
   // The barrel shifter is formed by a 5-level fixed RIGHT-shifter
   // that pipes in the value of the last stage
+  // For rotations, the bits shifted out of each stage are piped back in
 
-  p0 = shamt[0] ? {    shift_in  , data[31:1]} : data;
-  p1 = shamt[1] ? {{ 2{shift_in}}, p0[31:2]}   : p0;
-  p2 = shamt[2] ? {{ 4{shift_in}}, p1[31:4]}   : p1;
-  p3 = shamt[3] ? {{ 8{shift_in}}, p2[31:8]}   : p2;
-  p4 = shamt[4] ? {{16{shift_in}}, p3[31:16]}  : p3;
+  p0 = shamt[0] ? {rot ? data[0]    : {    shift_in  }, data[31:1]} : data;
+  p1 = shamt[1] ? {rot ? p0[1:0]    : {{ 2{shift_in}}}, p0[31:2]}   : p0;
+  p2 = shamt[2] ? {rot ? p1[3:0]    : {{ 4{shift_in}}}, p1[31:4]}   : p1;
+  p3 = shamt[3] ? {rot ? p2[7:0]    : {{ 8{shift_in}}}, p2[31:8]}   : p2;
+  p4 = shamt[4] ? {rot ? p3[15:0]   : {{16{shift_in}}}, p3[31:16]}  : p3;
 
   // Reverse last to get SHL result
   r_shift = rev ? {<<{p4}} : p4;
 end
 
+// BIT COUNTERS
+always_comb begin
+  // Count trailing zeros on the shifter data.
+  // Since, the data is reversed for CLZ, this counts the leading zeros of op1
+  r_ctz = 6'd32;
+  for (int i=31; i>=0; i--) begin
+    if (data[i]) r_ctz = i[5:0];
+  end
+
+  // Population count
+  r_cpop = '0;
+  for (int i=0; i<32; i++) begin
+    r_cpop = r_cpop + {5'b0, op1[i]};
+  end
+end
+
+// BYTE OPERATIONS
+always_comb begin
+  // OR-Combine, each byte is set if any of its bits are set
+  for (int i=0; i<4; i++) begin
+    r_orcb[i*8+:8] = {8{|op1[i*8+:8]}};
+  end
+
+  // Byte reverse
+  r_rev8 = {op1[7:0], op1[15:8], op1[23:16], op1[31:24]};
+end
+
 // ============================================================
 // Result Mux
 always_comb begin
-  unique case(aluop)
+  case(aluop)
     SLT,
     SLTU        : result = {31'b0, r_comp};
     XOR         : result = r_xor;
@@ -143,6 +202,39 @@ always_comb begin
     SRA         : result = r_shift;
     default     : result = r_adder; // ADD, SUB
   endcase
+
+  if (EN_ZBB || EN_ZBS) begin
+    case(aluop)
+      XNOR        : result = r_xor;
+      ORN         : result = r_or;
+      ANDN        : result = r_and;
+      default     : ;
+    endcase
+  end
+
+  if (EN_ZBB) begin
+    case(aluop)
+      ROL,
+      ROR         : result = r_shift;
+      CLZ,
+      CTZ         : result = {26'b0, r_ctz};
+      CPOP        : result = {26'b0, r_cpop};
+      MIN,
+      MINU,
+      MAX,
+      MAXU        : result = r_minmax;
+      SEXTB       : result = {{24{op1[7]}}, op1[7:0]};
+      SEXTH       : result = {{16{op1[15]}}, op1[15:0]};
+      ZEXTH       : result = {16'b0, op1[15:0]};
+      ORCB        : result = r_orcb;
+      REV8        : result = r_rev8;
+      default     : ;
+    endcase
+  end
+
+  if (EN_ZBS) begin
+    if (aluop == BEXT) result = {31'b0, r_shift[0]};
+  end
 end
 
 endmodule
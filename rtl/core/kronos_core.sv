@@ -4,6 +4,31 @@
 /*
 Kronos 
   3-stage RISC-V RV32I_Zicsr_Zifencei Core
+  with optional Zba/Zbb/Zbs bit-manipulation
+
+DUAL_ISSUE
+  - Fetches an aligned 64b block of two instructions per cycle, over a 64b
+    wide instruction interface. The instruction address is 8B aligned.
+  - A pair of instructions is issued together, where the second is a base ALU
+    instruction and the first is an ALU, branch or load/store instruction.
+
+DEEP_PIPELINE
+  - Registers the write back and branch redirect paths, to shorten the
+    critical path: the write back is not forwarded to the decoder, and the
+    branch redirect to the fetch stage is registered. Dependent instructions
+    and jumps take one more cycle. The fmax gain on the iCE40UP5K hasn't been
+    measured yet.
+
+HART_ID
+  - The mhartid of the core, to tell the cores apart in a multi-core system.
+
+EN_RVFI
+  - Exposes the retired instructions on an RVFI style trace port, for
+    simulation tools (profilers, commit logs, lockstep checkers). The port
+    reports one instruction per retirement lane (NRET = 2 with DUAL_ISSUE or
+    EN_FUSION, else 1), in the cycle after it retires. Lane `i` occupies the i-th slice of each signal.
+  - Without EN_RVFI, the trace port is tied to zero and the logic is optimized
+    away.
 */
 
 module kronos_core 
@@ -15,13 +40,25 @@ module kronos_core
   parameter EN_COUNTERS64B = 1,
   parameter CATCH_ILLEGAL_INSTR = 1,
   parameter CATCH_MISALIGNED_JMP = 1,
-  parameter CATCH_MISALIGNED_LDST = 1
+  parameter CATCH_MISALIGNED_LDST = 1,
+  parameter EN_MISALIGNED_LDST = 0,
+  parameter EN_ZBA = 0,
+  parameter EN_ZBB = 0,
+  parameter EN_ZBS = 0,
+  parameter EN_FUSION = 0,
+  parameter DUAL_ISSUE = 0,
+  parameter DEEP_PIPELINE = 0,
+  parameter NUM_HPMCOUNTERS = 0,
+  parameter HART_ID = 0,
+  parameter EN_RVFI = 0,
+  // Retirement lanes, for a dual-issued or fused pair
+  localparam NRET = (DUAL_ISSUE || EN_FUSION) ? 2 : 1
 )(
   input  logic        clk,
   input  logic        rstz,
   // Instruction interface
   output logic [31:0] instr_addr,
-  input  logic [31:0] instr_data,
+  input  logic [32*(DUAL_ISSUE+1)-1:0] instr_data,
   output logic        instr_req,
   input  logic        instr_ack,
   // Data interface
@@ -35,7 +72,21 @@ module kronos_core
   // Interrupt sources
   input  logic        software_interrupt,
   input  logic        timer_interrupt,
-  input  logic        external_interrupt
+  input  logic        external_interrupt,
+  // Retirement trace (RVFI)
+  output logic [NRET-1:0]      rvfi_valid,
+  output logic [64*NRET-1:0]   rvfi_order,
+  output logic [32*NRET-1:0]   rvfi_insn,
+  output logic [NRET-1:0]      rvfi_trap,
+  output logic [32*NRET-1:0]   rvfi_pc_rdata,
+  output logic [32*NRET-1:0]   rvfi_pc_wdata,
+  output logic [5*NRET-1:0]    rvfi_rd_addr,
+  output logic [32*NRET-1:0]   rvfi_rd_wdata,
+  output logic [32*NRET-1:0]   rvfi_mem_addr,
+  output logic [4*NRET-1:0]    rvfi_mem_rmask,
+  output logic [4*NRET-1:0]    rvfi_mem_wmask,
+  output logic [32*NRET-1:0]   rvfi_mem_rdata,
+  output logic [32*NRET-1:0]   rvfi_mem_wdata
 );
 
 logic [31:0] immediate;
@@ -59,32 +110,73 @@ pipeIDEX_t decode;
 logic fetch_vld, fetch_rdy;
 logic decode_vld, decode_rdy;
 
+logic [31:0] lookahead;
+logic lookahead_vld, fuse;
+
+logic [31:0] immediate1;
+logic [31:0] regrd1_rs1;
+logic [31:0] regrd1_rs2;
+logic regrd1_rs1_en;
+logic regrd1_rs2_en;
+
+logic [31:0] regwr1_data;
+logic [4:0] regwr1_sel;
+logic regwr1_en;
+
+pipeIFID_t fetch1;
+pipeIDEX_t decode1;
+
+logic fetch1_vld, fetch1_rdy;
+logic decode1_vld;
+
+logic hpm_fetch_miss, hpm_fetch_stall, hpm_hazard_stall;
+
+rvfi_t rvfi, rvfi1;
+rvfi_t [NRET-1:0] rvfi_lane;
+
 // ============================================================
 // Fetch
 // ============================================================
 kronos_IF #(
   .BOOT_ADDR(BOOT_ADDR),
-  .FAST_BRANCH(FAST_BRANCH)
+  .FAST_BRANCH(FAST_BRANCH),
+  .DUAL_ISSUE(DUAL_ISSUE)
 ) u_if (
-  .clk          (clk          ),
-  .rstz         (rstz         ),
-  .instr_addr   (instr_addr   ),
-  .instr_data   (instr_data   ),
-  .instr_req    (instr_req    ),
-  .instr_ack    (instr_ack    ),
-  .fetch        (fetch        ),
-  .immediate    (immediate    ),
-  .regrd_rs1    (regrd_rs1    ),
-  .regrd_rs2    (regrd_rs2    ),
-  .regrd_rs1_en (regrd_rs1_en ),
-  .regrd_rs2_en (regrd_rs2_en ),
-  .fetch_vld    (fetch_vld    ),
-  .fetch_rdy    (fetch_rdy    ),
-  .branch_target(branch_target),
-  .branch       (branch       ),
-  .regwr_data   (regwr_data   ),
-  .regwr_sel    (regwr_sel    ),
-  .regwr_en     (regwr_en     )
+  .clk            (clk            ),
+  .rstz           (rstz           ),
+  .instr_addr     (instr_addr     ),
+  .instr_data     (instr_data     ),
+  .instr_req      (instr_req      ),
+  .instr_ack      (instr_ack      ),
+  .fetch          (fetch          ),
+  .immediate      (immediate      ),
+  .regrd_rs1      (regrd_rs1      ),
+  .regrd_rs2      (regrd_rs2      ),
+  .regrd_rs1_en   (regrd_rs1_en   ),
+  .regrd_rs2_en   (regrd_rs2_en   ),
+  .fetch_vld      (fetch_vld      ),
+  .fetch_rdy      (fetch_rdy      ),
+  .lookahead      (lookahead      ),
+  .lookahead_vld  (lookahead_vld  ),
+  .fuse           (fuse           ),
+  .fetch1         (fetch1         ),
+  .immediate1     (immediate1     ),
+  .regrd1_rs1     (regrd1_rs1     ),
+  .regrd1_rs2     (regrd1_rs2     ),
+  .regrd1_rs1_en  (regrd1_rs1_en  ),
+  .regrd1_rs2_en  (regrd1_rs2_en  ),
+  .fetch1_vld     (fetch1_vld     ),
+  .fetch1_rdy     (fetch1_rdy     ),
+  .branch_target  (branch_target  ),
+  .branch         (branch         ),
+  .regwr_data     (regwr_data     ),
+  .regwr_sel      (regwr_sel      ),
+  .regwr_en       (regwr_en       ),
+  .regwr1_data    (regwr1_data    ),
+  .regwr1_sel     (regwr1_sel     ),
+  .regwr1_en      (regwr1_en      ),
+  .hpm_fetch_miss (hpm_fetch_miss ),
+  .hpm_fetch_stall(hpm_fetch_stall)
 );
 
 // ============================================================
@@ -93,34 +185,66 @@ kronos_IF #(
 kronos_ID #(
   .CATCH_ILLEGAL_INSTR(CATCH_ILLEGAL_INSTR),
   .CATCH_MISALIGNED_JMP(CATCH_MISALIGNED_JMP),
-  .CATCH_MISALIGNED_LDST(CATCH_MISALIGNED_LDST)
+  // misaligned accesses don't trap when they are handled by the LSU
+  .CATCH_MISALIGNED_LDST(CATCH_MISALIGNED_LDST && !EN_MISALIGNED_LDST),
+  .EN_ZBA(EN_ZBA),
+  .EN_ZBB(EN_ZBB),
+  .EN_ZBS(EN_ZBS),
+  .EN_FUSION(EN_FUSION),
+  .DUAL_ISSUE(DUAL_ISSUE),
+  .DEEP_PIPELINE(DEEP_PIPELINE)
 ) u_id (
-  .clk         (clk         ),
-  .rstz        (rstz        ),
-  .flush       (flush       ),
-  .fetch       (fetch       ),
-  .immediate   (immediate   ),
-  .regrd_rs1   (regrd_rs1   ),
-  .regrd_rs2   (regrd_rs2   ),
-  .regrd_rs1_en(regrd_rs1_en),
-  .regrd_rs2_en(regrd_rs2_en),
-  .fetch_vld   (fetch_vld   ),
-  .fetch_rdy   (fetch_rdy   ),
-  .decode      (decode      ),
-  .decode_vld  (decode_vld  ),
-  .decode_rdy  (decode_rdy  ),
-  .regwr_data  (regwr_data  ),
-  .regwr_sel   (regwr_sel   ),
-  .regwr_en    (regwr_en    )
+  .clk             (clk             ),
+  .rstz            (rstz            ),
+  .flush           (flush           ),
+  .fetch           (fetch           ),
+  .immediate       (immediate       ),
+  .regrd_rs1       (regrd_rs1       ),
+  .regrd_rs2       (regrd_rs2       ),
+  .regrd_rs1_en    (regrd_rs1_en    ),
+  .regrd_rs2_en    (regrd_rs2_en    ),
+  .fetch_vld       (fetch_vld       ),
+  .fetch_rdy       (fetch_rdy       ),
+  .lookahead       (lookahead       ),
+  .lookahead_vld   (lookahead_vld   ),
+  .fuse            (fuse            ),
+  .decode          (decode          ),
+  .decode_vld      (decode_vld      ),
+  .decode_rdy      (decode_rdy      ),
+  .regwr_data      (regwr_data      ),
+  .regwr_sel       (regwr_sel       ),
+  .regwr_en        (regwr_en        ),
+  .fetch1          (fetch1          ),
+  .immediate1      (immediate1      ),
+  .regrd1_rs1      (regrd1_rs1      ),
+  .regrd1_rs2      (regrd1_rs2      ),
+  .regrd1_rs1_en   (regrd1_rs1_en   ),
+  .regrd1_rs2_en   (regrd1_rs2_en   ),
+  .fetch1_vld      (fetch1_vld      ),
+  .fetch1_rdy      (fetch1_rdy      ),
+  .decode1         (decode1         ),
+  .decode1_vld     (decode1_vld     ),
+  .regwr1_data     (regwr1_data     ),
+  .regwr1_sel      (regwr1_sel      ),
+  .regwr1_en       (regwr1_en       ),
+  .hpm_hazard_stall(hpm_hazard_stall)
 );
 
 // ============================================================
 // Execute
 // ============================================================
 kronos_EX #(
-  .BOOT_ADDR     (BOOT_ADDR),
-  .EN_COUNTERS   (EN_COUNTERS),
-  .EN_COUNTERS64B(EN_COUNTERS64B)
+  .BOOT_ADDR         (BOOT_ADDR         ),
+  .EN_COUNTERS       (EN_COUNTERS       ),
+  .EN_COUNTERS64B    (EN_COUNTERS64B    ),
+  .EN_MISALIGNED_LDST(EN_MISALIGNED_LDST),
+  .EN_ZBB            (EN_ZBB            ),
+  .EN_ZBS            (EN_ZBS            ),
+  .DUAL_ISSUE        (DUAL_ISSUE        ),
+  .DEEP_PIPELINE     (DEEP_PIPELINE     ),
+  .NUM_HPMCOUNTERS   (NUM_HPMCOUNTERS   ),
+  .HART_ID           (HART_ID           ),
+  .EN_RVFI           (EN_RVFI           )
 ) u_ex (
   .clk               (clk               ),
   .rstz              (rstz              ),
@@ -141,10 +265,55 @@ kronos_EX #(
   .data_ack          (data_ack          ),
   .software_interrupt(software_interrupt),
   .timer_interrupt   (timer_interrupt   ),
-  .external_interrupt(external_interrupt)
+  .external_interrupt(external_interrupt),
+  .hpm_fetch_miss    (hpm_fetch_miss    ),
+  .hpm_fetch_stall   (hpm_fetch_stall   ),
+  .hpm_hazard_stall  (hpm_hazard_stall  ),
+  .decode1           (decode1           ),
+  .decode1_vld       (decode1_vld       ),
+  .regwr1_data       (regwr1_data       ),
+  .regwr1_sel        (regwr1_sel        ),
+  .regwr1_en         (regwr1_en         ),
+  .rvfi              (rvfi              ),
+  .rvfi1             (rvfi1             )
 );
 
 // Flush pipeline on branch
 assign flush = branch;
 
+// ============================================================
+// Retirement Trace
+// ============================================================
+generate
+  if (NRET > 1) begin
+    assign rvfi_lane = {rvfi1, rvfi};
+  end
+  else begin
+    assign rvfi_lane = rvfi;
+
+    `ifdef verilator
+    logic _unused = &{1'b0
+      , rvfi1
+    };
+    `endif
+  end
+
+  genvar i;
+  for (i=0; i<NRET; i++) begin : gen_rvfi
+    assign rvfi_valid[i]            = rvfi_lane[i].valid;
+    assign rvfi_order[64*i+:64]     = rvfi_lane[i].order;
+    assign rvfi_insn[32*i+:32]      = rvfi_lane[i].insn;
+    assign rvfi_trap[i]             = rvfi_lane[i].trap;
+    assign rvfi_pc_rdata[32*i+:32]  = rvfi_lane[i].pc_rdata;
+    assign rvfi_pc_wdata[32*i+:32]  = rvfi_lane[i].pc_wdata;
+    assign rvfi_rd_addr[5*i+:5]     = rvfi_lane[i].rd_addr;
+    assign rvfi_rd_wdata[32*i+:32]  = rvfi_lane[i].rd_wdata;
+    assign rvfi_mem_addr[32*i+:32]  = rvfi_lane[i].mem_addr;
+    assign rvfi_mem_rmask[4*i+:4]   = rvfi_lane[i].mem_rmask;
+    assign rvfi_mem_wmask[4*i+:4]   = rvfi_lane[i].mem_wmask;
+    assign rvfi_mem_rdata[32*i+:32] = rvfi_lane[i].mem_rdata;
+    assign rvfi_mem_wdata[32*i+:32] = rvfi_lane[i].mem_wdata;
+  end
+endgenerate
+
 endmodule
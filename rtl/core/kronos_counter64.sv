@@ -7,24 +7,30 @@ Staggered 64b counter for Kronos RISC-V
 The counter is made of two 32b counters splitting the critical path
 for lower-end implementations (ex: Lattice iCE40UP)
 The upper word update is delayed by a cycle
+
+The counter can be incremented by more than 1 per cycle, up to
+2**INCR_WIDTH-1, ex: instructions retired with macro-op fusion.
 */
 
 module kronos_counter64 #(
   parameter EN_COUNTERS = 1,
-  parameter EN_COUNTERS64B = 1
+  parameter EN_COUNTERS64B = 1,
+  parameter INCR_WIDTH = 1
 )(
-  input  logic        clk,
-  input  logic        rstz,
-  input  logic        incr,
-  input  logic [31:0] load_data,
-  input  logic        load_low,
-  input  logic        load_high,
-  output logic [63:0] count,
-  output logic        count_vld
+  input  logic                  clk,
+  input  logic                  rstz,
+  input  logic [INCR_WIDTH-1:0] incr,
+  input  logic [31:0]           load_data,
+  input  logic                  load_low,
+  input  logic                  load_high,
+  output logic [63:0]           count,
+  output logic                  count_vld
 );
 
-logic [31:0] count_low, count_high;
-logic incr_high;
+// Public for the simulation harness, which skips idle cycles (kronos_sim)
+logic [31:0] count_low /*verilator public_flat*/;
+logic [31:0] count_high /*verilator public_flat*/;
+logic incr_high /*verilator public_flat*/;
 
 always_ff @(posedge clk or negedge rstz) begin
   if (~rstz) begin
@@ -39,10 +45,9 @@ always_ff @(posedge clk or negedge rstz) begin
     if (load_low) count_low <= load_data;
     else if (load_high) count_high <= load_data;
     else begin
-      if (incr) begin
-        count_low <= count_low + 1'b1;
-        // indicate that the upper word needs to increment
-        incr_high <= count_low == '1;
+      if (|incr) begin
+        // indicate that the upper word needs to increment, on carry out
+        {incr_high, count_low} <= {1'b0, count_low} + {{(33-INCR_WIDTH){1'b0}}, incr};
       end
 
       if (incr_high) count_high <= count_high + 1'b1;
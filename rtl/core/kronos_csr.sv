@@ -5,6 +5,8 @@
 Kronos RISC-V Machine-Level CSRs v1.11
 
 This is a partial implementation with the following CSRs:
+- Machine Information Registers
+  * mhartid, as per HART_ID
 - Machine Trap Setup
   * mstatus: mie, mpie, mpp
   * mie: msie, mtie, meie
@@ -18,6 +20,15 @@ This is a partial implementation with the following CSRs:
 - Machine Hardware Performance Counters
   * mcycle/mcycleh
   * minstret/minstreth
+  * mhpmcounter3..N/mhpmcounter3h..Nh, with the mhpmevent3..N selectors
+- Machine Counter Setup
+  * mcountinhibit
+
+NUM_HPMCOUNTERS
+  - Number of programmable counters (0-29), mhpmcounter3 onwards.
+  - Each counter counts the event selected by its mhpmevent (see HPM_* in
+    kronos_types). Unimplemented events count nothing.
+  - The counters are sized as per EN_COUNTERS/EN_COUNTERS64B.
 
 mtvec takes only Direct mode (mtvec.mode = 2'b00) for trap handler jumps
 
@@ -31,7 +42,9 @@ module kronos_csr
 #(
   parameter logic [31:0]  BOOT_ADDR = 32'h0,
   parameter EN_COUNTERS = 1,
-  parameter EN_COUNTERS64B = 1
+  parameter EN_COUNTERS64B = 1,
+  parameter NUM_HPMCOUNTERS = 0,
+  parameter HART_ID = 0
 )(
   input  logic        clk,
   input  logic        rstz,
@@ -42,7 +55,8 @@ module kronos_csr
   output logic [31:0] csr_data,
   output logic        regwr_csr,
   // Trackers
-  input  logic        instret,
+  input  logic [1:0]  instret,
+  input  logic [15:0] hpm_event,
   // trap handling
   input  logic        activate_trap,
   input  logic        return_trap,
@@ -93,13 +107,24 @@ struct packed {
 logic [31:0] mscratch, mepc, mcause, mtval;
 
 logic mcycle_wrenl, mcycle_wrenh;
+logic mcycle_incr;
 logic mcycle_rd_vld;
 logic [63:0] mcycle;
 
 logic minstret_wrenl, minstret_wrenh;
+logic [1:0] minstret_incr;
 logic minstret_rd_vld;
 logic [63:0] minstret;
 
+// Counter inhibit: CY, IR and HPM3..N
+localparam logic [31:0] INHIBIT_MASK = 32'h5 | (((32'h1 << NUM_HPMCOUNTERS) - 1) << 3);
+logic [31:0] mcountinhibit;
+
+localparam NHPM = NUM_HPMCOUNTERS > 0 ? NUM_HPMCOUNTERS : 1;
+logic [3:0] mhpmevent [NHPM];
+logic [63:0] mhpmcounter [NHPM];
+logic [NHPM-1:0] mhpmcounter_rd_vld;
+
 enum logic [1:0] {
   IDLE,
   READ,
@@ -155,7 +180,7 @@ end
 
 // CSR R/W ----------------------------------------------------
 // aggregate all read-valid sources
-assign csr_rd_vld = mcycle_rd_vld && minstret_rd_vld;
+assign csr_rd_vld = mcycle_rd_vld && minstret_rd_vld && &mhpmcounter_rd_vld;
 
 // CSR read/write access
 assign csr_rd_en = state == READ && csr_rd_vld;
@@ -198,6 +223,8 @@ always_comb begin
       csr_rd_data[11] = mie.meie;
     end
 
+    MHARTID   : csr_rd_data = 32'(HART_ID);
+
     MTVEC     : csr_rd_data = mtvec;
     MSCRATCH  : csr_rd_data = mscratch;
     MEPC      : csr_rd_data = mepc;
@@ -214,8 +241,16 @@ always_comb begin
     MINSTRET  : csr_rd_data = minstret[31:0];
     MCYCLEH   : csr_rd_data = mcycle[63:32];
     MINSTRETH : csr_rd_data = minstret[63:32];
+
+    MCOUNTINHIBIT : csr_rd_data = mcountinhibit;
   endcase // addr
   /* verilator lint_on CASEINCOMPLETE */
+
+  for (int i=0; i<NUM_HPMCOUNTERS; i++) begin
+    if (addr == MHPMCOUNTER3 + 12'(i)) csr_rd_data = mhpmcounter[i][31:0];
+    if (addr == MHPMCOUNTER3H + 12'(i)) csr_rd_data = mhpmcounter[i][63:32];
+    if (addr == MHPMEVENT3 + 12'(i)) csr_rd_data = {28'b0, mhpmevent[i]};
+  end
 end
 
 // ============================================================
@@ -241,6 +276,7 @@ always_ff @(posedge clk or negedge rstz) begin
     mie <= '0;
     mtvec.base <= BOOT_ADDR[31:2];
     mtvec.mode <= DIRECT_MODE; // Direct Mode
+    mcountinhibit <= '0;
   end
   else begin
     // Machine-mode writable registers
@@ -280,6 +316,9 @@ always_ff @(posedge clk or negedge rstz) begin
         // Trap value register
         MTVAL: mtval <= csr_wr_data;
 
+        // Stop counters, only the implemented ones are writable
+        MCOUNTINHIBIT: mcountinhibit <= csr_wr_data & INHIBIT_MASK;
+
       endcase // addr
       /* verilator lint_on CASEINCOMPLETE */
     end
@@ -331,6 +370,7 @@ end
 // Hardware Performance Monitors
 
 // mcycle, 64b Machine cycle counter
+assign mcycle_incr = ~mcountinhibit[0];
 assign mcycle_wrenl = csr_wr_en && addr == MCYCLE;
 assign mcycle_wrenh = csr_wr_en && addr == MCYCLEH;
 
@@ -340,7 +380,7 @@ kronos_counter64 #(
 ) u_hpmcounter0 (
   .clk      (clk          ),
   .rstz     (rstz         ),
-  .incr     (1'b1         ),
+  .incr     (mcycle_incr  ),
   .load_data(csr_wr_data  ),
   .load_low (mcycle_wrenl ),
   .load_high(mcycle_wrenh ),
@@ -349,16 +389,18 @@ kronos_counter64 #(
 );
 
 // minstret, 64b Machine instructions-retired counter
+assign minstret_incr = mcountinhibit[2] ? 2'b0 : instret;
 assign minstret_wrenl = csr_wr_en && addr == MINSTRET;
 assign minstret_wrenh = csr_wr_en && addr == MINSTRETH;
 
 kronos_counter64 #(
   .EN_COUNTERS   (EN_COUNTERS),
-  .EN_COUNTERS64B(EN_COUNTERS64B)
+  .EN_COUNTERS64B(EN_COUNTERS64B),
+  .INCR_WIDTH    (2)
 ) u_hpmcounter1 (
   .clk      (clk            ),
   .rstz     (rstz           ),
-  .incr     (instret        ),
+  .incr     (minstret_incr  ),
   .load_data(csr_wr_data    ),
   .load_low (minstret_wrenl ),
   .load_high(minstret_wrenh ),
@@ -366,10 +408,53 @@ kronos_counter64 #(
   .count_vld(minstret_rd_vld)
 );
 
+// mhpmcounter3..N, programmable event counters
+generate
+  genvar i;
+  for (i=0; i<NUM_HPMCOUNTERS; i++) begin : gen_hpm
+    logic incr;
+    logic wrenl, wrenh;
+
+    // Event selector, WARL
+    always_ff @(posedge clk or negedge rstz) begin
+      if (~rstz) mhpmevent[i] <= HPM_NONE;
+      else if (csr_wr_en && addr == MHPMEVENT3 + 12'(i)) mhpmevent[i] <= csr_wr_data[3:0];
+    end
+
+    assign incr = hpm_event[mhpmevent[i]] & ~mcountinhibit[3+i];
+
+    assign wrenl = csr_wr_en && addr == MHPMCOUNTER3 + 12'(i);
+    assign wrenh = csr_wr_en && addr == MHPMCOUNTER3H + 12'(i);
+
+    kronos_counter64 #(
+      .EN_COUNTERS   (EN_COUNTERS),
+      .EN_COUNTERS64B(EN_COUNTERS64B)
+    ) u_hpmcounter (
+      .clk      (clk                  ),
+      .rstz     (rstz                 ),
+      .incr     (incr                 ),
+      .load_data(csr_wr_data          ),
+      .load_low (wrenl                ),
+      .load_high(wrenh                ),
+      .count    (mhpmcounter[i]       ),
+      .count_vld(mhpmcounter_rd_vld[i])
+    );
+  end
+
+  if (NUM_HPMCOUNTERS == 0) begin
+    assign mhpmevent[0] = HPM_NONE;
+    assign mhpmcounter[0] = '0;
+    assign mhpmcounter_rd_vld = 1'b1;
+  end
+endgenerate
+
 // ------------------------------------------------------------
 `ifdef verilator
 logic _unused = &{1'b0
   , decode
+  , hpm_event[0]
+  , mhpmevent[0]
+  , mhpmcounter[0]
 };
 `endif
 
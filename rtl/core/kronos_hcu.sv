@@ -6,11 +6,25 @@ Kronos Hazard Control Unit
 
 Minimalist HCU to detect pending writes on an operand and assert a STALL
 condition that halts the pipeline.
+
+DUAL_ISSUE
+  - Tracks the pending write of the second instruction of an issued pair.
+  - Detects hazards for the second instruction in the fetch block, against
+    pending writes. The decoder doesn't pair it, if there's a hazard (STALL1).
+  - Dependencies within the pair are resolved by the decoder.
+
+DEEP_PIPELINE
+  - The decoder doesn't forward the write back. Hence, a pending write is only
+    cleared for the operands in the cycle after the write back, when the
+    register file has latched it.
 */
 
 module kronos_hcu 
   import kronos_types::*;
-(
+#(
+  parameter DUAL_ISSUE = 0,
+  parameter DEEP_PIPELINE = 0
+)(
   input  logic        clk,
   input  logic        rstz,
   input  logic        flush,
@@ -24,7 +38,15 @@ module kronos_hcu
   input  logic [4:0]  regwr_sel,
   input  logic        regwr_en,
   // Stall
-  output logic        stall
+  output logic        stall,
+  // Second instruction
+  input  logic [31:0] instr1,
+  input  logic        regrd1_rs1_en,
+  input  logic        regrd1_rs2_en,
+  input  logic        pair,
+  input  logic [4:0]  regwr1_sel,
+  input  logic        regwr1_en,
+  output logic        stall1
 );
 
 logic [4:0] OP;
@@ -36,6 +58,11 @@ logic is_reg_write, csr_regwr;
 logic regwr_pending;
 logic rs1_hazard, rs2_hazard;
 logic [4:0] rpend;
+logic wait0, wait1;
+
+logic [4:0] rs1_1, rs2_1, rd1;
+logic regwr1_pending;
+logic [4:0] rpend1;
 
 // ============================================================
 // Hazard Tracking and Control
@@ -65,13 +92,18 @@ assign csr_regwr = OP == INSTR_SYS && (funct3 == 3'b001
                     || funct3 == 3'b110
                     || funct3 == 3'b111);
 
+// Pending write that isn't written back in this cycle
+// (or at all, if the write back isn't forwarded)
+assign wait0 = regwr_pending & (DEEP_PIPELINE | ~(regwr_en & rpend == regwr_sel));
+assign wait1 = regwr1_pending & (DEEP_PIPELINE | ~(regwr1_en & rpend1 == regwr1_sel));
+
 // Hazard on register operands
-assign rs1_hazard = regrd_rs1_en & regwr_pending & rpend == rs1;
-assign rs2_hazard = regrd_rs2_en & regwr_pending & rpend == rs2;
+assign rs1_hazard = regrd_rs1_en & ((wait0 & rpend == rs1) | (wait1 & rpend1 == rs1));
+assign rs2_hazard = regrd_rs2_en & ((wait0 & rpend == rs2) | (wait1 & rpend1 == rs2));
 
 // Stall condition if either operand has a hazard,
 // and register write back isn't ready
-assign stall = (rs1_hazard | rs2_hazard) & ~(regwr_en & rpend == regwr_sel);
+assign stall = rs1_hazard | rs2_hazard;
 
 always_ff @(posedge clk or negedge rstz) begin
   if (~rstz) begin
@@ -91,11 +123,57 @@ always_ff @(posedge clk or negedge rstz) begin
   end
 end
 
+// ============================================================
+// Second instruction
+generate
+  if (DUAL_ISSUE) begin
+    assign rs1_1 = instr1[19:15];
+    assign rs2_1 = instr1[24:20];
+    assign rd1 = instr1[11:7];
+
+    assign stall1 = (regrd1_rs1_en & ((wait0 & rpend == rs1_1) | (wait1 & rpend1 == rs1_1)))
+                  | (regrd1_rs2_en & ((wait0 & rpend == rs2_1) | (wait1 & rpend1 == rs2_1)));
+
+    // Paired instructions are only ALU ops, which always write back to rd
+    always_ff @(posedge clk or negedge rstz) begin
+      if (~rstz) begin
+        regwr1_pending <= 1'b0;
+      end
+      else begin
+        if (flush) begin
+          regwr1_pending <= 1'b0;
+        end
+        else if(fetch_vld && fetch_rdy) begin
+          regwr1_pending <= pair && rd1 != '0;
+          rpend1 <= rd1;
+        end
+        else if(regwr1_pending) begin
+          regwr1_pending <= ~(regwr1_en & rpend1 == regwr1_sel);
+        end
+      end
+    end
+  end
+  else begin
+    assign rs1_1 = '0;
+    assign rs2_1 = '0;
+    assign rd1 = '0;
+    assign stall1 = 1'b0;
+    assign regwr1_pending = 1'b0;
+    assign rpend1 = '0;
+  end
+endgenerate
+
 // ------------------------------------------------------------
 `ifdef verilator
 logic _unused = &{1'b0
     , instr[1:0]
     , instr[31:25]
+    , instr1
+    , regrd1_rs1_en
+    , regrd1_rs2_en
+    , pair
+    , regwr1_sel
+    , regwr1_en
 };
 `endif
 
@@ -7,13 +7,25 @@ Kronos Load Store Unit
 Control unit that interfaces with "Data" memory and fulfills
 Load/Store instructions
 
-Memory Access needs to be aligned.
-
+Memory Access needs to be aligned, unless EN_MISALIGNED_LDST is set.
+
+EN_MISALIGNED_LDST
+  - A misaligned access that crosses a word boundary is split into two
+    word transactions. The first access covers the bytes in the lower word,
+    and the second covers the rest in the next word.
+  - Loads latch the first word and merge it with the second.
+  - Stores reuse the rotated store data for both words, and only the
+    write mask is split.
+  - Misaligned accesses within a word are still single transactions.
 */
 
 module kronos_lsu
   import kronos_types::*;
-(
+#(
+  parameter EN_MISALIGNED_LDST = 0
+)(
+  input  logic        clk,
+  input  logic        rstz,
   // ID/EX
   input  pipeIDEX_t   decode,
   input  logic        lsu_vld,
@@ -37,8 +49,16 @@ logic [1:0] data_size;
 logic load_uns;
 
 logic [3:0][7:0] ldata;
+logic [3:0][7:0] rdata;
 logic [31:0] word_data, half_data, byte_data;
 
+// Split access
+logic [3:0] size_mask;
+logic [7:0] span_mask;
+logic split;
+logic second;
+logic [3:0][7:0] first_data;
+
 // ============================================================
 // IR Segments
 assign byte_addr = decode.addr[1:0];
@@ -46,16 +66,56 @@ assign data_size = decode.ir[13:12];
 assign load_uns = decode.ir[14];
 assign rd  = decode.ir[11:7];
 
+// ============================================================
+// Split Access
+
+// Bytes touched by the access, across two words
+always_comb begin
+  if (data_size == BYTE) size_mask = 4'h1;
+  else if (data_size == HALF) size_mask = 4'h3;
+  else size_mask = 4'hF;
+
+  span_mask = {4'h0, size_mask} << byte_addr;
+end
+
+generate
+  if (EN_MISALIGNED_LDST) begin
+    // The access spills into the next word
+    assign split = |span_mask[7:4];
+
+    // Tracks the second transaction of a split access
+    always_ff @(posedge clk or negedge rstz) begin
+      if (~rstz) second <= 1'b0;
+      else if (data_ack) second <= split & ~second;
+    end
+
+    // Stow the (rotated) first word of a split load
+    always_ff @(posedge clk) begin
+      if (data_ack && ~second) first_data <= rdata;
+    end
+  end
+  else begin
+    assign split = 1'b0;
+    assign second = 1'b0;
+    assign first_data = '0;
+  end
+endgenerate
+
 // ============================================================
 // Memory interface
-assign data_addr = {decode.addr[31:2], 2'b0};
+assign data_addr = second ? {decode.addr[31:2] + 1'b1, 2'b0} : {decode.addr[31:2], 2'b0};
 assign data_wr_data = decode.op2;
-assign data_mask = decode.mask;
 assign data_wr_en = lsu_vld && decode.store && ~data_ack;
 assign data_req = lsu_vld && (decode.load | decode.store) && ~data_ack;
 
+always_comb begin
+  // Store mask is split across the two words of the access
+  if (EN_MISALIGNED_LDST && decode.store) data_mask = second ? span_mask[7:4] : span_mask[3:0];
+  else data_mask = decode.mask;
+end
+
 // response controls
-assign lsu_rdy = data_ack;
+assign lsu_rdy = data_ack && (~split || second);
 assign regwr_lsu = decode.load && rd != '0;
 
 // ============================================================
@@ -67,13 +127,24 @@ assign ldata = data_rd_data;
 always_comb begin
   // Barrel Rotate Right read data bytes as per offset
   case(byte_addr)
-    2'b00: word_data = ldata;
-    2'b01: word_data = {ldata[0]  , ldata[3:1]};
-    2'b10: word_data = {ldata[1:0], ldata[3:2]};
-    2'b11: word_data = {ldata[2:0], ldata[3]};
+    2'b00: rdata = ldata;
+    2'b01: rdata = {ldata[0]  , ldata[3:1]};
+    2'b10: rdata = {ldata[1:0], ldata[3:2]};
+    2'b11: rdata = {ldata[2:0], ldata[3]};
   endcase
 end
 
+always_comb begin
+  // Merge the split load. The lower bytes come from the first word,
+  // and the bytes that wrapped around come from the second word
+  word_data = rdata;
+  if (split) begin
+    for (int i=0; i<4; i++) begin
+      if (i < 4 - byte_addr) word_data[i*8+:8] = first_data[i];
+    end
+  end
+end
+
 always_comb begin
   // select BYTE data, sign extend if needed
   if (load_uns) byte_data = {24'b0, word_data[7:0]};
@@ -96,6 +167,8 @@ end
 `ifdef verilator
 logic _unused = &{1'b0
   , decode
+  , clk
+  , rstz
 };
 `endif
 
@@ -21,7 +21,9 @@ typedef struct packed {
     // ------------------------
     // EX controls
     logic        basic;
-    logic [3:0]  aluop;
+    logic        fused;
+    logic [31:0] fuse_ir;   // first instruction of a fused pair, for the trace
+    logic [4:0]  aluop;
     logic        regwr_alu;
     logic        jump;
     logic        branch;
@@ -36,6 +38,23 @@ typedef struct packed {
     logic        misaligned_ldst;
 } pipeIDEX_t;
 
+// Retired instruction, RVFI style
+typedef struct packed {
+    logic        valid;
+    logic [63:0] order;
+    logic [31:0] insn;
+    logic        trap;
+    logic [31:0] pc_rdata;
+    logic [31:0] pc_wdata;
+    logic [4:0]  rd_addr;
+    logic [31:0] rd_wdata;
+    logic [31:0] mem_addr;
+    logic [3:0]  mem_rmask;
+    logic [3:0]  mem_wmask;
+    logic [31:0] mem_rdata;
+    logic [31:0] mem_wdata;
+} rvfi_t;
+
 // ============================================================
 // Instruction Types: {opcode[6:2]}
 parameter logic [4:0] INSTR_LOAD  = 5'b00_000;
@@ -56,16 +75,38 @@ parameter logic [4:0] INSTR_LUI   = 5'b01_101;
 
 // ============================================================
 // ALU Operations
-parameter logic [3:0] ADD       = 4'b0000;
-parameter logic [3:0] SUB       = 4'b1000;
-parameter logic [3:0] SLT       = 4'b0010;
-parameter logic [3:0] SLTU      = 4'b0011;
-parameter logic [3:0] XOR       = 4'b0100;
-parameter logic [3:0] OR        = 4'b0110;
-parameter logic [3:0] AND       = 4'b0111;
-parameter logic [3:0] SLL       = 4'b0001;
-parameter logic [3:0] SRL       = 4'b0101;
-parameter logic [3:0] SRA       = 4'b1101;
+parameter logic [4:0] ADD       = 5'b00000;
+parameter logic [4:0] SUB       = 5'b01000;
+parameter logic [4:0] SLT       = 5'b00010;
+parameter logic [4:0] SLTU      = 5'b00011;
+parameter logic [4:0] XOR       = 5'b00100;
+parameter logic [4:0] OR        = 5'b00110;
+parameter logic [4:0] AND       = 5'b00111;
+parameter logic [4:0] SLL       = 5'b00001;
+parameter logic [4:0] SRL       = 5'b00101;
+parameter logic [4:0] SRA       = 5'b01101;
+
+// Zbb/Zbs - logic with negate, shares the encoding space with the base ops
+parameter logic [4:0] XNOR      = 5'b01100;
+parameter logic [4:0] ORN       = 5'b01110;
+parameter logic [4:0] ANDN      = 5'b01111;
+
+// Zbb/Zbs - extended operations
+parameter logic [4:0] CLZ       = 5'b10000;
+parameter logic [4:0] ROL       = 5'b10001;
+parameter logic [4:0] CPOP      = 5'b10010;
+parameter logic [4:0] ZEXTH     = 5'b10011;
+parameter logic [4:0] CTZ       = 5'b10100;
+parameter logic [4:0] ROR       = 5'b10101;
+parameter logic [4:0] SEXTB     = 5'b10110;
+parameter logic [4:0] SEXTH     = 5'b10111;
+parameter logic [4:0] ORCB      = 5'b11000;
+parameter logic [4:0] REV8      = 5'b11001;
+parameter logic [4:0] MIN       = 5'b11010;
+parameter logic [4:0] MINU      = 5'b11011;
+parameter logic [4:0] BEXT      = 5'b11101;
+parameter logic [4:0] MAX       = 5'b11110;
+parameter logic [4:0] MAXU      = 5'b11111;
 
 // ============================================================
 // Branch Operations
@@ -122,6 +163,8 @@ parameter logic [1:0]  CSR_RS       = 2'b10;
 parameter logic [1:0]  CSR_RC       = 2'b11;
 
 // CSR Address
+parameter logic [11:0] MHARTID      = 12'hF14;
+
 parameter logic [11:0] MSTATUS      = 12'h300;
 parameter logic [11:0] MIE          = 12'h304;
 parameter logic [11:0] MTVEC        = 12'h305;
@@ -132,10 +175,28 @@ parameter logic [11:0] MCAUSE       = 12'h342;
 parameter logic [11:0] MTVAL        = 12'h343;
 parameter logic [11:0] MIP          = 12'h344;
 
+parameter logic [11:0] MCOUNTINHIBIT = 12'h320;
+parameter logic [11:0] MHPMEVENT3   = 12'h323;
+
 parameter logic [11:0] MCYCLE       = 12'hB00;
 parameter logic [11:0] MINSTRET     = 12'hB02;
 parameter logic [11:0] MCYCLEH      = 12'hB80;
 parameter logic [11:0] MINSTRETH    = 12'hB82;
+parameter logic [11:0] MHPMCOUNTER3 = 12'hB03;
+parameter logic [11:0] MHPMCOUNTER3H= 12'hB83;
+
+// Hardware performance monitor events, mhpmevent selectors
+parameter logic [3:0] HPM_NONE          = 4'd0;
+parameter logic [3:0] HPM_FETCH_MISS    = 4'd1;  // IF waiting on the instruction memory
+parameter logic [3:0] HPM_FETCH_STALL   = 4'd2;  // IF holding a fetched instruction in the skid buffer
+parameter logic [3:0] HPM_HAZARD_STALL  = 4'd3;  // ID stalled by the HCU
+parameter logic [3:0] HPM_BRANCH        = 4'd4;  // taken branches
+parameter logic [3:0] HPM_JUMP          = 4'd5;  // jumps
+parameter logic [3:0] HPM_LOAD          = 4'd6;  // loads retired
+parameter logic [3:0] HPM_STORE         = 4'd7;  // stores retired
+parameter logic [3:0] HPM_LSU_WAIT      = 4'd8;  // EX waiting on the data memory
+parameter logic [3:0] HPM_CSR           = 4'd9;  // CSR instructions retired
+parameter logic [3:0] HPM_TRAP          = 4'd10; // traps taken (exceptions and interrupts)
 
 // Privilege levels
 parameter logic [1:0] PRIVILEGE_MACHINE = 2'b11;
@@ -3,11 +3,16 @@
 
 /*
 
-8-bit Full-Duplex SPI Master
+8-bit Full-Duplex SPI Master, with Dual/Quad SPI
 
 - Control and status
     * CPOL/CPHA (All SPI Modes Supported)
     * SPI clock rate = clk/(2 * prescaler+1)
+- Width of each byte, latched at its start
+    * Single: full duplex, MOSI on io0 and MISO on io1. io2/io3 (WP/HOLD
+      of a flash) are held high
+    * Dual/Quad: 2/4 bits per clock on io0-1/io0-3, MSB on the highest io.
+      Half duplex, either writing din or reading dout
 
 The SCLK sets its idle value based on CPOL
 
@@ -20,12 +25,15 @@ module spi_master #(
     input  logic        rstz,
     // SPI PHY
     output logic        sclk,
-    output logic        mosi,
-    input  logic        miso,
+    output logic [3:0]  io_out,
+    output logic [3:0]  io_oe,
+    input  logic [3:0]  io_in,
     // Config
     input  logic [PRESCALER_WIDTH-1:0] prescaler,
     input  logic        cpol,
     input  logic        cpha,
+    input  logic [1:0]  width,  // 0: single, 1: dual, 2: quad
+    input  logic        rd,     // dual/quad read
     // Data interface
     input  logic [7:0]  din,
     input  logic        din_vld,
@@ -41,11 +49,14 @@ logic [4:0] state;
 logic init, done, active;
 
 logic [7:0] tx_buffer, rx_buffer;
+logic [1:0] bw;
+logic brd;
+logic [4:0] last;
 
 // ============================================================
 // SPI Master Sequencer
 
-// 17-state counter that starts when there's data to transmit,
+// Up to 17-state counter that starts when there's data to transmit,
 // and counts up on SPI ticks.
 always_ff @(posedge clk or negedge rstz) begin
     if (~rstz) state <= '0;
@@ -56,7 +67,22 @@ end
 // sequence control signals
 assign active = state != '0;
 assign init = din_vld && state == '0;
-assign done = state == 5'd16 && tick;
+assign done = state == last && tick;
+
+// A byte is 16, 8 or 4 SPI ticks wide
+assign last = 5'd16 >> bw;
+
+// Byte width and direction, held until the next byte
+always_ff @(posedge clk or negedge rstz) begin
+    if (~rstz) begin
+        bw <= '0;
+        brd <= 1'b0;
+    end
+    else if (init) begin
+        bw <= width;
+        brd <= rd;
+    end
+end
 
 // inform host to prepare the next byte
 assign din_rdy = init;
@@ -92,10 +118,25 @@ end
 always_ff @(posedge clk or negedge rstz) begin
     if (~rstz) tx_buffer <= '0;
     else if (init) tx_buffer <= din;
-    else if (tick && ~state[0]) tx_buffer <= tx_buffer << 1;
+    else if (tick && ~state[0]) tx_buffer <= tx_buffer << (3'd1 << bw);
 end
 
-assign mosi = tx_buffer[7];
+always_comb begin
+    case (bw)
+        2'd1: begin
+            io_out = {2'b11, tx_buffer[7:6]};
+            io_oe = brd ? 4'b1100 : 4'b1111;
+        end
+        2'd2: begin
+            io_out = tx_buffer[7:4];
+            io_oe = brd ? 4'b0000 : 4'b1111;
+        end
+        default: begin
+            io_out = {2'b11, 1'b0, tx_buffer[7]};
+            io_oe = 4'b1101;
+        end
+    endcase
+end
 
 // ============================================================
 // SPI MISO
@@ -104,7 +145,13 @@ assign mosi = tx_buffer[7];
 always_ff @(posedge clk or negedge rstz) begin
     if (~rstz) rx_buffer <= '0;
     else if (init) rx_buffer <= '0;
-    else if (tick && state[0] && ~done) rx_buffer <= {rx_buffer[6:0], miso};
+    else if (tick && state[0] && ~done) begin
+        case (bw)
+            2'd1: rx_buffer <= {rx_buffer[5:0], io_in[1:0]};
+            2'd2: rx_buffer <= {rx_buffer[3:0], io_in[3:0]};
+            default: rx_buffer <= {rx_buffer[6:0], io_in[1]};
+        endcase
+    end
 end
 
 assign dout = rx_buffer;
@@ -26,7 +26,9 @@
 // updates output signals 1ns after the SPI clock edge.
 //
 // Supported commands:
-//    AB, B9, FF, 03, BB, EB, ED
+//    AB, B9, FF, 03, 0B, 3B, BB, EB, ED
+//
+// The dummy clocks of BB/EB/ED are set by the latency parameter
 //
 // Well written SPI flash data sheets:
 //    Cypress S25FL064L http://www.cypress.com/file/316661/download
@@ -45,7 +47,7 @@ module spiflash (
     inout io3
 );
     localparam verbose = 0;
-    localparam integer latency = 8;
+    parameter integer latency = 8;
     
     reg [7:0] buffer;
     integer bitcount = 0;
@@ -141,6 +143,43 @@ module spiflash (
                 end
             end
 
+            if (powered_up && spi_cmd == 'h 0b) begin
+                if (bytecount == 2)
+                    spi_addr[23:16] = buffer;
+
+                if (bytecount == 3)
+                    spi_addr[15:8] = buffer;
+
+                if (bytecount == 4) begin
+                    spi_addr[7:0] = buffer;
+                    dummycount = 8;
+                end
+
+                if (bytecount >= 4) begin
+                    buffer = memory[spi_addr];
+                    spi_addr = spi_addr + 1;
+                end
+            end
+
+            if (powered_up && spi_cmd == 'h 3b) begin
+                if (bytecount == 2)
+                    spi_addr[23:16] = buffer;
+
+                if (bytecount == 3)
+                    spi_addr[15:8] = buffer;
+
+                if (bytecount == 4) begin
+                    spi_addr[7:0] = buffer;
+                    mode = mode_dspi_wr;
+                    dummycount = 8;
+                end
+
+                if (bytecount >= 4) begin
+                    buffer = memory[spi_addr];
+                    spi_addr = spi_addr + 1;
+                end
+            end
+
             if (powered_up && spi_cmd == 'h bb) begin
                 if (bytecount == 1)
                     mode = mode_dspi_rd;
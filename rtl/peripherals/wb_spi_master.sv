@@ -3,19 +3,32 @@
 
 /*
 
-8-bit Full-Duplex SPI Master with RX/TX Queue
+8-bit Full-Duplex SPI Master with RX/TX Queue, and Dual/Quad SPI transfers
 
-- Wishbone slave, 8b data bus
+- Wishbone slave, 32b data bus with byte select
+    * A write queues the selected bytes, lowest lane first
+    * A read drains a byte from the RX Queue into each selected lane
 - Control and status
     * CPOL/CPHA (All SPI Modes Supported)
     * SPI clock rate = clk/(2 * prescaler+1)
     * clear TX/RX Queue
     * Size of the TX/RX Queue
-- Peek at RX Queue without reading it
-- No Chip Select - implementation left to the Host
+- Transfers of a given length (burst)
+    * Runs N bytes, sending the TX Queue, or 0x00 once it is empty
+    * Only starts a byte if there's room for it in the RX Queue
+    * Single (full duplex), or Dual/Quad SPI. A Dual/Quad transfer either
+      writes the TX Queue, or reads into the RX Queue
+    * Active-low chip select, from the start to the end of the transfer.
+      It can be held for the next transfer. A transfer of length 0 just
+      sets the chip select (hold) or releases it
+- Unless in transfer mode, the TX Queue is also sent as it is filled
+  without a burst, and the chip select is left to the Host
 
 Wishbone slave interface
-    - Registered Feedback Bus Cycle, Advanced
+    - Pipelined (B4), one access at a time. The ack is registered, with
+      the read data, a cycle per selected byte lane after the strobe: in
+      the next cycle for a byte, and after 4 cycles for a word. The master
+      doesn't strobe again until the ack (see krz_sysbus)
 
 */
 
@@ -27,8 +40,9 @@ module wb_spi_master #(
     input  logic        rstz,
     // SPI PHY
     output logic        sclk,
-    output logic        mosi,
-    input  logic        miso,
+    output logic [3:0]  io_out,
+    output logic [3:0]  io_oe,
+    input  logic [3:0]  io_in,
     // Control and Status
     input  logic [PRESCALER_WIDTH-1:0]  prescaler,
     input  logic                        cpol,
@@ -37,15 +51,40 @@ module wb_spi_master #(
     input  logic                        rx_clear,
     output logic [$clog2(BUFFER):0]     tx_size,
     output logic [$clog2(BUFFER):0]     rx_size,
+    // Transfer
+    input  logic                        xfer_mode,
+    input  logic [15:0]                 xfer_len,
+    input  logic                        xfer_hold,
+    input  logic [1:0]                  xfer_width,
+    input  logic                        xfer_rd,
+    input  logic                        xfer_start,
+    output logic [15:0]                 xfer_left,
+    output logic                        xfer_busy,
+    output logic                        csn,
     // data interface
-    input  logic [7:0]  dat_i,
-    output logic [7:0]  dat_o,
+    input  logic [31:0] dat_i,
+    output logic [31:0] dat_o,
+    input  logic [3:0]  sel_i,
     input  logic        we_i,
     input  logic        stb_i,
     output logic        ack_o
 );
 
-logic txq_ack;
+logic ack;
+
+logic [3:0] sel, lane, lanes;
+logic [31:0] wdata;
+logic [7:0] wbyte;
+logic we, access_we, last;
+
+logic [15:0] left;
+logic burst, hold, room;
+logic [1:0] width, phy_width;
+logic rd, wide_rd, wide_wr;
+
+logic phy_din_vld, phy_din_rdy;
+logic [7:0] phy_din, phy_dout;
+logic phy_dout_vld;
 
 logic txq_full, txq_empty;
 logic [$clog2(BUFFER):0] txq_size;
@@ -54,8 +93,6 @@ logic txq_din_vld, txq_din_rdy;
 logic txq_dout_vld, txq_dout_rdy;
 logic [7:0] txq_din, txq_dout;
 
-logic rxq_ack;
-
 logic rxq_full, rxq_empty;
 logic [$clog2(BUFFER):0] rxq_size;
 
@@ -87,8 +124,8 @@ fifo #(
     .dout_rdy(txq_dout_rdy)
 );
 
-assign txq_din = dat_i;
-assign txq_din_vld = stb_i & we_i & txq_ack;
+assign txq_din = wbyte;
+assign txq_din_vld = lane != '0 && access_we;
 
 // ============================================================
 // RX Queue
@@ -113,21 +150,49 @@ fifo #(
     .dout_rdy(rxq_dout_rdy)
 );
 
-assign dat_o = rxq_dout;
-assign rxq_dout_rdy = stb_i & ~we_i & rxq_ack;
+assign rxq_dout_rdy = lane != '0 && ~access_we;
 
 // ============================================================
 // Host Interface
+// A byte lane is accessed per cycle, starting with the strobe
+
+// The access in the strobe cycle, or the rest of the selected lanes
+always_comb begin
+    sel = stb_i ? sel_i : lanes;
+    access_we = stb_i ? we_i : we;
+
+    // lowest selected lane
+    lane = sel & (~sel + 1'b1);
+    last = (sel & ~lane) == '0;
+
+    wbyte = '0;
+    for (int i=0; i<4; i++) begin
+        if (lane[i]) wbyte = stb_i ? dat_i[i*8 +: 8] : wdata[i*8 +: 8];
+    end
+end
 
-// register the Read/Write ACK, always ack
+// register the Read/Write ACK and read data, ack after the last lane
 always_ff @(posedge clk or negedge rstz) begin
     if (~rstz) begin
-        txq_ack <= 1'b0;
-        rxq_ack <= 1'b0;
+        ack <= 1'b0;
+        dat_o <= '0;
+        lanes <= '0;
+        wdata <= '0;
+        we <= 1'b0;
     end
     else begin
-        txq_ack <= stb_i & we_i;
-        rxq_ack <= stb_i & ~we_i;
+        ack <= (stb_i || lanes != '0) && last;
+        lanes <= sel & ~lane;
+
+        if (stb_i) begin
+            wdata <= dat_i;
+            we <= we_i;
+            if (~we_i) dat_o <= '0;
+        end
+
+        for (int i=0; i<4; i++) begin
+            if (lane[i] && ~access_we) dat_o[i*8 +: 8] <= rxq_dout;
+        end
     end
 end
 
@@ -135,8 +200,69 @@ end
 assign tx_size = txq_size;
 assign rx_size = rxq_size;
 
-// Advanced synchronous terminated burst
-assign ack_o = stb_i & (txq_ack | rxq_ack);
+assign ack_o = ack;
+
+// ============================================================
+// Transfer
+// Counts down the bytes started by the phy, and the chip select is released
+// when the last one is received
+
+always_ff @(posedge clk or negedge rstz) begin
+    if (~rstz) begin
+        left <= '0;
+        burst <= 1'b0;
+        hold <= 1'b0;
+        width <= '0;
+        rd <= 1'b0;
+        csn <= 1'b1;
+    end
+    else if (xfer_start) begin
+        left <= xfer_len;
+        hold <= xfer_hold;
+        width <= xfer_width;
+        rd <= xfer_rd;
+        burst <= xfer_len != '0;
+        csn <= xfer_len == '0 && ~xfer_hold;
+    end
+    else if (burst) begin
+        if (phy_din_rdy) left <= left - 1'b1;
+
+        if (left == '0 && phy_dout_vld) begin
+            burst <= 1'b0;
+            csn <= ~hold;
+        end
+    end
+end
+
+// Dual/Quad is half duplex. A read doesn't send the TX Queue, and a write
+// doesn't fill the RX Queue
+assign wide_rd = burst && width != '0 && rd;
+assign wide_wr = burst && width != '0 && ~rd;
+
+// Single SPI without a burst
+assign phy_width = burst ? width : '0;
+
+// Leave room in the RX Queue for the byte in flight
+assign room = rxq_size < BUFFER || wide_wr;
+
+always_comb begin
+    if (burst) begin
+        phy_din = (txq_dout_vld && ~wide_rd) ? txq_dout : 8'h00;
+        phy_din_vld = left != '0 && room;
+    end
+    else begin
+        phy_din = txq_dout;
+        phy_din_vld = txq_dout_vld & ~xfer_mode;
+    end
+end
+
+assign txq_dout_rdy = phy_din_rdy & ~wide_rd;
+
+assign rxq_din = phy_dout;
+assign rxq_din_vld = phy_dout_vld & ~wide_wr;
+
+assign xfer_left = left;
+assign xfer_busy = burst;
 
 // ============================================================
 // SPI Master Phy
@@ -147,16 +273,19 @@ spi_master #(
     .clk      (clk         ),
     .rstz     (rstz        ),
     .sclk     (sclk        ),
-    .mosi     (mosi        ),
-    .miso     (miso        ),
+    .io_out   (io_out      ),
+    .io_oe    (io_oe       ),
+    .io_in    (io_in       ),
     .prescaler(prescaler   ),
     .cpol     (cpol        ),
     .cpha     (cpha        ),
-    .din      (txq_dout    ),
-    .din_vld  (txq_dout_vld),
-    .din_rdy  (txq_dout_rdy),
-    .dout     (rxq_din     ),
-    .dout_vld (rxq_din_vld )
+    .width    (phy_width   ),
+    .rd       (rd          ),
+    .din      (phy_din     ),
+    .din_vld  (phy_din_vld ),
+    .din_rdy  (phy_din_rdy ),
+    .dout     (phy_dout    ),
+    .dout_vld (phy_dout_vld)
 );
 
 // ------------------------------------------------------------
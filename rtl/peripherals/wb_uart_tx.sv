@@ -12,7 +12,8 @@
     * Size of the TX Queue
 
 Wishbone slave interface
-    - Registered Feedback Bus Cycle, Advanced
+    - Pipelined (B4), without stall. Every strobe is an access, acked in
+      the next cycle. Reads return nothing.
 */
 
 module wb_uart_tx #(
@@ -66,16 +67,15 @@ fifo #(
 );
 
 assign txq_din = dat_i;
-assign txq_din_vld = stb_i & we_i & ack;
+assign txq_din_vld = stb_i & we_i;
 
 // register the ACK, always ack
 always_ff @(posedge clk or negedge rstz) begin
     if (~rstz) ack <= 1'b0;
-    else ack <= stb_i & we_i;
+    else ack <= stb_i;
 end
 
-// Advanced synchronous terminated burst
-assign ack_o = stb_i & ack;
+assign ack_o = ack;
 
 // size is already registered in the fifo
 assign size = txq_size;
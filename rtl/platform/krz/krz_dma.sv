@@ -0,0 +1,330 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+KRZ DMA Controller
+
+- Multi-channel DMA, mastering the crossbar as the third initiator.
+- Memory-to-memory, memory-to-peripheral and peripheral-to-memory transfers.
+- Byte or word transfers, with incrementing or fixed source/destination.
+- Peripheral flow control with DMA requests (dreq). A channel only transfers
+  while its selected request is high, ex: while the UART TX Queue has space.
+  A word channel is paced by the word variant of the request (dreq_word),
+  ex: while the SPIM RX Queue holds at least 4 bytes.
+- A byte transfer only accesses its byte lane, on the read and the write, so
+  that a peripheral queue isn't popped or pushed on the other lanes.
+- Completion status per channel, and an interrupt.
+
+The channels are served round-robin, one transfer (a read, and a write) at a
+time. The read of the next transfer is requested in the cycle the write is
+acked, when its channel is not paced by a dreq and it reads the memory (not
+the system bus). A transfer then takes 3 cycles, and a memory copy moves a
+word every 3 cycles. Otherwise, there's an idle cycle between the transfers,
+for the peripherals to update their requests, and for the system bus to be
+released.
+
+Registers, see krz_map
+  - Per channel, at channel*4 words
+      SRC   : 24b source address
+      DST   : 24b destination address
+      COUNT : 16b number of transfers, counts down to 0
+      CTRL  : [0] start (reads busy), [1] increment source, [2] increment
+              destination, [3] word transfer (else byte), [5:4] dreq select
+              (0: none, N: dreq[N-1]), [6] interrupt enable
+  - STATUS  : [7:0] done (write 1 to clear), [15:8] busy
+
+Writing 0 to CTRL.start aborts the channel. A read in flight completes, but
+its write is dropped. A write in flight completes, and is counted. An aborted
+channel is never done. A channel started with a COUNT of 0 is done right away.
+
+The interrupt is high while any channel is done, with its interrupt enabled.
+
+Register interface: Wishbone slave interface
+  - Pipelined (B4), without stall
+
+Crossbar facing: As the Kronos data interface
+*/
+
+module krz_dma
+  import krz_map::*;
+#(
+  parameter CHANNELS = 4  // 2, 4 or 8
+)(
+  input  logic        clk,
+  input  logic        rstz,
+  // Registers
+  input  logic [5:0]  adr_i,
+  input  logic [31:0] dat_i,
+  output logic [31:0] dat_o,
+  input  logic        we_i,
+  input  logic        stb_i,
+  output logic        ack_o,
+  // Crossbar
+  output logic [23:0] dma_addr,
+  input  logic [31:0] dma_rd_data,
+  output logic [31:0] dma_wr_data,
+  output logic [3:0]  dma_mask,
+  output logic        dma_wr_en,
+  output logic        dma_req,
+  input  logic        dma_ack,
+  // Peripheral DMA requests, for byte and word transfers
+  input  logic [2:0]  dreq,
+  input  logic [2:0]  dreq_word,
+  // Interrupt
+  output logic        irq
+);
+
+localparam CW = $clog2(CHANNELS);
+
+logic [CHANNELS-1:0][23:0] src, dst;
+logic [CHANNELS-1:0][15:0] count;
+logic [CHANNELS-1:0] src_inc, dst_inc, word, ie;
+logic [CHANNELS-1:0][1:0] dreq_sel;
+logic [CHANNELS-1:0] busy, done;
+
+logic [3:0] dreq_ext, dreq_word_ext;
+logic [CHANNELS-1:0] ready, stop, ctrl_wr;
+logic [CW-1:0] ch, last, next;
+logic [CW-1:0] chain_ch;
+logic [23:0] next_src, chain_addr;
+logic [3:0] chain_mask;
+logic chain_vld, chain;
+logic [23:0] src_addr, dst_addr;
+logic [7:0] rbyte;
+logic [31:0] rdata;
+logic [2:0] step;
+logic [1:0] reg_ch;
+logic [CW-1:0] reg_sel;
+
+enum logic [1:0] {
+  IDLE,
+  READ,
+  WRITE
+} state;
+
+// ============================================================
+// Channel Arbiter
+// ============================================================
+
+// A channel is ready to transfer when it is busy, and its dreq is high.
+// It isn't, when it stops in this cycle: it's reprogrammed by the host, or
+// it's on its last transfer
+assign dreq_ext = {dreq, 1'b1};
+assign dreq_word_ext = {dreq_word, 1'b1};
+
+always_comb begin
+  for (int i=0; i<CHANNELS; i++) begin
+    ctrl_wr[i] = stb_i && we_i && ~adr_i[5] && adr_i[4:2] == 3'(i) && reg_ch == KRZ_DMA_CTRL;
+  end
+
+  stop = ctrl_wr;
+  if (state != IDLE && count[ch] == 16'h1) stop[ch] = 1'b1;
+
+  for (int i=0; i<CHANNELS; i++) begin
+    ready[i] = busy[i] & ~stop[i] & (word[i] ? dreq_word_ext[dreq_sel[i]] : dreq_ext[dreq_sel[i]]);
+  end
+end
+
+// Round-robin, starting after the last channel served
+always_comb begin
+  next = last;
+  for (int i=CHANNELS; i>0; i--) begin
+    if (ready[CW'(last + i)]) next = CW'(last + i);
+  end
+end
+
+// ============================================================
+// Transfer
+// ============================================================
+
+assign src_addr = src[ch];
+assign dst_addr = dst[ch];
+
+// read byte, from its lane
+assign rbyte = dma_rd_data[src_addr[1:0]*8 +: 8];
+
+// address step
+assign step = word[ch] ? 3'd4 : 3'd1;
+
+// The next transfer is picked during the write, and its read is requested with
+// the ack of the write. Only for a channel that isn't paced by a dreq, which
+// could be stale until the write lands, and that reads the memory, as the
+// system bus is released on the ack. The read of the same channel is from its
+// next source address
+assign next_src = (next == ch && src_inc[ch]) ? src[ch] + step : src[next];
+
+always_ff @(posedge clk or negedge rstz) begin
+  if (~rstz) begin
+    chain_vld <= 1'b0;
+    chain_ch <= '0;
+    chain_addr <= '0;
+    chain_mask <= '0;
+  end
+  else begin
+    chain_vld <= state == WRITE && ready[next] && dreq_sel[next] == '0 && ~next_src[23];
+    chain_ch <= next;
+    chain_addr <= next_src;
+    chain_mask <= word[next] ? 4'hF : 4'b1 << next_src[1:0];
+  end
+end
+
+assign chain = state == WRITE && dma_ack && chain_vld && ~stop[chain_ch];
+
+always_ff @(posedge clk or negedge rstz) begin
+  if (~rstz) begin
+    state <= IDLE;
+    ch <= '0;
+    last <= '0;
+    rdata <= '0;
+  end
+  else begin
+    case (state)
+      IDLE: if (ready != '0) begin
+        ch <= next;
+        last <= next;
+        state <= READ;
+      end
+
+      READ: if (dma_ack) begin
+        // Byte reads are replicated over the word, for any destination lane
+        rdata <= word[ch] ? dma_rd_data : {4{rbyte}};
+        // The write of an aborted channel is dropped
+        state <= (busy[ch] && ~ctrl_wr[ch]) ? WRITE : IDLE;
+      end
+
+      WRITE: if (dma_ack) begin
+        if (chain) begin
+          ch <= chain_ch;
+          last <= chain_ch;
+          state <= READ;
+        end
+        else state <= IDLE;
+      end
+
+      default: state <= IDLE;
+    endcase
+  end
+end
+
+// Master, as the kronos data interface, hold the request until the ack.
+// The ack of a write can carry the request of the next read
+always_comb begin
+  dma_req = ((state == READ || state == WRITE) && ~dma_ack) || chain;
+  dma_wr_en = state == WRITE && ~dma_ack;
+  dma_wr_data = rdata;
+
+  if (chain) begin
+    dma_addr = {chain_addr[23:2], 2'b0};
+    dma_mask = chain_mask;
+  end
+  else if (state == WRITE) begin
+    dma_addr = {dst_addr[23:2], 2'b0};
+    dma_mask = word[ch] ? 4'hF : 4'b1 << dst_addr[1:0];
+  end
+  else begin
+    dma_addr = {src_addr[23:2], 2'b0};
+    dma_mask = word[ch] ? 4'hF : 4'b1 << src_addr[1:0];
+  end
+end
+
+// ============================================================
+// Registers
+// ============================================================
+
+assign reg_ch = adr_i[1:0];
+assign reg_sel = CW'(adr_i[4:2]);
+
+always_ff @(posedge clk or negedge rstz) begin
+  if (~rstz) begin
+    src <= '0;
+    dst <= '0;
+    count <= '0;
+    src_inc <= '0;
+    dst_inc <= '0;
+    word <= '0;
+    dreq_sel <= '0;
+    ie <= '0;
+    busy <= '0;
+    done <= '0;
+  end
+  else begin
+    // Clear done, before the engine can set it again
+    if (stb_i && we_i && adr_i == KRZ_DMA_STATUS) begin
+      for (int i=0; i<CHANNELS; i++)
+        if (dat_i[i]) done[i] <= 1'b0;
+    end
+
+    // Completed transfer. A write that lands after an abort is counted, but
+    // the channel isn't done
+    if (state == WRITE && dma_ack) begin
+      if (src_inc[ch]) src[ch] <= src[ch] + step;
+      if (dst_inc[ch]) dst[ch] <= dst[ch] + step;
+      count[ch] <= count[ch] - 1'b1;
+
+      if (count[ch] == 16'h1 && busy[ch] && ~ctrl_wr[ch]) begin
+        busy[ch] <= 1'b0;
+        done[ch] <= 1'b1;
+      end
+    end
+
+    // Host access to the channel, after the engine
+    if (stb_i & we_i) begin
+      if (~adr_i[5] && adr_i[4:2] < CHANNELS) begin
+        /* verilator lint_off CASEINCOMPLETE */
+        case (reg_ch)
+          KRZ_DMA_SRC: src[reg_sel] <= dat_i[23:0];
+          KRZ_DMA_DST: dst[reg_sel] <= dat_i[23:0];
+          KRZ_DMA_COUNT: count[reg_sel] <= dat_i[15:0];
+          KRZ_DMA_CTRL: begin
+            busy[reg_sel] <= dat_i[0] && count[reg_sel] != '0;
+            if (dat_i[0] && count[reg_sel] == '0) done[reg_sel] <= 1'b1;
+            src_inc[reg_sel] <= dat_i[1];
+            dst_inc[reg_sel] <= dat_i[2];
+            word[reg_sel] <= dat_i[3];
+            dreq_sel[reg_sel] <= dat_i[5:4];
+            ie[reg_sel] <= dat_i[6];
+          end
+        endcase
+        /* verilator lint_on CASEINCOMPLETE */
+      end
+    end
+  end
+end
+
+// Registered read data
+always_ff @(posedge clk) begin
+  if (stb_i & ~we_i) begin
+    if (adr_i == KRZ_DMA_STATUS) begin
+      dat_o <= {16'h0, 8'(busy), 8'(done)};
+    end
+    else if (~adr_i[5] && adr_i[4:2] < CHANNELS) begin
+      case (reg_ch)
+        KRZ_DMA_SRC   : dat_o <= {8'h0, src[reg_sel]};
+        KRZ_DMA_DST   : dat_o <= {8'h0, dst[reg_sel]};
+        KRZ_DMA_COUNT : dat_o <= {16'h0, count[reg_sel]};
+        default       : dat_o <= {25'h0, ie[reg_sel], dreq_sel[reg_sel],
+                            word[reg_sel], dst_inc[reg_sel], src_inc[reg_sel], busy[reg_sel]};
+      endcase
+    end
+    else begin
+      dat_o <= '0;
+    end
+  end
+end
+
+// always ack, in the next cycle
+always_ff @(posedge clk or negedge rstz) begin
+  if (~rstz) ack_o <= 1'b0;
+  else ack_o <= stb_i;
+end
+
+assign irq = |(done & ie);
+
+// ------------------------------------------------------------
+`ifdef verilator
+logic _unused = &{1'b0
+  , dat_i[31:24]
+};
+`endif
+
+endmodule
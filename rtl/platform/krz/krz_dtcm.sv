@@ -0,0 +1,97 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+KRZ Data Tightly Coupled Memory
+
+A small data scratchpad (EBR), on the Kronos Data interface, in front of the
+crossbar. The accesses to the DTCM aren't arbitrated, and they never contend
+with the instr interface or the DMA. They are acked in the next cycle, like
+an access to an idle bank of the main memory. All other accesses pass through
+to the crossbar.
+
+The DTCM doesn't make a load or store faster than the RAM: the EBR reads
+synchronously, so the LSU still spends the request and the ack cycle on it.
+A same-cycle response would need the core to address the DTCM a stage early,
+from ID, and handle a store in EX to the same word. The gain is only the
+arbitration that is avoided: the cycles in which a data access takes a bank
+from the instr fetch (counted by the crossbar as conflicts), and the waits
+for the DMA and the other core.
+
+Only the core's data interface can access the DTCM. It's meant for the stack
+and the hot variables of a program.
+
+DTCM, KB (up to 32KB): 0x008000 - 0x00ffff
+Filter in address when addr[17:15] == 001, the DTCM repeats in the segment.
+With a KB of 0, the DTCM is left out.
+*/
+
+module krz_dtcm #(
+  parameter KB = 4
+)(
+  input  logic        clk,
+  input  logic        rstz,
+  // Core.data interface
+  input  logic [23:0] data_addr,
+  output logic [31:0] data_rd_data,
+  input  logic [31:0] data_wr_data,
+  input  logic [3:0]  data_mask,
+  input  logic        data_wr_en,
+  input  logic        data_req,
+  output logic        data_ack,
+  // Crossbar data interface
+  output logic [23:0] xbar_addr,
+  input  logic [31:0] xbar_rd_data,
+  output logic [31:0] xbar_wr_data,
+  output logic [3:0]  xbar_mask,
+  output logic        xbar_wr_en,
+  output logic        xbar_req,
+  input  logic        xbar_ack
+);
+
+logic addr_in_dtcm;
+logic dtcm_req;
+logic dtcm_ack;
+logic [31:0] dtcm_rd_data;
+
+generate
+  if (KB > 0) begin : gen_dtcm
+    assign addr_in_dtcm = (data_addr[17:15] == 3'b001) && ~data_addr[23];
+
+    generic_spram #(.AWIDTH(24), .KB(KB)) u_dtcm (
+      .clk  (clk         ),
+      .addr (data_addr   ),
+      .wdata(data_wr_data),
+      .rdata(dtcm_rd_data),
+      .en   (dtcm_req    ),
+      .wr_en(data_wr_en  ),
+      .mask (data_mask   )
+    );
+  end
+  else begin : gen_no_dtcm
+    assign addr_in_dtcm = 1'b0;
+    assign dtcm_rd_data = '0;
+  end
+endgenerate
+
+assign dtcm_req = data_req & addr_in_dtcm;
+
+// Single cycle access
+always_ff @(posedge clk or negedge rstz) begin
+  if (~rstz) dtcm_ack <= 1'b0;
+  else dtcm_ack <= dtcm_req;
+end
+
+// Pass through to the crossbar
+always_comb begin
+  xbar_addr = data_addr;
+  xbar_wr_data = data_wr_data;
+  xbar_mask = data_mask;
+  xbar_wr_en = data_wr_en;
+  xbar_req = data_req & ~addr_in_dtcm;
+
+  data_ack = dtcm_ack | xbar_ack;
+  data_rd_data = dtcm_ack ? dtcm_rd_data : xbar_rd_data;
+end
+
+endmodule
@@ -5,7 +5,8 @@
 KRZ General Purpose Registers
 
 Wishbone slave interface
-  - Registered Feedback Bus Cycle, Classic
+  - Pipelined (B4), without stall. Every strobe is an access, acked in the
+    next cycle with the registered read data
 */
 
 module krz_gpreg 
@@ -33,8 +34,19 @@ module krz_gpreg
   output logic        spim_cpha,
   output logic        spim_tx_clear,
   output logic        spim_rx_clear,
-  input  logic [7:0]  spim_tx_size,
-  input  logic [7:0]  spim_rx_size
+  output logic        spim_xfer_mode,
+  input  logic [9:0]  spim_tx_size,
+  input  logic [9:0]  spim_rx_size,
+  output logic [15:0] spim_xfer_len,
+  output logic        spim_xfer_hold,
+  output logic        spim_xfer_start,
+  output logic        spim_cs_sel,
+  output logic [1:0]  spim_xfer_width,
+  output logic        spim_xfer_rd,
+  input  logic [15:0] spim_xfer_left,
+  input  logic        spim_xfer_busy,
+  // Crossbar
+  input  logic [7:0][31:0] xbar_stats
 );
 
 logic ack;
@@ -57,10 +69,23 @@ always_ff @(posedge clk or negedge rstz) begin
     spim_cpha <= 1'b0;
     spim_tx_clear <= 1'b0;
     spim_rx_clear <= 1'b0;
+    spim_xfer_mode <= 1'b0;
+    spim_xfer_len <= '0;
+    spim_xfer_hold <= 1'b0;
+    spim_xfer_start <= 1'b0;
+    spim_cs_sel <= 1'b0;        // Flash
+    spim_xfer_width <= '0;      // Single
+    spim_xfer_rd <= 1'b0;
   end
-  else if (stb_i & ~ack) begin
+  else begin
+    // One-shots, unless written again
+    uart_tx_clear <= 1'b0;
+    spim_tx_clear <= 1'b0;
+    spim_rx_clear <= 1'b0;
+    spim_xfer_start <= 1'b0;
+
     /* verilator lint_off CASEINCOMPLETE */
-    case(adr_i)
+    if (stb_i) case(adr_i)
       // ------------------------------------------------
       KRZ_SCRATCH:
         if (we_i) scratch <= dat_i;
@@ -104,29 +129,63 @@ always_ff @(posedge clk or negedge rstz) begin
           spim_cpha <= dat_i[9];
           spim_tx_clear <= dat_i[10];
           spim_rx_clear <= dat_i[11];
+          spim_xfer_mode <= dat_i[12];
         end
         else begin
-          dat_o <= {22'h0, spim_cpha, spim_cpol, spim_prescaler};
+          dat_o <= {19'h0, spim_xfer_mode, 2'b0, spim_cpha, spim_cpol, spim_prescaler};
         end
       
       KRZ_SPIM_STATUS: // Read-Only
-        if (~we_i) dat_o <= {16'h0, spim_rx_size, spim_tx_size};
+        if (~we_i) dat_o <= {6'h0, spim_rx_size, 6'h0, spim_tx_size};
+
+      KRZ_SPIM_XFER:
+        if (we_i) begin
+          spim_xfer_len <= dat_i[15:0];
+          spim_xfer_hold <= dat_i[16];
+          spim_cs_sel <= dat_i[17];
+          spim_xfer_width <= dat_i[19:18];
+          spim_xfer_rd <= dat_i[20];
+          spim_xfer_start <= 1'b1;
+        end
+        else begin
+          dat_o <= {7'h0, spim_xfer_busy, 3'h0, spim_xfer_rd, spim_xfer_width,
+            spim_cs_sel, spim_xfer_hold, spim_xfer_left};
+        end
+
+      // ------------------------------------------------
+      // Crossbar statistics, Read-Only
+      KRZ_XBAR_CONFLICT:
+        if (~we_i) dat_o <= xbar_stats[0];
+
+      KRZ_XBAR_INSTR_GNT:
+        if (~we_i) dat_o <= xbar_stats[1];
+
+      KRZ_XBAR_DATA_GNT:
+        if (~we_i) dat_o <= xbar_stats[2];
+
+      KRZ_XBAR_BOOTROM_BUSY:
+        if (~we_i) dat_o <= xbar_stats[3];
+
+      KRZ_XBAR_MEM0_BUSY:
+        if (~we_i) dat_o <= xbar_stats[4];
+
+      KRZ_XBAR_MEM1_BUSY:
+        if (~we_i) dat_o <= xbar_stats[5];
+
+      KRZ_XBAR_SYS_BUSY:
+        if (~we_i) dat_o <= xbar_stats[6];
+
+      KRZ_XBAR_DMA_GNT:
+        if (~we_i) dat_o <= xbar_stats[7];
 
     endcase
     /* verilator lint_on CASEINCOMPLETE */
   end
-  else if (ack) begin
-    // Clear one-shots
-    uart_tx_clear <= 1'b0;
-    spim_tx_clear <= 1'b0;
-    spim_rx_clear <= 1'b0;
-  end
 end
 
 always_ff @(posedge clk or negedge rstz) begin
   if (~rstz) ack <= 1'b0;
-  else if (stb_i & ~ack) ack <= 1'b1;
-  else ack <= 1'b0;
+  else ack <= stb_i;
 end
 
 assign ack_o = ack;
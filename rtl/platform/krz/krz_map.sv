@@ -33,4 +33,50 @@ parameter logic [5:0] KRZ_SPIM_CTRL     = 6'h07;
 // SPIM Status: RX/TX Queue size
 parameter logic [5:0] KRZ_SPIM_STATUS   = 6'h08;
 
+// Crossbar Conflicts: Cycles of the instr interface stalled by the data interface
+parameter logic [5:0] KRZ_XBAR_CONFLICT     = 6'h09;
+
+// Crossbar Grants: Accesses completed on the instr/data interface
+parameter logic [5:0] KRZ_XBAR_INSTR_GNT    = 6'h0A;
+parameter logic [5:0] KRZ_XBAR_DATA_GNT     = 6'h0B;
+
+// Crossbar Busy: Cycles in which the Boot ROM/Bank0/Bank1/System is accessed
+parameter logic [5:0] KRZ_XBAR_BOOTROM_BUSY = 6'h0C;
+parameter logic [5:0] KRZ_XBAR_MEM0_BUSY    = 6'h0D;
+parameter logic [5:0] KRZ_XBAR_MEM1_BUSY    = 6'h0E;
+parameter logic [5:0] KRZ_XBAR_SYS_BUSY     = 6'h0F;
+
+// Crossbar DMA Grants: Accesses completed on the DMA interface
+parameter logic [5:0] KRZ_XBAR_DMA_GNT      = 6'h10;
+
+// SPIM Transfer: Length, chip select hold and select, width. Write to start
+parameter logic [5:0] KRZ_SPIM_XFER     = 6'h11;
+
+// ============================================================
+// DMA Registers
+
+// Per channel, at channel*4 words: source, destination, count and control
+parameter logic [1:0] KRZ_DMA_SRC       = 2'h0;
+parameter logic [1:0] KRZ_DMA_DST       = 2'h1;
+parameter logic [1:0] KRZ_DMA_COUNT     = 2'h2;
+parameter logic [1:0] KRZ_DMA_CTRL      = 2'h3;
+
+// DMA Status: Done (write 1 to clear) and Busy, per channel
+parameter logic [5:0] KRZ_DMA_STATUS    = 6'h20;
+
+// ============================================================
+// Mailbox Registers
+
+// Semaphores 0-7: Read to test-and-set (0: acquired), write 0 to release
+parameter logic [5:0] KRZ_MBOX_SEM      = 6'h00;
+
+// Mailbox per core: Write to post a message, read to take it
+parameter logic [5:0] KRZ_MBOX_MSG      = 6'h08;
+
+// Mailbox Status: Messages pending, per core
+parameter logic [5:0] KRZ_MBOX_STATUS   = 6'h10;
+
+// Core Run: Release the cores from reset, core0 always runs
+parameter logic [5:0] KRZ_MBOX_RUN      = 6'h11;
+
 endpackage
\ No newline at end of file
@@ -0,0 +1,104 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+KRZ Mailbox
+
+Hardware semaphores and mailboxes, for the cores of a multi-core KRZ to
+synchronize and pass messages.
+
+- 8 Semaphores. Reading a semaphore returns its value and sets it, an atomic
+  test-and-set: a read of 0 means the semaphore was acquired. Write 0 to
+  release it.
+- A mailbox per core. A write to the mailbox of a core posts the message,
+  and raises the software interrupt of that core until the message is read.
+  Reading the mailbox returns the message and clears it.
+- Run control: the cores, other than core0, are held in reset until their
+  run bit is set.
+
+Registers, see krz_map
+  - SEM[0-7]  : [0] semaphore
+  - MSG[core] : 32b message
+  - STATUS    : [CORES-1:0] messages pending, per core (Read-Only)
+  - RUN       : [CORES-1:0] run, per core. core0 always runs
+
+Wishbone slave interface
+  - Pipelined (B4), without stall. Every strobe is an access, acked in the
+    next cycle with the registered read data
+*/
+
+module krz_mbox
+  import krz_map::*;
+#(
+  parameter CORES = 2   // up to 8
+)(
+  input  logic              clk,
+  input  logic              rstz,
+  input  logic [5:0]        adr_i,
+  input  logic [31:0]       dat_i,
+  output logic [31:0]       dat_o,
+  input  logic              we_i,
+  input  logic              stb_i,
+  output logic              ack_o,
+  // Cores
+  output logic [CORES-1:0]  msip,
+  output logic [CORES-1:0]  run
+);
+
+logic [7:0] sem;
+logic [CORES-1:0][31:0] msg;
+logic [CORES-1:0] pending;
+logic [CORES-1:0] run_q;
+
+logic sem_sel, msg_sel;
+logic [2:0] idx;
+
+assign idx = adr_i[2:0];
+assign sem_sel = adr_i[5:3] == KRZ_MBOX_SEM[5:3];
+assign msg_sel = adr_i[5:3] == KRZ_MBOX_MSG[5:3] && 32'(idx) < CORES;
+
+always_ff @(posedge clk or negedge rstz) begin
+  if (~rstz) begin
+    sem <= '0;
+    msg <= '0;
+    pending <= '0;
+    run_q <= '0;
+  end
+  else if (stb_i) begin
+    if (sem_sel) begin
+      // Test-and-set on read
+      if (we_i) sem[idx] <= dat_i[0];
+      else sem[idx] <= 1'b1;
+    end
+    else if (msg_sel) begin
+      // Post on write, and clear on read
+      msg[idx] <= we_i ? dat_i : '0;
+      pending[idx] <= we_i;
+    end
+    else if (adr_i == KRZ_MBOX_RUN && we_i) begin
+      run_q <= dat_i[CORES-1:0];
+    end
+  end
+end
+
+// Registered read data
+always_ff @(posedge clk) begin
+  if (stb_i & ~we_i) begin
+    if (sem_sel) dat_o <= {31'h0, sem[idx]};
+    else if (msg_sel) dat_o <= msg[idx];
+    else if (adr_i == KRZ_MBOX_STATUS) dat_o <= 32'(pending);
+    else if (adr_i == KRZ_MBOX_RUN) dat_o <= 32'(run);
+    else dat_o <= '0;
+  end
+end
+
+// always ack, in the next cycle
+always_ff @(posedge clk or negedge rstz) begin
+  if (~rstz) ack_o <= 1'b0;
+  else ack_o <= stb_i;
+end
+
+assign msip = pending;
+assign run = run_q | CORES'(1);
+
+endmodule
@@ -7,12 +7,22 @@ KRZ System Peripheral Bus
 
 - Multiplex access to the system peripherals.
 - Address needs to be word aligned so the core will read the data from 
-the lowest byte of the word
+the lowest byte of the word. The byte select is passed on, for the
+peripherals with a wider data port
 
 For system address map, see: krz_map
 
 Crossbar facing: Wishbone slave interface
-  - Registered Feedback Bus Cycle, Classic
+  - The strobe is held until the ack, which is passed through
+  - Single cycle access with the peripherals below, except the SPIM
+
+Peripheral facing: Wishbone master interface
+  - Pipelined (B4). The strobe is a single cycle per access, and the access
+    is pending until the peripheral acks (with registered read data). Most
+    peripherals ack in the next cycle. The SPIM acks after a cycle per
+    selected byte lane, as its queues move a byte per cycle
+  - The strobe is decoded from the crossbar in the same cycle, so a new
+    access can follow the ack of the last, back-to-back
 */
 
 module krz_sysbus #(
@@ -25,6 +35,7 @@ module krz_sysbus #(
   input  logic [31:0]         sys_dat_i,
   output logic [31:0]         sys_dat_o,
   input  logic                sys_we_i,
+  input  logic [3:0]          sys_sel_i,
   input  logic                sys_stb_i,
   output logic                sys_ack_o,
   // Peripheral Bus
@@ -32,30 +43,30 @@ module krz_sysbus #(
   input  logic [N-1:0][31:0]  perif_dat_i,
   output logic [31:0]         perif_dat_o,
   output logic                perif_we_o,
+  output logic [3:0]          perif_sel_o,
   output logic [N-1:0]        perif_stb_o,
   input  logic [N-1:0]        perif_ack_o
 );
 
 logic ack;
+logic pending;
 
-// Register grant and peripheral bus IO
-always_ff @(posedge clk or negedge rstz) begin
-  if (~rstz) begin
-    perif_stb_o <= '0;
+// Strobe the addressed peripheral once per access
+always_comb begin
+  for (int i=0; i<N; i++) begin
+    perif_stb_o[i] = sys_stb_i && ~pending && sys_adr_i[11:8] == i[3:0];
   end
-  else if (perif_stb_o == '0 && sys_stb_i && ~sys_ack_o) begin
 
-    for (int i=0; i<N; i++) begin
-      perif_stb_o[i] <= sys_adr_i[11:8] == i[3:0];
-    end
+  perif_adr_o = sys_adr_i[7:2];
+  perif_dat_o = sys_dat_i;
+  perif_we_o  = sys_we_i;
+  perif_sel_o = sys_sel_i;
+end
 
-    perif_adr_o <= sys_adr_i[7:2];
-    perif_dat_o <= sys_dat_i;
-    perif_we_o  <= sys_we_i;
-  end
-  else if (perif_stb_o != '0 && ack) begin
-    perif_stb_o <= '0;
-  end
+// An access is pending between the strobe and the ack
+always_ff @(posedge clk or negedge rstz) begin
+  if (~rstz) pending <= 1'b0;
+  else pending <= (perif_stb_o != '0) | (pending & ~ack);
 end
 
 // accumulate ACK from all peripherals
@@ -63,20 +74,13 @@ assign ack = |{perif_ack_o};
 
 // ============================================================
 // Crossbar Wiring
-// Register an ACK and read data signal for the crossbar
-always_ff @(posedge clk or negedge rstz) begin
-  if (~rstz) begin
-    sys_ack_o <= 1'b0;
-  end
-  else if (perif_stb_o != '0 && ack) begin
-    sys_ack_o <= 1'b1;
+// The peripheral ack and read data are registered, pass them through
+always_comb begin
+  sys_ack_o = ack;
 
-    for (int i=N-1; i>=0; i--) begin
-      if (perif_stb_o[i]) sys_dat_o <= perif_dat_i[i];
-    end
-  end
-  else begin
-    sys_ack_o <= 1'b0;
+  sys_dat_o = '0;
+  for (int i=N-1; i>=0; i--) begin
+    if (perif_ack_o[i]) sys_dat_o = perif_dat_i[i];
   end
 end
 
@@ -85,8 +89,7 @@ end
 logic _unused = &{1'b0
   , sys_adr_i[23:12]
   , sys_adr_i[1:0]
-  , sys_dat_i[31:8]
 };
 `endif
 
-endmodule
\ No newline at end of file
+endmodule
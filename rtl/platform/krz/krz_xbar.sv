@@ -4,7 +4,8 @@
 /*
 Primary Crossbar for the KRZ SoC
 
-- Presents dual wishbone pipelined slave buses to the Kronos Instruction and Data interface.
+- Presents wishbone pipelined slave buses to the Kronos Instruction and Data interface,
+  and to the DMA (krz_dma).
 - Arbitrates access to the all resources, at the individual resource level.
 - Multiplexes peripheral interfaces to the Kronos Data interface.
 
@@ -14,10 +15,43 @@ individually and concurrently.
 When they both access the same resource arbitration is required.
 Data interface has priority, else the system will deadlock.
 
+The DMA is the third initiator. It has the same access as the data interface,
+and the priority is: data > dma > instr. The DMA doesn't hold a resource for
+more than an access, and it moves data while the core computes out of
+another resource. The system bus is held by an initiator until its access
+is acked.
+
+With CORES = 2, the second Kronos core has its own instr and data interfaces
+(instr1/data1). The two cores are served round-robin on every resource: the
+core that was granted a resource last loses it to the other, if both request
+it in the same cycle. The priority between the kinds of initiators is as
+above: data (either core) > dma > instr (either core). With CORES = 1, the
+instr1/data1 interfaces are unused, and never acked.
+
 The main memory of is split into two banks of 64K each. If all of the text is 
 located in Bank0 and the data and stack in Bank1, then there's almost never any 
 contention between the two interfaces. The system can run at its peak performance.
 
+MEM_INTERLEAVE
+  - 0: The banks are contiguous, Bank0 at 0x010000 and Bank1 at 0x020000.
+  - N (2-15): The banks are interleaved on bit N of the address, ex: 2 for
+    alternate words, 4 for 16B lines. Sequential fetches and data accesses
+    spread over both banks, whatever the layout of the program. The instr and
+    data streams mostly hit different banks, without a split linker script.
+
+Statistics
+The crossbar counts the following from reset, in `stats`, to profile how the
+layout of a program uses the resources. All counters are 32b, and wrap around.
+  - 0: Conflicts, cycles in which an instr interface lost a bank (or the
+       Boot ROM) to a data interface, the DMA or the other core.
+  - 1: Instr grants, accesses completed on the instr interfaces.
+  - 2: Data grants, accesses completed on the data interfaces.
+  - 3: Boot ROM busy cycles.
+  - 4: Bank0 busy cycles.
+  - 5: Bank1 busy cycles.
+  - 6: System busy cycles, including the wait for the peripheral ack.
+  - 7: DMA grants, accesses completed on the DMA interface.
+
 
 0x1000000    24b/16MB Address Space
 +----------+------------+           ^
@@ -37,9 +71,11 @@ contention between the two interfaces. The system can run at its peak performanc
            |     2x64K  |           |
 0x010000   |            |           |
 +-----------------------+           |
-0x00ffff   |            |   ^       |  8MB
+0x00ffff   |    DTCM    |   ^       |  8MB
+           |        4K  |   |       |
+0x008000   |            |   |       |
++-----------------------+   |       |
            |  reserved  |   |       |
-           |            |   |       |
 +-----------------------+   |       |
            |            |   | 64K   |
            |  BOOT ROM  |   |       |
@@ -49,7 +85,10 @@ contention between the two interfaces. The system can run at its peak performanc
 
 */
 
-module krz_xbar (
+module krz_xbar #(
+    parameter MEM_INTERLEAVE = 0,
+    parameter CORES = 1
+)(
     input  logic        clk,
     input  logic        rstz,
     // Core.instr interface
@@ -65,6 +104,27 @@ module krz_xbar (
     input  logic        data_wr_en,
     input  logic        data_req,
     output logic        data_ack,
+    // Core1.instr interface
+    input  logic [23:0] instr1_addr,
+    output logic [31:0] instr1_data,
+    input  logic        instr1_req,
+    output logic        instr1_ack,
+    // Core1.data interface
+    input  logic [23:0] data1_addr,
+    output logic [31:0] data1_rd_data,
+    input  logic [31:0] data1_wr_data,
+    input  logic [3:0]  data1_mask,
+    input  logic        data1_wr_en,
+    input  logic        data1_req,
+    output logic        data1_ack,
+    // DMA interface
+    input  logic [23:0] dma_addr,
+    output logic [31:0] dma_rd_data,
+    input  logic [31:0] dma_wr_data,
+    input  logic [3:0]  dma_mask,
+    input  logic        dma_wr_en,
+    input  logic        dma_req,
+    output logic        dma_ack,
     // Boot ROM interface
     output logic [23:0] bootrom_addr,
     input  logic [31:0] bootrom_rd_data,
@@ -90,7 +150,9 @@ module krz_xbar (
     output logic        sys_we_o,
     output logic [3:0]  sys_sel_o,
     output logic        sys_stb_o,
-    input  logic        sys_ack_i
+    input  logic        sys_ack_i,
+    // Statistics
+    output logic [7:0][31:0] stats
 );
 
 logic instr_addr_in_bootrom;
@@ -100,14 +162,63 @@ logic data_addr_in_mem0;
 logic instr_addr_in_mem1;
 logic data_addr_in_mem1;
 logic data_addr_in_sys;
+logic instr1_addr_in_bootrom;
+logic data1_addr_in_bootrom;
+logic instr1_addr_in_mem0;
+logic data1_addr_in_mem0;
+logic instr1_addr_in_mem1;
+logic data1_addr_in_mem1;
+logic data1_addr_in_sys;
+logic dma_addr_in_bootrom;
+logic dma_addr_in_mem0;
+logic dma_addr_in_mem1;
+logic dma_addr_in_sys;
+
+logic [23:0] instr_mem_addr;
+logic [23:0] data_mem_addr;
+logic [23:0] instr1_mem_addr;
+logic [23:0] data1_mem_addr;
+logic [23:0] dma_mem_addr;
+logic instr_conflict;
+logic [7:0][1:0] stats_event;
+
+logic core1_instr_req;
+logic core1_data_req;
 
 logic bootrom_instr_req;
 logic bootrom_data_req;
+logic bootrom_instr1_req;
+logic bootrom_data1_req;
+logic bootrom_dma_req;
 logic mem0_instr_req;
 logic mem0_data_req;
+logic mem0_instr1_req;
+logic mem0_data1_req;
+logic mem0_dma_req;
 logic mem1_instr_req;
 logic mem1_data_req;
+logic mem1_instr1_req;
+logic mem1_data1_req;
+logic mem1_dma_req;
 logic sys_data_req;
+logic sys_data1_req;
+logic sys_dma_req;
+
+// Winner of each resource, see arbitration
+logic bootrom_instr_win, bootrom_data_win, bootrom_instr1_win, bootrom_data1_win, bootrom_dma_win;
+logic mem0_instr_win, mem0_data_win, mem0_instr1_win, mem0_data1_win, mem0_dma_win;
+logic mem1_instr_win, mem1_data_win, mem1_instr1_win, mem1_data1_win, mem1_dma_win;
+
+// Round-robin between the cores: the turn of core1, per resource
+logic bootrom_rr, mem0_rr, mem1_rr, sys_rr;
+
+logic sys_busy;
+
+enum logic [1:0] {
+    SYS_DATA,
+    SYS_DATA1,
+    SYS_DMA
+} sys_owner, sys_owner_locked;
 
 enum logic [2:0] {
     NONE,
@@ -115,7 +226,7 @@ enum logic [2:0] {
     MEM0,
     MEM1,
     SYS
-} instr_gnt, data_gnt;
+} instr_gnt, data_gnt, instr1_gnt, data1_gnt, dma_gnt;
 
 
 // ============================================================
@@ -124,13 +235,20 @@ enum logic [2:0] {
 // Filter address by looking at as few bits as possible
 // Warning & FIXME: illegal address aren't caught, this is left to the code
 
+// Core1 is only present with CORES = 2
+assign core1_instr_req = (CORES > 1) && instr1_req;
+assign core1_data_req = (CORES > 1) && data1_req;
+
 /*
-Boot ROM, 1KB: 0x000000 - 0x0003ff
+Boot ROM, 2KB: 0x000000 - 0x0007ff
 Both the Instr and Data interfaces can access this segment
 Filter in address when addr[17:16] == 00
 */
 assign instr_addr_in_bootrom = instr_addr[17:16] == 2'b00;
 assign data_addr_in_bootrom = (data_addr[17:16] == 2'b00) && ~data_addr[23];
+assign instr1_addr_in_bootrom = instr1_addr[17:16] == 2'b00;
+assign data1_addr_in_bootrom = (data1_addr[17:16] == 2'b00) && ~data1_addr[23];
+assign dma_addr_in_bootrom = (dma_addr[17:16] == 2'b00) && ~dma_addr[23];
 
 /*
 Main Memory (RAM), 128KB: 0x010000 - 0x02ffff
@@ -138,74 +256,276 @@ Both the Instr and Data interfaces can access this segment
 Filter in address when addr[17:16] == 01 or 10
 Bank0: 01
 Bank1: 10
+
+Interleaved, the offset into the RAM (addr[17], addr[15:0]) is split on the
+interleave bit. The bit selects the bank, and the rest is the bank address.
 */
-assign instr_addr_in_mem0 = instr_addr[17:16] == 2'b01;
-assign data_addr_in_mem0 = (data_addr[17:16] == 2'b01) && ~data_addr[23];
+generate
+    if (MEM_INTERLEAVE == 0) begin : gen_contiguous
+        assign instr_addr_in_mem0 = instr_addr[17:16] == 2'b01;
+        assign data_addr_in_mem0 = (data_addr[17:16] == 2'b01) && ~data_addr[23];
 
-assign instr_addr_in_mem1 = instr_addr[17:16] == 2'b10;
-assign data_addr_in_mem1 = (data_addr[17:16] == 2'b10) && ~data_addr[23];
+        assign instr_addr_in_mem1 = instr_addr[17:16] == 2'b10;
+        assign data_addr_in_mem1 = (data_addr[17:16] == 2'b10) && ~data_addr[23];
+
+        assign instr1_addr_in_mem0 = instr1_addr[17:16] == 2'b01;
+        assign data1_addr_in_mem0 = (data1_addr[17:16] == 2'b01) && ~data1_addr[23];
+
+        assign instr1_addr_in_mem1 = instr1_addr[17:16] == 2'b10;
+        assign data1_addr_in_mem1 = (data1_addr[17:16] == 2'b10) && ~data1_addr[23];
+
+        assign dma_addr_in_mem0 = (dma_addr[17:16] == 2'b01) && ~dma_addr[23];
+        assign dma_addr_in_mem1 = (dma_addr[17:16] == 2'b10) && ~dma_addr[23];
+
+        assign instr_mem_addr = instr_addr;
+        assign data_mem_addr = data_addr;
+        assign instr1_mem_addr = instr1_addr;
+        assign data1_mem_addr = data1_addr;
+        assign dma_mem_addr = dma_addr;
+    end
+    else begin : gen_interleaved
+        logic instr_addr_in_ram, data_addr_in_ram, dma_addr_in_ram;
+        logic instr1_addr_in_ram, data1_addr_in_ram;
+        logic [16:0] instr_offset, data_offset, dma_offset;
+        logic [16:0] instr1_offset, data1_offset;
+
+        assign instr_addr_in_ram = instr_addr[17] ^ instr_addr[16];
+        assign data_addr_in_ram = (data_addr[17] ^ data_addr[16]) && ~data_addr[23];
+        assign instr1_addr_in_ram = instr1_addr[17] ^ instr1_addr[16];
+        assign data1_addr_in_ram = (data1_addr[17] ^ data1_addr[16]) && ~data1_addr[23];
+        assign dma_addr_in_ram = (dma_addr[17] ^ dma_addr[16]) && ~dma_addr[23];
+
+        assign instr_offset = {instr_addr[17], instr_addr[15:0]};
+        assign data_offset = {data_addr[17], data_addr[15:0]};
+        assign instr1_offset = {instr1_addr[17], instr1_addr[15:0]};
+        assign data1_offset = {data1_addr[17], data1_addr[15:0]};
+        assign dma_offset = {dma_addr[17], dma_addr[15:0]};
+
+        assign instr_addr_in_mem0 = instr_addr_in_ram & ~instr_offset[MEM_INTERLEAVE];
+        assign data_addr_in_mem0 = data_addr_in_ram & ~data_offset[MEM_INTERLEAVE];
+
+        assign instr_addr_in_mem1 = instr_addr_in_ram & instr_offset[MEM_INTERLEAVE];
+        assign data_addr_in_mem1 = data_addr_in_ram & data_offset[MEM_INTERLEAVE];
+
+        assign instr1_addr_in_mem0 = instr1_addr_in_ram & ~instr1_offset[MEM_INTERLEAVE];
+        assign data1_addr_in_mem0 = data1_addr_in_ram & ~data1_offset[MEM_INTERLEAVE];
+
+        assign instr1_addr_in_mem1 = instr1_addr_in_ram & instr1_offset[MEM_INTERLEAVE];
+        assign data1_addr_in_mem1 = data1_addr_in_ram & data1_offset[MEM_INTERLEAVE];
+
+        assign dma_addr_in_mem0 = dma_addr_in_ram & ~dma_offset[MEM_INTERLEAVE];
+        assign dma_addr_in_mem1 = dma_addr_in_ram & dma_offset[MEM_INTERLEAVE];
+
+        assign instr_mem_addr = {8'h0, instr_offset[16:MEM_INTERLEAVE+1], instr_offset[MEM_INTERLEAVE-1:0]};
+        assign data_mem_addr = {8'h0, data_offset[16:MEM_INTERLEAVE+1], data_offset[MEM_INTERLEAVE-1:0]};
+        assign instr1_mem_addr = {8'h0, instr1_offset[16:MEM_INTERLEAVE+1], instr1_offset[MEM_INTERLEAVE-1:0]};
+        assign data1_mem_addr = {8'h0, data1_offset[16:MEM_INTERLEAVE+1], data1_offset[MEM_INTERLEAVE-1:0]};
+        assign dma_mem_addr = {8'h0, dma_offset[16:MEM_INTERLEAVE+1], dma_offset[MEM_INTERLEAVE-1:0]};
+
+`ifdef verilator
+        logic _unused = &{1'b0
+            , instr_addr[23:18]
+            , data_addr[22:18]
+            , instr1_addr[23:18]
+            , data1_addr[22:18]
+            , dma_addr[22:18]
+        };
+`endif
+    end
+endgenerate
 
 /*
 System, 8M: 0x800000 - 0xffffff
-Only the Data interfaces can access this segment
+Only the Data interface and the DMA can access this segment
 */
 assign data_addr_in_sys = data_addr[23];
+assign data1_addr_in_sys = data1_addr[23];
+assign dma_addr_in_sys = dma_addr[23];
 
 // ============================================================
 // Arbitration
 // ============================================================
+// Per resource: data > dma > instr, and round-robin between the cores.
+// The core that wins a resource hands the turn to the other core.
 
 // Boot ROM
 always_comb begin
     bootrom_instr_req = instr_req & instr_addr_in_bootrom;
     bootrom_data_req = data_req & data_addr_in_bootrom;
-
-    bootrom_en =  bootrom_instr_req | bootrom_data_req;
-    bootrom_addr = (bootrom_data_req) ? data_addr : instr_addr;
+    bootrom_instr1_req = core1_instr_req & instr1_addr_in_bootrom;
+    bootrom_data1_req = core1_data_req & data1_addr_in_bootrom;
+    bootrom_dma_req = dma_req & dma_addr_in_bootrom;
+
+    bootrom_data1_win = bootrom_data1_req & (~bootrom_data_req | bootrom_rr);
+    bootrom_data_win = bootrom_data_req & ~bootrom_data1_win;
+    bootrom_dma_win = bootrom_dma_req & ~bootrom_data_req & ~bootrom_data1_req;
+    bootrom_instr1_win = bootrom_instr1_req & ~bootrom_data_req & ~bootrom_data1_req & ~bootrom_dma_req
+                       & (~bootrom_instr_req | bootrom_rr);
+    bootrom_instr_win = bootrom_instr_req & ~bootrom_data_req & ~bootrom_data1_req & ~bootrom_dma_req
+                      & ~bootrom_instr1_win;
+
+    bootrom_en =  bootrom_instr_req | bootrom_data_req | bootrom_instr1_req | bootrom_data1_req | bootrom_dma_req;
+    if (bootrom_data_win) bootrom_addr = data_addr;
+    else if (bootrom_data1_win) bootrom_addr = data1_addr;
+    else if (bootrom_dma_win) bootrom_addr = dma_addr;
+    else if (bootrom_instr1_win) bootrom_addr = instr1_addr;
+    else bootrom_addr = instr_addr;
 end
 
 // Main Memory Bank0
 always_comb begin
     mem0_instr_req = instr_req & instr_addr_in_mem0;
     mem0_data_req = data_req & data_addr_in_mem0;
-
-    mem0_en =  mem0_instr_req | mem0_data_req;
-    mem0_addr = (mem0_data_req) ? data_addr : instr_addr;
+    mem0_instr1_req = core1_instr_req & instr1_addr_in_mem0;
+    mem0_data1_req = core1_data_req & data1_addr_in_mem0;
+    mem0_dma_req = dma_req & dma_addr_in_mem0;
+
+    mem0_data1_win = mem0_data1_req & (~mem0_data_req | mem0_rr);
+    mem0_data_win = mem0_data_req & ~mem0_data1_win;
+    mem0_dma_win = mem0_dma_req & ~mem0_data_req & ~mem0_data1_req;
+    mem0_instr1_win = mem0_instr1_req & ~mem0_data_req & ~mem0_data1_req & ~mem0_dma_req
+                    & (~mem0_instr_req | mem0_rr);
+    mem0_instr_win = mem0_instr_req & ~mem0_data_req & ~mem0_data1_req & ~mem0_dma_req
+                   & ~mem0_instr1_win;
+
+    mem0_en =  mem0_instr_req | mem0_data_req | mem0_instr1_req | mem0_data1_req | mem0_dma_req;
+    if (mem0_data_win) mem0_addr = data_mem_addr;
+    else if (mem0_data1_win) mem0_addr = data1_mem_addr;
+    else if (mem0_dma_win) mem0_addr = dma_mem_addr;
+    else if (mem0_instr1_win) mem0_addr = instr1_mem_addr;
+    else mem0_addr = instr_mem_addr;
 
     // mask is only used for write
-    mem0_mask = data_mask;
-
-    mem0_wr_data = data_wr_data;
-    mem0_wr_en = mem0_data_req & data_wr_en;
+    if (mem0_data_win) begin
+        mem0_mask = data_mask;
+        mem0_wr_data = data_wr_data;
+        mem0_wr_en = data_wr_en;
+    end
+    else if (mem0_data1_win) begin
+        mem0_mask = data1_mask;
+        mem0_wr_data = data1_wr_data;
+        mem0_wr_en = data1_wr_en;
+    end
+    else begin
+        mem0_mask = dma_mask;
+        mem0_wr_data = dma_wr_data;
+        mem0_wr_en = mem0_dma_win & dma_wr_en;
+    end
 end
 
 // Main Memory Bank1, same routing as Bank0
 always_comb begin
     mem1_instr_req = instr_req & instr_addr_in_mem1;
     mem1_data_req = data_req & data_addr_in_mem1;
-
-    mem1_en =  mem1_instr_req | mem1_data_req;
-    mem1_addr = (mem1_data_req) ? data_addr : instr_addr;
+    mem1_instr1_req = core1_instr_req & instr1_addr_in_mem1;
+    mem1_data1_req = core1_data_req & data1_addr_in_mem1;
+    mem1_dma_req = dma_req & dma_addr_in_mem1;
+
+    mem1_data1_win = mem1_data1_req & (~mem1_data_req | mem1_rr);
+    mem1_data_win = mem1_data_req & ~mem1_data1_win;
+    mem1_dma_win = mem1_dma_req & ~mem1_data_req & ~mem1_data1_req;
+    mem1_instr1_win = mem1_instr1_req & ~mem1_data_req & ~mem1_data1_req & ~mem1_dma_req
+                    & (~mem1_instr_req | mem1_rr);
+    mem1_instr_win = mem1_instr_req & ~mem1_data_req & ~mem1_data1_req & ~mem1_dma_req
+                   & ~mem1_instr1_win;
+
+    mem1_en =  mem1_instr_req | mem1_data_req | mem1_instr1_req | mem1_data1_req | mem1_dma_req;
+    if (mem1_data_win) mem1_addr = data_mem_addr;
+    else if (mem1_data1_win) mem1_addr = data1_mem_addr;
+    else if (mem1_dma_win) mem1_addr = dma_mem_addr;
+    else if (mem1_instr1_win) mem1_addr = instr1_mem_addr;
+    else mem1_addr = instr_mem_addr;
 
     // mask is only used for write
-    mem1_mask = data_mask;
-
-    mem1_wr_data = data_wr_data;
-    mem1_wr_en = mem1_data_req & data_wr_en;
+    if (mem1_data_win) begin
+        mem1_mask = data_mask;
+        mem1_wr_data = data_wr_data;
+        mem1_wr_en = data_wr_en;
+    end
+    else if (mem1_data1_win) begin
+        mem1_mask = data1_mask;
+        mem1_wr_data = data1_wr_data;
+        mem1_wr_en = data1_wr_en;
+    end
+    else begin
+        mem1_mask = dma_mask;
+        mem1_wr_data = dma_wr_data;
+        mem1_wr_en = mem1_dma_win & dma_wr_en;
+    end
 end
 
-// System access - data interface only
+// System access - data interfaces and DMA
+// The initiator of an access in flight owns the system bus until the ack
 always_comb begin
     sys_data_req = data_req & data_addr_in_sys;
+    sys_data1_req = core1_data_req & data1_addr_in_sys;
+    sys_dma_req = dma_req & dma_addr_in_sys;
+
+    if (sys_busy) sys_owner = sys_owner_locked;
+    else if (sys_data1_req && (~sys_data_req || sys_rr)) sys_owner = SYS_DATA1;
+    else if (sys_data_req) sys_owner = SYS_DATA;
+    else if (sys_dma_req) sys_owner = SYS_DMA;
+    else sys_owner = SYS_DATA;
 
     // wishbone pass-thru
-    sys_stb_o = sys_data_req;
-    sys_adr_o = data_addr;
-    sys_we_o = data_wr_en;
-    sys_dat_o = data_wr_data;
-    sys_sel_o = data_mask;
+    case (sys_owner)
+        SYS_DMA: begin
+            sys_stb_o = sys_dma_req;
+            sys_adr_o = dma_addr;
+            sys_we_o = dma_wr_en;
+            sys_dat_o = dma_wr_data;
+            sys_sel_o = dma_mask;
+        end
+        SYS_DATA1: begin
+            sys_stb_o = sys_data1_req;
+            sys_adr_o = data1_addr;
+            sys_we_o = data1_wr_en;
+            sys_dat_o = data1_wr_data;
+            sys_sel_o = data1_mask;
+        end
+        default: begin
+            sys_stb_o = sys_data_req;
+            sys_adr_o = data_addr;
+            sys_we_o = data_wr_en;
+            sys_dat_o = data_wr_data;
+            sys_sel_o = data_mask;
+        end
+    endcase
 end 
 
+always_ff @(posedge clk or negedge rstz) begin
+    if (~rstz) begin
+        sys_busy <= 1'b0;
+        sys_owner_locked <= SYS_DATA;
+    end
+    else begin
+        sys_busy <= sys_stb_o & ~sys_ack_i;
+        sys_owner_locked <= sys_owner;
+    end
+end
+
+// Round-robin turns
+always_ff @(posedge clk or negedge rstz) begin
+    if (~rstz) begin
+        bootrom_rr <= 1'b0;
+        mem0_rr <= 1'b0;
+        mem1_rr <= 1'b0;
+        sys_rr <= 1'b0;
+    end
+    else begin
+        if (bootrom_data_win | bootrom_instr_win) bootrom_rr <= 1'b1;
+        else if (bootrom_data1_win | bootrom_instr1_win) bootrom_rr <= 1'b0;
+
+        if (mem0_data_win | mem0_instr_win) mem0_rr <= 1'b1;
+        else if (mem0_data1_win | mem0_instr1_win) mem0_rr <= 1'b0;
+
+        if (mem1_data_win | mem1_instr_win) mem1_rr <= 1'b1;
+        else if (mem1_data1_win | mem1_instr1_win) mem1_rr <= 1'b0;
+
+        if (~sys_busy && sys_stb_o && sys_owner != SYS_DMA) sys_rr <= sys_owner == SYS_DATA;
+    end
+end
+
 // ============================================================
 // Grant Mux
 // ============================================================
@@ -214,12 +534,18 @@ end
 always_ff @(posedge clk or negedge rstz) begin
     if (~rstz) begin
         instr_gnt <= NONE;
+        instr1_gnt <= NONE;
     end
     else begin
-        if (bootrom_instr_req && ~bootrom_data_req) instr_gnt <= BOOTROM;
-        else if (mem0_instr_req && ~mem0_data_req) instr_gnt <= MEM0;
-        else if (mem1_instr_req && ~mem1_data_req) instr_gnt <= MEM1;
+        if (bootrom_instr_win) instr_gnt <= BOOTROM;
+        else if (mem0_instr_win) instr_gnt <= MEM0;
+        else if (mem1_instr_win) instr_gnt <= MEM1;
         else instr_gnt <= NONE;
+
+        if (bootrom_instr1_win) instr1_gnt <= BOOTROM;
+        else if (mem0_instr1_win) instr1_gnt <= MEM0;
+        else if (mem1_instr1_win) instr1_gnt <= MEM1;
+        else instr1_gnt <= NONE;
     end
 end
 
@@ -227,15 +553,36 @@ end
 always_ff @(posedge clk or negedge rstz) begin
     if (~rstz) begin
         data_gnt <= NONE;
+        data1_gnt <= NONE;
     end
     else begin
-        // if in a bus cycle for the system, then wait for the ack
         // memory access are single cycle
-        if (bootrom_data_req) data_gnt <= BOOTROM;
-        else if (mem0_data_req) data_gnt <= MEM0;
-        else if (mem1_data_req) data_gnt <= MEM1;
-        else if (sys_data_req && sys_ack_i) data_gnt <= SYS;
+        // if in a bus cycle for the system, then the ack is from the sysbus
+        if (bootrom_data_win) data_gnt <= BOOTROM;
+        else if (mem0_data_win) data_gnt <= MEM0;
+        else if (mem1_data_win) data_gnt <= MEM1;
+        else if (sys_data_req && sys_owner == SYS_DATA) data_gnt <= SYS;
         else data_gnt <= NONE;
+
+        if (bootrom_data1_win) data1_gnt <= BOOTROM;
+        else if (mem0_data1_win) data1_gnt <= MEM0;
+        else if (mem1_data1_win) data1_gnt <= MEM1;
+        else if (sys_data1_req && sys_owner == SYS_DATA1) data1_gnt <= SYS;
+        else data1_gnt <= NONE;
+    end
+end
+
+// DMA Grant Mux
+always_ff @(posedge clk or negedge rstz) begin
+    if (~rstz) begin
+        dma_gnt <= NONE;
+    end
+    else begin
+        if (bootrom_dma_win) dma_gnt <= BOOTROM;
+        else if (mem0_dma_win) dma_gnt <= MEM0;
+        else if (mem1_dma_win) dma_gnt <= MEM1;
+        else if (sys_dma_req && sys_owner == SYS_DMA) dma_gnt <= SYS;
+        else dma_gnt <= NONE;
     end
 end
 
@@ -252,14 +599,77 @@ end
 
 // Select grant source for data read-data
 always_comb begin
-    data_ack = data_gnt != NONE;
+    data_ack = (data_gnt == SYS) ? sys_ack_i : data_gnt != NONE;
 
     case (data_gnt)
         MEM0    : data_rd_data = mem0_rd_data;
         MEM1    : data_rd_data = mem1_rd_data;
         SYS     : data_rd_data = sys_dat_i;
         default : data_rd_data = bootrom_rd_data;
-    endcase // instr_gnt
+    endcase // data_gnt
+end
+
+// Select grant source for core1 instr read-data
+always_comb begin
+    instr1_ack = instr1_gnt != NONE;
+
+    case (instr1_gnt)
+        MEM0    : instr1_data = mem0_rd_data;
+        MEM1    : instr1_data = mem1_rd_data;
+        default : instr1_data = bootrom_rd_data;
+    endcase // instr1_gnt
+end
+
+// Select grant source for core1 data read-data
+always_comb begin
+    data1_ack = (data1_gnt == SYS) ? sys_ack_i : data1_gnt != NONE;
+
+    case (data1_gnt)
+        MEM0    : data1_rd_data = mem0_rd_data;
+        MEM1    : data1_rd_data = mem1_rd_data;
+        SYS     : data1_rd_data = sys_dat_i;
+        default : data1_rd_data = bootrom_rd_data;
+    endcase // data1_gnt
+end
+
+// Select grant source for dma read-data
+always_comb begin
+    dma_ack = (dma_gnt == SYS) ? sys_ack_i : dma_gnt != NONE;
+
+    case (dma_gnt)
+        MEM0    : dma_rd_data = mem0_rd_data;
+        MEM1    : dma_rd_data = mem1_rd_data;
+        SYS     : dma_rd_data = sys_dat_i;
+        default : dma_rd_data = bootrom_rd_data;
+    endcase // dma_gnt
+end
+
+// ============================================================
+// Statistics
+// ============================================================
+// An instr interface stalls on a resource that it requests, and loses
+assign instr_conflict = (bootrom_instr_req & ~bootrom_instr_win) | (bootrom_instr1_req & ~bootrom_instr1_win)
+                      | (mem0_instr_req & ~mem0_instr_win) | (mem0_instr1_req & ~mem0_instr1_win)
+                      | (mem1_instr_req & ~mem1_instr_win) | (mem1_instr1_req & ~mem1_instr1_win);
+
+// Events per cycle, up to one per core
+assign stats_event[0] = {1'b0, instr_conflict};
+assign stats_event[1] = 2'(instr_ack) + 2'(instr1_ack);
+assign stats_event[2] = 2'(data_ack) + 2'(data1_ack);
+assign stats_event[3] = {1'b0, bootrom_en};
+assign stats_event[4] = {1'b0, mem0_en};
+assign stats_event[5] = {1'b0, mem1_en};
+assign stats_event[6] = {1'b0, sys_stb_o};
+assign stats_event[7] = {1'b0, dma_ack};
+
+always_ff @(posedge clk or negedge rstz) begin
+    if (~rstz) begin
+        stats <= '0;
+    end
+    else begin
+        for (int i=0; i<8; i++)
+            stats[i] <= stats[i] + 32'(stats_event[i]);
+    end
 end
 
-endmodule 
+endmodule
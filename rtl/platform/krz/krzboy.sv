@@ -15,6 +15,8 @@ Kronos: Zero Degree
 | SCLK      |         15 | SPI FLASH clock                 | board    |
 | MOSI      |         14 | SPI FLASH data in               | board    |
 | MISO      |         17 | SPI FLASH data out              | board    |
+| IO2       |         12 | SPI FLASH IO2 (WP), Quad SPI    | board    |
+| IO3       |         13 | SPI FLASH IO3 (HOLD), Quad SPI  | board    |
 | OLED_CLK  |         43 | Duplicate SCLK - OLED SPI clock | PMOD1B   |
 | OLED_DATA |         38 | Duplicate MOSI - OLED SPI data  | PMOD1B   |
 | GPIO0     |         11 | LEDR                            | board    |
@@ -35,16 +37,21 @@ Kronos: Zero Degree
 
 Kronos-powered SoC designed for the iCE40UP5K
 
-  - 128KB of RAM as 2 contiguous banks of 64KB.
-  - 1KB Bootrom for loading program from flash to RAM.
+  - 128KB of RAM as 2 contiguous banks of 64KB, or interleaved (MEM_INTERLEAVE).
+  - 2KB Bootrom for loading program from flash to RAM.
+  - 4KB Data TCM (DTCM_KB), for the stack and hot data.
   - UART TX with 128B buffer.
     - Configurable baud rate
-  - SPI Master with 256B RX/TX buffers.
+  - SPI Master with 512B RX/TX buffers.
     - Configurable SPI Mode and rate.
+    - 32-bit data port, and transfers with automatic chip select.
+    - Dual/Quad SPI transfers, for fast flash reads.
     - Max 12MHz.
   - 12 Bidirectional configurable GPIO.
     - Debounced inputs.
   - General Purpose registers
+  - 4-channel DMA, for memory and peripheral transfers.
+  - Optionally, a second Kronos core (CORES), and a mailbox with semaphores.
   - Tiny PWM for Speaker
 
 The bootrom, and two 64KB banks of main memory are individually arbitrated.
@@ -57,14 +64,34 @@ But, usually, most of the code should be run from bank0, while frequent data
 like the stack will be in bank1. In a design without cache, this setup
 will lead to optimal performance.
 
+With MEM_INTERLEAVE, the banks are interleaved on that address bit (see krz_xbar),
+and the instr and data accesses mostly hit different banks whatever the layout.
+The contention and the usage of each resource are counted in the KRZ_XBAR_*
+registers.
+
+The Data TCM (see krz_dtcm) is on the data interface, in front of the crossbar.
+Data placed in it (the .dtcm section) is accessed without any contention.
+
+With CORES = 2, a second core (mhartid = 1) shares the crossbar, and the cores
+are served round-robin on every resource. It has its own Data TCM, at the same
+address. The second core is held in reset until released through the mailbox
+(krz_mbox), and then starts from the RAM. The cores synchronize with the
+semaphores, and signal each other with the mailboxes (software interrupt).
+
 */
 
-module krzboy (
+module krzboy #(
+  parameter MEM_INTERLEAVE = 0,
+  parameter DTCM_KB = 4,
+  parameter CORES = 1
+)(
   input  logic    RSTN,
   output logic    TX,
   output logic    SCLK,
-  output logic    MOSI,
-  input  logic    MISO,
+  inout  wire     MOSI,
+  inout  wire     MISO,
+  inout  wire     IO2,
+  inout  wire     IO3,
   output logic    OLED_CLK,
   output logic    OLED_DATA,
   inout  wire     GPIO0,
@@ -100,6 +127,40 @@ logic data_wr_en;
 logic data_req;
 logic data_ack;
 
+logic [23:0] xdata_addr;
+logic [31:0] xdata_rd_data;
+logic [31:0] xdata_wr_data;
+logic [3:0] xdata_mask;
+logic xdata_wr_en;
+logic xdata_req;
+logic xdata_ack;
+
+logic [23:0] instr1_addr;
+logic [31:0] instr1_data;
+logic instr1_req;
+logic instr1_ack;
+logic [23:0] xdata1_addr;
+logic [31:0] xdata1_rd_data;
+logic [31:0] xdata1_wr_data;
+logic [3:0] xdata1_mask;
+logic xdata1_wr_en;
+logic xdata1_req;
+logic xdata1_ack;
+
+logic [CORES-1:0] core_run;
+logic [CORES-1:0] mbox_msip;
+
+logic [23:0] dma_addr;
+logic [31:0] dma_rd_data;
+logic [31:0] dma_wr_data;
+logic [3:0] dma_mask;
+logic dma_wr_en;
+logic dma_req;
+logic dma_ack;
+logic [2:0] dma_dreq;
+logic [2:0] dma_dreq_word;
+logic dma_irq;
+
 // ----------------------------
 logic [23:0] bootrom_addr;
 logic [31:0] bootrom_rd_data;
@@ -126,22 +187,29 @@ logic sys_we;
 logic [3:0] sys_sel;
 logic sys_stb;
 logic sys_ack;
+logic [7:0][31:0] xbar_stats;
 
 // ----------------------------
 logic [5:0] perif_adr;
-logic [2:0][31:0] perif_rdat;
+logic [5:0][31:0] perif_rdat;
 logic [31:0] perif_wdat;
 logic perif_we;
-logic [2:0] perif_stb;
-logic [2:0] perif_ack;
+logic [3:0] perif_sel;
+logic [5:0] perif_stb;
+logic [5:0] perif_ack;
 
 logic gpreg_stb, gpreg_ack;
 logic uart_stb, uart_ack;
 logic spim_stb, spim_ack;
+logic dmac_stb, dmac_ack;
+logic mbox_stb, mbox_ack;
+logic rsvd_stb;
 
 logic [31:0] gpreg_dat;
 logic [7:0] uart_dat;
-logic [7:0] spim_dat;
+logic [31:0] spim_dat;
+logic [31:0] dmac_dat;
+logic [31:0] mbox_dat;
 
 // ----------------------------
 logic [11:0] gpio_dir;
@@ -157,8 +225,21 @@ logic spim_cpol;
 logic spim_cpha;
 logic spim_tx_clear;
 logic spim_rx_clear;
-logic [7:0] spim_tx_size;
-logic [7:0] spim_rx_size;
+logic [9:0] spim_tx_size;
+logic [9:0] spim_rx_size;
+logic spim_xfer_mode;
+logic [15:0] spim_xfer_len;
+logic spim_xfer_hold;
+logic spim_xfer_start;
+logic spim_cs_sel;
+logic [15:0] spim_xfer_left;
+logic spim_xfer_busy;
+logic spim_csn;
+logic [1:0] spim_xfer_width;
+logic spim_xfer_rd;
+logic [3:0] spim_io_out;
+logic [3:0] spim_io_oe;
+logic [3:0] spim_io_in;
 
 
 // ============================================================
@@ -211,29 +292,184 @@ kronos_core #(
   .data_wr_en        (data_wr_en  ),
   .data_req          (data_req    ),
   .data_ack          (data_ack    ),
-  .software_interrupt(1'b0        ),
+  .software_interrupt(mbox_msip[0]),
   .timer_interrupt   (1'b0        ),
-  .external_interrupt(1'b0        )
+  .external_interrupt(dma_irq     ),
+  .rvfi_valid        (            ),
+  .rvfi_order        (            ),
+  .rvfi_insn         (            ),
+  .rvfi_trap         (            ),
+  .rvfi_pc_rdata     (            ),
+  .rvfi_pc_wdata     (            ),
+  .rvfi_rd_addr      (            ),
+  .rvfi_rd_wdata     (            ),
+  .rvfi_mem_addr     (            ),
+  .rvfi_mem_rmask    (            ),
+  .rvfi_mem_wmask    (            ),
+  .rvfi_mem_rdata    (            ),
+  .rvfi_mem_wdata    (            )
+);
+
+// ============================================================
+// Kronos, Core1
+// ============================================================
+// With CORES = 2, the second core (mhartid = 1) has its own Data TCM, and
+// starts from the RAM once released by the mailbox (KRZ_MBOX_RUN)
+
+generate
+  if (CORES > 1) begin : gen_core1
+    logic [31:0] instr1_addr32;
+    logic [31:0] data1_addr;
+    logic [31:0] data1_rd_data;
+    logic [31:0] data1_wr_data;
+    logic [3:0] data1_mask;
+    logic data1_wr_en;
+    logic data1_req;
+    logic data1_ack;
+    logic core1_rstz;
+
+    // Synchronous release from reset
+    always_ff @(posedge clk or negedge rstz) begin
+      if (~rstz) core1_rstz <= 1'b0;
+      else core1_rstz <= core_run[1];
+    end
+
+    kronos_core #(
+      .BOOT_ADDR(32'h10000),
+      .FAST_BRANCH(1),
+      .EN_COUNTERS(1),
+      .EN_COUNTERS64B(0),
+      .CATCH_ILLEGAL_INSTR(1),
+      .CATCH_MISALIGNED_JMP(0),
+      .CATCH_MISALIGNED_LDST(0),
+      .NUM_HPMCOUNTERS(4),
+      .HART_ID(1)
+    ) u_core1 (
+      .clk               (clk          ),
+      .rstz              (core1_rstz   ),
+      .instr_addr        (instr1_addr32),
+      .instr_data        (instr1_data  ),
+      .instr_req         (instr1_req   ),
+      .instr_ack         (instr1_ack   ),
+      .data_addr         (data1_addr   ),
+      .data_rd_data      (data1_rd_data),
+      .data_wr_data      (data1_wr_data),
+      .data_mask         (data1_mask   ),
+      .data_wr_en        (data1_wr_en  ),
+      .data_req          (data1_req    ),
+      .data_ack          (data1_ack    ),
+      .software_interrupt(mbox_msip[1] ),
+      .timer_interrupt   (1'b0         ),
+      .external_interrupt(1'b0         ),
+      .rvfi_valid        (             ),
+      .rvfi_order        (             ),
+      .rvfi_insn         (             ),
+      .rvfi_trap         (             ),
+      .rvfi_pc_rdata     (             ),
+      .rvfi_pc_wdata     (             ),
+      .rvfi_rd_addr      (             ),
+      .rvfi_rd_wdata     (             ),
+      .rvfi_mem_addr     (             ),
+      .rvfi_mem_rmask    (             ),
+      .rvfi_mem_wmask    (             ),
+      .rvfi_mem_rdata    (             ),
+      .rvfi_mem_wdata    (             )
+    );
+
+    assign instr1_addr = instr1_addr32[23:0];
+
+    krz_dtcm #(.KB(DTCM_KB)) u_dtcm1 (
+      .clk         (clk             ),
+      .rstz        (rstz            ),
+      .data_addr   (data1_addr[23:0]),
+      .data_rd_data(data1_rd_data   ),
+      .data_wr_data(data1_wr_data   ),
+      .data_mask   (data1_mask      ),
+      .data_wr_en  (data1_wr_en     ),
+      .data_req    (data1_req       ),
+      .data_ack    (data1_ack       ),
+      .xbar_addr   (xdata1_addr     ),
+      .xbar_rd_data(xdata1_rd_data  ),
+      .xbar_wr_data(xdata1_wr_data  ),
+      .xbar_mask   (xdata1_mask     ),
+      .xbar_wr_en  (xdata1_wr_en    ),
+      .xbar_req    (xdata1_req      ),
+      .xbar_ack    (xdata1_ack      )
+    );
+  end
+  else begin : gen_no_core1
+    assign instr1_addr = '0;
+    assign instr1_req = 1'b0;
+    assign xdata1_addr = '0;
+    assign xdata1_wr_data = '0;
+    assign xdata1_mask = '0;
+    assign xdata1_wr_en = 1'b0;
+    assign xdata1_req = 1'b0;
+  end
+endgenerate
+
+// ============================================================
+// Data TCM
+// ============================================================
+
+krz_dtcm #(.KB(DTCM_KB)) u_dtcm (
+  .clk         (clk            ),
+  .rstz        (rstz           ),
+  .data_addr   (data_addr[23:0]),
+  .data_rd_data(data_rd_data   ),
+  .data_wr_data(data_wr_data   ),
+  .data_mask   (data_mask      ),
+  .data_wr_en  (data_wr_en     ),
+  .data_req    (data_req       ),
+  .data_ack    (data_ack       ),
+  .xbar_addr   (xdata_addr     ),
+  .xbar_rd_data(xdata_rd_data  ),
+  .xbar_wr_data(xdata_wr_data  ),
+  .xbar_mask   (xdata_mask     ),
+  .xbar_wr_en  (xdata_wr_en    ),
+  .xbar_req    (xdata_req      ),
+  .xbar_ack    (xdata_ack      )
 );
 
 // ============================================================
 // Primary Crossbar and Memory
 // ============================================================
 
-krz_xbar u_xbar (
+krz_xbar #(
+  .MEM_INTERLEAVE(MEM_INTERLEAVE),
+  .CORES         (CORES         )
+) u_xbar (
   .clk            (clk             ),
   .rstz           (rstz            ),
   .instr_addr     (instr_addr[23:0]),
   .instr_data     (instr_data      ),
   .instr_req      (instr_req       ),
   .instr_ack      (instr_ack       ),
-  .data_addr      (data_addr[23:0] ),
-  .data_rd_data   (data_rd_data    ),
-  .data_wr_data   (data_wr_data    ),
-  .data_mask      (data_mask       ),
-  .data_wr_en     (data_wr_en      ),
-  .data_req       (data_req        ),
-  .data_ack       (data_ack        ),
+  .data_addr      (xdata_addr      ),
+  .data_rd_data   (xdata_rd_data   ),
+  .data_wr_data   (xdata_wr_data   ),
+  .data_mask      (xdata_mask      ),
+  .data_wr_en     (xdata_wr_en     ),
+  .data_req       (xdata_req       ),
+  .data_ack       (xdata_ack       ),
+  .instr1_addr    (instr1_addr     ),
+  .instr1_data    (instr1_data     ),
+  .instr1_req     (instr1_req      ),
+  .instr1_ack     (instr1_ack      ),
+  .data1_addr     (xdata1_addr     ),
+  .data1_rd_data  (xdata1_rd_data  ),
+  .data1_wr_data  (xdata1_wr_data  ),
+  .data1_mask     (xdata1_mask     ),
+  .data1_wr_en    (xdata1_wr_en    ),
+  .data1_req      (xdata1_req      ),
+  .data1_ack      (xdata1_ack      ),
+  .dma_addr       (dma_addr        ),
+  .dma_rd_data    (dma_rd_data     ),
+  .dma_wr_data    (dma_wr_data     ),
+  .dma_mask       (dma_mask        ),
+  .dma_wr_en      (dma_wr_en       ),
+  .dma_req        (dma_req         ),
+  .dma_ack        (dma_ack         ),
   .bootrom_addr   (bootrom_addr    ),
   .bootrom_rd_data(bootrom_rd_data ),
   .bootrom_en     (bootrom_en      ),
@@ -255,10 +491,11 @@ krz_xbar u_xbar (
   .sys_we_o       (sys_we          ),
   .sys_sel_o      (sys_sel         ),
   .sys_stb_o      (sys_stb         ),
-  .sys_ack_i      (sys_ack         )
+  .sys_ack_i      (sys_ack         ),
+  .stats          (xbar_stats      )
 );
 
-generic_rom #(.AWIDTH(24), .KB(1)) u_bootrom (
+generic_rom #(.AWIDTH(24), .KB(2)) u_bootrom (
   .clk    (clk            ),
   .addr   (bootrom_addr   ),
   .rdata  (bootrom_rd_data),
@@ -290,54 +527,70 @@ ice40up_sram64K #(.AWIDTH(24)) u_mem1 (
 // ============================================================
 
 // System Bus
-krz_sysbus u_sysbus (
+krz_sysbus #(.N(6)) u_sysbus (
   .clk        (clk       ),
   .rstz       (rstz      ),
   .sys_adr_i  (sys_adr   ),
   .sys_dat_i  (sys_wdat  ),
   .sys_dat_o  (sys_rdat  ),
   .sys_we_i   (sys_we    ),
+  .sys_sel_i  (sys_sel   ),
   .sys_stb_i  (sys_stb   ),
   .sys_ack_o  (sys_ack   ),
   .perif_adr_o(perif_adr ),
   .perif_dat_i(perif_rdat),
   .perif_dat_o(perif_wdat),
   .perif_we_o (perif_we  ),
+  .perif_sel_o(perif_sel ),
   .perif_stb_o(perif_stb ),
   .perif_ack_o(perif_ack )
 );
 
-assign {spim_stb, uart_stb, gpreg_stb} = perif_stb;
-assign perif_ack = {spim_ack, uart_ack, gpreg_ack};
+// 0x800300 is reserved, for the machine timer of kronos_sim
+assign {mbox_stb, dmac_stb, rsvd_stb, spim_stb, uart_stb, gpreg_stb} = perif_stb;
+assign perif_ack = {mbox_ack, dmac_ack, 1'b0, spim_ack, uart_ack, gpreg_ack};
 
 assign perif_rdat[0] = gpreg_dat;
 assign perif_rdat[1] = {24'h0, uart_dat};
-assign perif_rdat[2] = {24'h0, spim_dat};
+assign perif_rdat[2] = spim_dat;
+assign perif_rdat[3] = '0;
+assign perif_rdat[4] = dmac_dat;
+assign perif_rdat[5] = mbox_dat;
 
 
 // General Purpose Registers
 krz_gpreg u_gpr (
-  .clk           (clk           ),
-  .rstz          (rstz          ),
-  .adr_i         (perif_adr     ),
-  .dat_i         (perif_wdat    ),
-  .dat_o         (gpreg_dat     ),
-  .we_i          (perif_we      ),
-  .stb_i         (gpreg_stb     ),
-  .ack_o         (gpreg_ack     ),
-  .gpio_dir      (gpio_dir      ),
-  .gpio_write    (gpio_write    ),
-  .gpio_read     (gpio_read     ),
-  .uart_prescaler(uart_prescaler),
-  .uart_tx_clear (uart_tx_clear ),
-  .uart_tx_size  (uart_tx_size  ),
-  .spim_prescaler(spim_prescaler),
-  .spim_cpol     (spim_cpol     ),
-  .spim_cpha     (spim_cpha     ),
-  .spim_tx_clear (spim_tx_clear ),
-  .spim_rx_clear (spim_rx_clear ),
-  .spim_tx_size  (spim_tx_size  ),
-  .spim_rx_size  (spim_rx_size  )
+  .clk            (clk            ),
+  .rstz           (rstz           ),
+  .adr_i          (perif_adr      ),
+  .dat_i          (perif_wdat     ),
+  .dat_o          (gpreg_dat      ),
+  .we_i           (perif_we       ),
+  .stb_i          (gpreg_stb      ),
+  .ack_o          (gpreg_ack      ),
+  .gpio_dir       (gpio_dir       ),
+  .gpio_write     (gpio_write     ),
+  .gpio_read      (gpio_read      ),
+  .uart_prescaler (uart_prescaler ),
+  .uart_tx_clear  (uart_tx_clear  ),
+  .uart_tx_size   (uart_tx_size   ),
+  .spim_prescaler (spim_prescaler ),
+  .spim_cpol      (spim_cpol      ),
+  .spim_cpha      (spim_cpha      ),
+  .spim_tx_clear  (spim_tx_clear  ),
+  .spim_rx_clear  (spim_rx_clear  ),
+  .spim_xfer_mode (spim_xfer_mode ),
+  .spim_tx_size   (spim_tx_size   ),
+  .spim_rx_size   (spim_rx_size   ),
+  .spim_xfer_len  (spim_xfer_len  ),
+  .spim_xfer_hold (spim_xfer_hold ),
+  .spim_xfer_start(spim_xfer_start),
+  .spim_cs_sel    (spim_cs_sel    ),
+  .spim_xfer_width(spim_xfer_width),
+  .spim_xfer_rd   (spim_xfer_rd   ),
+  .spim_xfer_left (spim_xfer_left ),
+  .spim_xfer_busy (spim_xfer_busy ),
+  .xbar_stats     (xbar_stats     )
 );
 
 
@@ -363,34 +616,103 @@ assign uart_dat = '0;
 
 // SPI Master
 wb_spi_master #(
-  .BUFFER         (128),
+  .BUFFER         (512),
   .PRESCALER_WIDTH(8  )
 ) u_spim (
-  .clk      (clk            ),
-  .rstz     (rstz           ),
-  .sclk     (SCLK           ),
-  .mosi     (MOSI           ),
-  .miso     (MISO           ),
-  .prescaler(spim_prescaler ),
-  .cpol     (spim_cpol      ),
-  .cpha     (spim_cpha      ),
-  .tx_clear (spim_tx_clear  ),
-  .rx_clear (spim_rx_clear  ),
-  .tx_size  (spim_tx_size   ),
-  .rx_size  (spim_rx_size   ),
-  .dat_i    (perif_wdat[7:0]),
-  .dat_o    (spim_dat       ),
-  .we_i     (perif_we       ),
-  .stb_i    (spim_stb       ),
-  .ack_o    (spim_ack       )
+  .clk       (clk            ),
+  .rstz      (rstz           ),
+  .sclk      (SCLK           ),
+  .io_out    (spim_io_out    ),
+  .io_oe     (spim_io_oe     ),
+  .io_in     (spim_io_in     ),
+  .prescaler (spim_prescaler ),
+  .cpol      (spim_cpol      ),
+  .cpha      (spim_cpha      ),
+  .tx_clear  (spim_tx_clear  ),
+  .rx_clear  (spim_rx_clear  ),
+  .xfer_mode (spim_xfer_mode ),
+  .tx_size   (spim_tx_size   ),
+  .rx_size   (spim_rx_size   ),
+  .xfer_len  (spim_xfer_len  ),
+  .xfer_hold (spim_xfer_hold ),
+  .xfer_width(spim_xfer_width),
+  .xfer_rd   (spim_xfer_rd   ),
+  .xfer_start(spim_xfer_start),
+  .xfer_left (spim_xfer_left ),
+  .xfer_busy (spim_xfer_busy ),
+  .csn       (spim_csn       ),
+  .dat_i     (perif_wdat     ),
+  .dat_o     (spim_dat       ),
+  .sel_i     (perif_sel      ),
+  .we_i      (perif_we       ),
+  .stb_i     (spim_stb       ),
+  .ack_o     (spim_ack       )
+);
+
+
+// SPI IO: io0/io1 are MOSI/MISO, io2/io3 are the WP/HOLD of the flash
+assign MOSI = spim_io_oe[0] ? spim_io_out[0] : 1'bz;
+assign MISO = spim_io_oe[1] ? spim_io_out[1] : 1'bz;
+assign IO2  = spim_io_oe[2] ? spim_io_out[2] : 1'bz;
+assign IO3  = spim_io_oe[3] ? spim_io_out[3] : 1'bz;
+
+assign spim_io_in = {IO3, IO2, MISO, MOSI};
+
+
+// DMA
+// Requests: 1 - UART TX Queue has space, 2 - SPIM TX Queue has space for a word,
+// 3 - SPIM RX Queue has data (a byte, or a word for the word channels)
+assign dma_dreq[0] = uart_tx_size < 8'd128;
+assign dma_dreq[1] = spim_tx_size < 10'd509;
+assign dma_dreq[2] = spim_rx_size != '0;
+
+assign dma_dreq_word[0] = dma_dreq[0];
+assign dma_dreq_word[1] = dma_dreq[1];
+assign dma_dreq_word[2] = spim_rx_size >= 10'd4;
+
+krz_dma #(.CHANNELS(4)) u_dma (
+  .clk        (clk        ),
+  .rstz       (rstz       ),
+  .adr_i      (perif_adr  ),
+  .dat_i      (perif_wdat ),
+  .dat_o      (dmac_dat   ),
+  .we_i       (perif_we   ),
+  .stb_i      (dmac_stb   ),
+  .ack_o      (dmac_ack   ),
+  .dma_addr   (dma_addr   ),
+  .dma_rd_data(dma_rd_data),
+  .dma_wr_data(dma_wr_data),
+  .dma_mask   (dma_mask   ),
+  .dma_wr_en  (dma_wr_en  ),
+  .dma_req    (dma_req    ),
+  .dma_ack    (dma_ack    ),
+  .dreq       (dma_dreq   ),
+  .dreq_word  (dma_dreq_word),
+  .irq        (dma_irq    )
+);
+
+
+// Mailbox, and the run control of the cores
+krz_mbox #(.CORES(CORES)) u_mbox (
+  .clk  (clk       ),
+  .rstz (rstz      ),
+  .adr_i(perif_adr ),
+  .dat_i(perif_wdat),
+  .dat_o(mbox_dat  ),
+  .we_i (perif_we  ),
+  .stb_i(mbox_stb  ),
+  .ack_o(mbox_ack  ),
+  .msip (mbox_msip ),
+  .run  (core_run  )
 );
 
 
 // Bidirectional GPIO x 12
+// The SPIM transfer also drives the chip select on GPIO2 (Flash) or GPIO3
 assign GPIO0  = gpio_dir[0]  ? gpio_write[0]  : 1'bz;
 assign GPIO1  = gpio_dir[1]  ? gpio_write[1]  : 1'bz;
-assign GPIO2  = gpio_dir[2]  ? gpio_write[2]  : 1'bz;
-assign GPIO3  = gpio_dir[3]  ? gpio_write[3]  : 1'bz;
+assign GPIO2  = gpio_dir[2]  ? (gpio_write[2] & (spim_csn | spim_cs_sel)) : 1'bz;
+assign GPIO3  = gpio_dir[3]  ? (gpio_write[3] & (spim_csn | ~spim_cs_sel)) : 1'bz;
 
 assign GPIO4  = gpio_dir[4]  ? gpio_write[4]  : 1'bz;
 assign GPIO5  = gpio_dir[5]  ? gpio_write[5]  : 1'bz;
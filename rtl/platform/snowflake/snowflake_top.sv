@@ -106,7 +106,20 @@ kronos_core #(
   .data_ack          (data_ack    ),
   .software_interrupt(1'b0        ),
   .timer_interrupt   (1'b0        ),
-  .external_interrupt(1'b0        )
+  .external_interrupt(1'b0        ),
+  .rvfi_valid        (            ),
+  .rvfi_order        (            ),
+  .rvfi_insn         (            ),
+  .rvfi_trap         (            ),
+  .rvfi_pc_rdata     (            ),
+  .rvfi_pc_wdata     (            ),
+  .rvfi_rd_addr      (            ),
+  .rvfi_rd_wdata     (            ),
+  .rvfi_mem_addr     (            ),
+  .rvfi_mem_rmask    (            ),
+  .rvfi_mem_wmask    (            ),
+  .rvfi_mem_rdata    (            ),
+  .rvfi_mem_wdata    (            )
 );
 
 snowflake_system_bus u_sysbus (
@@ -0,0 +1,118 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+Kronos Basic Block Vectors
+
+Profiles the basic blocks executed in fixed intervals of retired instructions,
+for SimPoint-style sampled simulation. A basic block is identified by the PC
+of its first instruction, and ends at any control flow instruction or trap.
+
+Output is in the SimPoint format (.bb), one line per interval:
+  T:<block id>:<instructions> :<block id>:<instructions> ...
+where the block ids start at 1, in order of first execution, and the count is
+that of the instructions retired in the block, during the interval.
+*/
+
+#ifndef BBV_H
+#define BBV_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rvfi.h"
+
+class BBVProfile : public RetireListener {
+  private:
+    FILE *fp;
+    uint64_t interval;
+    uint64_t boundary;
+    uint64_t instret;
+
+    std::unordered_map<uint32_t, uint32_t> ids;
+    std::vector<uint64_t> counts;
+    std::vector<uint32_t> touched;
+
+    uint32_t block_pc;
+    uint64_t block_len;
+
+    void end_block(void) {
+      if (block_len == 0) return;
+
+      auto it = ids.find(block_pc);
+      uint32_t id;
+      if (it == ids.end()) {
+        id = ids.size() + 1;
+        ids[block_pc] = id;
+        counts.push_back(0);
+      }
+      else id = it->second;
+
+      if (counts[id - 1] == 0) touched.push_back(id);
+      counts[id - 1] += block_len;
+      block_len = 0;
+    }
+
+    void end_interval(void) {
+      fputc('T', fp);
+      for (auto id : touched) {
+        fprintf(fp, ":%u:%lu ", id, (unsigned long)counts[id - 1]);
+        counts[id - 1] = 0;
+      }
+      fputc('\n', fp);
+      touched.clear();
+    }
+
+  public:
+    BBVProfile(std::string filename, uint64_t interval) {
+      this->interval = interval;
+      boundary = interval;
+      instret = 0;
+      block_pc = 0;
+      block_len = 0;
+
+      fp = fopen(filename.c_str(), "w");
+    }
+
+    ~BBVProfile(void) {
+      if (fp) fclose(fp);
+    }
+
+    void retire(const Retired &r, uint64_t /* cycle */) {
+      // The order accounts for fused pairs
+      uint64_t n = r.order + 1 - instret;
+      instret = r.order + 1;
+
+      if (fp == NULL) return;
+
+      if (block_len == 0) block_pc = r.pc_rdata;
+      block_len += n;
+
+      if (r.trap || r.pc_wdata != r.pc_rdata + 4) {
+        end_block();
+
+        // Like valgrind's exp-bbv, a block counts to the interval it ends in,
+        // so that the intervals end on a block boundary
+        if (instret >= boundary) {
+          end_interval();
+          while (boundary <= instret) boundary += interval;
+        }
+      }
+    }
+
+    void finish(uint64_t /* cycles */) {
+      if (fp == NULL) return;
+
+      // Partial last interval
+      end_block();
+      if (!touched.empty()) end_interval();
+
+      fclose(fp);
+      fp = NULL;
+    }
+};
+
+#endif // BBV_H
@@ -0,0 +1,179 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+Kronos Branch Trace
+
+The outcomes of the retired control flow instructions, in program order.
+The kind of the instruction is decoded from its instruction word, and the
+outcome is taken from the retirement trace (next PC).
+
+Format (.krzb)
+  Header: "KRZB", version (1B), 3B reserved
+  Record: pc (4B), target (4B), kind (1B), taken (1B)
+  Trailer: kind = BR_END record (pc, target = 0), then the instructions
+           retired (8B) and the cycles simulated (8B)
+
+The target of a conditional branch is recorded even if it isn't taken.
+*/
+
+#ifndef BRANCH_TRACE_H
+#define BRANCH_TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "rvfi.h"
+
+#define KRZB_VERSION    1
+
+enum BranchKind {
+  BR_COND   = 0,    // beq, bne, blt, bge, bltu, bgeu
+  BR_JUMP   = 1,    // jal, without link
+  BR_CALL   = 2,    // jal, linking ra/t0
+  BR_IJUMP  = 3,    // jalr, without link
+  BR_ICALL  = 4,    // jalr, linking ra/t0
+  BR_RET    = 5,    // jalr x0, ra/t0
+  BR_END    = 0xFF
+};
+
+struct BranchRecord {
+  uint32_t pc;
+  uint32_t target;
+  uint8_t  kind;
+  uint8_t  taken;
+};
+
+static inline bool is_link(uint32_t r) {
+  return r == 1 || r == 5;
+}
+
+// Retirement listener that writes the branch trace
+class BranchTrace : public RetireListener {
+  private:
+    FILE *fp;
+    uint64_t instret;
+
+    void put(uint32_t pc, uint32_t target, uint8_t kind, uint8_t taken) {
+      uint8_t rec[10];
+      memcpy(rec, &pc, 4);
+      memcpy(rec + 4, &target, 4);
+      rec[8] = kind;
+      rec[9] = taken;
+      fwrite(rec, 1, 10, fp);
+    }
+
+  public:
+    BranchTrace(std::string filename) {
+      const uint8_t hdr[8] = {'K', 'R', 'Z', 'B', KRZB_VERSION, 0, 0, 0};
+
+      instret = 0;
+      fp = fopen(filename.c_str(), "wb");
+      if (fp) {
+        setvbuf(fp, NULL, _IOFBF, 1 << 20);
+        fwrite(hdr, 1, 8, fp);
+      }
+    }
+
+    ~BranchTrace(void) {
+      if (fp) fclose(fp);
+    }
+
+    void retire(const Retired &r, uint64_t /* cycle */) {
+      uint32_t opcode = r.insn & 0x7f;
+      uint32_t rd = (r.insn >> 7) & 0x1f;
+      uint32_t rs1 = (r.insn >> 15) & 0x1f;
+      int32_t imm;
+
+      instret = r.order + 1;
+
+      if (fp == NULL || r.trap) return;
+
+      if (opcode == 0x63) {
+        // B-type immediate
+        imm = ((int32_t)(r.insn & 0x80000000) >> 19)
+            | ((r.insn & 0x80) << 4)
+            | ((r.insn >> 20) & 0x7e0)
+            | ((r.insn >> 7) & 0x1e);
+        put(r.pc_rdata, r.pc_rdata + imm, BR_COND, r.pc_wdata != r.pc_rdata + 4);
+      }
+      else if (opcode == 0x6f) {
+        put(r.pc_rdata, r.pc_wdata, is_link(rd) ? BR_CALL : BR_JUMP, 1);
+      }
+      else if (opcode == 0x67) {
+        uint8_t kind;
+        if (is_link(rd)) kind = BR_ICALL;
+        else if (rd == 0 && is_link(rs1)) kind = BR_RET;
+        else kind = BR_IJUMP;
+        put(r.pc_rdata, r.pc_wdata, kind, 1);
+      }
+    }
+
+    void finish(uint64_t cycles) {
+      if (fp == NULL) return;
+
+      put(0, 0, BR_END, 0);
+      fwrite(&instret, 8, 1, fp);
+      fwrite(&cycles, 8, 1, fp);
+
+      fclose(fp);
+      fp = NULL;
+    }
+};
+
+// Branch trace reader
+class BranchTraceReader {
+  private:
+    FILE *fp;
+
+  public:
+    uint64_t instret;
+    uint64_t cycles;
+
+    BranchTraceReader(std::string filename) {
+      uint8_t hdr[8];
+
+      instret = 0;
+      cycles = 0;
+
+      fp = fopen(filename.c_str(), "rb");
+      if (fp == NULL) return;
+
+      if (fread(hdr, 1, 8, fp) != 8 || memcmp(hdr, "KRZB", 4) != 0 || hdr[4] != KRZB_VERSION) {
+        fclose(fp);
+        fp = NULL;
+      }
+    }
+
+    ~BranchTraceReader(void) {
+      if (fp) fclose(fp);
+    }
+
+    bool ok(void) {
+      return fp != NULL;
+    }
+
+    // Returns false at the end of the trace, where the totals are read
+    bool next(BranchRecord &b) {
+      uint8_t rec[10];
+
+      if (fp == NULL || fread(rec, 1, 10, fp) != 10) return false;
+
+      memcpy(&b.pc, rec, 4);
+      memcpy(&b.target, rec + 4, 4);
+      b.kind = rec[8];
+      b.taken = rec[9];
+
+      if (b.kind == BR_END) {
+        if (fread(&instret, 8, 1, fp) != 1) instret = 0;
+        if (fread(&cycles, 8, 1, fp) != 1) cycles = 0;
+        return false;
+      }
+
+      return true;
+    }
+};
+
+#endif // BRANCH_TRACE_H
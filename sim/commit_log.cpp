@@ -0,0 +1,358 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstring>
+#include <iostream>
+
+#include "commit_log.h"
+
+using namespace std;
+
+// Flush the write buffer to file, beyond this size
+#define WRITE_CHUNK   (1 << 20)
+
+// ============================================================
+// Helpers
+
+static inline uint64_t zigzag(int64_t v) {
+  return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t v) {
+  return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static inline int mask_offset(uint8_t mask) {
+  for (int i=0; i<4; i++) {
+    if (mask & (1 << i)) return i;
+  }
+  return 0;
+}
+
+static inline int mask_size(uint8_t mask) {
+  return __builtin_popcount(mask);
+}
+
+void TraceState::reset(void) {
+  next_pc = 0;
+  next_order = 0;
+  mem_addr = 0;
+  memset(insn_pc, 0xff, sizeof(insn_pc));
+  memset(insn, 0, sizeof(insn));
+}
+
+// ============================================================
+// Encoder
+
+TraceEncoder::TraceEncoder(void) {
+  state.reset();
+}
+
+void TraceEncoder::put_varint(vector<uint8_t> &buf, uint64_t v) {
+  while (v >= 0x80) {
+    buf.push_back((uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  buf.push_back((uint8_t)v);
+}
+
+void TraceEncoder::put_svarint(vector<uint8_t> &buf, int64_t v) {
+  put_varint(buf, zigzag(v));
+}
+
+void TraceEncoder::header(vector<uint8_t> &buf) {
+  const uint8_t hdr[8] = {'K', 'R', 'Z', 'T', KRZT_VERSION, 0, 0, 0};
+  buf.insert(buf.end(), hdr, hdr + 8);
+}
+
+void TraceEncoder::encode(vector<uint8_t> &buf, const Retired &r) {
+  uint8_t flags = 0;
+  int idx = (r.pc_rdata >> 2) & (INSN_CACHE_SIZE - 1);
+
+  if (r.pc_rdata != state.next_pc) flags |= F_PC;
+  if (state.insn_pc[idx] != r.pc_rdata || state.insn[idx] != r.insn) flags |= F_INSN;
+  if (r.pc_wdata != r.pc_rdata + 4) flags |= F_NEXT;
+  if (r.order != state.next_order) flags |= F_ORDER;
+  if (r.rd_addr != 0) flags |= F_RD;
+  if (r.mem_rmask) flags |= F_LOAD;
+  if (r.mem_wmask) flags |= F_STORE;
+  if (r.trap) flags |= F_TRAP;
+
+  buf.push_back(flags);
+
+  if (flags & F_PC) put_svarint(buf, (int32_t)(r.pc_rdata - state.next_pc));
+
+  if (flags & F_INSN) {
+    for (int i=0; i<4; i++) buf.push_back((uint8_t)(r.insn >> (8*i)));
+    state.insn_pc[idx] = r.pc_rdata;
+    state.insn[idx] = r.insn;
+  }
+
+  if (flags & F_NEXT) put_svarint(buf, (int32_t)(r.pc_wdata - r.pc_rdata - 4));
+  if (flags & F_ORDER) put_varint(buf, r.order - state.next_order);
+
+  if (flags & F_RD) {
+    buf.push_back(r.rd_addr);
+    put_varint(buf, r.rd_wdata);
+  }
+
+  if (flags & F_LOAD) {
+    buf.push_back(r.mem_rmask);
+    put_svarint(buf, (int32_t)(r.mem_addr - state.mem_addr));
+    put_varint(buf, r.mem_rdata);
+    state.mem_addr = r.mem_addr;
+  }
+
+  if (flags & F_STORE) {
+    buf.push_back(r.mem_wmask);
+    put_svarint(buf, (int32_t)(r.mem_addr - state.mem_addr));
+    put_varint(buf, r.mem_wdata);
+    state.mem_addr = r.mem_addr;
+  }
+
+  state.next_pc = r.pc_wdata;
+  state.next_order = r.order + 1;
+}
+
+// ============================================================
+// Reader
+
+TraceReader::TraceReader(string filename) {
+  uint8_t hdr[8];
+
+  state.reset();
+
+  fp = fopen(filename.c_str(), "rb");
+  if (fp == NULL) return;
+
+  if (fread(hdr, 1, 8, fp) != 8 || memcmp(hdr, "KRZT", 4) != 0 || hdr[4] != KRZT_VERSION) {
+    fclose(fp);
+    fp = NULL;
+  }
+}
+
+TraceReader::~TraceReader(void) {
+  if (fp) fclose(fp);
+}
+
+bool TraceReader::ok(void) {
+  return fp != NULL;
+}
+
+bool TraceReader::get_varint(uint64_t &v) {
+  int c, shift = 0;
+
+  v = 0;
+  do {
+    c = getc_unlocked(fp);
+    if (c == EOF) return false;
+    v |= (uint64_t)(c & 0x7f) << shift;
+    shift += 7;
+  } while (c & 0x80);
+
+  return true;
+}
+
+bool TraceReader::get_svarint(int64_t &v) {
+  uint64_t u;
+  if (!get_varint(u)) return false;
+  v = unzigzag(u);
+  return true;
+}
+
+bool TraceReader::next(Retired &r) {
+  int c;
+  uint8_t flags;
+  int64_t sv;
+  uint64_t v;
+
+  if (fp == NULL) return false;
+
+  c = getc_unlocked(fp);
+  if (c == EOF) return false;
+  flags = (uint8_t)c;
+
+  memset(&r, 0, sizeof(r));
+
+  r.pc_rdata = state.next_pc;
+  if (flags & F_PC) {
+    if (!get_svarint(sv)) return false;
+    r.pc_rdata += (int32_t)sv;
+  }
+
+  int idx = (r.pc_rdata >> 2) & (INSN_CACHE_SIZE - 1);
+  if (flags & F_INSN) {
+    uint32_t insn = 0;
+    for (int i=0; i<4; i++) {
+      c = getc_unlocked(fp);
+      if (c == EOF) return false;
+      insn |= (uint32_t)c << (8*i);
+    }
+    state.insn_pc[idx] = r.pc_rdata;
+    state.insn[idx] = insn;
+  }
+  r.insn = state.insn[idx];
+
+  r.pc_wdata = r.pc_rdata + 4;
+  if (flags & F_NEXT) {
+    if (!get_svarint(sv)) return false;
+    r.pc_wdata += (int32_t)sv;
+  }
+
+  r.order = state.next_order;
+  if (flags & F_ORDER) {
+    if (!get_varint(v)) return false;
+    r.order += v;
+  }
+
+  if (flags & F_RD) {
+    c = getc_unlocked(fp);
+    if (c == EOF || !get_varint(v)) return false;
+    r.rd_addr = (uint8_t)c;
+    r.rd_wdata = (uint32_t)v;
+  }
+
+  if (flags & F_LOAD) {
+    c = getc_unlocked(fp);
+    if (c == EOF || !get_svarint(sv) || !get_varint(v)) return false;
+    r.mem_rmask = (uint8_t)c;
+    r.mem_addr = state.mem_addr + (int32_t)sv;
+    r.mem_rdata = (uint32_t)v;
+    state.mem_addr = r.mem_addr;
+  }
+
+  if (flags & F_STORE) {
+    c = getc_unlocked(fp);
+    if (c == EOF || !get_svarint(sv) || !get_varint(v)) return false;
+    r.mem_wmask = (uint8_t)c;
+    r.mem_addr = state.mem_addr + (int32_t)sv;
+    r.mem_wdata = (uint32_t)v;
+    state.mem_addr = r.mem_addr;
+  }
+
+  r.trap = (flags & F_TRAP) != 0;
+
+  state.next_pc = r.pc_wdata;
+  state.next_order = r.order + 1;
+
+  return true;
+}
+
+// ============================================================
+// Spike commit log
+
+bool format_spike(const Retired &r, char *line, size_t len) {
+  int n;
+
+  // Spike doesn't commit the instructions that raise an exception
+  if (r.trap) return false;
+
+  n = snprintf(line, len, "core   0: 3 0x%08x (0x%08x)", r.pc_rdata, r.insn);
+
+  if (r.rd_addr != 0) {
+    n += snprintf(line + n, len - n, " x%-2d 0x%08x", r.rd_addr, r.rd_wdata);
+  }
+
+  // The memory access at the byte address, with the data shifted down
+  if (r.mem_rmask) {
+    uint32_t addr = r.mem_addr + mask_offset(r.mem_rmask);
+    n += snprintf(line + n, len - n, " mem 0x%08x", addr);
+  }
+  else if (r.mem_wmask) {
+    int offset = mask_offset(r.mem_wmask);
+    int size = mask_size(r.mem_wmask);
+    uint32_t data = r.mem_wdata >> (8*offset);
+    if (size < 4) data &= (1u << (8*size)) - 1;
+    n += snprintf(line + n, len - n, " mem 0x%08x 0x%0*x", r.mem_addr + offset, 2*size, data);
+  }
+
+  snprintf(line + n, len - n, "\n");
+  return true;
+}
+
+// ============================================================
+// Commit log writer
+
+CommitLog::CommitLog(string filename, bool text) : ring(16) {
+  this->text = text;
+  count = 0;
+  bytes = 0;
+  done = false;
+
+  fp = fopen(filename.c_str(), text ? "w" : "wb");
+  if (fp == NULL) {
+    cout << "Unable to open commit log: " << filename << endl;
+    return;
+  }
+
+  writer = thread(&CommitLog::drain, this);
+}
+
+CommitLog::~CommitLog(void) {
+  if (writer.joinable()) {
+    done = true;
+    writer.join();
+  }
+  if (fp) fclose(fp);
+}
+
+void CommitLog::retire(const Retired &r, uint64_t /* cycle */) {
+  if (fp) ring.push(r);
+}
+
+void CommitLog::finish(uint64_t /* cycles */) {
+  if (!writer.joinable()) return;
+
+  done = true;
+  writer.join();
+
+  fclose(fp);
+  fp = NULL;
+
+  cout << "Commit log: " << count << " instructions, " << bytes << " bytes";
+  if (count) cout << " (" << (double)bytes / count << " B/instr)";
+  cout << endl;
+}
+
+void CommitLog::drain(void) {
+  TraceEncoder encoder;
+  vector<uint8_t> buf;
+  char line[128];
+  Retired r;
+
+  buf.reserve(2 * WRITE_CHUNK);
+
+  if (!text) encoder.header(buf);
+
+  while (true) {
+    bool idle = true;
+
+    while (ring.pop(r)) {
+      idle = false;
+      count++;
+
+      if (text) {
+        if (format_spike(r, line, sizeof(line))) {
+          size_t n = strlen(line);
+          buf.insert(buf.end(), line, line + n);
+        }
+      }
+      else {
+        encoder.encode(buf, r);
+      }
+
+      if (buf.size() >= WRITE_CHUNK) {
+        bytes += fwrite(buf.data(), 1, buf.size(), fp);
+        buf.clear();
+      }
+    }
+
+    if (idle) {
+      // Drained everything that was pushed before the stop
+      if (done && ring.empty()) break;
+      this_thread::yield();
+    }
+  }
+
+  bytes += fwrite(buf.data(), 1, buf.size(), fp);
+}
@@ -0,0 +1,127 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+Kronos Commit Log
+
+Logs the retired instructions of a simulation, either as a Spike compatible
+text commit log, or (default) in a compact binary format.
+
+The log is written by a background thread, which drains a lock-free ring
+buffer fed by the simulation loop. The simulation only pays for a copy of
+the retired instruction.
+
+Binary format (.krzt)
+  Header: "KRZT", version (1B), 3B reserved
+  Record: flags (1B), followed by the fields flagged, in this order
+
+  | Flag       | Field
+  |------------|------
+  | F_PC       | zigzag varint, PC - expected PC (next PC of the last record)
+  | F_INSN     | 4B instruction word, only when it changed for this PC
+  | F_NEXT     | zigzag varint, next PC - (PC + 4), for jumps and traps
+  | F_ORDER    | varint, order - expected order (last order + 1)
+  | F_RD       | rd (1B), varint rd data
+  | F_LOAD     | read mask (1B), zigzag varint address delta, varint read data
+  | F_STORE    | write mask (1B), zigzag varint address delta, varint write data
+  | F_TRAP     | -
+
+  The instruction words are tracked in a direct mapped table of
+  INSN_CACHE_SIZE entries, which the reader mirrors. The memory address is
+  a delta to the last memory access.
+*/
+
+#ifndef COMMIT_LOG_H
+#define COMMIT_LOG_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rvfi.h"
+#include "ring_buffer.h"
+
+#define KRZT_VERSION      1
+#define INSN_CACHE_SIZE   4096
+
+enum {
+  F_PC    = 0x01,
+  F_INSN  = 0x02,
+  F_NEXT  = 0x04,
+  F_ORDER = 0x08,
+  F_RD    = 0x10,
+  F_LOAD  = 0x20,
+  F_STORE = 0x40,
+  F_TRAP  = 0x80
+};
+
+// Encoder/decoder state, shared by the writer and the reader
+struct TraceState {
+  uint32_t next_pc;
+  uint64_t next_order;
+  uint32_t mem_addr;
+  uint32_t insn_pc[INSN_CACHE_SIZE];
+  uint32_t insn[INSN_CACHE_SIZE];
+
+  void reset(void);
+};
+
+// Binary trace encoder, into an in-memory buffer
+class TraceEncoder {
+  private:
+    TraceState state;
+
+    void put_varint(std::vector<uint8_t> &buf, uint64_t v);
+    void put_svarint(std::vector<uint8_t> &buf, int64_t v);
+
+  public:
+    TraceEncoder(void);
+    void header(std::vector<uint8_t> &buf);
+    void encode(std::vector<uint8_t> &buf, const Retired &r);
+};
+
+// Binary trace reader
+class TraceReader {
+  private:
+    FILE *fp;
+    TraceState state;
+
+    bool get_varint(uint64_t &v);
+    bool get_svarint(int64_t &v);
+
+  public:
+    TraceReader(std::string filename);
+    ~TraceReader(void);
+    bool ok(void);
+    bool next(Retired &r);
+};
+
+// Format a retired instruction as a Spike commit log line.
+// Returns false if Spike wouldn't log it (the instruction trapped)
+bool format_spike(const Retired &r, char *line, size_t len);
+
+// Retirement listener that writes the commit log
+class CommitLog : public RetireListener {
+  private:
+    FILE *fp;
+    bool text;
+    RingBuffer<Retired> ring;
+    std::atomic<bool> done;
+    std::thread writer;
+    uint64_t count;
+    uint64_t bytes;
+
+    void drain(void);
+
+  public:
+    CommitLog(std::string filename, bool text);
+    ~CommitLog(void);
+
+    void retire(const Retired &r, uint64_t cycle);
+    void finish(uint64_t cycles);
+};
+
+#endif // COMMIT_LOG_H
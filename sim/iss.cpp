@@ -0,0 +1,766 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "iss.h"
+
+using namespace std;
+
+// CSR addresses
+enum {
+  CSR_MSTATUS       = 0x300,
+  CSR_MISA          = 0x301,
+  CSR_MIE           = 0x304,
+  CSR_MTVEC         = 0x305,
+  CSR_MCOUNTINHIBIT = 0x320,
+  CSR_MHPMEVENT3    = 0x323,
+  CSR_MSCRATCH      = 0x340,
+  CSR_MEPC          = 0x341,
+  CSR_MCAUSE        = 0x342,
+  CSR_MTVAL         = 0x343,
+  CSR_MIP           = 0x344,
+  CSR_MCYCLE        = 0xB00,
+  CSR_MINSTRET      = 0xB02,
+  CSR_MHPMCOUNTER3  = 0xB03,
+  CSR_MCYCLEH       = 0xB80,
+  CSR_MINSTRETH     = 0xB82,
+  CSR_MHPMCOUNTER3H = 0xB83
+};
+
+// Trap causes
+enum {
+  ILLEGAL_INSTR = 2,
+  BREAKPOINT    = 3,
+  ECALL_MACHINE = 11
+};
+
+// Interrupt causes
+enum {
+  SOFTWARE_INTERRUPT  = 3,
+  TIMER_INTERRUPT     = 7,
+  EXTERNAL_INTERRUPT  = 11
+};
+
+// Performance monitoring events, as per kronos_types
+enum {
+  HPM_FETCH_MISS    = 1,
+  HPM_FETCH_STALL   = 2,
+  HPM_HAZARD_STALL  = 3,
+  HPM_BRANCH        = 4,
+  HPM_JUMP          = 5,
+  HPM_LOAD          = 6,
+  HPM_STORE         = 7,
+  HPM_LSU_WAIT      = 8,
+  HPM_CSR           = 9,
+  HPM_TRAP          = 10,
+  HPM_NUM_EVENTS    = 11
+};
+
+// Crossbar resource of an address: Boot ROM, RAM bank0/bank1, System, and
+// the Data TCM (in front of the crossbar)
+static inline uint32_t xbar_bank(uint32_t addr, uint32_t interleave) {
+  if (addr & KRZ_SYS_BASE) return 3;
+  if (addr - KRZ_DTCM_BASE < KRZ_DTCM_SIZE) return 4;
+
+  uint32_t bank = (addr >> 16) & 3;
+  if (interleave == 0 || bank == 0 || bank == 3) return bank;
+
+  // The bit of the offset into the RAM
+  uint32_t offset = addr - KRZ_RAM_BASE;
+  return 1 + ((offset >> interleave) & 1);
+}
+
+static inline int32_t imm_i(uint32_t insn) {
+  return (int32_t)insn >> 20;
+}
+
+static inline int32_t imm_s(uint32_t insn) {
+  return ((int32_t)(insn & 0xfe000000) >> 20) | ((insn >> 7) & 0x1f);
+}
+
+static inline int32_t imm_b(uint32_t insn) {
+  return ((int32_t)(insn & 0x80000000) >> 19)
+    | ((insn & 0x80) << 4)
+    | ((insn >> 20) & 0x7e0)
+    | ((insn >> 7) & 0x1e);
+}
+
+static inline int32_t imm_j(uint32_t insn) {
+  return ((int32_t)(insn & 0x80000000) >> 11)
+    | (insn & 0xff000)
+    | ((insn >> 9) & 0x800)
+    | ((insn >> 20) & 0x7fe);
+}
+
+// ============================================================
+
+ISS::ISS(ISSConfig cfg) {
+  this->cfg = cfg;
+  if (this->cfg.num_hpmcounters > ISS_MAX_HPM) this->cfg.num_hpmcounters = ISS_MAX_HPM;
+
+  ram.assign(KRZ_RAM_SIZE / 4, 0);
+  rom.assign(KRZ_ROM_SIZE / 4, 0);
+  dtcm.assign(KRZ_DTCM_SIZE / 4, 0);
+  memset(gpreg, 0, sizeof(gpreg));
+
+  memset(x, 0, sizeof(x));
+  pc = KRZ_RAM_BASE;
+
+  mstatus = 0x1800; // mpp: machine
+  mie = 0;
+  mtvec = pc;
+  mscratch = 0;
+  mepc = 0;
+  mcause = 0;
+  mtval = 0;
+  mcountinhibit = 0;
+  mcycle = 0;
+  minstret = 0;
+  memset(mhpmevent, 0, sizeof(mhpmevent));
+  memset(mhpmcounter, 0, sizeof(mhpmcounter));
+
+  mtime = 0;
+  mtimecmp = ~0ull;
+  msip = false;
+
+  pending_rd = 0;
+  wfi = false;
+
+  cycles = 0;
+  order = 0;
+  xbar_conflicts = 0;
+  exited = false;
+  exit_code = 0;
+}
+
+void ISS::add_listener(RetireListener *l) {
+  listeners.push_back(l);
+}
+
+bool ISS::load(string filename) {
+  ifstream f(filename.c_str(), ios::binary);
+  if (!f) return false;
+
+  vector<uint8_t> buf((istreambuf_iterator<char>(f)), istreambuf_iterator<char>());
+  bool ok = true;
+
+  auto rd16 = [&](size_t off) -> uint32_t { return buf[off] | (buf[off+1] << 8); };
+  auto rd32 = [&](size_t off) -> uint32_t { return rd16(off) | (rd16(off+2) << 16); };
+  auto put8 = [&](uint32_t addr, uint8_t b) {
+    uint32_t shift = (addr & 3) * 8;
+    if (!poke(addr, (peek(addr) & ~(0xffu << shift)) | ((uint32_t)b << shift))) ok = false;
+  };
+
+  if (buf.size() >= 52 && memcmp(buf.data(), "\x7f" "ELF", 4) == 0) {
+    // ELF32, little endian: load the PT_LOAD segments
+    if (buf[4] != 1 || buf[5] != 1) return false;
+
+    uint32_t phoff = rd32(28);
+    uint32_t phentsize = rd16(42);
+    uint32_t phnum = rd16(44);
+
+    for (uint32_t i=0; i<phnum; i++) {
+      size_t ph = phoff + i * phentsize;
+      if (ph + 32 > buf.size()) return false;
+      if (rd32(ph) != 1) continue; // PT_LOAD
+
+      uint32_t offset = rd32(ph + 4);
+      uint32_t paddr = rd32(ph + 12);
+      uint32_t filesz = rd32(ph + 16);
+      if (offset + filesz > buf.size()) return false;
+
+      for (uint32_t j=0; j<filesz; j++) put8(paddr + j, buf[offset + j]);
+    }
+
+    // The Boot ROM is read-only
+    if (!ok) return false;
+
+    // Symbol table, for the program's landmarks
+    uint32_t shoff = rd32(32);
+    uint32_t shentsize = rd16(46);
+    uint32_t shnum = rd16(48);
+
+    for (uint32_t i=0; i<shnum; i++) {
+      size_t sh = shoff + i * shentsize;
+      if (sh + 40 > buf.size()) break;
+      if (rd32(sh + 4) != 2) continue; // SHT_SYMTAB
+
+      uint32_t symoff = rd32(sh + 16);
+      uint32_t symsize = rd32(sh + 20);
+      size_t strsh = shoff + rd32(sh + 24) * shentsize;
+      if (strsh + 40 > buf.size()) break;
+      uint32_t stroff = rd32(strsh + 16);
+      uint32_t strsize = rd32(strsh + 20);
+
+      for (uint32_t j=16; j+16<=symsize && symoff+j+16<=buf.size(); j+=16) {
+        uint32_t name = rd32(symoff + j);
+        if (name == 0 || name >= strsize || stroff + strsize > buf.size()) continue;
+        const char *str = (const char*)&buf[stroff + name];
+        symbols[string(str, strnlen(str, strsize - name))] = rd32(symoff + j + 4);
+      }
+    }
+
+    pc = rd32(24);
+  }
+  else {
+    // Raw binary, at the start of the RAM
+    for (size_t j=0; j<buf.size() && j<KRZ_RAM_SIZE; j++) put8(KRZ_RAM_BASE + j, buf[j]);
+    pc = KRZ_RAM_BASE;
+  }
+
+  mtvec = pc;
+  return true;
+}
+
+bool ISS::symbol(string name, uint32_t &addr) {
+  auto it = symbols.find(name);
+  if (it == symbols.end()) return false;
+  addr = it->second;
+  return true;
+}
+
+// ============================================================
+// Memory
+
+uint32_t ISS::peek(uint32_t addr) {
+  if (addr - KRZ_RAM_BASE < KRZ_RAM_SIZE) return ram[(addr - KRZ_RAM_BASE) >> 2];
+  if (addr < KRZ_ROM_SIZE) return rom[addr >> 2];
+  if (addr - KRZ_DTCM_BASE < KRZ_DTCM_SIZE) return dtcm[(addr - KRZ_DTCM_BASE) >> 2];
+  return 0;
+}
+
+bool ISS::poke(uint32_t addr, uint32_t data) {
+  if (addr - KRZ_RAM_BASE < KRZ_RAM_SIZE) ram[(addr - KRZ_RAM_BASE) >> 2] = data;
+  else if (addr - KRZ_DTCM_BASE < KRZ_DTCM_SIZE) dtcm[(addr - KRZ_DTCM_BASE) >> 2] = data;
+  else return false;
+  return true;
+}
+
+uint32_t ISS::fetch(uint32_t addr) {
+  return peek(addr);
+}
+
+uint32_t ISS::mem_read(uint32_t addr) {
+  if ((addr & 0xffffff00) == KRZ_SYS_BASE) {
+    // The UART TX queue is always empty
+    if (addr == KRZ_UART_STATUS) return 0;
+    return gpreg[(addr >> 2) & (KRZ_GPREG_COUNT - 1)];
+  }
+  if ((addr & 0xffffffe0) == KRZ_TIMER_BASE) {
+    switch ((addr >> 2) & 7) {
+      case 0: return mtime;
+      case 1: return mtime >> 32;
+      case 2: return mtimecmp;
+      case 3: return mtimecmp >> 32;
+      case 4: return msip;
+    }
+    return 0;
+  }
+  return peek(addr);
+}
+
+void ISS::mem_write(uint32_t addr, uint32_t data, uint32_t mask) {
+  uint32_t bits = 0;
+  for (int i=0; i<4; i++) if (mask & (1 << i)) bits |= 0xffu << (i * 8);
+
+  if ((addr & 0xffffff00) == KRZ_SYS_BASE) {
+    uint32_t &reg = gpreg[(addr >> 2) & (KRZ_GPREG_COUNT - 1)];
+    reg = (reg & ~bits) | (data & bits);
+
+    if (addr == KRZ_SIM_EXIT) {
+      exited = true;
+      exit_code = data;
+    }
+  }
+  else if (addr == KRZ_UART_TX) {
+    putchar(data & 0xff);
+  }
+  else if ((addr & 0xffffffe0) == KRZ_TIMER_BASE) {
+    auto put = [&](uint64_t &reg, uint32_t shift) {
+      reg = (reg & ~((uint64_t)bits << shift)) | ((uint64_t)(data & bits) << shift);
+    };
+
+    switch ((addr >> 2) & 7) {
+      case 0: put(mtime, 0); break;
+      case 1: put(mtime, 32); break;
+      case 2: put(mtimecmp, 0); break;
+      case 3: put(mtimecmp, 32); break;
+      case 4: if (mask & 0x1) msip = data & 1; break;
+    }
+  }
+  else {
+    poke(addr, (peek(addr) & ~bits) | (data & bits));
+  }
+}
+
+// ============================================================
+// CSR
+
+bool ISS::csr_read(uint32_t addr, uint32_t &data) {
+  uint32_t n = cfg.num_hpmcounters;
+
+  data = 0;
+  switch (addr) {
+    case CSR_MSTATUS: data = mstatus; break;
+    case CSR_MIE: data = mie; break;
+    case CSR_MIP:
+      if (mstatus & 0x8) data = mie & (((uint32_t)msip << 3) | ((uint32_t)(mtime >= mtimecmp) << 7));
+      break;
+    case CSR_MTVEC: data = mtvec; break;
+    case CSR_MSCRATCH: data = mscratch; break;
+    case CSR_MEPC: data = mepc; break;
+    case CSR_MCAUSE: data = mcause; break;
+    case CSR_MTVAL: data = mtval; break;
+    case CSR_MCOUNTINHIBIT: data = mcountinhibit; break;
+    case CSR_MCYCLE: data = mcycle; break;
+    case CSR_MCYCLEH: data = mcycle >> 32; break;
+    case CSR_MINSTRET: data = minstret; break;
+    case CSR_MINSTRETH: data = minstret >> 32; break;
+    default:
+      if (addr - CSR_MHPMEVENT3 < n) data = mhpmevent[addr - CSR_MHPMEVENT3];
+      else if (addr - CSR_MHPMCOUNTER3 < n) data = mhpmcounter[addr - CSR_MHPMCOUNTER3];
+      else if (addr - CSR_MHPMCOUNTER3H < n) data = mhpmcounter[addr - CSR_MHPMCOUNTER3H] >> 32;
+  }
+
+  // Like Kronos, unimplemented CSRs read as zero
+  return true;
+}
+
+bool ISS::csr_write(uint32_t addr, uint32_t data) {
+  uint32_t n = cfg.num_hpmcounters;
+
+  switch (addr) {
+    case CSR_MSTATUS: mstatus = (mstatus & ~0x88u) | (data & 0x88); break;
+    case CSR_MIE: mie = data & 0x888; break;
+    case CSR_MTVEC: mtvec = data & ~3u; break;
+    case CSR_MSCRATCH: mscratch = data; break;
+    case CSR_MEPC: mepc = data & ~3u; break;
+    case CSR_MCAUSE: mcause = data; break;
+    case CSR_MTVAL: mtval = data; break;
+    case CSR_MCOUNTINHIBIT: mcountinhibit = data & ((((1ull << n) - 1) << 3) | 0x5); break;
+    case CSR_MCYCLE: mcycle = (mcycle & ~0xffffffffull) | data; break;
+    case CSR_MCYCLEH: mcycle = (mcycle & 0xffffffffull) | ((uint64_t)data << 32); break;
+    case CSR_MINSTRET: minstret = (minstret & ~0xffffffffull) | data; break;
+    case CSR_MINSTRETH: minstret = (minstret & 0xffffffffull) | ((uint64_t)data << 32); break;
+    default:
+      if (addr - CSR_MHPMEVENT3 < n) {
+        mhpmevent[addr - CSR_MHPMEVENT3] = data & 0xf;
+      }
+      else if (addr - CSR_MHPMCOUNTER3 < n) {
+        uint64_t &c = mhpmcounter[addr - CSR_MHPMCOUNTER3];
+        c = (c & ~0xffffffffull) | data;
+      }
+      else if (addr - CSR_MHPMCOUNTER3H < n) {
+        uint64_t &c = mhpmcounter[addr - CSR_MHPMCOUNTER3H];
+        c = (c & 0xffffffffull) | ((uint64_t)data << 32);
+      }
+  }
+
+  return true;
+}
+
+// Advance the counters by the modelled cycles and events of an instruction,
+// or of an interrupt (which doesn't retire one)
+void ISS::count(uint32_t n, const uint32_t *events, bool retired) {
+  cycles += n;
+  mtime += n;
+
+  if (~mcountinhibit & 0x1) mcycle += n;
+  if (~mcountinhibit & 0x4 && retired) minstret++;
+
+  for (uint32_t i=0; i<cfg.num_hpmcounters; i++) {
+    if (mcountinhibit & (1u << (i + 3))) continue;
+    if (mhpmevent[i] > 0 && mhpmevent[i] < HPM_NUM_EVENTS) mhpmcounter[i] += events[mhpmevent[i]];
+  }
+}
+
+// The pending interrupt, as per kronos_csr
+uint32_t ISS::interrupt(void) {
+  if (~mstatus & 0x8) return 0;
+  if (msip && (mie & 0x8)) return SOFTWARE_INTERRUPT;
+  if (mtime >= mtimecmp && (mie & 0x80)) return TIMER_INTERRUPT;
+  return 0;
+}
+
+bool ISS::interrupts_enabled(void) {
+  return (mstatus & 0x8) && (mie & 0x888);
+}
+
+// ============================================================
+// Execute
+
+void ISS::step(void) {
+  uint32_t penalty = (cfg.fast_branch ? 1 : 2) + (cfg.deep_pipeline ? 1 : 0);
+  uint32_t cause = interrupt();
+
+  // --------------------------------------------------------
+  // Interrupts, and the wait for one
+  if (wfi && !cause) {
+    // Only the timer can wake the core up. Skip ahead to the compare
+    uint64_t n = 1;
+    if ((mstatus & 0x8) && (mie & 0x80) && mtimecmp > mtime) n = mtimecmp - mtime;
+
+    cycles += n;
+    mtime += n;
+    if (~mcountinhibit & 0x1) mcycle += n;
+    return;
+  }
+
+  if (cause) {
+    uint32_t ev[HPM_NUM_EVENTS] = {0};
+
+    // The interrupted instruction (or the wfi) is the return address
+    mstatus = (mstatus & ~0x88u) | ((mstatus & 0x8) << 4);
+    mepc = pc;
+    mcause = 0x80000000 | cause;
+    mtval = 0;
+    pc = mtvec;
+    pending_rd = 0;
+    wfi = false;
+
+    ev[HPM_TRAP]++;
+    ev[HPM_FETCH_MISS] += penalty;
+    ev[HPM_FETCH_STALL] = 1;
+    count(2 + penalty, ev, false);
+    return;
+  }
+
+  uint32_t insn = fetch(pc);
+  uint32_t opcode = insn & 0x7f;
+  uint32_t rd = (insn >> 7) & 0x1f;
+  uint32_t funct3 = (insn >> 12) & 0x7;
+  uint32_t rs1 = (insn >> 15) & 0x1f;
+  uint32_t rs2 = (insn >> 20) & 0x1f;
+  uint32_t funct7 = insn >> 25;
+  uint32_t a = x[rs1];
+  uint32_t b = x[rs2];
+
+  uint32_t next = pc + 4;
+  uint32_t wb = 0;
+  bool regwr = false;
+  bool rd_rs1 = false, rd_rs2 = false;
+  bool jump = false;
+  bool illegal = false;
+  bool trap = false;
+  uint32_t trap_cause = 0, trap_value = 0;
+
+  uint32_t n = 1;
+  uint32_t ev[HPM_NUM_EVENTS] = {0};
+
+  Retired r;
+  memset(&r, 0, sizeof(r));
+  r.order = order;
+  r.insn = insn;
+  r.pc_rdata = pc;
+
+  switch (opcode) {
+    case 0x37: // LUI
+      regwr = true;
+      wb = insn & 0xfffff000;
+      break;
+
+    case 0x17: // AUIPC
+      regwr = true;
+      wb = pc + (insn & 0xfffff000);
+      break;
+
+    case 0x6f: // JAL
+      regwr = true;
+      wb = pc + 4;
+      next = pc + imm_j(insn);
+      jump = true;
+      ev[HPM_JUMP]++;
+      break;
+
+    case 0x67: // JALR
+      if (funct3 != 0) {
+        illegal = true;
+        break;
+      }
+      rd_rs1 = true;
+      regwr = true;
+      wb = pc + 4;
+      next = (a + imm_i(insn)) & ~1u;
+      jump = true;
+      ev[HPM_JUMP]++;
+      break;
+
+    case 0x63: { // BRANCH
+      bool taken;
+      rd_rs1 = rd_rs2 = true;
+      switch (funct3) {
+        case 0: taken = a == b; break;
+        case 1: taken = a != b; break;
+        case 4: taken = (int32_t)a < (int32_t)b; break;
+        case 5: taken = (int32_t)a >= (int32_t)b; break;
+        case 6: taken = a < b; break;
+        case 7: taken = a >= b; break;
+        default: illegal = true; taken = false;
+      }
+      if (illegal) break;
+      if (taken) {
+        next = pc + imm_b(insn);
+        jump = true;
+      }
+      ev[HPM_BRANCH]++;
+      break;
+    }
+
+    case 0x03: { // LOAD
+      uint32_t addr = a + imm_i(insn);
+      uint32_t shift = (addr & 3) * 8;
+      uint32_t word, mask;
+
+      rd_rs1 = true;
+      switch (funct3) {
+        case 0: case 4: mask = 0x1; break;
+        case 1: case 5: mask = 0x3; break;
+        case 2: mask = 0xf; break;
+        default: illegal = true; mask = 0;
+      }
+      if (illegal) break;
+
+      word = mem_read(addr & ~3u);
+      wb = word >> shift;
+      switch (funct3) {
+        case 0: wb = (int32_t)(int8_t)wb; break;
+        case 1: wb = (int32_t)(int16_t)wb; break;
+        case 4: wb &= 0xff; break;
+        case 5: wb &= 0xffff; break;
+      }
+      regwr = true;
+
+      r.mem_addr = addr & ~3u;
+      r.mem_rmask = (mask << (addr & 3)) & 0xf;
+      r.mem_rdata = word;
+
+      n += 1;
+      ev[HPM_LOAD]++;
+      ev[HPM_LSU_WAIT]++;
+      if (xbar_bank(addr, cfg.mem_interleave) == 3) {
+        n += cfg.sys_latency;
+        ev[HPM_LSU_WAIT] += cfg.sys_latency;
+      }
+      break;
+    }
+
+    case 0x23: { // STORE
+      uint32_t addr = a + imm_s(insn);
+      uint32_t shift = (addr & 3) * 8;
+      uint32_t mask;
+
+      rd_rs1 = rd_rs2 = true;
+      switch (funct3) {
+        case 0: mask = 0x1; break;
+        case 1: mask = 0x3; break;
+        case 2: mask = 0xf; break;
+        default: illegal = true; mask = 0;
+      }
+      if (illegal) break;
+
+      mask = (mask << (addr & 3)) & 0xf;
+      mem_write(addr & ~3u, b << shift, mask);
+
+      r.mem_addr = addr & ~3u;
+      r.mem_wmask = mask;
+      r.mem_wdata = b << shift;
+
+      n += 1;
+      ev[HPM_STORE]++;
+      ev[HPM_LSU_WAIT]++;
+      if (xbar_bank(addr, cfg.mem_interleave) == 3) {
+        n += cfg.sys_latency;
+        ev[HPM_LSU_WAIT] += cfg.sys_latency;
+      }
+      break;
+    }
+
+    case 0x13: { // OPIMM
+      uint32_t imm = imm_i(insn);
+      uint32_t shamt = rs2;
+
+      rd_rs1 = true;
+      regwr = true;
+      switch (funct3) {
+        case 0: wb = a + imm; break;
+        case 2: wb = (int32_t)a < (int32_t)imm; break;
+        case 3: wb = a < imm; break;
+        case 4: wb = a ^ imm; break;
+        case 6: wb = a | imm; break;
+        case 7: wb = a & imm; break;
+        case 1:
+          if (funct7 != 0) illegal = true;
+          wb = a << shamt;
+          break;
+        case 5:
+          if (funct7 == 0x00) wb = a >> shamt;
+          else if (funct7 == 0x20) wb = (int32_t)a >> shamt;
+          else illegal = true;
+          break;
+      }
+      break;
+    }
+
+    case 0x33: // OP
+      rd_rs1 = rd_rs2 = true;
+      regwr = true;
+      if (funct7 == 0x00) {
+        switch (funct3) {
+          case 0: wb = a + b; break;
+          case 1: wb = a << (b & 31); break;
+          case 2: wb = (int32_t)a < (int32_t)b; break;
+          case 3: wb = a < b; break;
+          case 4: wb = a ^ b; break;
+          case 5: wb = a >> (b & 31); break;
+          case 6: wb = a | b; break;
+          case 7: wb = a & b; break;
+        }
+      }
+      else if (funct7 == 0x20 && funct3 == 0) wb = a - b;
+      else if (funct7 == 0x20 && funct3 == 5) wb = (int32_t)a >> (b & 31);
+      else illegal = true;
+      break;
+
+    case 0x0f: // MISC-MEM
+      if (funct3 == 1) {
+        // fence.i is a jump to the next instruction, to refetch
+        jump = true;
+      }
+      else if (funct3 != 0) illegal = true;
+      break;
+
+    case 0x73: // SYSTEM
+      if (funct3 == 0) {
+        if (rs1 != 0 || rd != 0) illegal = true;
+        else if (insn >> 20 == 0x000) {
+          trap = true;
+          trap_cause = ECALL_MACHINE;
+        }
+        else if (insn >> 20 == 0x001) {
+          trap = true;
+          trap_cause = BREAKPOINT;
+          trap_value = pc;
+        }
+        else if (insn >> 20 == 0x302) {
+          // mret
+          mstatus = (mstatus & ~0x88u) | ((mstatus & 0x80) >> 4) | 0x80;
+          next = mepc;
+          n += 2 + penalty;
+        }
+        else if (insn >> 20 == 0x105) {
+          // wfi holds the pipeline until an interrupt, and doesn't retire
+          wfi = true;
+          count(1, ev, false);
+          return;
+        }
+        else illegal = true;
+      }
+      else if (funct3 != 4) {
+        uint32_t csr = insn >> 20;
+        uint32_t src = (funct3 & 4) ? rs1 : a;
+        uint32_t data;
+
+        rd_rs1 = !(funct3 & 4);
+        csr_read(csr, data);
+
+        // csrrs/c don't write, if rs1/zimm is zero
+        if ((funct3 & 3) == 1) csr_write(csr, src);
+        else if (rs1 != 0 && (funct3 & 3) == 2) csr_write(csr, data | src);
+        else if (rs1 != 0 && (funct3 & 3) == 3) csr_write(csr, data & ~src);
+
+        regwr = true;
+        wb = data;
+
+        n += 2;
+        ev[HPM_CSR]++;
+      }
+      else illegal = true;
+      break;
+
+    default:
+      illegal = true;
+  }
+
+  // --------------------------------------------------------
+  // Hazard on the write back of the previous instruction
+  if (pending_rd && ((rd_rs1 && rs1 == pending_rd) || (rd_rs2 && rs2 == pending_rd))) {
+    uint32_t h = cfg.deep_pipeline ? 2 : 1;
+    n += h;
+    ev[HPM_HAZARD_STALL] += h;
+  }
+
+  if (illegal) {
+    trap = true;
+    trap_cause = ILLEGAL_INSTR;
+    trap_value = insn;
+  }
+
+  // --------------------------------------------------------
+  // Commit
+  if (trap) {
+    mstatus = (mstatus & ~0x88u) | ((mstatus & 0x8) << 4);
+    mepc = pc & ~3u;
+    mcause = trap_cause;
+    mtval = trap_value;
+    next = mtvec;
+    n += 2 + penalty;
+    ev[HPM_TRAP]++;
+    pending_rd = 0;
+
+    // An excepting instruction only retires as a trap
+    memset(&r, 0, sizeof(r));
+    r.order = order;
+    r.insn = insn;
+    r.pc_rdata = pc;
+    r.trap = true;
+  }
+  else {
+    if (regwr && rd != 0) {
+      x[rd] = wb;
+      r.rd_addr = rd;
+      r.rd_wdata = wb;
+    }
+
+    if (jump) {
+      n += penalty;
+      ev[HPM_FETCH_MISS] += penalty;
+      pending_rd = 0;
+    }
+    else {
+      pending_rd = regwr ? rd : 0;
+    }
+
+    // The data interface wins the arbitration for a bank, and
+    // the fetch of the next instruction waits
+    if (cfg.xbar && (r.mem_rmask || r.mem_wmask)
+        && xbar_bank(r.mem_addr, cfg.mem_interleave) == xbar_bank(next, cfg.mem_interleave)) {
+      n += 1;
+      ev[HPM_FETCH_MISS]++;
+      xbar_conflicts++;
+    }
+  }
+
+  // The pipeline is held on the decoded instruction, while the
+  // Execute stage is busy
+  ev[HPM_FETCH_STALL] = n - 1 - ev[HPM_FETCH_MISS];
+
+  r.pc_wdata = next;
+  pc = next;
+  order++;
+
+  count(n, ev, true);
+
+  for (auto l : listeners) l->retire(r, cycles);
+}
+
+bool ISS::run(uint64_t max_cycles) {
+  while (!exited && cycles < max_cycles) step();
+
+  for (auto l : listeners) l->finish(cycles);
+
+  return exited;
+}
@@ -0,0 +1,169 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+Kronos Instruction Set Simulator
+
+A functional RV32I_Zicsr model of Kronos in the KRZ SoC, for running the KRZ
+programs and capturing their traces without the RTL simulation. It carries a
+rough timing model, which is not a substitute for the cycles of kronos_sim.
+
+Memory map, as per KRZ
+  - 2KB Boot ROM at 0x000000 (empty, read-only)
+  - 4KB Data TCM at 0x008000, data accesses only
+  - 128KB RAM at 0x010000, as two 64KB banks
+  - System registers at 0x800000: the GPREGs are storage, the UART TX queue
+    is always empty, byte writes to the UART TX (0x800100) are printed, and
+    a write to SIM_EXIT (0x8000FC) ends the simulation, like kronos_sim.
+  - The machine timer of kronos_sim at 0x800300: mtime (0x800300/4) counts
+    the modelled cycles, mtimecmp (0x800308/C), and msip (0x800310)
+
+Interrupts, as per kronos_csr
+  - An interrupt is pending while its source is up, and it's enabled in mie
+    and mstatus.MIE. The priority is external, software, then timer.
+  - A pending interrupt is taken before the next instruction
+  - wfi waits for a pending interrupt. The wait skips ahead to the timer
+    compare, and only mcycle and mtime advance over it.
+
+Timing model, per retired instruction. The costs are derived from the RTL of
+the pipeline. They haven't been calibrated against kronos_sim, so the cycle
+counts are unverified estimates, with no known error.
+  - 1 cycle
+  - Taken jump: +1 cycle with FAST_BRANCH, else +2 (+1 with DEEP_PIPELINE)
+  - Load/Store: +1 cycle (LSU two-cycle access), +SYS_LATENCY for the
+    system registers (none, with the single cycle KRZ sysbus)
+  - CSR: +2 cycles (read/modify/write sequence)
+  - Trap/mret: +2 cycles for the trap sequence, and the jump
+  - Hazard: +1 cycle if an operand is written by the previous instruction,
+    +2 with DEEP_PIPELINE, unless the previous instruction jumped (flush)
+  - Xbar: +1 cycle if a data access is to the memory bank of the next
+    instruction fetch, where the data interface wins the arbitration. The
+    banks are contiguous, or interleaved on an address bit (MEM_INTERLEAVE
+    of krz_xbar)
+
+The performance counters (mcycle, minstret, mhpmcounter) count in modelled
+cycles, so that the programs report their own statistics.
+*/
+
+#ifndef ISS_H
+#define ISS_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "rvfi.h"
+
+// KRZ memory map
+#define KRZ_ROM_BASE      0x000000
+#define KRZ_ROM_SIZE      0x800
+#define KRZ_DTCM_BASE     0x008000
+#define KRZ_DTCM_SIZE     0x1000
+#define KRZ_RAM_BASE      0x010000
+#define KRZ_RAM_SIZE      0x20000
+#define KRZ_SYS_BASE      0x800000
+#define KRZ_GPREG_COUNT   64
+#define KRZ_UART_STATUS   0x800018
+#define KRZ_UART_TX       0x800100
+#define KRZ_SIM_EXIT      0x8000FC
+#define KRZ_TIMER_BASE    0x800300
+
+#define ISS_MAX_HPM       29
+
+struct ISSConfig {
+  bool fast_branch;
+  bool deep_pipeline;
+  bool xbar;
+  uint32_t sys_latency;
+  uint32_t num_hpmcounters;
+  uint32_t mem_interleave;
+};
+
+// Default: the KRZ configuration of Kronos
+static const ISSConfig KRZ_CONFIG = {true, false, true, 0, 4, 0};
+
+class ISS {
+  private:
+    ISSConfig cfg;
+    std::vector<RetireListener*> listeners;
+
+    std::vector<uint32_t> ram;
+    std::vector<uint32_t> rom;
+    std::vector<uint32_t> dtcm;
+    uint32_t gpreg[KRZ_GPREG_COUNT];
+
+    // ELF symbols
+    std::map<std::string, uint32_t> symbols;
+
+    // Timing state
+    uint32_t pending_rd;
+
+    // Waiting for an interrupt (wfi)
+    bool wfi;
+
+    uint32_t mem_read(uint32_t addr);
+    void mem_write(uint32_t addr, uint32_t data, uint32_t mask);
+    uint32_t fetch(uint32_t addr);
+
+    bool csr_read(uint32_t addr, uint32_t &data);
+    bool csr_write(uint32_t addr, uint32_t data);
+    void count(uint32_t cycles, const uint32_t *events, bool retired);
+    uint32_t interrupt(void);
+
+  public:
+    // Architectural state
+    uint32_t x[32];
+    uint32_t pc;
+
+    uint32_t mstatus;
+    uint32_t mie;
+    uint32_t mtvec;
+    uint32_t mscratch;
+    uint32_t mepc;
+    uint32_t mcause;
+    uint32_t mtval;
+    uint32_t mcountinhibit;
+    uint64_t mcycle;
+    uint64_t minstret;
+    uint32_t mhpmevent[ISS_MAX_HPM];
+    uint64_t mhpmcounter[ISS_MAX_HPM];
+
+    // Machine timer
+    uint64_t mtime;
+    uint64_t mtimecmp;
+    bool msip;
+
+    // Simulation state
+    uint64_t cycles;
+    uint64_t order;
+    uint64_t xbar_conflicts;
+    bool exited;
+    uint32_t exit_code;
+
+    ISS(ISSConfig cfg = KRZ_CONFIG);
+
+    // Load an ELF, or a raw binary at the start of the RAM
+    bool load(std::string filename);
+
+    // Address of an ELF symbol
+    bool symbol(std::string name, uint32_t &addr);
+
+    void add_listener(RetireListener *l);
+
+    // Execute one instruction
+    void step(void);
+
+    // Run until the program exits, or the cycle limit is hit
+    bool run(uint64_t max_cycles);
+
+    // Interrupts are enabled (mstatus.MIE, and a source in mie)
+    bool interrupts_enabled(void);
+
+    // Direct access to the memory, for loaders and checkpoints.
+    // The Boot ROM is read-only, and a poke to it fails
+    uint32_t peek(uint32_t addr);
+    bool poke(uint32_t addr, uint32_t data);
+};
+
+#endif // ISS_H
@@ -0,0 +1,391 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+Kronos Branch Predictor Evaluator
+
+Trace driven evaluation of branch predictors for the fetch stage. Reads the
+branch traces (.krzb) captured by kronos_sim, and runs a set of predictor
+models side by side in one pass over each trace.
+
+Kronos computes the jump target in the decode stage, but resolves the jump
+in the execute stage, and always fetches down the not-taken path. Every taken
+jump flushes the fetch and pays the penalty:
+  - 1 cycle with FAST_BRANCH (2 cycle jumps), 2 cycles without
+  - 1 more cycle with DEEP_PIPELINE
+This is the baseline ("nt"), against which the cycles saved are reported.
+
+A model is a combination of components, joined by '+', ex: bimodal:256+btb:64
+  - btfn            static, backward taken and forward not-taken
+  - bimodal:N       N entry table of 2b counters, indexed by the PC
+  - gshare:N:H      N entry table of 2b counters, indexed by the PC xor'd
+                    with H bits of global branch history
+  - btb:N           N entry direct mapped branch target buffer
+  - ras:D           D deep return address stack
+
+A predicted-taken jump is redirected at fetch with no penalty if the BTB
+provides the target. Else, the direct target is predecoded from the fetched
+instruction, and the redirect costs one cycle less than the flush. Without a
+direction predictor, a BTB hit is predicted taken. Indirect jumps are only
+predicted through the BTB, and returns through the RAS, which is always taken
+when it isn't empty. A misprediction, of direction or target, pays the full
+flush penalty. A model has at most one direction predictor.
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "branch_trace.h"
+
+using namespace std;
+
+struct Timing {
+  uint32_t penalty;
+  uint32_t predecode;
+};
+
+// 2b saturating counters, initialized to weakly not-taken
+class CounterTable {
+  private:
+    vector<uint8_t> ctr;
+    uint32_t mask;
+
+  public:
+    CounterTable(uint32_t entries) {
+      ctr.assign(entries, 1);
+      mask = entries - 1;
+    }
+
+    bool predict(uint32_t index) {
+      return ctr[index & mask] >= 2;
+    }
+
+    void update(uint32_t index, bool taken) {
+      uint8_t &c = ctr[index & mask];
+      if (taken && c < 3) c++;
+      else if (!taken && c > 0) c--;
+    }
+};
+
+class Predictor {
+  private:
+    enum Direction { DIR_NONE, DIR_BTFN, DIR_BIMODAL, DIR_GSHARE };
+
+    struct BTBEntry {
+      bool valid;
+      uint32_t pc;
+      uint32_t target;
+      uint8_t kind;
+    };
+
+    Direction dir;
+    CounterTable *pht;
+    uint32_t history;
+    uint32_t history_mask;
+
+    vector<BTBEntry> btb;
+    vector<uint32_t> ras;
+    uint32_t ras_top;
+    uint32_t ras_count;
+
+    bool predecode;
+
+    uint32_t pht_index(uint32_t pc) {
+      if (dir == DIR_GSHARE) return (pc >> 2) ^ history;
+      return pc >> 2;
+    }
+
+    BTBEntry* btb_lookup(uint32_t pc) {
+      if (btb.empty()) return NULL;
+      BTBEntry *e = &btb[(pc >> 2) & (btb.size() - 1)];
+      return (e->valid && e->pc == pc) ? e : NULL;
+    }
+
+  public:
+    string name;
+    uint64_t branches;
+    uint64_t mispredicts;
+    uint64_t cycles;
+
+    Predictor(string spec) {
+      stringstream ss(spec);
+      string item;
+
+      name = spec;
+      dir = DIR_NONE;
+      pht = NULL;
+      history = 0;
+      history_mask = 0;
+      ras_top = 0;
+      ras_count = 0;
+      branches = mispredicts = cycles = 0;
+
+      while (getline(ss, item, '+')) {
+        vector<uint32_t> args;
+        stringstream is(item);
+        string kind, v;
+
+        getline(is, kind, ':');
+        while (getline(is, v, ':')) args.push_back(stoul(v));
+
+        // table sizes are powers of 2
+        if (kind != "ras" && !args.empty() && (args[0] == 0 || (args[0] & (args[0] - 1))))
+          throw invalid_argument(item);
+
+        // only one direction predictor
+        if ((kind == "btfn" || kind == "bimodal" || kind == "gshare") && dir != DIR_NONE)
+          throw invalid_argument(item);
+
+        if (kind == "nt") continue;
+        else if (kind == "btfn") dir = DIR_BTFN;
+        else if (kind == "bimodal" && args.size() == 1) {
+          dir = DIR_BIMODAL;
+          pht = new CounterTable(args[0]);
+        }
+        else if (kind == "gshare" && args.size() == 2) {
+          dir = DIR_GSHARE;
+          pht = new CounterTable(args[0]);
+          history_mask = (1u << args[1]) - 1;
+        }
+        else if (kind == "btb" && args.size() == 1) {
+          btb.assign(args[0], BTBEntry{false, 0, 0, 0});
+        }
+        else if (kind == "ras" && args.size() == 1) {
+          ras.assign(args[0], 0);
+        }
+        else throw invalid_argument(item);
+      }
+
+      // Any direction predictor needs to predecode the fetched instruction
+      predecode = dir != DIR_NONE;
+    }
+
+    ~Predictor(void) {
+      delete pht;
+    }
+
+    static bool valid(string spec) {
+      try {
+        Predictor p(spec);
+        return true;
+      }
+      catch (...) {
+        return false;
+      }
+    }
+
+    void branch(const BranchRecord &b, Timing t) {
+      BTBEntry *hit = btb_lookup(b.pc);
+      bool taken = false;
+      uint32_t target = 0;
+      uint32_t redirect = 0;
+
+      // --------------------------------------------------------
+      // Predict
+      bool ras_hit = b.kind == BR_RET && ras_count > 0;
+
+      if (b.kind == BR_COND) {
+        if (dir == DIR_BTFN) taken = b.target < b.pc;
+        else if (dir != DIR_NONE) taken = pht->predict(pht_index(b.pc));
+        else taken = hit != NULL;
+      }
+      else if (b.kind == BR_JUMP || b.kind == BR_CALL) {
+        taken = hit || predecode;
+      }
+      else if (ras_hit) {
+        // The RAS predecodes the return, and predicts it taken
+        taken = true;
+      }
+      else {
+        taken = hit != NULL;
+      }
+
+      if (taken) {
+        if (ras_hit) {
+          target = ras[ras_top];
+          redirect = hit ? 0 : t.predecode;
+        }
+        else if (hit) {
+          target = hit->target;
+        }
+        else if (predecode && b.kind != BR_IJUMP && b.kind != BR_ICALL && b.kind != BR_RET) {
+          target = b.target;
+          redirect = t.predecode;
+        }
+        else {
+          taken = false;
+        }
+      }
+
+      branches++;
+      if (taken != (bool)b.taken || (taken && target != b.target)) {
+        mispredicts++;
+        cycles += t.penalty;
+      }
+      else if (taken) {
+        cycles += redirect;
+      }
+
+      // --------------------------------------------------------
+      // Update
+      if (b.kind == BR_COND) {
+        if (pht) pht->update(pht_index(b.pc), b.taken);
+        history = ((history << 1) | b.taken) & history_mask;
+      }
+
+      if (!btb.empty() && b.taken) {
+        BTBEntry &e = btb[(b.pc >> 2) & (btb.size() - 1)];
+        e.valid = true;
+        e.pc = b.pc;
+        e.target = b.target;
+        e.kind = b.kind;
+      }
+
+      if (!ras.empty()) {
+        if (b.kind == BR_CALL || b.kind == BR_ICALL) {
+          // overflow overwrites the oldest entry
+          ras_top = (ras_top + 1) % ras.size();
+          ras[ras_top] = b.pc + 4;
+          if (ras_count < ras.size()) ras_count++;
+        }
+        else if (b.kind == BR_RET && ras_count > 0) {
+          ras_top = (ras_top + ras.size() - 1) % ras.size();
+          ras_count--;
+        }
+      }
+    }
+};
+
+// ============================================================
+
+static const char* kind_names[] = {"cond", "jump", "call", "ijump", "icall", "ret"};
+
+int main(int argc, char **argv) {
+  vector<string> traces;
+  vector<string> models;
+  bool fast_branch = true;
+  bool deep = false;
+  int penalty = -1;
+  int predecode = -1;
+
+  // ----------------------------------------------------------
+  // Parse args
+  if (argc < 2) {
+    cout << "[USAGE]\n";
+    cout << "kronos_bpred <PATH/trace.krzb>... [options]\n";
+    cout << "  --model <spec>       predictor model, ex: gshare:1024:10+btb:64+ras:4\n";
+    cout << "                       repeat to evaluate several (default: a sweep)\n";
+    cout << "  --no-fast-branch     the core is configured without FAST_BRANCH\n";
+    cout << "  --deep               the core is configured with DEEP_PIPELINE\n";
+    cout << "  --penalty <N>        override the flush penalty\n";
+    cout << "  --predecode <N>      override the predecoded redirect penalty\n\n";
+    return 1;
+  }
+
+  for (int i=1; i<argc; i++) {
+    string arg = argv[i];
+    bool has_val = i+1 < argc;
+
+    if (arg == "--model" && has_val) models.push_back(argv[++i]);
+    else if (arg == "--no-fast-branch") fast_branch = false;
+    else if (arg == "--deep") deep = true;
+    else if (arg == "--penalty" && has_val) penalty = stoi(argv[++i]);
+    else if (arg == "--predecode" && has_val) predecode = stoi(argv[++i]);
+    else if (arg.compare(0, 2, "--") == 0) {
+      cout << "Unknown argument: " << arg << endl;
+      return 1;
+    }
+    else traces.push_back(arg);
+  }
+
+  if (models.empty()) {
+    models = {
+      "btfn",
+      "bimodal:64",
+      "bimodal:256",
+      "bimodal:1024",
+      "gshare:256:8",
+      "gshare:1024:10",
+      "btb:16",
+      "btb:64",
+      "bimodal:256+btb:16",
+      "bimodal:256+btb:64",
+      "bimodal:256+btb:64+ras:2",
+      "bimodal:256+btb:64+ras:4",
+      "bimodal:256+btb:64+ras:8",
+      "gshare:1024:10+btb:64+ras:4"
+    };
+  }
+
+  // The baseline is the current core, which always predicts not-taken
+  models.insert(models.begin(), "nt");
+
+  for (auto &m : models) {
+    if (!Predictor::valid(m)) {
+      cout << "Invalid model: " << m << endl;
+      return 1;
+    }
+  }
+
+  Timing timing;
+  timing.penalty = (penalty >= 0) ? penalty : (fast_branch ? 1 : 2) + (deep ? 1 : 0);
+  // The predecoded redirect saves one cycle of the flush
+  timing.predecode = (predecode >= 0) ? predecode : (timing.penalty > 0 ? timing.penalty - 1 : 0);
+
+  printf("Penalty: flush %u cycles, predecoded redirect %u cycles\n", timing.penalty, timing.predecode);
+
+  // ----------------------------------------------------------
+  // One pass over each trace, through all the predictors
+  for (auto &trace : traces) {
+    BranchTraceReader reader(trace);
+    if (!reader.ok()) {
+      cout << "Invalid trace: " << trace << endl;
+      continue;
+    }
+
+    vector<Predictor*> preds;
+    for (auto &m : models) preds.push_back(new Predictor(m));
+
+    BranchRecord b;
+    uint64_t kinds[6] = {0};
+    uint64_t taken = 0;
+
+    while (reader.next(b)) {
+      if (b.kind < 6) kinds[b.kind]++;
+      if (b.taken) taken++;
+      for (auto p : preds) p->branch(b, timing);
+    }
+
+    uint64_t instret = reader.instret;
+    uint64_t base = preds[0]->cycles;
+
+    printf("\n============================================================\n");
+    printf("Trace: %s\n", trace.c_str());
+    printf("Instructions: %lu, Cycles: %lu, Control flow: %lu (%lu taken)\n",
+      (unsigned long)instret, (unsigned long)reader.cycles,
+      (unsigned long)preds[0]->branches, (unsigned long)taken);
+    for (int k=0; k<6; k++) printf("  %-6s %lu\n", kind_names[k], (unsigned long)kinds[k]);
+
+    printf("\n%-32s | %7s %8s %10s %10s %7s\n",
+      "model", "miss%", "MPKI", "penalty", "saved", "saved%");
+
+    for (auto p : preds) {
+      double miss = p->branches ? 100.0 * p->mispredicts / p->branches : 0.0;
+      double mpki = instret ? 1000.0 * p->mispredicts / instret : 0.0;
+      int64_t saved = (int64_t)base - (int64_t)p->cycles;
+      double pct = reader.cycles ? 100.0 * saved / reader.cycles : 0.0;
+
+      printf("%-32s | %7.2f %8.2f %10lu %10ld %7.2f\n",
+        p->name.c_str(), miss, mpki, (unsigned long)p->cycles, (long)saved, pct);
+    }
+
+    for (auto p : preds) delete p;
+  }
+
+  return 0;
+}
@@ -0,0 +1,338 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+Kronos Cache Explorer
+
+Trace driven design-space exploration of the instruction and data caches.
+Reads the memory access traces (.krzm) captured by kronos_sim, and simulates
+a matrix of cache geometries in one pass over each trace.
+
+Only the data accesses to the RAM reach the data caches. The DTCM and the
+system registers are not cached.
+
+For every cache, it reports the hit rate, the misses per thousand instructions
+(MPKI), and an estimate of the CPI added over an ideal (always hit) memory:
+  - A line fill costs `latency + words_per_line * word_cycles`
+  - Write-back (with write-allocate) pays a line write for every dirty eviction
+  - Write-through (no write-allocate) pays a word write for every store
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mem_trace.h"
+
+using namespace std;
+
+enum Replacement { LRU, FIFO, RANDOM };
+enum WritePolicy { WRITE_BACK, WRITE_THROUGH };
+
+static const char* repl_names[] = {"lru", "fifo", "random"};
+static const char* write_names[] = {"wb", "wt"};
+
+// KRZ RAM, the cacheable data memory
+#define RAM_BASE    0x10000
+#define RAM_SIZE    0x20000
+
+struct CacheConfig {
+  uint32_t size;
+  uint32_t ways;
+  uint32_t line;
+  Replacement repl;
+  WritePolicy write;
+};
+
+struct TimingConfig {
+  uint32_t latency;
+  uint32_t word_cycles;
+};
+
+class Cache {
+  private:
+    struct Line {
+      uint32_t tag;
+      bool valid;
+      bool dirty;
+      uint64_t stamp;
+    };
+
+    vector<Line> lines;
+    uint32_t sets;
+    uint32_t line_bits;
+    uint64_t tick;
+    uint32_t rng;
+
+    uint32_t victim(Line *set) {
+      uint32_t v = 0;
+
+      for (uint32_t w=0; w<cfg.ways; w++) {
+        if (!set[w].valid) return w;
+      }
+
+      if (cfg.repl == RANDOM) {
+        // xorshift32
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng % cfg.ways;
+      }
+
+      // LRU and FIFO both evict the oldest stamp, which is
+      // refreshed on every access for LRU, and only on fill for FIFO
+      for (uint32_t w=1; w<cfg.ways; w++) {
+        if (set[w].stamp < set[v].stamp) v = w;
+      }
+      return v;
+    }
+
+  public:
+    CacheConfig cfg;
+    uint64_t accesses;
+    uint64_t misses;
+    uint64_t fills;
+    uint64_t writebacks;
+    uint64_t writes;
+
+    Cache(CacheConfig cfg) {
+      this->cfg = cfg;
+      sets = cfg.size / (cfg.ways * cfg.line);
+      line_bits = __builtin_ctz(cfg.line);
+      lines.resize(sets * cfg.ways);
+      for (auto &l : lines) {
+        l.valid = false;
+        l.dirty = false;
+        l.stamp = 0;
+      }
+
+      tick = 0;
+      rng = 0x12345678;
+      accesses = misses = fills = writebacks = writes = 0;
+    }
+
+    static bool valid(CacheConfig cfg) {
+      uint32_t n = cfg.ways * cfg.line;
+      if (cfg.line < 4 || (cfg.line & (cfg.line - 1))) return false;
+      if (n > cfg.size || cfg.size % n) return false;
+      uint32_t s = cfg.size / n;
+      return (s & (s - 1)) == 0;
+    }
+
+    void access(uint32_t addr, bool write) {
+      uint32_t block = addr >> line_bits;
+      uint32_t index = block & (sets - 1);
+      Line *set = &lines[index * cfg.ways];
+
+      tick++;
+      accesses++;
+      if (write && cfg.write == WRITE_THROUGH) writes++;
+
+      for (uint32_t w=0; w<cfg.ways; w++) {
+        if (set[w].valid && set[w].tag == block) {
+          if (cfg.repl == LRU) set[w].stamp = tick;
+          if (write && cfg.write == WRITE_BACK) set[w].dirty = true;
+          return;
+        }
+      }
+
+      misses++;
+
+      // no write-allocate
+      if (write && cfg.write == WRITE_THROUGH) return;
+
+      uint32_t v = victim(set);
+      if (set[v].valid && set[v].dirty) writebacks++;
+
+      set[v].valid = true;
+      set[v].tag = block;
+      set[v].dirty = write;
+      set[v].stamp = tick;
+      fills++;
+    }
+
+    uint64_t stall_cycles(TimingConfig t) {
+      uint64_t words = cfg.line / 4;
+      return fills * (t.latency + words * t.word_cycles)
+        + writebacks * words * t.word_cycles
+        + writes * t.word_cycles;
+    }
+};
+
+// ============================================================
+
+static vector<uint32_t> parse_list(string s, bool size) {
+  vector<uint32_t> list;
+  stringstream ss(s);
+  string item;
+
+  while (getline(ss, item, ',')) {
+    uint32_t v = stoul(item);
+    if (size && (item.back() == 'K' || item.back() == 'k')) v *= 1024;
+    list.push_back(v);
+  }
+  return list;
+}
+
+static bool has_zero(const vector<uint32_t> &list) {
+  for (auto v : list) if (v == 0) return true;
+  return false;
+}
+
+static string size_str(uint32_t size) {
+  if (size >= 1024 && size % 1024 == 0) return to_string(size / 1024) + "K";
+  return to_string(size);
+}
+
+static void report(const char* name, vector<Cache> &caches, uint64_t instret, TimingConfig t, bool data) {
+  printf("\n%s  %6s %4s %4s %6s %5s | %7s %8s %7s\n",
+    name, "size", "ways", "line", "repl", data ? "write" : "", "hit%", "MPKI", "+CPI");
+
+  for (auto &c : caches) {
+    double hit = c.accesses ? 100.0 * (c.accesses - c.misses) / c.accesses : 100.0;
+    double mpki = instret ? 1000.0 * c.misses / instret : 0.0;
+    double cpi = instret ? (double)c.stall_cycles(t) / instret : 0.0;
+
+    printf("%s  %6s %4u %4u %6s %5s | %7.2f %8.2f %7.3f\n",
+      name, size_str(c.cfg.size).c_str(), c.cfg.ways, c.cfg.line,
+      repl_names[c.cfg.repl], data ? write_names[c.cfg.write] : "",
+      hit, mpki, cpi);
+  }
+}
+
+int main(int argc, char **argv) {
+  vector<string> traces;
+  vector<uint32_t> sizes = {1024, 2048, 4096, 8192};
+  vector<uint32_t> ways = {1, 2, 4};
+  vector<uint32_t> lines = {16, 32};
+  vector<Replacement> repls = {LRU};
+  vector<WritePolicy> writes = {WRITE_BACK, WRITE_THROUGH};
+  TimingConfig timing = {4, 1};
+
+  // ----------------------------------------------------------
+  // Parse args
+  if (argc < 2) {
+    cout << "[USAGE]\n";
+    cout << "kronos_cache <PATH/trace.krzm>... [options]\n";
+    cout << "  --size <list>        cache sizes, ex: 1K,2K,4K\n";
+    cout << "  --ways <list>        associativity, ex: 1,2,4\n";
+    cout << "  --line <list>        line size in bytes, ex: 16,32\n";
+    cout << "  --repl <list>        replacement: lru,fifo,random\n";
+    cout << "  --write <list>       data cache write policy: wb,wt\n";
+    cout << "  --latency <N>        cycles to the first word of a line fill\n";
+    cout << "  --word-cycles <N>    cycles per word transferred\n\n";
+    return 1;
+  }
+
+  for (int i=1; i<argc; i++) {
+    string arg = argv[i];
+    bool has_val = i+1 < argc;
+
+    if (arg == "--size" && has_val) sizes = parse_list(argv[++i], true);
+    else if (arg == "--ways" && has_val) ways = parse_list(argv[++i], false);
+    else if (arg == "--line" && has_val) lines = parse_list(argv[++i], false);
+    else if (arg == "--latency" && has_val) timing.latency = stoul(argv[++i]);
+    else if (arg == "--word-cycles" && has_val) timing.word_cycles = stoul(argv[++i]);
+    else if (arg == "--repl" && has_val) {
+      stringstream ss(argv[++i]);
+      string item;
+      repls.clear();
+      while (getline(ss, item, ',')) {
+        if (item == "lru") repls.push_back(LRU);
+        else if (item == "fifo") repls.push_back(FIFO);
+        else if (item == "random") repls.push_back(RANDOM);
+      }
+    }
+    else if (arg == "--write" && has_val) {
+      stringstream ss(argv[++i]);
+      string item;
+      writes.clear();
+      while (getline(ss, item, ',')) {
+        if (item == "wb") writes.push_back(WRITE_BACK);
+        else if (item == "wt") writes.push_back(WRITE_THROUGH);
+      }
+    }
+    else if (arg.compare(0, 2, "--") == 0) {
+      cout << "Unknown argument: " << arg << endl;
+      return 1;
+    }
+    else traces.push_back(arg);
+  }
+
+  if (has_zero(sizes) || has_zero(ways) || has_zero(lines)) {
+    cout << "Cache size, ways and line size must be non-zero" << endl;
+    return 1;
+  }
+
+  // ----------------------------------------------------------
+  // The configuration matrix
+  vector<CacheConfig> icfg, dcfg;
+
+  for (auto s : sizes) {
+    for (auto w : ways) {
+      for (auto l : lines) {
+        for (auto r : repls) {
+          CacheConfig c = {s, w, l, r, WRITE_BACK};
+          if (!Cache::valid(c)) continue;
+          icfg.push_back(c);
+
+          for (auto wp : writes) {
+            c.write = wp;
+            dcfg.push_back(c);
+          }
+        }
+      }
+    }
+  }
+
+  printf("Line fill: %u + %u cycles/word\n", timing.latency, timing.word_cycles);
+
+  // ----------------------------------------------------------
+  // One pass over each trace, through all the caches
+  for (auto &trace : traces) {
+    MemTraceReader reader(trace);
+    if (!reader.ok()) {
+      cout << "Invalid trace: " << trace << endl;
+      continue;
+    }
+
+    vector<Cache> icaches, dcaches;
+    for (auto &c : icfg) icaches.push_back(Cache(c));
+    for (auto &c : dcfg) dcaches.push_back(Cache(c));
+
+    uint32_t addr;
+    int type;
+    uint64_t instret = 0, loads = 0, stores = 0, uncached = 0;
+
+    while (reader.next(addr, type)) {
+      if (type == MEM_FETCH) {
+        instret++;
+        for (auto &c : icaches) c.access(addr, false);
+      }
+      else {
+        bool write = type == MEM_STORE;
+        if (write) stores++;
+        else loads++;
+
+        if (addr - RAM_BASE >= RAM_SIZE) {
+          uncached++;
+          continue;
+        }
+        for (auto &c : dcaches) c.access(addr, write);
+      }
+    }
+
+    printf("\n============================================================\n");
+    printf("Trace: %s\n", trace.c_str());
+    printf("Instructions: %lu, Loads: %lu, Stores: %lu, Uncached (DTCM/System): %lu\n",
+      (unsigned long)instret, (unsigned long)loads, (unsigned long)stores, (unsigned long)uncached);
+
+    report("I$", icaches, instret, timing, false);
+    report("D$", dcaches, instret, timing, true);
+  }
+
+  return 0;
+}
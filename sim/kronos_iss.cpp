@@ -0,0 +1,145 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+Kronos ISS
+
+Runs a KRZ program (ELF or binary) on the instruction set simulator, and
+reports the modelled cycles. The retired instructions are passed on to the
+same tools as kronos_sim, so the traces can be captured at ISS speed.
+*/
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "iss.h"
+#include "commit_log.h"
+#include "mem_trace.h"
+#include "branch_trace.h"
+#include "bbv.h"
+
+using namespace std;
+
+int main(int argc, char **argv) {
+  string progfile, log_file, mem_file, branch_file, bbv_file;
+  bool log_text = false;
+  uint64_t max_cycles = 1000000000;
+  uint64_t interval = 100000;
+  ISSConfig cfg = KRZ_CONFIG;
+
+  // ----------------------------------------------------------
+  // Parse args
+  if (argc < 2) {
+    cout << "[USAGE]\n";
+    cout << "kronos_iss <PATH/program.elf|bin> [options]\n";
+    cout << "  --max-cycles <N>             simulation timeout\n";
+    cout << "  --no-fast-branch             model the core without FAST_BRANCH\n";
+    cout << "  --deep                       model the core with DEEP_PIPELINE\n";
+    cout << "  --ideal                      model the ideal memory of kronos_sim, instead of KRZ\n";
+    cout << "  --hpm <N>                    number of mhpmcounters\n";
+    cout << "  --interleave <BIT>           interleave the RAM banks on an address bit\n";
+    cout << "  --log <PATH/trace.krzt>      write a binary commit log\n";
+    cout << "  --log-spike <PATH/trace.log> write a Spike compatible commit log\n";
+    cout << "  --mem-trace <PATH/trace.krzm> write the memory access trace\n";
+    cout << "  --branch-trace <PATH/trace.krzb> write the branch outcome trace\n";
+    cout << "  --bbv <PATH/profile.bb>      write the basic block vectors ...\n";
+    cout << "  --interval <N>               ... per N instructions (default: 100000)\n\n";
+    return 1;
+  }
+
+  progfile = argv[1];
+
+  for (int i=2; i<argc; i++) {
+    string arg = argv[i];
+    if (arg == "--max-cycles" && i+1 < argc) max_cycles = stoull(argv[++i]);
+    else if (arg == "--no-fast-branch") cfg.fast_branch = false;
+    else if (arg == "--deep") cfg.deep_pipeline = true;
+    else if (arg == "--ideal") {
+      cfg.xbar = false;
+      cfg.sys_latency = 0;
+    }
+    else if (arg == "--hpm" && i+1 < argc) cfg.num_hpmcounters = stoul(argv[++i]);
+    else if (arg == "--interleave" && i+1 < argc) cfg.mem_interleave = stoul(argv[++i]);
+    else if (arg == "--log" && i+1 < argc) log_file = argv[++i];
+    else if (arg == "--mem-trace" && i+1 < argc) mem_file = argv[++i];
+    else if (arg == "--branch-trace" && i+1 < argc) branch_file = argv[++i];
+    else if (arg == "--bbv" && i+1 < argc) bbv_file = argv[++i];
+    else if (arg == "--interval" && i+1 < argc) interval = stoull(argv[++i]);
+    else if (arg == "--log-spike" && i+1 < argc) {
+      log_file = argv[++i];
+      log_text = true;
+    }
+    else {
+      cout << "Unknown argument: " << arg << endl;
+      return 1;
+    }
+  }
+
+  cout << "Program: " << progfile << endl;
+
+  if (cfg.mem_interleave == 1 || cfg.mem_interleave > 15) {
+    cout << "The interleave bit must be 2-15\n";
+    return 1;
+  }
+
+  ISS iss(cfg);
+  if (!iss.load(progfile)) {
+    cout << "Unable to load: " << progfile << endl;
+    return 1;
+  }
+
+  // ----------------------------------------------------------
+  // Run simulation
+  cout << "\nStarting ISS...\n\n";
+
+  CommitLog *commit_log = NULL;
+  MemTrace *mem_trace = NULL;
+  BranchTrace *branch_trace = NULL;
+  BBVProfile *bbv = NULL;
+
+  if (!log_file.empty()) {
+    commit_log = new CommitLog(log_file, log_text);
+    iss.add_listener(commit_log);
+  }
+
+  if (!mem_file.empty()) {
+    mem_trace = new MemTrace(mem_file);
+    iss.add_listener(mem_trace);
+  }
+
+  if (!branch_file.empty()) {
+    branch_trace = new BranchTrace(branch_file);
+    iss.add_listener(branch_trace);
+  }
+
+  if (!bbv_file.empty()) {
+    bbv = new BBVProfile(bbv_file, interval);
+    iss.add_listener(bbv);
+  }
+
+  auto start = chrono::steady_clock::now();
+  bool done = iss.run(max_cycles);
+  double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  delete commit_log;
+  delete mem_trace;
+  delete branch_trace;
+  delete bbv;
+
+  cout << "\nModelled cycles: " << iss.cycles << endl;
+  cout << "Retired instructions: " << iss.order << endl;
+  if (iss.order) printf("CPI: %.3f\n", (double)iss.cycles / iss.order);
+  if (cfg.xbar) cout << "Xbar conflicts: " << iss.xbar_conflicts << endl;
+  if (elapsed > 0) printf("Speed: %.1f MIPS\n", iss.order / elapsed / 1e6);
+  printf("Wall time: %.2fs\n", elapsed);
+
+  if (!done) {
+    cout << "Simulation Timeout\n";
+    return 1;
+  }
+
+  cout << "Exit code: " << iss.exit_code << endl;
+  cout <<"\n\n";
+  return iss.exit_code;
+}
@@ -0,0 +1,770 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <verilated.h>
+#include <verilated_vcd_c.h>
+#include <verilated_save.h>
+
+#include "kronos_sim_top.h"
+#include "rvfi.h"
+#include "commit_log.h"
+#include "mem_trace.h"
+#include "branch_trace.h"
+#include "bbv.h"
+#include "iss.h"
+#include "warm_start.h"
+
+using namespace std;
+
+// KRZ RAM, Boot ROM and Data TCM, as per kronos_sim_top
+#define RAM_BASE    0x10000
+#define RAM_WORDS   32768
+#define ROM_WORDS   256
+#define DTCM_BASE   0x8000
+#define DTCM_WORDS  1024
+
+// Kronos configuration in kronos_sim_top
+#define NUM_HPMCOUNTERS 4
+#ifndef DEEP_PIPELINE
+#define DEEP_PIPELINE 0
+#endif
+
+// Snapshot header, for the harness state
+#define SNAPSHOT_MAGIC  "KRZSNAP1"
+
+// Idle-cycle skipping: the core in WFINTR (kronos_EX state), for long enough
+// to skip ahead
+#define EX_WFINTR       5
+#define MIN_IDLE_SKIP   16
+
+#define CORE(x)         kronos_sim_top__DOT__u_core__DOT__ ## x
+#define CSR_COUNTER(x)  { \
+  &top->CORE(u_ex__DOT__u_csr__DOT__ ## x ## __DOT__count_low), \
+  &top->CORE(u_ex__DOT__u_csr__DOT__ ## x ## __DOT__count_high), \
+  &top->CORE(u_ex__DOT__u_csr__DOT__ ## x ## __DOT__incr_high) }
+
+// A kronos_counter64, see read_counter()
+struct Counter {
+  IData *low;
+  IData *high;
+  CData *incr_high;
+};
+
+class Sim {
+  private:
+    kronos_sim_top *top;
+    VerilatedVcdC* trace;
+    bool tracing;
+    uint64_t cycles;
+    uint64_t instret;
+    vector<RetireListener*> listeners;
+
+    // Warm start, the stub retirements aren't reported
+    uint32_t skip;
+    uint64_t order_offset;
+
+    // Warm start, the timer of the ISS is set after the reset
+    bool warm_timer;
+    uint64_t mtime, mtimecmp;
+    bool msip;
+
+    // Snapshot
+    uint64_t save_cycle;
+    string save_file;
+
+    // Idle-cycle skipping
+    bool idle_skip;
+    uint32_t idle;
+    uint64_t skipped;
+    vector<Counter> counters;
+    vector<uint64_t> prev_count;
+
+    // The counter value, including a pending carry into the upper word
+    uint64_t read_counter(const Counter &c) {
+      return (((uint64_t)*c.high + *c.incr_high) << 32) | *c.low;
+    }
+
+    void write_counter(const Counter &c, uint64_t v) {
+      *c.low = v;
+      *c.high = v >> 32;
+      *c.incr_high = 0;
+    }
+
+    // When the core waits for an interrupt, and none can arrive before the
+    // timer compare, then jump the model ahead to the cycle before it. The
+    // counters of the core (mcycle, and the mhpmcounters on per-cycle events)
+    // advance at their rate over the last idle cycle, and the timer with them.
+    void skip_idle(uint64_t max_cycles) {
+      if (top->CORE(u_ex__DOT__state) != EX_WFINTR) {
+        idle = 0;
+        return;
+      }
+
+      vector<uint64_t> count;
+      for (auto &c : counters) count.push_back(read_counter(c));
+
+      // The counters have settled into WFINTR over a full cycle. A pending
+      // interrupt source is either about to wake the core, or it's masked
+      if (++idle > 2 && !top->kronos_sim_top__DOT__msip
+          && top->kronos_sim_top__DOT__mtime < top->kronos_sim_top__DOT__mtimecmp) {
+
+        uint64_t n = top->kronos_sim_top__DOT__mtimecmp - top->kronos_sim_top__DOT__mtime - 1;
+        if (cycles + n > max_cycles) n = max_cycles - cycles;
+        if (!save_file.empty() && save_cycle > cycles && cycles + n >= save_cycle) n = save_cycle - 1 - cycles;
+
+        if (n >= MIN_IDLE_SKIP) {
+          for (size_t i=0; i<counters.size(); i++) {
+            count[i] += n * (count[i] - prev_count[i]);
+            write_counter(counters[i], count[i]);
+          }
+
+          top->kronos_sim_top__DOT__mtime += n;
+          top->eval();
+
+          cycles += n;
+          skipped += n;
+        }
+      }
+
+      prev_count = count;
+    }
+
+  public:
+    Sim(void) {
+      top = new kronos_sim_top;
+      trace = new VerilatedVcdC;
+      tracing = false;
+
+      cycles = 0;
+      instret = 0;
+      skip = 0;
+      order_offset = 0;
+      warm_timer = false;
+      save_cycle = 0;
+
+      idle_skip = true;
+      idle = 0;
+      skipped = 0;
+
+      // mcycle, minstret, mhpmcounter3..6
+      counters = {
+        CSR_COUNTER(u_hpmcounter0),
+        CSR_COUNTER(u_hpmcounter1),
+        CSR_COUNTER(gen_hpm__BRA__0__KET____DOT__u_hpmcounter),
+        CSR_COUNTER(gen_hpm__BRA__1__KET____DOT__u_hpmcounter),
+        CSR_COUNTER(gen_hpm__BRA__2__KET____DOT__u_hpmcounter),
+        CSR_COUNTER(gen_hpm__BRA__3__KET____DOT__u_hpmcounter)
+      };
+
+      // init inputs
+      top->clk = 0;
+      top->rstz = 1;
+    }
+
+    ~Sim(void) {
+      delete top;
+      delete trace;
+    }
+
+    // Load the program, from the memory of the ISS
+    void load(ISS &iss) {
+      for (int i=0; i<RAM_WORDS; i++) {
+        top->kronos_sim_top__DOT__MEM[i] = iss.peek(RAM_BASE + 4*i);
+      }
+      for (int i=0; i<DTCM_WORDS; i++) {
+        top->kronos_sim_top__DOT__DTCM[i] = iss.peek(DTCM_BASE + 4*i);
+      }
+    }
+
+    // Continue from the state of the ISS, see warm_start.h
+    bool warm_start(ISS &iss) {
+      // The stub runs for a few hundred cycles, which would shift an
+      // interrupt against the program
+      if (iss.interrupts_enabled()) {
+        cout << "Can't warm start with the interrupts enabled\n";
+        return false;
+      }
+
+      WarmStart ws = ::warm_start(iss, NUM_HPMCOUNTERS, ROM_WORDS);
+      if (ws.rom.size() > ROM_WORDS) {
+        cout << "Warm start stub doesn't fit the Boot ROM\n";
+        return false;
+      }
+
+      load(iss);
+      for (int i=0; i<ROM_WORDS; i++) top->kronos_sim_top__DOT__ROM[i] = ws.rom[i];
+      top->kronos_sim_top__DOT__MEM[0] = ws.boot_jump;
+
+      warm_timer = true;
+      mtime = iss.mtime;
+      mtimecmp = iss.mtimecmp;
+      msip = iss.msip;
+
+      skip = ws.length;
+      order_offset = iss.order - ws.length;
+      instret = iss.order;
+      return true;
+    }
+
+    // Save the model and the harness state to a file.
+    // The memories are a part of the model
+    bool save(string filename) {
+      VerilatedSave os;
+      string magic = SNAPSHOT_MAGIC;
+
+      os.open(filename.c_str());
+      if (!os.isOpen()) return false;
+
+      os << magic << cycles << instret << skip << order_offset;
+      os << *top;
+      os.close();
+      return true;
+    }
+
+    bool restore(string filename) {
+      VerilatedRestore os;
+      string magic;
+
+      os.open(filename.c_str());
+      if (!os.isOpen()) return false;
+
+      os >> magic;
+      if (magic != SNAPSHOT_MAGIC) return false;
+
+      os >> cycles >> instret >> skip >> order_offset;
+      os >> *top;
+      os.close();
+
+      idle = 0;
+      return true;
+    }
+
+    void save_at(uint64_t cycle, string filename) {
+      save_cycle = cycle;
+      save_file = filename;
+    }
+
+    void set_idle_skip(bool en) {
+      idle_skip = en;
+    }
+
+    uint64_t get_skipped(void) {
+      return skipped;
+    }
+
+    void add_listener(RetireListener *l) {
+      listeners.push_back(l);
+    }
+
+    void start_trace(string vcd_file) {
+      // init waveform tracer
+      Verilated::traceEverOn(true);
+      top->trace(trace, 99);
+      trace->open(vcd_file.c_str());
+      tracing = true;
+    }
+
+    void stop_trace(void) {
+      if (tracing) trace->close();
+      tracing = false;
+    }
+
+    void tick(void) {
+      top->clk = 1;
+      top->eval();
+      if (tracing) trace->dump(2*cycles);
+
+      top->clk = 0;
+      top->eval();
+      if (tracing) trace->dump(2*cycles+1);
+
+      cycles++;
+    }
+
+    void reset(void) {
+      top->rstz = 0;
+      tick();
+      top->rstz = 1;
+
+      if (warm_timer) {
+        top->kronos_sim_top__DOT__mtime = mtime;
+        top->kronos_sim_top__DOT__mtimecmp = mtimecmp;
+        top->kronos_sim_top__DOT__msip = msip;
+        top->eval();
+      }
+    }
+
+    uint64_t get_cycles(void) {
+      return cycles;
+    }
+
+    uint64_t get_instret(void) {
+      return instret;
+    }
+
+    int get_exit_code(void) {
+      return top->sim_exit_code;
+    }
+
+    void retire(void) {
+      Retired r;
+
+      if (skip) {
+        skip--;
+        return;
+      }
+
+      r.order     = top->rvfi_order + order_offset;
+      r.insn      = top->rvfi_insn;
+      r.trap      = top->rvfi_trap;
+      r.pc_rdata  = top->rvfi_pc_rdata;
+      r.pc_wdata  = top->rvfi_pc_wdata;
+      r.rd_addr   = top->rvfi_rd_addr;
+      r.rd_wdata  = top->rvfi_rd_wdata;
+      r.mem_addr  = top->rvfi_mem_addr;
+      r.mem_rmask = top->rvfi_mem_rmask;
+      r.mem_wmask = top->rvfi_mem_wmask;
+      r.mem_rdata = top->rvfi_mem_rdata;
+      r.mem_wdata = top->rvfi_mem_wdata;
+
+      // The order accounts for fused pairs
+      instret = r.order + 1;
+
+      for (auto l : listeners) l->retire(r, cycles);
+    }
+
+    // Run until the program exits, the cycle limit is hit, or the core has
+    // retired max_instret instructions
+    bool run(uint64_t max_cycles, uint64_t max_instret = UINT64_MAX) {
+      bool done = false;
+
+      while (cycles < max_cycles && instret < max_instret) {
+        tick();
+
+        if (top->rvfi_valid) retire();
+
+        if (top->uart_tx_vld) {
+          cout << (char)top->uart_tx_data;
+        }
+
+        // The program writes its exit code to SIM_EXIT, once main returns
+        if (top->sim_exit) {
+          done = true;
+          break;
+        }
+
+        if (!save_file.empty() && cycles == save_cycle) {
+          if (save(save_file)) cout << "\n[Snapshot at cycle " << cycles << ": " << save_file << "]\n";
+          else cout << "\n[Unable to save snapshot: " << save_file << "]\n";
+        }
+
+        if (idle_skip) skip_idle(max_cycles);
+      }
+
+      for (auto l : listeners) l->finish(cycles);
+
+      return done;
+    }
+};
+
+// ============================================================
+// Retirement statistics
+
+class RetireStats : public RetireListener {
+  private:
+    uint64_t instret;
+    uint64_t traps;
+
+  public:
+    RetireStats(void) {
+      instret = 0;
+      traps = 0;
+    }
+
+    void retire(const Retired &r, uint64_t /* cycle */) {
+      // The order accounts for fused pairs
+      instret = r.order + 1;
+      if (r.trap) traps++;
+    }
+
+    void finish(uint64_t cycles) {
+      cout << "\nSimulation cycles: " << cycles << endl;
+      cout << "Retired instructions: " << instret << endl;
+      cout << "Traps: " << traps << endl;
+    }
+};
+
+// ============================================================
+// Sampled simulation
+//
+// Only the representative intervals of the program (see kronos_simpoint.cpp)
+// run on the RTL. The ISS runs the whole program, and warm starts the RTL a
+// little ahead of each interval, so that the pipeline is in a steady state
+// when the measurement starts. The CPI estimate is the weighted sum of the
+// CPI of the intervals.
+//
+// The ISS also measures its own CPI over every interval, and so the error of
+// sampling the program at these intervals, against the full run, on the ISS.
+// That's a hint of how representative the intervals are, not an error bound on
+// the RTL estimate. Only a full RTL run gives the actual error.
+
+struct SimPoint {
+  uint64_t interval;
+  double weight;
+};
+
+static bool read_simpoints(string prefix, vector<SimPoint> &points) {
+  ifstream sp(prefix + ".simpoints");
+  ifstream wt(prefix + ".weights");
+  if (!sp || !wt) return false;
+
+  map<uint32_t, uint64_t> intervals;
+  map<uint32_t, double> weights;
+  uint64_t t;
+  double w;
+  uint32_t c;
+
+  while (sp >> t >> c) intervals[c] = t;
+  while (wt >> w >> c) weights[c] = w;
+
+  for (auto &i : intervals) {
+    if (weights.count(i.first) == 0) return false;
+    points.push_back({i.second, weights[i.first]});
+  }
+
+  sort(points.begin(), points.end(),
+    [](const SimPoint &a, const SimPoint &b) { return a.interval < b.interval; });
+
+  return !points.empty();
+}
+
+static int run_sampled(ISS &iss, vector<SimPoint> &points, uint64_t interval,
+    uint64_t warmup, uint64_t max_cycles) {
+
+  // ISS cycles at the end of each interval
+  vector<uint64_t> boundary;
+
+  auto advance = [&](uint64_t order) {
+    while (!iss.exited && iss.cycles < max_cycles && iss.order < order) {
+      iss.step();
+      while (iss.order >= (boundary.size() + 1) * interval) boundary.push_back(iss.cycles);
+    }
+  };
+
+  vector<double> rtl_cpi(points.size(), 0);
+  vector<bool> measured(points.size(), false);
+
+  for (size_t i=0; i<points.size(); i++) {
+    uint64_t start = points[i].interval * interval;
+    uint64_t from = start > warmup ? start - warmup : 0;
+
+    advance(from);
+    if (iss.order < from) {
+      printf("\n[Interval %lu: the program ended before it]\n", (unsigned long)points[i].interval);
+      continue;
+    }
+
+    printf("\n[Interval %lu: warm start at %lu instructions]\n",
+      (unsigned long)points[i].interval, (unsigned long)iss.order);
+
+    Sim sim;
+    if (iss.order == 0) sim.load(iss);
+    else if (!sim.warm_start(iss)) {
+      return 1;
+    }
+
+    // Warm-up, then the interval
+    sim.reset();
+    bool done = sim.run(max_cycles, start);
+    uint64_t c0 = sim.get_cycles();
+    uint64_t n0 = sim.get_instret();
+    if (!done) sim.run(max_cycles, start + interval);
+
+    uint64_t n = sim.get_instret() - n0;
+    if (n == 0) continue;
+
+    rtl_cpi[i] = (double)(sim.get_cycles() - c0) / n;
+    measured[i] = true;
+  }
+
+  // The rest of the program, on the ISS
+  advance(UINT64_MAX);
+  if (!iss.exited) {
+    cout << "\nSimulation Timeout (ISS)\n";
+    return 1;
+  }
+  if (iss.order > boundary.size() * interval) boundary.push_back(iss.cycles);
+
+  // ----------------------------------------------------------
+  // Report
+  double weight = 0, rtl = 0, sampled = 0;
+
+  cout << "\n\nInterval   Weight  CPI (RTL)  CPI (ISS)\n";
+  for (size_t i=0; i<points.size(); i++) {
+    uint64_t t = points[i].interval;
+    if (!measured[i] || t >= boundary.size()) continue;
+
+    uint64_t cycles = boundary[t] - (t ? boundary[t-1] : 0);
+    uint64_t insts = min(iss.order - t * interval, interval);
+    double iss_cpi = (double)cycles / insts;
+
+    weight += points[i].weight;
+    rtl += points[i].weight * rtl_cpi[i];
+    sampled += points[i].weight * iss_cpi;
+
+    printf("%8lu %8.4f %10.3f %10.3f\n", (unsigned long)t, points[i].weight, rtl_cpi[i], iss_cpi);
+  }
+
+  if (weight == 0) {
+    cout << "No intervals were simulated\n";
+    return 1;
+  }
+
+  rtl /= weight;
+  sampled /= weight;
+  double full = (double)iss.cycles / iss.order;
+  double error = fabs(sampled - full) / full;
+
+  printf("\nCPI (ISS, full run): %.4f\n", full);
+  printf("CPI (ISS, sampled): %.4f\n", sampled);
+  printf("Sampling error (ISS): %.2f%%\n", 100 * error);
+  printf("\nCPI estimate: %.4f\n", rtl);
+  printf("Cycle estimate: %.0f, for %lu instructions\n\n", rtl * iss.order, (unsigned long)iss.order);
+  return 0;
+}
+
+// ============================================================
+
+int main(int argc, char **argv) {
+  string memfile, vcd_file, log_file, mem_file, branch_file, ff_symbol;
+  string save_file, restore_file, bbv_file, simpoints;
+  bool log_text = false;
+  uint64_t max_cycles = 100000000;
+  uint64_t save_cycle = 0;
+  uint64_t ff_insts = 0;
+  uint64_t interval = 100000;
+  uint64_t warmup = 10000;
+  uint32_t ff_pc = 0;
+  bool ff = false, ff_at_pc = false;
+  bool idle_skip = true;
+
+  // ----------------------------------------------------------
+  // Parse args
+  if (argc < 2) {
+    cout << "[USAGE]\n";
+    cout << "kronos_sim <PATH/program.bin|elf> [options]\n";
+    cout << "kronos_sim --restore <PATH/snapshot> [options]\n";
+    cout << "  --vcd <PATH/waveform.vcd>    dump the waveform\n";
+    cout << "  --max-cycles <N>             simulation timeout\n";
+    cout << "  --log <PATH/trace.krzt>      write a binary commit log\n";
+    cout << "  --log-spike <PATH/trace.log> write a Spike compatible commit log\n";
+    cout << "  --mem-trace <PATH/trace.krzm> write the memory access trace\n";
+    cout << "  --branch-trace <PATH/trace.krzb> write the branch outcome trace\n";
+    cout << "  --bbv <PATH/profile.bb>      write the basic block vectors\n";
+    cout << "  --simpoints <PATH/prefix>    only simulate the representative intervals\n";
+    cout << "  --interval <N>               instructions per interval (default: 100000)\n";
+    cout << "  --warmup <N>                 warm-up instructions per interval (default: 10000)\n";
+    cout << "  --ff-pc <ADDR>               fast-forward on the ISS up to a PC\n";
+    cout << "  --ff-symbol <NAME>           fast-forward on the ISS up to a symbol (ELF)\n";
+    cout << "  --ff-insts <N>               fast-forward on the ISS for N instructions\n";
+    cout << "  --save <PATH/snapshot>       snapshot the simulation ...\n";
+    cout << "  --save-at <N>                ... at this cycle\n";
+    cout << "  --restore <PATH/snapshot>    resume from a snapshot\n";
+    cout << "  --no-idle-skip               simulate every cycle of a WFI\n\n";
+    return 1;
+  }
+
+  for (int i=1; i<argc; i++) {
+    string arg = argv[i];
+    if (i == 1 && arg.compare(0, 2, "--") != 0) memfile = arg;
+    else if (arg == "--vcd" && i+1 < argc) vcd_file = argv[++i];
+    else if (arg == "--save" && i+1 < argc) save_file = argv[++i];
+    else if (arg == "--save-at" && i+1 < argc) save_cycle = stoull(argv[++i]);
+    else if (arg == "--restore" && i+1 < argc) restore_file = argv[++i];
+    else if (arg == "--max-cycles" && i+1 < argc) max_cycles = stoull(argv[++i]);
+    else if (arg == "--log" && i+1 < argc) log_file = argv[++i];
+    else if (arg == "--mem-trace" && i+1 < argc) mem_file = argv[++i];
+    else if (arg == "--branch-trace" && i+1 < argc) branch_file = argv[++i];
+    else if (arg == "--bbv" && i+1 < argc) bbv_file = argv[++i];
+    else if (arg == "--simpoints" && i+1 < argc) simpoints = argv[++i];
+    else if (arg == "--interval" && i+1 < argc) interval = stoull(argv[++i]);
+    else if (arg == "--warmup" && i+1 < argc) warmup = stoull(argv[++i]);
+    else if (arg == "--ff-insts" && i+1 < argc) {
+      ff_insts = stoull(argv[++i]);
+      ff = true;
+    }
+    else if (arg == "--ff-pc" && i+1 < argc) {
+      ff_pc = stoul(argv[++i], NULL, 0);
+      ff = ff_at_pc = true;
+    }
+    else if (arg == "--ff-symbol" && i+1 < argc) {
+      ff_symbol = argv[++i];
+      ff = ff_at_pc = true;
+    }
+    else if (arg == "--no-idle-skip") idle_skip = false;
+    else if (arg == "--log-spike" && i+1 < argc) {
+      log_file = argv[++i];
+      log_text = true;
+    }
+    else {
+      cout << "Unknown argument: " << arg << endl;
+      return 1;
+    }
+  }
+
+  if (memfile.empty() == restore_file.empty()) {
+    cout << "Either a program or a snapshot is needed\n";
+    return 1;
+  }
+
+  if (ff && !restore_file.empty()) {
+    cout << "A snapshot can't be fast-forwarded\n";
+    return 1;
+  }
+
+  if (!simpoints.empty() && (ff || !restore_file.empty())) {
+    cout << "A sampled simulation can't be fast-forwarded, or restored\n";
+    return 1;
+  }
+
+  if (interval == 0) {
+    cout << "Invalid interval\n";
+    return 1;
+  }
+
+  ISSConfig cfg = KRZ_CONFIG;
+  cfg.xbar = false;
+  cfg.sys_latency = 0;
+  cfg.num_hpmcounters = NUM_HPMCOUNTERS;
+  cfg.deep_pipeline = DEEP_PIPELINE;
+
+  ISS iss(cfg);
+  Sim sim;
+
+  if (!restore_file.empty()) {
+    cout << "Snapshot: " << restore_file << endl;
+
+    if (!sim.restore(restore_file)) {
+      cout << "Unable to restore: " << restore_file << endl;
+      return 1;
+    }
+  }
+  else {
+    cout << "Program: " << memfile << endl;
+
+    if (!iss.load(memfile)) {
+      cout << "Unable to load: " << memfile << endl;
+      return 1;
+    }
+  }
+
+  if (!ff_symbol.empty() && !iss.symbol(ff_symbol, ff_pc)) {
+    cout << "Unknown symbol: " << ff_symbol << endl;
+    return 1;
+  }
+
+  if (!simpoints.empty()) {
+    vector<SimPoint> points;
+    if (!read_simpoints(simpoints, points)) {
+      cout << "Unable to read: " << simpoints << ".simpoints/.weights\n";
+      return 1;
+    }
+
+    cout << "\nStarting sampled Sim...\n";
+    return run_sampled(iss, points, interval, warmup, max_cycles);
+  }
+
+  // ----------------------------------------------------------
+  // Fast-forward on the ISS
+  if (ff) {
+    cout << "\nFast-forwarding on the ISS...\n\n";
+
+    while (!iss.exited && iss.cycles < max_cycles) {
+      if (ff_at_pc && iss.pc == ff_pc) break;
+      if (!ff_at_pc && iss.order >= ff_insts) break;
+      iss.step();
+    }
+
+    if (iss.exited || iss.cycles >= max_cycles) {
+      cout << "\nThe program ended before the fast-forward point\n";
+      return 1;
+    }
+
+    printf("\nFast-forwarded %lu instructions (~%lu cycles), to PC 0x%08x\n",
+      (unsigned long)iss.order, (unsigned long)iss.cycles, iss.pc);
+
+    if (!sim.warm_start(iss)) return 1;
+  }
+  else if (restore_file.empty()) {
+    sim.load(iss);
+  }
+
+  // ----------------------------------------------------------
+  // Run simulation
+  cout << "\nStarting Sim...\n\n";
+  RetireStats stats;
+  CommitLog *commit_log = NULL;
+  MemTrace *mem_trace = NULL;
+  BranchTrace *branch_trace = NULL;
+  BBVProfile *bbv = NULL;
+
+  sim.add_listener(&stats);
+
+  if (!log_file.empty()) {
+    commit_log = new CommitLog(log_file, log_text);
+    sim.add_listener(commit_log);
+  }
+
+  if (!mem_file.empty()) {
+    mem_trace = new MemTrace(mem_file);
+    sim.add_listener(mem_trace);
+  }
+
+  if (!branch_file.empty()) {
+    branch_trace = new BranchTrace(branch_file);
+    sim.add_listener(branch_trace);
+  }
+
+  if (!bbv_file.empty()) {
+    bbv = new BBVProfile(bbv_file, interval);
+    sim.add_listener(bbv);
+  }
+
+  if (!vcd_file.empty()) sim.start_trace(vcd_file);
+
+  if (!save_file.empty()) sim.save_at(save_cycle, save_file);
+
+  sim.set_idle_skip(idle_skip);
+
+  // A restored simulation is already out of reset
+  if (restore_file.empty()) sim.reset();
+  auto start = chrono::steady_clock::now();
+  bool done = sim.run(max_cycles);
+  double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  sim.stop_trace();
+  delete commit_log;
+  delete mem_trace;
+  delete branch_trace;
+  delete bbv;
+
+  if (sim.get_skipped()) cout << "Idle cycles skipped: " << sim.get_skipped() << endl;
+  printf("Wall time: %.2fs\n", elapsed);
+
+  if (!done) {
+    cout << "Simulation Timeout\n";
+    return 1;
+  }
+
+  cout << "Exit code: " << sim.get_exit_code() << endl;
+  cout <<"\n\n";
+  return sim.get_exit_code();
+}
@@ -0,0 +1,263 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+Kronos Simulation Top
+
+Kronos (KRZ configuration) with an ideal memory, for running the KRZ programs
+in a Verilator simulation.
+
+- 128KB RAM at 0x10000, as per the KRZ memory map. The RAM is dual ported,
+  and the instruction and data accesses complete in a cycle, without any
+  bank conflicts. It's loaded by the harness.
+- 1KB Boot ROM at 0x0, loaded by the harness. Empty, unless the harness warm
+  starts the core from the ISS state.
+- 4KB Data TCM at 0x8000, for data accesses, as the krz_dtcm.
+- System registers (0x800000+) are modelled as far as the programs need:
+  * Byte writes to the UART TX (0x800100) are presented on `uart_tx`.
+  * The UART TX queue is always empty, i.e. all system registers read as 0.
+  * A write to SIM_EXIT (0x8000FC, an unused KRZ GPREG) ends the simulation,
+    with the write data as the exit code.
+- A machine timer, for interrupt driven programs (not in KRZ), at 0x800300:
+  * mtime (0x800300/4), counts cycles
+  * mtimecmp (0x800308/C), the timer interrupt is pending while mtime >= mtimecmp
+  * msip (0x800310), bit 0 is the software interrupt
+- The retirement trace (RVFI) of the core is brought out.
+- DEEP_PIPELINE is passed on to the core, to compare the CPI of both
+  configurations on the same programs.
+*/
+
+module kronos_sim_top #(
+  parameter DEEP_PIPELINE = 0
+)(
+  input  logic        clk,
+  input  logic        rstz,
+  // Console
+  output logic        uart_tx_vld,
+  output logic [7:0]  uart_tx_data,
+  // End of simulation
+  output logic        sim_exit,
+  output logic [31:0] sim_exit_code,
+  // Retirement trace
+  output logic        rvfi_valid,
+  output logic [63:0] rvfi_order,
+  output logic [31:0] rvfi_insn,
+  output logic        rvfi_trap,
+  output logic [31:0] rvfi_pc_rdata,
+  output logic [31:0] rvfi_pc_wdata,
+  output logic [4:0]  rvfi_rd_addr,
+  output logic [31:0] rvfi_rd_wdata,
+  output logic [31:0] rvfi_mem_addr,
+  output logic [3:0]  rvfi_mem_rmask,
+  output logic [3:0]  rvfi_mem_wmask,
+  output logic [31:0] rvfi_mem_rdata,
+  output logic [31:0] rvfi_mem_wdata
+);
+
+localparam logic [31:0] RAM_BASE  = 32'h0001_0000;
+localparam logic [31:0] KRZ_UART  = 32'h0080_0100;
+localparam logic [31:0] SIM_EXIT  = 32'h0080_00FC;
+localparam logic [31:0] TIMER     = 32'h0080_0300;
+
+localparam NWORDS = 32768;
+localparam NROM = 256;
+localparam NDTCM = 1024;
+
+logic [31:0] instr_addr;
+logic [31:0] instr_data;
+logic instr_req;
+logic instr_ack;
+logic [31:0] data_addr;
+logic [31:0] data_rd_data;
+logic [31:0] data_wr_data;
+logic [3:0] data_mask;
+logic data_wr_en;
+logic data_req;
+logic data_ack;
+
+logic [31:0] MEM [NWORDS] /*verilator public*/;
+logic [31:0] ROM [NROM] /*verilator public*/;
+logic [31:0] DTCM [NDTCM] /*verilator public*/;
+
+logic [14:0] instr_word, data_word;
+logic instr_ram, data_ram;
+logic instr_rom, data_rom;
+logic data_dtcm;
+
+// Machine timer, public for the harness to skip idle cycles
+logic [63:0] mtime /*verilator public*/;
+logic [63:0] mtimecmp /*verilator public*/;
+logic msip /*verilator public*/;
+logic data_timer;
+logic [31:0] timer_rd_data;
+logic timer_interrupt, software_interrupt;
+
+// ============================================================
+// Kronos
+// ============================================================
+kronos_core #(
+  .BOOT_ADDR            (RAM_BASE),
+  .FAST_BRANCH          (1       ),
+  .EN_COUNTERS          (1       ),
+  .EN_COUNTERS64B       (0       ),
+  .CATCH_ILLEGAL_INSTR  (1       ),
+  .CATCH_MISALIGNED_JMP (0       ),
+  .CATCH_MISALIGNED_LDST(0       ),
+  .NUM_HPMCOUNTERS      (4       ),
+  .DEEP_PIPELINE        (DEEP_PIPELINE),
+  .EN_RVFI              (1       )
+) u_core (
+  .clk               (clk           ),
+  .rstz              (rstz          ),
+  .instr_addr        (instr_addr    ),
+  .instr_data        (instr_data    ),
+  .instr_req         (instr_req     ),
+  .instr_ack         (instr_ack     ),
+  .data_addr         (data_addr     ),
+  .data_rd_data      (data_rd_data  ),
+  .data_wr_data      (data_wr_data  ),
+  .data_mask         (data_mask     ),
+  .data_wr_en        (data_wr_en    ),
+  .data_req          (data_req      ),
+  .data_ack          (data_ack      ),
+  .software_interrupt(software_interrupt),
+  .timer_interrupt   (timer_interrupt   ),
+  .external_interrupt(1'b0          ),
+  .rvfi_valid        (rvfi_valid    ),
+  .rvfi_order        (rvfi_order    ),
+  .rvfi_insn         (rvfi_insn     ),
+  .rvfi_trap         (rvfi_trap     ),
+  .rvfi_pc_rdata     (rvfi_pc_rdata ),
+  .rvfi_pc_wdata     (rvfi_pc_wdata ),
+  .rvfi_rd_addr      (rvfi_rd_addr  ),
+  .rvfi_rd_wdata     (rvfi_rd_wdata ),
+  .rvfi_mem_addr     (rvfi_mem_addr ),
+  .rvfi_mem_rmask    (rvfi_mem_rmask),
+  .rvfi_mem_wmask    (rvfi_mem_wmask),
+  .rvfi_mem_rdata    (rvfi_mem_rdata),
+  .rvfi_mem_wdata    (rvfi_mem_wdata)
+);
+
+// ============================================================
+// Memory
+// ============================================================
+assign instr_ram = instr_addr[31:17] == '0 && instr_addr[16];
+assign data_ram = data_addr[31:17] == '0 && data_addr[16];
+
+assign instr_rom = instr_addr[31:10] == '0;
+assign data_rom = data_addr[31:10] == '0;
+assign data_dtcm = data_addr[31:12] == 20'h8;
+
+assign instr_word = instr_addr[16:2];
+assign data_word = data_addr[16:2];
+
+always_ff @(posedge clk or negedge rstz) begin
+  if (~rstz) begin
+    instr_ack <= 1'b0;
+    data_ack <= 1'b0;
+  end
+  else begin
+    instr_ack <= instr_req;
+    data_ack <= data_req;
+  end
+end
+
+always_ff @(posedge clk) begin
+  if (instr_req) begin
+    if (instr_ram) instr_data <= MEM[instr_word];
+    else if (instr_rom) instr_data <= ROM[instr_word[7:0]];
+    else instr_data <= '0;
+  end
+
+  if (data_req) begin
+    if (data_ram) begin
+      if (data_wr_en) begin
+        for (int i=0; i<4; i++) begin
+          if (data_mask[i]) MEM[data_word][i*8+:8] <= data_wr_data[i*8+:8];
+        end
+      end
+      else data_rd_data <= MEM[data_word];
+    end
+    else if (data_rom) data_rd_data <= ROM[data_word[7:0]];
+    else if (data_dtcm) begin
+      if (data_wr_en) begin
+        for (int i=0; i<4; i++) begin
+          if (data_mask[i]) DTCM[data_word[9:0]][i*8+:8] <= data_wr_data[i*8+:8];
+        end
+      end
+      else data_rd_data <= DTCM[data_word[9:0]];
+    end
+    else if (data_timer) data_rd_data <= timer_rd_data;
+    else data_rd_data <= '0;
+  end
+end
+
+// ============================================================
+// System
+// ============================================================
+always_ff @(posedge clk or negedge rstz) begin
+  if (~rstz) begin
+    uart_tx_vld <= 1'b0;
+    sim_exit <= 1'b0;
+  end
+  else begin
+    uart_tx_vld <= data_req && data_wr_en && data_addr == KRZ_UART;
+    uart_tx_data <= data_wr_data[7:0];
+
+    if (data_req && data_wr_en && data_addr == SIM_EXIT) begin
+      sim_exit <= 1'b1;
+      sim_exit_code <= data_wr_data;
+    end
+  end
+end
+
+// ============================================================
+// Machine Timer
+// ============================================================
+assign data_timer = data_addr[31:5] == TIMER[31:5];
+
+always_comb begin
+  unique case (data_addr[4:2])
+    3'd0: timer_rd_data = mtime[31:0];
+    3'd1: timer_rd_data = mtime[63:32];
+    3'd2: timer_rd_data = mtimecmp[31:0];
+    3'd3: timer_rd_data = mtimecmp[63:32];
+    3'd4: timer_rd_data = {31'b0, msip};
+    default: timer_rd_data = '0;
+  endcase
+end
+
+always_ff @(posedge clk or negedge rstz) begin
+  if (~rstz) begin
+    mtime <= '0;
+    mtimecmp <= '1;
+    msip <= 1'b0;
+  end
+  else begin
+    mtime <= mtime + 1'b1;
+
+    if (data_req && data_wr_en && data_timer) begin
+      unique case (data_addr[4:2])
+        3'd0: mtime[31:0] <= data_wr_data;
+        3'd1: mtime[63:32] <= data_wr_data;
+        3'd2: mtimecmp[31:0] <= data_wr_data;
+        3'd3: mtimecmp[63:32] <= data_wr_data;
+        3'd4: msip <= data_wr_data[0];
+        default: ;
+      endcase
+    end
+  end
+end
+
+assign timer_interrupt = mtime >= mtimecmp;
+assign software_interrupt = msip;
+
+// ------------------------------------------------------------
+`ifdef verilator
+logic _unused = &{1'b0
+  , instr_addr[1:0]
+  , data_addr[1:0]
+};
+`endif
+
+endmodule
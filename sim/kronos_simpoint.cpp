@@ -0,0 +1,358 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+Kronos SimPoint
+
+Picks the representative intervals of a program from its basic block vectors
+(.bb, see bbv.h), for sampled simulation on kronos_sim, as per SimPoint:
+  1. Each interval's vector is normalized to the fraction of the instructions
+     retired in each basic block
+  2. The vectors are randomly projected down to a few dimensions
+  3. They are clustered with k-means, for k up to a maximum. The smallest k
+     that scores within 90% of the best BIC is picked
+  4. The interval closest to the centroid of each cluster represents it, and
+     is weighted by the fraction of the instructions in the cluster
+
+The output is the same as SimPoint's:
+  <prefix>.simpoints    <interval> <cluster>
+  <prefix>.weights      <weight> <cluster>
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef vector<double> Point;
+
+struct Interval {
+  vector<pair<uint32_t, double>> bbv;
+  uint64_t instret;
+};
+
+struct Clustering {
+  uint32_t k;
+  vector<Point> centroids;
+  vector<uint32_t> assign;
+  double distortion;
+  double bic;
+};
+
+// ============================================================
+
+static bool read_bbv(string filename, vector<Interval> &intervals, uint32_t &num_blocks) {
+  ifstream in(filename);
+  if (!in) return false;
+
+  string line;
+  num_blocks = 0;
+
+  while (getline(in, line)) {
+    if (line.empty() || line[0] != 'T') continue;
+
+    Interval t;
+    t.instret = 0;
+
+    // T:<id>:<count> :<id>:<count> ...
+    stringstream ss(line.substr(1));
+    string tok;
+    while (ss >> tok) {
+      unsigned long id, count;
+      if (sscanf(tok.c_str(), ":%lu:%lu", &id, &count) != 2 || id == 0) return false;
+
+      t.bbv.push_back({id - 1, (double)count});
+      t.instret += count;
+      if (id > num_blocks) num_blocks = id;
+    }
+
+    if (t.instret == 0) continue;
+    for (auto &b : t.bbv) b.second /= t.instret;
+    intervals.push_back(t);
+  }
+
+  return true;
+}
+
+static double dist2(const Point &a, const Point &b) {
+  double d = 0;
+  for (size_t i=0; i<a.size(); i++) d += (a[i] - b[i]) * (a[i] - b[i]);
+  return d;
+}
+
+static uint32_t nearest(const Point &p, const vector<Point> &centroids) {
+  uint32_t best = 0;
+  double best_d = numeric_limits<double>::max();
+
+  for (uint32_t c=0; c<centroids.size(); c++) {
+    double d = dist2(p, centroids[c]);
+    if (d < best_d) {
+      best_d = d;
+      best = c;
+    }
+  }
+  return best;
+}
+
+// k-means, seeded with k-means++
+static Clustering kmeans(const vector<Point> &x, uint32_t k, mt19937 &rng, uint32_t max_iter) {
+  Clustering c;
+  uint32_t n = x.size();
+  uint32_t dim = x[0].size();
+
+  c.k = k;
+  c.centroids.push_back(x[uniform_int_distribution<uint32_t>(0, n-1)(rng)]);
+
+  vector<double> d(n);
+  while (c.centroids.size() < k) {
+    double sum = 0;
+    for (uint32_t i=0; i<n; i++) {
+      d[i] = dist2(x[i], c.centroids[nearest(x[i], c.centroids)]);
+      sum += d[i];
+    }
+
+    // All the points are already centroids
+    if (sum == 0) {
+      c.centroids.push_back(c.centroids.back());
+      continue;
+    }
+
+    double r = uniform_real_distribution<double>(0, sum)(rng);
+    uint32_t i = 0;
+    for (; i<n-1; i++) {
+      r -= d[i];
+      if (r <= 0) break;
+    }
+    c.centroids.push_back(x[i]);
+  }
+
+  c.assign.assign(n, 0);
+  for (uint32_t iter=0; iter<max_iter; iter++) {
+    bool changed = iter == 0;
+
+    for (uint32_t i=0; i<n; i++) {
+      uint32_t a = nearest(x[i], c.centroids);
+      if (a != c.assign[i]) changed = true;
+      c.assign[i] = a;
+    }
+
+    if (!changed) break;
+
+    vector<uint32_t> count(k, 0);
+    vector<Point> sum(k, Point(dim, 0));
+    for (uint32_t i=0; i<n; i++) {
+      count[c.assign[i]]++;
+      for (uint32_t j=0; j<dim; j++) sum[c.assign[i]][j] += x[i][j];
+    }
+
+    // An empty cluster keeps its centroid
+    for (uint32_t j=0; j<k; j++) {
+      if (count[j] == 0) continue;
+      for (uint32_t m=0; m<dim; m++) c.centroids[j][m] = sum[j][m] / count[j];
+    }
+  }
+
+  c.distortion = 0;
+  for (uint32_t i=0; i<n; i++) c.distortion += dist2(x[i], c.centroids[c.assign[i]]);
+
+  return c;
+}
+
+// Bayesian Information Criterion of a clustering, with spherical gaussians
+// of a shared variance (Pelleg and Moore, X-means)
+static double bic(const vector<Point> &x, const Clustering &c) {
+  double R = x.size();
+  double M = x[0].size();
+  double K = c.k;
+
+  vector<uint32_t> count(c.k, 0);
+  for (auto a : c.assign) count[a]++;
+
+  double variance = R > K ? c.distortion / (R - K) : 0;
+  if (variance <= 0) variance = numeric_limits<double>::min();
+
+  double l = 0;
+  for (uint32_t j=0; j<c.k; j++) {
+    double Rn = count[j];
+    if (Rn == 0) continue;
+
+    l += Rn * log(Rn) - Rn * log(R)
+      - Rn / 2 * log(2 * M_PI)
+      - Rn * M / 2 * log(variance)
+      - (Rn - 1) * M / 2;
+  }
+
+  double params = (K - 1) + M * K + 1;
+  return l - params / 2 * log(R);
+}
+
+// ============================================================
+
+int main(int argc, char **argv) {
+  string bbv_file, prefix;
+  uint32_t max_k = 10;
+  uint32_t fixed_k = 0;
+  uint32_t dim = 15;
+  uint32_t seeds = 5;
+  uint32_t max_iter = 100;
+  uint32_t seed = 1;
+
+  // ----------------------------------------------------------
+  // Parse args
+  if (argc < 3) {
+    cout << "[USAGE]\n";
+    cout << "kronos_simpoint <PATH/profile.bb> <PATH/prefix> [options]\n";
+    cout << "  --max-k <N>          maximum number of clusters (default: 10)\n";
+    cout << "  --k <N>              fixed number of clusters, instead of the BIC\n";
+    cout << "  --dim <N>            random projection dimensions (default: 15)\n";
+    cout << "  --seeds <N>          k-means runs per k, the best is kept (default: 5)\n";
+    cout << "  --seed <N>           random seed (default: 1)\n\n";
+    return 1;
+  }
+
+  bbv_file = argv[1];
+  prefix = argv[2];
+
+  for (int i=3; i<argc; i++) {
+    string arg = argv[i];
+    bool has_val = i+1 < argc;
+
+    if (arg == "--max-k" && has_val) max_k = stoul(argv[++i]);
+    else if (arg == "--k" && has_val) fixed_k = stoul(argv[++i]);
+    else if (arg == "--dim" && has_val) dim = stoul(argv[++i]);
+    else if (arg == "--seeds" && has_val) seeds = stoul(argv[++i]);
+    else if (arg == "--seed" && has_val) seed = stoul(argv[++i]);
+    else {
+      cout << "Unknown argument: " << arg << endl;
+      return 1;
+    }
+  }
+
+  if (max_k == 0 || dim == 0 || seeds == 0) {
+    cout << "Invalid options\n";
+    return 1;
+  }
+
+  vector<Interval> intervals;
+  uint32_t num_blocks;
+
+  if (!read_bbv(bbv_file, intervals, num_blocks)) {
+    cout << "Unable to read: " << bbv_file << endl;
+    return 1;
+  }
+
+  if (intervals.empty()) {
+    cout << "No intervals in: " << bbv_file << endl;
+    return 1;
+  }
+
+  uint32_t n = intervals.size();
+  uint64_t instret = 0;
+  for (auto &t : intervals) instret += t.instret;
+
+  printf("Intervals: %u, basic blocks: %u, instructions: %lu\n",
+    n, num_blocks, (unsigned long)instret);
+
+  // ----------------------------------------------------------
+  // Random projection, uniform in [-1, 1]
+  mt19937 rng(seed);
+  uniform_real_distribution<double> uniform(-1, 1);
+
+  vector<Point> proj(num_blocks, Point(dim));
+  for (auto &p : proj) for (auto &v : p) v = uniform(rng);
+
+  vector<Point> x(n, Point(dim, 0));
+  for (uint32_t i=0; i<n; i++) {
+    for (auto &b : intervals[i].bbv) {
+      for (uint32_t j=0; j<dim; j++) x[i][j] += b.second * proj[b.first][j];
+    }
+  }
+
+  // ----------------------------------------------------------
+  // Cluster
+  uint32_t lo = fixed_k ? fixed_k : 1;
+  uint32_t hi = fixed_k ? fixed_k : max_k;
+  if (hi > n) hi = n;
+  if (lo > hi) lo = hi;
+
+  vector<Clustering> results;
+  for (uint32_t k=lo; k<=hi; k++) {
+    Clustering best;
+    best.distortion = numeric_limits<double>::max();
+
+    for (uint32_t s=0; s<seeds; s++) {
+      Clustering c = kmeans(x, k, rng, max_iter);
+      if (c.distortion < best.distortion) best = c;
+    }
+
+    best.bic = bic(x, best);
+    results.push_back(best);
+  }
+
+  double bic_min = results[0].bic, bic_max = results[0].bic;
+  for (auto &c : results) {
+    if (c.bic < bic_min) bic_min = c.bic;
+    if (c.bic > bic_max) bic_max = c.bic;
+  }
+
+  const Clustering *pick = &results.back();
+  for (auto &c : results) {
+    if (c.bic >= bic_min + 0.9 * (bic_max - bic_min)) {
+      pick = &c;
+      break;
+    }
+  }
+
+  cout << "\n   k          BIC   distortion\n";
+  for (auto &c : results) {
+    printf("%4u %12.1f %12.6f%s\n", c.k, c.bic, c.distortion, &c == pick ? "  <" : "");
+  }
+
+  // ----------------------------------------------------------
+  // Representatives, and weights
+  vector<uint64_t> cluster_instret(pick->k, 0);
+  vector<int64_t> rep(pick->k, -1);
+  vector<double> rep_d(pick->k, numeric_limits<double>::max());
+
+  for (uint32_t i=0; i<n; i++) {
+    uint32_t a = pick->assign[i];
+    cluster_instret[a] += intervals[i].instret;
+
+    double d = dist2(x[i], pick->centroids[a]);
+    if (d < rep_d[a]) {
+      rep_d[a] = d;
+      rep[a] = i;
+    }
+  }
+
+  ofstream sp(prefix + ".simpoints");
+  ofstream wt(prefix + ".weights");
+  if (!sp || !wt) {
+    cout << "Unable to write: " << prefix << ".simpoints/.weights\n";
+    return 1;
+  }
+
+  cout << "\ncluster  interval   weight\n";
+  uint32_t id = 0;
+  for (uint32_t j=0; j<pick->k; j++) {
+    if (rep[j] < 0) continue;
+
+    double w = (double)cluster_instret[j] / instret;
+    sp << rep[j] << " " << id << "\n";
+    wt << w << " " << id << "\n";
+    printf("%7u %9ld %8.4f\n", id, (long)rep[j], w);
+    id++;
+  }
+
+  cout << "\nSimPoints: " << prefix << ".simpoints\n";
+  cout << "Weights: " << prefix << ".weights\n\n";
+  return 0;
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+Kronos Trace Dump
+
+Converts a binary commit log (.krzt) written by kronos_sim into a Spike
+compatible text commit log, or summarizes it.
+*/
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "commit_log.h"
+
+using namespace std;
+
+int main(int argc, char **argv) {
+  string tracefile;
+  bool summary = false;
+
+  if (argc < 2) {
+    cout << "[USAGE]\n";
+    cout << "kronos_trace <PATH/trace.krzt> [--summary]\n\n";
+    return 1;
+  }
+
+  tracefile = argv[1];
+  if (argc > 2 && string(argv[2]) == "--summary") summary = true;
+
+  TraceReader reader(tracefile);
+  if (!reader.ok()) {
+    cout << "Invalid trace: " << tracefile << endl;
+    return 1;
+  }
+
+  Retired r;
+  char line[128];
+  uint64_t count = 0, loads = 0, stores = 0, traps = 0, jumps = 0;
+
+  while (reader.next(r)) {
+    count++;
+
+    if (summary) {
+      if (r.mem_rmask) loads++;
+      if (r.mem_wmask) stores++;
+      if (r.trap) traps++;
+      if (r.pc_wdata != r.pc_rdata + 4) jumps++;
+    }
+    else if (format_spike(r, line, sizeof(line))) {
+      fputs(line, stdout);
+    }
+  }
+
+  if (summary) {
+    cout << "Instructions: " << count << endl;
+    cout << "Loads: " << loads << endl;
+    cout << "Stores: " << stores << endl;
+    cout << "Jumps/taken branches: " << jumps << endl;
+    cout << "Traps: " << traps << endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,123 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+Kronos Memory Access Trace
+
+The instruction fetch and data accesses of the retired instructions, in
+program order. This is what an instruction and a data cache would see,
+minus the wrong path fetches.
+
+Format (.krzm)
+  Header: "KRZM", version (1B), 3B reserved
+  Record: 4B, {word address[31:2], type[1:0]}, where type is one of MEM_*
+*/
+
+#ifndef MEM_TRACE_H
+#define MEM_TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "rvfi.h"
+
+#define KRZM_VERSION    1
+
+enum {
+  MEM_FETCH = 0,
+  MEM_LOAD  = 1,
+  MEM_STORE = 2
+};
+
+// Retirement listener that writes the memory access trace
+class MemTrace : public RetireListener {
+  private:
+    FILE *fp;
+    uint64_t count;
+
+    void put(uint32_t addr, int type) {
+      uint32_t rec = (addr & ~3u) | type;
+      fwrite(&rec, 4, 1, fp);
+      count++;
+    }
+
+  public:
+    MemTrace(std::string filename) {
+      const uint8_t hdr[8] = {'K', 'R', 'Z', 'M', KRZM_VERSION, 0, 0, 0};
+
+      count = 0;
+      fp = fopen(filename.c_str(), "wb");
+      if (fp) {
+        setvbuf(fp, NULL, _IOFBF, 1 << 20);
+        fwrite(hdr, 1, 8, fp);
+      }
+    }
+
+    ~MemTrace(void) {
+      if (fp) fclose(fp);
+    }
+
+    void retire(const Retired &r, uint64_t /* cycle */) {
+      if (fp == NULL) return;
+
+      put(r.pc_rdata, MEM_FETCH);
+      if (r.mem_rmask) put(r.mem_addr, MEM_LOAD);
+      if (r.mem_wmask) put(r.mem_addr, MEM_STORE);
+    }
+
+    void finish(uint64_t /* cycles */) {
+      if (fp == NULL) return;
+      fclose(fp);
+      fp = NULL;
+    }
+};
+
+// Memory access trace reader
+class MemTraceReader {
+  private:
+    FILE *fp;
+    uint32_t buf[4096];
+    size_t len, pos;
+
+  public:
+    MemTraceReader(std::string filename) {
+      uint8_t hdr[8];
+
+      len = 0;
+      pos = 0;
+
+      fp = fopen(filename.c_str(), "rb");
+      if (fp == NULL) return;
+
+      if (fread(hdr, 1, 8, fp) != 8 || memcmp(hdr, "KRZM", 4) != 0 || hdr[4] != KRZM_VERSION) {
+        fclose(fp);
+        fp = NULL;
+      }
+    }
+
+    ~MemTraceReader(void) {
+      if (fp) fclose(fp);
+    }
+
+    bool ok(void) {
+      return fp != NULL;
+    }
+
+    bool next(uint32_t &addr, int &type) {
+      if (pos == len) {
+        if (fp == NULL) return false;
+        len = fread(buf, 4, 4096, fp);
+        pos = 0;
+        if (len == 0) return false;
+      }
+
+      addr = buf[pos] & ~3u;
+      type = buf[pos] & 3;
+      pos++;
+      return true;
+    }
+};
+
+#endif // MEM_TRACE_H
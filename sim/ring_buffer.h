@@ -0,0 +1,67 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+Lock-free Ring Buffer
+
+Single producer, single consumer queue of fixed capacity (power of two).
+The producer (simulation loop) and the consumer (a writer thread) each own
+one index, and only publish it to the other with release/acquire ordering.
+*/
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+template <typename T>
+class RingBuffer {
+  private:
+    std::vector<T> buffer;
+    size_t mask;
+
+    // Keep the indices on separate cache lines, to avoid false sharing
+    alignas(64) std::atomic<size_t> head;   // next slot to write
+    alignas(64) std::atomic<size_t> tail;   // next slot to read
+
+  public:
+    RingBuffer(size_t log2_size) : buffer(size_t(1) << log2_size) {
+      mask = buffer.size() - 1;
+      head = 0;
+      tail = 0;
+    }
+
+    // Producer: returns false if the buffer is full
+    bool try_push(const T &item) {
+      size_t h = head.load(std::memory_order_relaxed);
+      if (h - tail.load(std::memory_order_acquire) == buffer.size()) return false;
+
+      buffer[h & mask] = item;
+      head.store(h + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Producer: waits for space, if the consumer is lagging
+    void push(const T &item) {
+      while (!try_push(item)) std::this_thread::yield();
+    }
+
+    // Consumer: returns false if the buffer is empty
+    bool pop(T &item) {
+      size_t t = tail.load(std::memory_order_relaxed);
+      if (t == head.load(std::memory_order_acquire)) return false;
+
+      item = buffer[t & mask];
+      tail.store(t + 1, std::memory_order_release);
+      return true;
+    }
+
+    bool empty(void) {
+      return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+    }
+};
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,44 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+Kronos Retirement Trace
+
+The architectural view of the simulation. Every instruction retired by the core
+is reported on its RVFI port, and the harness passes it on to the listeners
+(profilers, trace writers, checkers), so that none of them probe the RTL.
+*/
+
+#ifndef RVFI_H
+#define RVFI_H
+
+#include <cstdint>
+
+struct Retired {
+  uint64_t order;
+  uint32_t insn;
+  bool     trap;
+  uint32_t pc_rdata;
+  uint32_t pc_wdata;
+  uint8_t  rd_addr;
+  uint32_t rd_wdata;
+  uint32_t mem_addr;
+  uint8_t  mem_rmask;
+  uint8_t  mem_wmask;
+  uint32_t mem_rdata;
+  uint32_t mem_wdata;
+};
+
+class RetireListener {
+  public:
+    virtual ~RetireListener(void) {}
+
+    // Called for every retired instruction, in program order.
+    // `cycle` is the simulation cycle of the retirement
+    virtual void retire(const Retired &r, uint64_t cycle) = 0;
+
+    // Called once the simulation ends
+    virtual void finish(uint64_t /* cycles */) {}
+};
+
+#endif // RVFI_H
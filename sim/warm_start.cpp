@@ -0,0 +1,102 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+#include "warm_start.h"
+
+using namespace std;
+
+// Scratch registers of the stub, restored last
+#define T0  1
+#define T1  2
+
+// ============================================================
+// RV32I encoding
+
+static uint32_t lui(uint32_t rd, uint32_t imm20) {
+  return (imm20 << 12) | (rd << 7) | 0x37;
+}
+
+static uint32_t addi(uint32_t rd, uint32_t rs1, uint32_t imm12) {
+  return ((imm12 & 0xfff) << 20) | (rs1 << 15) | (rd << 7) | 0x13;
+}
+
+static uint32_t csrw(uint32_t csr, uint32_t rs1) {
+  return (csr << 20) | (rs1 << 15) | (1 << 12) | 0x73;
+}
+
+static uint32_t sw(uint32_t rs2, uint32_t rs1) {
+  return (rs2 << 20) | (rs1 << 15) | (2 << 12) | 0x23;
+}
+
+static uint32_t jal(int32_t offset) {
+  uint32_t imm = offset;
+  return (imm & 0x80000000) | ((imm & 0x7fe) << 20) | ((imm & 0x800) << 9) | (imm & 0xff000) | 0x6f;
+}
+
+// Always two instructions, so that the stub length is fixed
+static void li(vector<uint32_t> &p, uint32_t rd, uint32_t v) {
+  p.push_back(lui(rd, (v + 0x800) >> 12));
+  p.push_back(addi(rd, rd, v));
+}
+
+static void set_csr(vector<uint32_t> &p, uint32_t csr, uint32_t v) {
+  li(p, T0, v);
+  p.push_back(csrw(csr, T0));
+}
+
+// ============================================================
+
+WarmStart warm_start(ISS &iss, uint32_t num_hpmcounters, uint32_t rom_words) {
+  WarmStart ws;
+  vector<uint32_t> &p = ws.rom;
+
+  // Hold all the counters, until the end of the stub
+  set_csr(p, 0x320, 0xffffffff);
+
+  // CSRs
+  set_csr(p, 0x300, iss.mstatus);
+  set_csr(p, 0x304, iss.mie);
+  set_csr(p, 0x305, iss.mtvec);
+  set_csr(p, 0x340, iss.mscratch);
+  set_csr(p, 0x341, iss.mepc);
+  set_csr(p, 0x342, iss.mcause);
+  set_csr(p, 0x343, iss.mtval);
+
+  for (uint32_t i=0; i<num_hpmcounters && i<ISS_MAX_HPM; i++) {
+    set_csr(p, 0x323 + i, iss.mhpmevent[i]);
+    p.push_back(csrw(0xB03 + i, 0));
+    set_csr(p, 0xB83 + i, iss.mhpmcounter[i] >> 32);
+    set_csr(p, 0xB03 + i, iss.mhpmcounter[i]);
+  }
+
+  // Put back the instruction at the BOOT_ADDR
+  li(p, T0, KRZ_RAM_BASE);
+  li(p, T1, iss.peek(KRZ_RAM_BASE));
+  p.push_back(sw(T1, T0));
+
+  // Integer registers
+  for (uint32_t r=T1; r<32; r++) li(p, r, iss.x[r]);
+
+  // Counters, compensated for the rest of the stub after the counters are
+  // released (as per the ISS timing model): 3 instructions, 5 cycles
+  uint64_t minstret = iss.minstret - 3;
+  uint64_t mcycle = iss.mcycle - 5;
+
+  p.push_back(csrw(0xB02, 0));
+  set_csr(p, 0xB82, minstret >> 32);
+  set_csr(p, 0xB02, minstret);
+  p.push_back(csrw(0xB00, 0));
+  set_csr(p, 0xB80, mcycle >> 32);
+  set_csr(p, 0xB00, mcycle);
+
+  // Release the counters, then the last scratch register, and jump to the PC
+  set_csr(p, 0x320, iss.mcountinhibit);
+  li(p, T0, iss.x[T0]);
+  p.push_back(jal(iss.pc - (KRZ_ROM_BASE + 4 * p.size())));
+
+  ws.length = 1 + p.size();
+  ws.boot_jump = jal(KRZ_ROM_BASE - KRZ_RAM_BASE);
+
+  if (p.size() < rom_words) p.resize(rom_words, 0);
+  return ws;
+}
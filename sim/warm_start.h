@@ -0,0 +1,43 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+Kronos Warm Start
+
+Hands over the architectural state of the ISS to the core, so that a program
+can be fast-forwarded on the ISS and continue cycle-accurately on the RTL.
+
+The memory is copied as is. The rest of the state is restored by the core
+itself, with a stub program in the Boot ROM of kronos_sim_top:
+  1. The first instruction at the BOOT_ADDR is replaced with a jump to the stub
+  2. The stub inhibits all the counters (mcountinhibit)
+  3. It writes the CSRs and the mhpmcounters (with a scratch register)
+  4. It puts back the original instruction at the BOOT_ADDR
+  5. It writes the integer registers, and the counters (mcycle, minstret)
+  6. It writes back mcountinhibit, and jumps to the PC of the ISS
+
+The counters are held for most of the stub, and released right before the
+final jump, so that they resume within a few counts of the ISS. The only
+data access of the stub is the store at the BOOT_ADDR.
+*/
+
+#ifndef WARM_START_H
+#define WARM_START_H
+
+#include <cstdint>
+#include <vector>
+
+#include "iss.h"
+
+struct WarmStart {
+  // Boot ROM contents, with the stub at the start
+  std::vector<uint32_t> rom;
+  // Instruction to patch in at the BOOT_ADDR
+  uint32_t boot_jump;
+  // Instructions retired by the core, before the PC of the ISS
+  uint32_t length;
+};
+
+WarmStart warm_start(ISS &iss, uint32_t num_hpmcounters, uint32_t rom_words);
+
+#endif // WARM_START_H
@@ -5,15 +5,17 @@
 krz_bootloader.c
 
 Simple bootloader that copies over an application from the SPI Flash
-and jumps to it.
+(with Quad SPI reads) and jumps to it. The reads need the transfer register
+and the dual/quad SPI of wb_spi_master, with IO2/IO3 wired to the flash.
+
+The application can be LZ4 compressed (krzprog.py --lz4), and is then
+decompressed as it is read from the flash.
 
 If the BOOTVEC is set, then the application is loaded from there
 
 */
 
 #include <stdint.h>
-#include <stdbool.h>
-#include <string.h>
 
 // Max program size is 128KB
 #define MAX_PROG_SIZE       128*1024
@@ -21,6 +23,9 @@ If the BOOTVEC is set, then the application is loaded from there
 // Main memory start
 #define RAM_BASE_ADDR       0x00010000
 
+// Program size flag, for an LZ4 compressed program
+#define PROG_LZ4            (1<<31)
+
 
 // ENTRY
 __attribute__((naked)) void _start(void) {
@@ -80,120 +85,220 @@ __attribute__((naked)) void _exec(void) {
 #define KRZ_SPIM_CTRL       MMPTR32(KRZ_GPREG | (7<<2))
 #define KRZ_SPIM_STATUS     MMPTR32(KRZ_GPREG | (8<<2))
 
-#define GPIO_FLASH_CS       2
+#define KRZ_SPIM_XFER       MMPTR32(KRZ_GPREG | (17<<2))
+
+#define SPIM_XFER_MODE      (1<<12)
+#define SPIM_XFER_HOLD      (1<<16)
+#define SPIM_XFER_QUAD      (2<<18)
+#define SPIM_XFER_RD        (1<<20)
+#define SPIM_XFER_BUSY      (1<<24)
 
 
 // ============================================================
 // Drivers
 
-void spim_transfer(uint8_t* tx, uint8_t* rx, uint8_t len, bool start, bool stop) {
-    uint32_t qsize;
+// Transfer len bytes with the flash selected, the queued bytes first and
+// then 0x00. The flash stays selected after, if held
+void spim_xfer(uint32_t len, uint32_t flags) {
+    KRZ_SPIM_XFER = flags | len;
+    while (KRZ_SPIM_XFER & SPIM_XFER_BUSY);
+}
+
+// Single byte command, and clear the RX/TX Queue
+void spim_cmd(uint8_t cmd) {
+    MMPTR8(KRZ_SPIM) = cmd;
+    spim_xfer(1, 0);
+    KRZ_SPIM_CTRL = SPIM_XFER_MODE | (0x3 << 10);
+}
+
+// Single byte command, keeping the flash selected
+void spim_cmd_hold(uint8_t cmd) {
+    MMPTR8(KRZ_SPIM) = cmd;
+    spim_xfer(1, SPIM_XFER_HOLD);
+    (void)MMPTR8(KRZ_SPIM);
+}
+
+// Complete the transaction, power down the flash and halt
+void flash_halt(void) {
+    KRZ_SPIM_XFER = 0;
+    spim_cmd(0xB9);
+    while(1);
+}
+
+// Read the next byte of a quad read stream of lz_size bytes. The transfers
+// are started as the stream is consumed, and the bytes in the RX Queue are
+// counted to read the status only once per batch. Halts if the stream is
+// read past its end. Not inlined, to fit the decompressor in the Boot ROM
+__attribute__((noinline)) uint8_t lz_getc(uint32_t *lz_size, uint32_t *avail) {
+    uint32_t block_size, busy;
+
+    while (*avail == 0) {
+        // Once the transfer is done, all of its bytes are in the RX Queue
+        busy = KRZ_SPIM_XFER & SPIM_XFER_BUSY;
+        *avail = KRZ_SPIM_STATUS >> 16;
+
+        if (*avail == 0 && !busy) {
+            if (*lz_size == 0) flash_halt();
 
-    uint32_t gpio = KRZ_GPIO_WRITE;
-    uint32_t ctrl = KRZ_SPIM_CTRL;
+            if (*lz_size > 0xFFFC) block_size = 0xFFFC;
+            else block_size = *lz_size;
 
-    // FLASH_CS = 0
-    if (start) {
-        KRZ_GPIO_WRITE = gpio & ~(1<<GPIO_FLASH_CS);
+            KRZ_SPIM_XFER = SPIM_XFER_HOLD | SPIM_XFER_QUAD | SPIM_XFER_RD | block_size;
+            *lz_size -= block_size;
+        }
     }
 
-    // --------------------------------------------------------
-    // Write bytes to SPIM.TXQ
-    uint8_t *p = tx;
-    for (uint8_t i=0; i<len; i++) {
-        MMPTR8(KRZ_SPIM) = *p;
-        p++;
+    (*avail)--;
+    return MMPTR8(KRZ_SPIM);
+}
+
+// Length extension of an LZ4 token
+uint32_t lz_len(uint32_t len, uint32_t *lz_size, uint32_t *avail) {
+    uint8_t b;
+
+    if (len == 15) {
+        do {
+            b = lz_getc(lz_size, avail);
+            len += b;
+        } while (b == 255);
     }
+    return len;
+}
+
+// Decompress an LZ4 block of lz_size bytes, streamed from the flash, into
+// prog_size bytes in the RAM. Halts on a sequence that would write past the
+// program (which is within the RAM), or copy from before it
+void lz4_boot(uint32_t prog_size, uint32_t lz_size) {
+    uint32_t avail = 0;
+    uint32_t len, offset;
+    uint8_t token;
+    uint8_t *base, *dst, *src, *end;
+
+    base = (uint8_t*)(RAM_BASE_ADDR);
+    dst = base;
+    end = dst + prog_size;
 
-    // Wait to transaction to be done by tracking RXQ size
     while (1) {
-        qsize = (KRZ_SPIM_STATUS & 0xff00) >> 8;
-        if (qsize == len) break;
-    }
+        token = lz_getc(&lz_size, &avail);
 
-    // FLASH_CS = 1
-    if (stop) {
-        KRZ_GPIO_WRITE = gpio | (1<<GPIO_FLASH_CS);
-    }
+        // Literals
+        len = lz_len(token >> 4, &lz_size, &avail);
+        if (len > (uint32_t)(end - dst)) flash_halt();
+        while (len--) *dst++ = lz_getc(&lz_size, &avail);
+
+        // The last sequence is only literals
+        if (dst == end) break;
 
-    // --------------------------------------------------------
-    // Read from SPIM.RXQ
-    p = rx;
-    for (uint8_t i=0; i<len; i++) {
-        *p = MMPTR8(KRZ_SPIM);
-        p++;
+        // Match, copied from the decompressed program
+        offset = lz_getc(&lz_size, &avail);
+        offset |= lz_getc(&lz_size, &avail) << 8;
+
+        len = lz_len(token & 0xF, &lz_size, &avail) + 4;
+        if (offset == 0 || offset > (uint32_t)(dst - base) || len > (uint32_t)(end - dst)) flash_halt();
+
+        src = dst - offset;
+        while (len--) *dst++ = *src++;
     }
+}
 
-    // Clear TX/RX Queue
-    KRZ_SPIM_CTRL = ctrl | (0x3 << 10);
+static inline uint32_t read_mcycle(void) {
+    uint32_t tmp;
+    asm volatile(
+        "csrr %0, mcycle \n"
+        : "=r" (tmp)
+    );
+    return tmp;
 }
 
 void flashboot(uint32_t boot_addr) {
-    uint8_t tx[128], rx[128];
     uint32_t prog_size;
-    uint32_t bytes_left, block_size;
-    uint8_t *p;
-
-    memset(&tx, 0x00, 128);
-    memset(&rx, 0x00, 128);
+    uint32_t block_size;
+    uint32_t words;
+    uint32_t lz_size, sum;
+    uint32_t *p, *end;
 
     // Set SPI prescaler to max = 12MHz and SPI-Mode-0
-    KRZ_SPIM_CTRL = 0;
+    // The TX Queue is only sent in transfers
+    KRZ_SPIM_CTRL = SPIM_XFER_MODE;
 
     // Wake up the SPI Flash
-    tx[0] = 0xAB;
-    spim_transfer(tx, rx, 1, true, true);
-
-    // Read program size at given boot_addr, keep transaction open
-    tx[0] = 0x03;
-    tx[1] = (boot_addr>>16) & 0xff; 
-    tx[2] = (boot_addr>>8) & 0xff;
-    tx[3] = boot_addr & 0xff;
-    spim_transfer(tx, rx, 8, true, false);
-
-    prog_size = *(uint32_t*)(&rx[4]);
+    spim_cmd(0xAB);
+
+    // Fast Read Quad I/O (0xEB) at given boot_addr, keep transaction open
+    spim_cmd_hold(0xEB);
+
+    // Address and mode bits (0x00, no continuous read) in quad,
+    // queued in a word, lowest byte first
+    MMPTR32(KRZ_SPIM) = ((boot_addr>>16) & 0xff)
+        | ((boot_addr>>8) & 0xff) << 8
+        | (boot_addr & 0xff) << 16;
+    spim_xfer(4, SPIM_XFER_HOLD | SPIM_XFER_QUAD);
+
+    // 4 dummy clocks (2 bytes in quad), and the program size
+    // The dummy bytes are drained with a halfword read
+    spim_xfer(6, SPIM_XFER_HOLD | SPIM_XFER_QUAD | SPIM_XFER_RD);
+
+    prog_size = MMPTR16(KRZ_SPIM);
+    prog_size = MMPTR32(KRZ_SPIM);
+
+    // Compressed program, with its compressed size and checksum
+    lz_size = 0;
+    if (prog_size & PROG_LZ4) {
+        spim_xfer(8, SPIM_XFER_HOLD | SPIM_XFER_QUAD | SPIM_XFER_RD);
+        lz_size = MMPTR32(KRZ_SPIM);
+        sum = MMPTR32(KRZ_SPIM);
+        prog_size &= ~PROG_LZ4;
+
+        if (lz_size > MAX_PROG_SIZE || lz_size == 0) flash_halt();
+    }
 
     // Check if program size is valid
     if (prog_size > MAX_PROG_SIZE || prog_size == 0 || prog_size & 0x3) {
-        // complete transaction
-        KRZ_GPIO_WRITE = KRZ_GPIO_WRITE | (1<<GPIO_FLASH_CS);
-        // Power down the flash
-        tx[0] = 0xB9;
-        spim_transfer(tx, rx, 1, true, true);
-        while(1);
+        flash_halt();
     }
 
-    // initialize
-    bytes_left = prog_size;
-    memset(&tx, 0x00, 128);
-    p = (uint8_t*)(RAM_BASE_ADDR);
-
-    while (bytes_left > 0) {
+    p = (uint32_t*)(RAM_BASE_ADDR);
 
-        // Read blocks of 128B from the flash
-        if (bytes_left > 128) block_size = 128;
-        else block_size = bytes_left;
+    if (lz_size) {
+        lz4_boot(prog_size, lz_size);
 
-        spim_transfer(tx, rx, block_size, false, false);
-
-        // Write them to the SRAM
-        memcpy(p, rx, block_size);
-
-        p += block_size;
-        bytes_left -= block_size;
+        // Check the sum of the program words
+        end = p + (prog_size >> 2);
+        while (p < end) sum -= *p++;
+        if (sum) flash_halt();
+    }
+    else {
+        while (prog_size > 0) {
+
+            // Read blocks of up to 64KB from the flash, in a single transfer
+            if (prog_size > 0xFFFC) block_size = 0xFFFC;
+            else block_size = prog_size;
+
+            KRZ_SPIM_XFER = SPIM_XFER_HOLD | SPIM_XFER_QUAD | SPIM_XFER_RD | block_size;
+            prog_size -= block_size;
+
+            // Double buffered: the transfer fills the RX Queue, while the words
+            // already received are copied to the SRAM. The status is read once
+            // for every batch of words
+            end = p + (block_size >> 2);
+            while (p < end) {
+                words = KRZ_SPIM_STATUS >> 18;
+                while (words--) *p++ = MMPTR32(KRZ_SPIM);
+            }
+        }
     }
 
     // complete transaction
-    KRZ_GPIO_WRITE = KRZ_GPIO_WRITE | (1<<GPIO_FLASH_CS);
+    KRZ_SPIM_XFER = 0;
     // Power down the flash
-    tx[0] = 0xB9;
-    spim_transfer(tx, rx, 1, true, true);
+    spim_cmd(0xB9);
 }
 
 
 // ============================================================
 void main(void) {
-    // init GPIO2 (FLASH CS) as output and set it
+    // init GPIO2 (FLASH CS) as output and set it, the SPIM selects
+    // the flash during transfers
     KRZ_GPIO_DIR = 0x00000004;
     KRZ_GPIO_WRITE = 0x00000004;
 
@@ -203,6 +308,9 @@ void main(void) {
     // Copy program from Flash to RAM
     flashboot(boot_addr);
 
+    // Report the boot time, in cycles since reset
+    KRZ_SCRATCH = read_mcycle();
+
     // Jump to program
     _exec();
 
@@ -217,6 +217,131 @@ function instr_t rv32_and(logic [4:0] rd, rs1, rs2);
     return {7'b0000000, rs2, rs1, 3'b111, rd, 7'b01_100_11};
 endfunction
 
+// ========================================================
+// Zba
+// ========================================================
+function instr_t rv32_sh1add(logic [4:0] rd, rs1, rs2);
+    return {7'b0010000, rs2, rs1, 3'b010, rd, 7'b01_100_11};
+endfunction
+
+function instr_t rv32_sh2add(logic [4:0] rd, rs1, rs2);
+    return {7'b0010000, rs2, rs1, 3'b100, rd, 7'b01_100_11};
+endfunction
+
+function instr_t rv32_sh3add(logic [4:0] rd, rs1, rs2);
+    return {7'b0010000, rs2, rs1, 3'b110, rd, 7'b01_100_11};
+endfunction
+
+// ========================================================
+// Zbb
+// ========================================================
+function instr_t rv32_andn(logic [4:0] rd, rs1, rs2);
+    return {7'b0100000, rs2, rs1, 3'b111, rd, 7'b01_100_11};
+endfunction
+
+function instr_t rv32_orn(logic [4:0] rd, rs1, rs2);
+    return {7'b0100000, rs2, rs1, 3'b110, rd, 7'b01_100_11};
+endfunction
+
+function instr_t rv32_xnor(logic [4:0] rd, rs1, rs2);
+    return {7'b0100000, rs2, rs1, 3'b100, rd, 7'b01_100_11};
+endfunction
+
+function instr_t rv32_clz(logic [4:0] rd, rs1);
+    return {7'b0110000, 5'd0, rs1, 3'b001, rd, 7'b00_100_11};
+endfunction
+
+function instr_t rv32_ctz(logic [4:0] rd, rs1);
+    return {7'b0110000, 5'd1, rs1, 3'b001, rd, 7'b00_100_11};
+endfunction
+
+function instr_t rv32_cpop(logic [4:0] rd, rs1);
+    return {7'b0110000, 5'd2, rs1, 3'b001, rd, 7'b00_100_11};
+endfunction
+
+function instr_t rv32_max(logic [4:0] rd, rs1, rs2);
+    return {7'b0000101, rs2, rs1, 3'b110, rd, 7'b01_100_11};
+endfunction
+
+function instr_t rv32_maxu(logic [4:0] rd, rs1, rs2);
+    return {7'b0000101, rs2, rs1, 3'b111, rd, 7'b01_100_11};
+endfunction
+
+function instr_t rv32_min(logic [4:0] rd, rs1, rs2);
+    return {7'b0000101, rs2, rs1, 3'b100, rd, 7'b01_100_11};
+endfunction
+
+function instr_t rv32_minu(logic [4:0] rd, rs1, rs2);
+    return {7'b0000101, rs2, rs1, 3'b101, rd, 7'b01_100_11};
+endfunction
+
+function instr_t rv32_sext_b(logic [4:0] rd, rs1);
+    return {7'b0110000, 5'd4, rs1, 3'b001, rd, 7'b00_100_11};
+endfunction
+
+function instr_t rv32_sext_h(logic [4:0] rd, rs1);
+    return {7'b0110000, 5'd5, rs1, 3'b001, rd, 7'b00_100_11};
+endfunction
+
+function instr_t rv32_zext_h(logic [4:0] rd, rs1);
+    return {7'b0000100, 5'd0, rs1, 3'b100, rd, 7'b01_100_11};
+endfunction
+
+function instr_t rv32_rol(logic [4:0] rd, rs1, rs2);
+    return {7'b0110000, rs2, rs1, 3'b001, rd, 7'b01_100_11};
+endfunction
+
+function instr_t rv32_ror(logic [4:0] rd, rs1, rs2);
+    return {7'b0110000, rs2, rs1, 3'b101, rd, 7'b01_100_11};
+endfunction
+
+function instr_t rv32_rori(logic [4:0] rd, rs1, logic [31:0] imm);
+    return {7'b0110000, imm[4:0], rs1, 3'b101, rd, 7'b00_100_11};
+endfunction
+
+function instr_t rv32_orc_b(logic [4:0] rd, rs1);
+    return {12'h287, rs1, 3'b101, rd, 7'b00_100_11};
+endfunction
+
+function instr_t rv32_rev8(logic [4:0] rd, rs1);
+    return {12'h698, rs1, 3'b101, rd, 7'b00_100_11};
+endfunction
+
+// ========================================================
+// Zbs
+// ========================================================
+function instr_t rv32_bclr(logic [4:0] rd, rs1, rs2);
+    return {7'b0100100, rs2, rs1, 3'b001, rd, 7'b01_100_11};
+endfunction
+
+function instr_t rv32_bclri(logic [4:0] rd, rs1, logic [31:0] imm);
+    return {7'b0100100, imm[4:0], rs1, 3'b001, rd, 7'b00_100_11};
+endfunction
+
+function instr_t rv32_bext(logic [4:0] rd, rs1, rs2);
+    return {7'b0100100, rs2, rs1, 3'b101, rd, 7'b01_100_11};
+endfunction
+
+function instr_t rv32_bexti(logic [4:0] rd, rs1, logic [31:0] imm);
+    return {7'b0100100, imm[4:0], rs1, 3'b101, rd, 7'b00_100_11};
+endfunction
+
+function instr_t rv32_binv(logic [4:0] rd, rs1, rs2);
+    return {7'b0110100, rs2, rs1, 3'b001, rd, 7'b01_100_11};
+endfunction
+
+function instr_t rv32_binvi(logic [4:0] rd, rs1, logic [31:0] imm);
+    return {7'b0110100, imm[4:0], rs1, 3'b001, rd, 7'b00_100_11};
+endfunction
+
+function instr_t rv32_bset(logic [4:0] rd, rs1, rs2);
+    return {7'b0010100, rs2, rs1, 3'b001, rd, 7'b01_100_11};
+endfunction
+
+function instr_t rv32_bseti(logic [4:0] rd, rs1, logic [31:0] imm);
+    return {7'b0010100, imm[4:0], rs1, 3'b001, rd, 7'b00_100_11};
+endfunction
+
 // ========================================================
 // MISC
 // ========================================================
@@ -263,7 +388,6 @@ function instr_t rv32_ebreak();
     return {12'b0000000_00001, 5'b0, 3'b000, 5'b0, 7'b11_100_11};
 endfunction
 
-
 function instr_t rv32_mret();
     return {12'b0011000_00010, 5'b0, 3'b000, 5'b0, 7'b11_100_11};
 endfunction
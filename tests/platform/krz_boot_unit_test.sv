@@ -10,6 +10,8 @@ wire  TX;
 wire  SCLK;
 wire  MOSI;
 wire  MISO;
+wire  IO2;
+wire  IO3;
 wire  LEDR;
 wire  LEDG;
 wire  FLASH_CS;
@@ -21,19 +23,22 @@ krz_top u_dut (
     .SCLK (SCLK    ),
     .MOSI (MOSI    ),
     .MISO (MISO    ),
+    .IO2  (IO2     ),
+    .IO3  (IO3     ),
     .GPIO0(LEDR    ),
     .GPIO1(LEDG    ),
     .GPIO2(FLASH_CS),
     .GPIO3(GPIO3   )
 );
 
-spiflash u_flash (
+// W25Q128JV: 4 dummy clocks after the mode bits of a Quad I/O read
+spiflash #(.latency(4)) u_flash (
     .csb(FLASH_CS),
     .clk(SCLK),
     .io0(MOSI),
     .io1(MISO),
-    .io2(),
-    .io3()
+    .io2(IO2),
+    .io3(IO3)
 );
 
 // graybox probes
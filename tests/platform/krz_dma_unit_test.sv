@@ -0,0 +1,561 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+`include "vunit_defines.svh"
+
+module tb_krz_dma_ut;
+
+import krz_map::*;
+
+logic clk;
+logic rstz;
+logic [5:0] adr_i;
+logic [31:0] dat_i;
+logic [31:0] dat_o;
+logic we_i;
+logic stb_i;
+logic ack_o;
+logic [2:0] dreq;
+logic [2:0] dreq_word;
+logic irq;
+logic [23:0] dma_addr;
+logic [31:0] dma_rd_data;
+logic [31:0] dma_wr_data;
+logic [3:0] dma_mask;
+logic dma_wr_en;
+logic dma_req;
+logic dma_ack;
+logic [31:0] instr_data;
+logic instr_ack;
+logic [31:0] data_rd_data;
+logic data_ack;
+logic [23:0] bootrom_addr;
+logic [31:0] bootrom_rd_data;
+logic bootrom_en;
+logic [23:0] mem0_addr;
+logic [31:0] mem0_rd_data;
+logic [31:0] mem0_wr_data;
+logic mem0_en;
+logic mem0_wr_en;
+logic [3:0] mem0_mask;
+logic [23:0] mem1_addr;
+logic [31:0] mem1_rd_data;
+logic [31:0] mem1_wr_data;
+logic mem1_en;
+logic mem1_wr_en;
+logic [3:0] mem1_mask;
+logic [23:0] sys_adr_o;
+logic [31:0] sys_dat_i;
+logic [31:0] sys_dat_o;
+logic sys_stb_o;
+logic sys_we_o;
+logic [3:0] sys_sel_o;
+logic sys_ack_i;
+logic [7:0][31:0] stats;
+
+krz_dma #(.CHANNELS(4)) u_dut (
+    .clk        (clk        ),
+    .rstz       (rstz       ),
+    .adr_i      (adr_i      ),
+    .dat_i      (dat_i      ),
+    .dat_o      (dat_o      ),
+    .we_i       (we_i       ),
+    .stb_i      (stb_i      ),
+    .ack_o      (ack_o      ),
+    .dma_addr   (dma_addr   ),
+    .dma_rd_data(dma_rd_data),
+    .dma_wr_data(dma_wr_data),
+    .dma_mask   (dma_mask   ),
+    .dma_wr_en  (dma_wr_en  ),
+    .dma_req    (dma_req    ),
+    .dma_ack    (dma_ack    ),
+    .dreq       (dreq       ),
+    .dreq_word  (dreq_word  ),
+    .irq        (irq        )
+);
+
+krz_xbar u_xbar (
+    .clk            (clk            ),
+    .rstz           (rstz           ),
+    .instr_addr     (24'h0          ),
+    .instr_data     (instr_data     ),
+    .instr_req      (1'b0           ),
+    .instr_ack      (instr_ack      ),
+    .data_addr      (24'h0          ),
+    .data_rd_data   (data_rd_data   ),
+    .data_wr_data   (32'h0          ),
+    .data_mask      (4'h0           ),
+    .data_wr_en     (1'b0           ),
+    .data_req       (1'b0           ),
+    .data_ack       (data_ack       ),
+    .instr1_addr    (24'h0          ),
+    .instr1_data    (               ),
+    .instr1_req     (1'b0           ),
+    .instr1_ack     (               ),
+    .data1_addr     (24'h0          ),
+    .data1_rd_data  (               ),
+    .data1_wr_data  (32'h0          ),
+    .data1_mask     (4'h0           ),
+    .data1_wr_en    (1'b0           ),
+    .data1_req      (1'b0           ),
+    .data1_ack      (               ),
+    .dma_addr       (dma_addr       ),
+    .dma_rd_data    (dma_rd_data    ),
+    .dma_wr_data    (dma_wr_data    ),
+    .dma_mask       (dma_mask       ),
+    .dma_wr_en      (dma_wr_en      ),
+    .dma_req        (dma_req        ),
+    .dma_ack        (dma_ack        ),
+    .bootrom_addr   (bootrom_addr   ),
+    .bootrom_rd_data(bootrom_rd_data),
+    .bootrom_en     (bootrom_en     ),
+    .mem0_addr      (mem0_addr      ),
+    .mem0_rd_data   (mem0_rd_data   ),
+    .mem0_wr_data   (mem0_wr_data   ),
+    .mem0_en        (mem0_en        ),
+    .mem0_wr_en     (mem0_wr_en     ),
+    .mem0_mask      (mem0_mask      ),
+    .mem1_addr      (mem1_addr      ),
+    .mem1_rd_data   (mem1_rd_data   ),
+    .mem1_wr_data   (mem1_wr_data   ),
+    .mem1_en        (mem1_en        ),
+    .mem1_wr_en     (mem1_wr_en     ),
+    .mem1_mask      (mem1_mask      ),
+    .sys_adr_o      (sys_adr_o      ),
+    .sys_dat_i      (sys_dat_i      ),
+    .sys_dat_o      (sys_dat_o      ),
+    .sys_we_o       (sys_we_o       ),
+    .sys_sel_o      (sys_sel_o      ),
+    .sys_stb_o      (sys_stb_o      ),
+    .sys_ack_i      (sys_ack_i      ),
+    .stats          (stats          )
+);
+
+spsram32_model #(.WORDS(256), .AWIDTH(24), .MASK_WR_ONLY(1)) u_bootrom (
+    .clk  (clk            ),
+    .addr (bootrom_addr   ),
+    .wdata(32'b0          ),
+    .rdata(bootrom_rd_data),
+    .en   (bootrom_en     ),
+    .wr_en(1'b0           ),
+    .mask (4'b0           )
+);
+
+spsram32_model #(.WORDS(1024), .AWIDTH(24), .MASK_WR_ONLY(1)) u_mem0 (
+    .clk  (clk         ),
+    .addr (mem0_addr   ),
+    .wdata(mem0_wr_data),
+    .rdata(mem0_rd_data),
+    .en   (mem0_en     ),
+    .wr_en(mem0_wr_en  ),
+    .mask (mem0_mask   )
+);
+
+spsram32_model #(.WORDS(1024), .AWIDTH(24), .MASK_WR_ONLY(1)) u_mem1 (
+    .clk  (clk         ),
+    .addr (mem1_addr   ),
+    .wdata(mem1_wr_data),
+    .rdata(mem1_rd_data),
+    .en   (mem1_en     ),
+    .wr_en(mem1_wr_en  ),
+    .mask (mem1_mask   )
+);
+
+default clocking cb @(posedge clk);
+    default input #10ps output #10ps;
+    input ack_o, dat_o, irq;
+    output adr_i, dat_i, we_i, stb_i;
+endclocking
+
+// ============================================================
+// Peripheral model on the system bus, acks in the next cycle
+// Like the byte queues of the UART and SPIM, every selected byte lane is a
+// push to PTX on a write, or a pop from PRX on a read (lane 0 first)
+
+logic [7:0] PTX [$], PRX [$];
+
+always @(posedge clk or negedge rstz) begin
+    if (~rstz) begin
+        sys_ack_i <= 1'b0;
+    end
+    else if (sys_stb_o & ~sys_ack_i) begin
+        sys_ack_i <= 1'b1;
+        for (int i=0; i<4; i++) begin
+            if (sys_sel_o[i]) begin
+                if (sys_we_o) PTX.push_back(sys_dat_o[i*8 +: 8]);
+                else sys_dat_i[i*8 +: 8] <= PRX.pop_front();
+            end
+        end
+    end
+    else begin
+        sys_ack_i <= 1'b0;
+    end
+end
+
+// ============================================================
+
+function automatic logic [7:0] peek(logic [23:0] addr);
+    logic [31:0] word;
+    if (addr[17:16] == 2'b01) word = u_mem0.MEM[addr[11:2]];
+    else word = u_mem1.MEM[addr[11:2]];
+    return word[addr[1:0]*8 +: 8];
+endfunction
+
+task automatic reg_write(input logic [5:0] adr, input logic [31:0] data);
+    @(cb);
+    cb.adr_i <= adr;
+    cb.dat_i <= data;
+    cb.we_i <= 1'b1;
+    cb.stb_i <= 1'b1;
+    @(cb);
+    cb.stb_i <= 1'b0;
+    cb.we_i <= 1'b0;
+endtask
+
+task automatic reg_read(input logic [5:0] adr, output logic [31:0] data);
+    @(cb);
+    cb.adr_i <= adr;
+    cb.we_i <= 1'b0;
+    cb.stb_i <= 1'b1;
+    @(cb);
+    cb.stb_i <= 1'b0;
+    @(cb);
+    assert(cb.ack_o);
+    data = cb.dat_o;
+endtask
+
+task automatic setup(input int ch, input logic [23:0] src, input logic [23:0] dst,
+                     input int count, input logic [31:0] ctrl);
+    reg_write({ch[2:0], KRZ_DMA_SRC}, src);
+    reg_write({ch[2:0], KRZ_DMA_DST}, dst);
+    reg_write({ch[2:0], KRZ_DMA_COUNT}, count);
+    reg_write({ch[2:0], KRZ_DMA_CTRL}, ctrl | 1);
+endtask
+
+task automatic wait_done(input int ch);
+    logic [31:0] status;
+    do reg_read(KRZ_DMA_STATUS, status);
+    while (~status[ch]);
+    assert(~status[8+ch]);
+endtask
+
+// ============================================================
+
+`TEST_SUITE begin
+    `TEST_SUITE_SETUP begin
+        clk = 0;
+        rstz = 0;
+
+        stb_i = 0;
+        dreq = '1;
+        dreq_word = '1;
+
+        for(int i=0; i<256; i++)
+            u_bootrom.MEM[i] = $urandom;
+
+        for(int i=0; i<1024; i++) begin
+            u_mem0.MEM[i] = $urandom;
+            u_mem1.MEM[i] = $urandom;
+        end
+
+        PTX = {};
+        PRX = {};
+
+        fork
+            forever #1ns clk = ~clk;
+        join_none
+
+        ##4 rstz = 1;
+    end
+
+    `TEST_CASE("mem2mem") begin
+        int ch, n;
+        logic word;
+        logic [23:0] src, dst;
+        logic [7:0] expected [$];
+        logic [31:0] count;
+
+        repeat (64) begin
+            $display("\n-----------------------");
+
+            // Bank0 to Bank1, words or bytes at any offset
+            ch = $urandom_range(0, 3);
+            word = $urandom_range(0, 1);
+            n = $urandom_range(1, 128);
+            src = 24'h10000 + $urandom_range(0, 1024);
+            dst = 24'h20000 + $urandom_range(0, 1024);
+            if (word) begin
+                src[1:0] = 2'b0;
+                dst[1:0] = 2'b0;
+            end
+
+            expected = {};
+            for (int i=0; i<n*(word ? 4 : 1); i++)
+                expected.push_back(peek(src + i));
+
+            $display("CH%0d: %h -> %h, %0d %s", ch, src, dst, n, word ? "words" : "bytes");
+
+            // increment both, interrupt enabled
+            setup(ch, src, dst, n, 32'h46 | (word << 3));
+
+            wait_done(ch);
+            assert(irq);
+
+            for (int i=0; i<expected.size(); i++)
+                assert(peek(dst + i) == expected[i]);
+
+            reg_read({ch[2:0], KRZ_DMA_COUNT}, count);
+            assert(count == 0);
+
+            // clear done
+            reg_write(KRZ_DMA_STATUS, 1 << ch);
+            ##1;
+            assert(~irq);
+        end
+
+        ##64;
+    end
+
+    `TEST_CASE("mem2perif") begin
+        int n;
+        logic [23:0] src;
+        logic [7:0] expected [$];
+
+        repeat (16) begin
+            $display("\n-----------------------");
+
+            // Bytes out to a peripheral queue, paced by its request
+            n = $urandom_range(1, 64);
+            src = 24'h10000 + $urandom_range(0, 1024);
+
+            expected = {};
+            for (int i=0; i<n; i++)
+                expected.push_back(peek(src + i));
+
+            PTX = {};
+            dreq = '0;
+
+            fork
+                setup(1, src, 24'h800100, n, 32'h12);
+                repeat (n * 8) @(cb) dreq[0] <= $urandom_range(0, 1);
+            join
+            dreq = '1;
+
+            wait_done(1);
+            assert(~irq);
+
+            $display("TX: %p", PTX);
+            assert(PTX == expected);
+
+            reg_write(KRZ_DMA_STATUS, 2);
+        end
+
+        ##64;
+    end
+
+    `TEST_CASE("perif2mem") begin
+        int n;
+        logic word;
+        logic [23:0] dst;
+        logic [7:0] expected [$];
+
+        repeat (32) begin
+            $display("\n-----------------------");
+
+            // Bytes or words in from a peripheral queue, paced by its request.
+            // A word channel only follows the word request
+            word = $urandom_range(0, 1);
+            n = $urandom_range(1, 64);
+            dst = 24'h20000 + $urandom_range(0, 1024);
+            if (word) dst[1:0] = 2'b0;
+
+            PRX = {};
+            for (int i=0; i<n*(word ? 4 : 1); i++)
+                PRX.push_back($urandom);
+            expected = PRX;
+
+            $display("RX: %0d %s -> %h", n, word ? "words" : "bytes", dst);
+
+            dreq = word ? '1 : '0;
+            dreq_word = word ? '0 : '1;
+
+            fork
+                setup(2, 24'h800200, dst, n, 32'h34 | (word << 3));
+                repeat (n * 8) @(cb) begin
+                    if (word) dreq_word[2] <= $urandom_range(0, 1);
+                    else dreq[2] <= $urandom_range(0, 1);
+                end
+            join
+            dreq = '1;
+            dreq_word = '1;
+
+            wait_done(2);
+
+            for (int i=0; i<expected.size(); i++)
+                assert(peek(dst + i) == expected[i]);
+            assert(PRX.size() == 0);
+
+            reg_write(KRZ_DMA_STATUS, 4);
+        end
+
+        ##64;
+    end
+
+    `TEST_CASE("channels") begin
+        logic [23:0] src [4], dst [4];
+        logic [31:0] expected [4][$];
+        logic [31:0] status;
+
+        // All channels at once, in round-robin
+        for (int ch=0; ch<4; ch++) begin
+            src[ch] = 24'h10000 + ch * 256;
+            dst[ch] = 24'h20000 + ch * 256;
+            expected[ch] = {};
+            for (int i=0; i<64; i++)
+                expected[ch].push_back(u_mem0.MEM[ch * 64 + i]);
+
+            reg_write({ch[2:0], KRZ_DMA_SRC}, src[ch]);
+            reg_write({ch[2:0], KRZ_DMA_DST}, dst[ch]);
+            reg_write({ch[2:0], KRZ_DMA_COUNT}, 64);
+        end
+
+        for (int ch=0; ch<4; ch++)
+            reg_write({ch[2:0], KRZ_DMA_CTRL}, 32'hf);
+
+        do reg_read(KRZ_DMA_STATUS, status);
+        while (status[3:0] != 4'hf);
+        assert(status[11:8] == 0);
+
+        for (int ch=0; ch<4; ch++)
+            for (int i=0; i<64; i++)
+                assert(u_mem1.MEM[ch * 64 + i] == expected[ch][i]);
+
+        // Transfers counted on the DMA interface, a read and write each
+        $display("DMA grants: %0d", stats[7]);
+        assert(stats[7] == 4 * 64 * 2);
+
+        ##64;
+    end
+
+    `TEST_CASE("throughput") begin
+        int n, cycles;
+        logic word;
+        logic [23:0] src, dst;
+        logic [7:0] expected [$];
+
+        repeat (16) begin
+            $display("\n-----------------------");
+
+            // An unpaced memory copy chains the next read into the ack of
+            // the write, a transfer every 3 cycles
+            word = $urandom_range(0, 1);
+            n = $urandom_range(16, 128);
+            src = 24'h10000 + $urandom_range(0, 1024);
+            dst = 24'h20000 + $urandom_range(0, 1024);
+            if (word) begin
+                src[1:0] = 2'b0;
+                dst[1:0] = 2'b0;
+            end
+
+            expected = {};
+            for (int i=0; i<n*(word ? 4 : 1); i++)
+                expected.push_back(peek(src + i));
+
+            setup(0, src, dst, n, 32'h6 | (word << 3));
+
+            // Cycles from the start, sampled between the edges
+            cycles = 0;
+            do begin
+                @(negedge clk);
+                cycles++;
+            end while (u_dut.busy[0]);
+
+            // A cycle to pick the channel, and a cycle to see it done
+            $display("%0d %s in %0d cycles", n, word ? "words" : "bytes", cycles);
+            assert(cycles <= 3 * n + 3);
+
+            for (int i=0; i<expected.size(); i++)
+                assert(peek(dst + i) == expected[i]);
+
+            reg_write(KRZ_DMA_STATUS, 1);
+        end
+
+        ##64;
+    end
+
+    `TEST_CASE("abort") begin
+        int n, wait_cycles;
+        logic word, paced, was_busy;
+        logic [23:0] src, dst;
+        logic [7:0] expected [$], original [$];
+        logic [31:0] count, status;
+
+        repeat (64) begin
+            $display("\n-----------------------");
+
+            // Abort a copy at any point, including around its last transfer
+            word = $urandom_range(0, 1);
+            paced = $urandom_range(0, 1);
+            n = $urandom_range(1, 16);
+            src = 24'h10000 + $urandom_range(0, 1024);
+            dst = 24'h20000 + $urandom_range(0, 1024);
+            if (word) begin
+                src[1:0] = 2'b0;
+                dst[1:0] = 2'b0;
+            end
+
+            expected = {};
+            original = {};
+            for (int i=0; i<n*(word ? 4 : 1); i++) begin
+                expected.push_back(peek(src + i));
+                original.push_back(peek(dst + i));
+            end
+
+            wait_cycles = $urandom_range(0, 5 * n);
+            $display("CH3: %h -> %h, %0d %s, %s, abort after %0d cycles", src, dst, n,
+                word ? "words" : "bytes", paced ? "paced" : "unpaced", wait_cycles);
+
+            // increment both, interrupt enabled, paced by an always high dreq
+            setup(3, src, dst, n, 32'h46 | (word << 3) | (paced << 4));
+            ##(wait_cycles);
+
+            // abort, and note if the channel was still busy when it landed
+            @(cb);
+            cb.adr_i <= {3'd3, KRZ_DMA_CTRL};
+            cb.dat_i <= 32'h0;
+            cb.we_i <= 1'b1;
+            cb.stb_i <= 1'b1;
+            @(negedge clk);
+            was_busy = u_dut.busy[3];
+            @(cb);
+            cb.stb_i <= 1'b0;
+            cb.we_i <= 1'b0;
+
+            ##8;
+            reg_read(KRZ_DMA_STATUS, status);
+            reg_read({3'd3, KRZ_DMA_COUNT}, count);
+            $display("busy at the abort: %0d, status: %h, count: %0d", was_busy, status, count);
+
+            // Never done after an abort, nor busy
+            assert(~status[11]);
+            if (was_busy) begin
+                assert(~status[3]);
+                assert(~irq);
+            end
+
+            // Exactly the counted transfers landed, and none after them
+            for (int i=0; i<expected.size(); i++) begin
+                if (i < (n - count) * (word ? 4 : 1)) assert(peek(dst + i) == expected[i]);
+                else assert(peek(dst + i) == original[i]);
+            end
+
+            reg_write(KRZ_DMA_STATUS, 8);
+        end
+
+        ##64;
+    end
+end
+
+`WATCHDOG(1ms);
+
+endmodule
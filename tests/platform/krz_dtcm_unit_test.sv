@@ -0,0 +1,144 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+`include "vunit_defines.svh"
+
+module tb_krz_dtcm_ut;
+
+logic clk;
+logic rstz;
+logic [23:0] data_addr;
+logic [31:0] data_rd_data;
+logic [31:0] data_wr_data;
+logic [3:0] data_mask;
+logic data_wr_en;
+logic data_req;
+logic data_ack;
+logic [23:0] xbar_addr;
+logic [31:0] xbar_rd_data;
+logic [31:0] xbar_wr_data;
+logic [3:0] xbar_mask;
+logic xbar_wr_en;
+logic xbar_req;
+logic xbar_ack;
+
+krz_dtcm #(.KB(4)) u_dut (
+  .clk         (clk         ),
+  .rstz        (rstz        ),
+  .data_addr   (data_addr   ),
+  .data_rd_data(data_rd_data),
+  .data_wr_data(data_wr_data),
+  .data_mask   (data_mask   ),
+  .data_wr_en  (data_wr_en  ),
+  .data_req    (data_req    ),
+  .data_ack    (data_ack    ),
+  .xbar_addr   (xbar_addr   ),
+  .xbar_rd_data(xbar_rd_data),
+  .xbar_wr_data(xbar_wr_data),
+  .xbar_mask   (xbar_mask   ),
+  .xbar_wr_en  (xbar_wr_en  ),
+  .xbar_req    (xbar_req    ),
+  .xbar_ack    (xbar_ack    )
+);
+
+// Crossbar, as a memory that acks in the next cycle
+spsram32_model #(.WORDS(1024), .AWIDTH(24), .MASK_WR_ONLY(1)) u_mem (
+  .clk  (clk         ),
+  .addr (xbar_addr   ),
+  .wdata(xbar_wr_data),
+  .rdata(xbar_rd_data),
+  .en   (xbar_req    ),
+  .wr_en(xbar_wr_en  ),
+  .mask (xbar_mask   )
+);
+
+always_ff @(posedge clk or negedge rstz) begin
+  if (~rstz) xbar_ack <= 1'b0;
+  else xbar_ack <= xbar_req;
+end
+
+default clocking cb @(posedge clk);
+  default input #10ps output #10ps;
+  input data_ack, data_rd_data;
+  output data_req, data_addr, data_wr_data, data_mask, data_wr_en;
+endclocking
+
+// ============================================================
+
+`TEST_SUITE begin
+  `TEST_SUITE_SETUP begin
+    clk = 0;
+    rstz = 0;
+
+    data_req = 0;
+
+    for(int i=0; i<1024; i++) begin
+      u_dut.gen_dtcm.u_dtcm.MEM[i] = $urandom;
+      u_mem.MEM[i] = $urandom;
+    end
+
+    fork
+      forever #1ns clk = ~clk;
+    join_none
+
+    ##4 rstz = 1;
+  end
+
+  `TEST_CASE("readwrite") begin
+    logic dtcm, write;
+    logic [23:0] addr;
+    logic [9:0] word;
+    logic [31:0] check_data;
+    logic [31:0] write_data, written_data;
+    logic [3:0] mask;
+
+    repeat (1024) begin
+      $display("\n-----------------------");
+
+      // setup a read/write to the DTCM, or through to the crossbar
+      dtcm = $urandom_range(0,1);
+      word = $urandom();
+      addr = dtcm ? (24'h8000 + (word<<2)) : (24'h10000 + (word<<2));
+
+      write = $urandom_range(0,1);
+      write_data = $urandom();
+      mask = (write) ? $urandom() : '1;
+
+      written_data = dtcm ? u_dut.gen_dtcm.u_dtcm.MEM[word] : u_mem.MEM[word];
+      for (int i=0; i<4; i++)
+        if (mask[i]) written_data[i*8+:8] = write_data[i*8+:8];
+
+      @(cb);
+      cb.data_req <= 1'b1;
+      cb.data_addr <= addr;
+      cb.data_wr_en <= write;
+      cb.data_wr_data <= write_data;
+      cb.data_mask <= mask;
+
+      @(cb);
+      cb.data_req <= 1'b0;
+      assert(data_ack);
+
+      // The DTCM access never reaches the crossbar
+      assert(xbar_ack == ~dtcm);
+
+      check_data = dtcm ? u_dut.gen_dtcm.u_dtcm.MEM[word] : u_mem.MEM[word];
+      $display("%s[%h]: %h", dtcm ? "DTCM" : "XBAR", addr, check_data);
+
+      if (write) begin
+        $display("write: %h, mask: %b", write_data, mask);
+        assert(check_data == written_data);
+      end
+      else begin
+        $display("read: %h", data_rd_data);
+        assert(data_rd_data == check_data);
+      end
+    end
+
+    ##64;
+  end
+end
+
+`WATCHDOG(1ms);
+
+endmodule
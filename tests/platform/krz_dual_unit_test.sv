@@ -0,0 +1,166 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+`include "vunit_defines.svh"
+
+module tb_krz_dual;
+
+import kronos_types::*;
+import rv32_assembler::*;
+
+logic RSTN;
+logic TX;
+
+krz_top #(.CORES(2)) u_dut (
+  .RSTN(RSTN),
+  .TX(TX)
+);
+
+// graybox probes
+`define MBOX u_dut.u_mbox
+`define CORE1_RSTZ u_dut.gen_core1.core1_rstz
+
+assign clk = u_dut.clk;
+default clocking cb @(posedge clk);
+  default input #10ps output #10ps;
+endclocking
+
+`define MEM00 u_dut.u_mem0.MEMINST[0].u_spsram.vfb_b_inst.SRAM_inst.spram256k_core_inst.uut.mem_core_array
+`define MEM01 u_dut.u_mem0.MEMINST[1].u_spsram.vfb_b_inst.SRAM_inst.spram256k_core_inst.uut.mem_core_array
+
+// Mailbox, and the shared data (RAM)
+localparam logic [31:0] MBOX = 32'h800500;
+localparam logic [31:0] DATA = 32'h11000;
+
+// ============================================================
+logic [31:0] PROG [1024];
+
+`TEST_SUITE begin
+  `TEST_SUITE_SETUP begin
+    RSTN = 1;
+  end
+
+  `TEST_CASE("handoff") begin
+    logic [31:0] data [6];
+
+    ##8;
+
+    // Boot ROM: jump to the RAM
+    u_dut.u_bootrom.MEM[0] = rv32_jal(x0, 32'h10000);
+
+    // Both cores start at the RAM, and branch on the mhartid
+    //  - core0 acquires SEM0, and releases core1, which waits on SEM0.
+    //    core0 writes the shared data, and releases SEM0
+    //  - core1 acquires SEM0, and posts the shared data (+0x100) to core0
+    //  - core0 reads its message (twice, the second read is cleared), and
+    //    posts it (+1) to core1, which stores it
+    PROG = '{default: '0};
+
+    PROG[0]  = rv32_csrrs(x1, x0, 12'hF14);     // mhartid
+    PROG[1]  = rv32_lui(x2, MBOX);
+    PROG[2]  = rv32_addi(x2, x2, MBOX[11:0]);
+    PROG[3]  = rv32_lui(x10, DATA);
+    PROG[4]  = rv32_bne(x1, x0, (32-4)*4);      // core1
+
+    // core0
+    PROG[5]  = rv32_lw(x3, x2, 0);              // acquire SEM0
+    PROG[6]  = rv32_sw(x10, x3, 0);
+    PROG[7]  = rv32_addi(x4, x0, 3);
+    PROG[8]  = rv32_sw(x2, x4, 8'h44);          // RUN, release core1
+    PROG[9]  = rv32_addi(x5, x0, 64);           // hold SEM0 for a while
+    PROG[10] = rv32_addi(x5, x5, -1);
+    PROG[11] = rv32_bne(x5, x0, -4);
+    PROG[12] = rv32_addi(x6, x0, 32'h55);
+    PROG[13] = rv32_sw(x10, x6, 4);             // shared data
+    PROG[14] = rv32_sw(x2, x0, 0);              // release SEM0
+    PROG[15] = rv32_lw(x7, x2, 8'h40);          // wait for MSG0 (STATUS)
+    PROG[16] = rv32_andi(x7, x7, 1);
+    PROG[17] = rv32_beq(x7, x0, -8);
+    PROG[18] = rv32_lw(x8, x2, 8'h20);          // MSG0
+    PROG[19] = rv32_sw(x10, x8, 8);
+    PROG[20] = rv32_lw(x9, x2, 8'h20);          // MSG0, cleared
+    PROG[21] = rv32_sw(x10, x9, 12);
+    PROG[22] = rv32_addi(x11, x8, 1);
+    PROG[23] = rv32_sw(x2, x11, 8'h24);         // MSG1
+    PROG[24] = rv32_jal(x0, 0);
+
+    // core1
+    PROG[32] = rv32_addi(x5, x0, 0);
+    PROG[33] = rv32_lw(x3, x2, 0);              // acquire SEM0, count the tries
+    PROG[34] = rv32_addi(x5, x5, 1);
+    PROG[35] = rv32_bne(x3, x0, -8);
+    PROG[36] = rv32_sw(x10, x5, 16);
+    PROG[37] = rv32_lw(x6, x10, 4);             // shared data
+    PROG[38] = rv32_addi(x6, x6, 32'h100);
+    PROG[39] = rv32_sw(x2, x0, 0);              // release SEM0
+    PROG[40] = rv32_sw(x2, x6, 8'h20);          // MSG0
+    PROG[41] = rv32_lw(x7, x2, 8'h40);          // wait for MSG1 (STATUS)
+    PROG[42] = rv32_andi(x7, x7, 2);
+    PROG[43] = rv32_beq(x7, x0, -8);
+    PROG[44] = rv32_lw(x8, x2, 8'h24);          // MSG1
+    PROG[45] = rv32_sw(x10, x8, 20);
+    PROG[46] = rv32_jal(x0, 0);
+
+    foreach (PROG[i]) begin
+      {`MEM01[i], `MEM00[i]} = PROG[i];
+    end
+
+    // Shared data, poisoned
+    for (int i=0; i<6; i++) begin
+      {`MEM01[DATA[15:2] + i], `MEM00[DATA[15:2] + i]} = '1;
+    end
+
+    reset();
+
+    // core1 is held in reset, until released by core0
+    assert(~`CORE1_RSTZ);
+    fork
+      begin
+        @(posedge `CORE1_RSTZ);
+        $display("core1 released");
+      end
+      ##20000;
+    join_any
+    assert(`CORE1_RSTZ);
+
+    ##4000;
+
+    for (int i=0; i<6; i++) begin
+      data[i] = {`MEM01[DATA[15:2] + i], `MEM00[DATA[15:2] + i]};
+      $display("DATA[%0d] = %h", i, data[i]);
+    end
+
+    // core0 acquired SEM0 on the first try
+    assert(data[0] == 0);
+    assert(data[1] == 32'h55);
+    // core1 waited on SEM0, and then saw the shared data
+    assert(data[4] > 1);
+    assert(data[2] == 32'h155);
+    // a message is cleared on read
+    assert(data[3] == 0);
+    assert(data[5] == 32'h156);
+
+    // All released, and read
+    assert(`MBOX.sem == '0);
+    assert(`MBOX.msip == '0);
+    assert(`MBOX.msg == '0);
+
+    ##64;
+  end
+end
+
+`WATCHDOG(10ms);
+
+
+// ============================================================
+// METHODS
+// ============================================================
+
+task automatic reset();
+  // Press reset
+  ##4 RSTN = 0;
+  ##4 RSTN = 1;
+  ##4;
+endtask
+
+endmodule
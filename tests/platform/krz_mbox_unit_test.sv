@@ -0,0 +1,151 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+`include "vunit_defines.svh"
+
+module tb_krz_mbox_ut;
+
+import krz_map::*;
+
+logic clk;
+logic rstz;
+logic [5:0] adr;
+logic [31:0] rdat;
+logic [31:0] wdat;
+logic we;
+logic stb;
+logic ack;
+logic [1:0] msip;
+logic [1:0] run;
+
+krz_mbox #(.CORES(2)) u_dut (
+  .clk  (clk  ),
+  .rstz (rstz ),
+  .adr_i(adr  ),
+  .dat_i(wdat ),
+  .dat_o(rdat ),
+  .we_i (we   ),
+  .stb_i(stb  ),
+  .ack_o(ack  ),
+  .msip (msip ),
+  .run  (run  )
+);
+
+default clocking cb @(posedge clk);
+  default input #10ps output #10ps;
+  input ack, rdat, msip, run;
+  output stb, adr, wdat, we;
+endclocking
+
+// ============================================================
+
+`TEST_SUITE begin
+  `TEST_SUITE_SETUP begin
+    clk = 0;
+    rstz = 0;
+
+    stb = 0;
+
+    fork
+      forever #1ns clk = ~clk;
+    join_none
+
+    ##4 rstz = 1;
+  end
+
+  `TEST_CASE("semaphore") begin
+    logic [31:0] data;
+
+    for (int i=0; i<8; i++) begin
+      // acquired on the first read, and held until released
+      reg_read(KRZ_MBOX_SEM + 6'(i), data);
+      assert(data == 0);
+      reg_read(KRZ_MBOX_SEM + 6'(i), data);
+      assert(data == 1);
+
+      reg_write(KRZ_MBOX_SEM + 6'(i), 0);
+      reg_read(KRZ_MBOX_SEM + 6'(i), data);
+      assert(data == 0);
+    end
+
+    ##64;
+  end
+
+  `TEST_CASE("mailbox") begin
+    logic [31:0] data, msg;
+
+    ##1 assert(cb.msip == 2'b00);
+
+    repeat (64) begin
+      for (int i=0; i<2; i++) begin
+        msg = $urandom();
+        $display("MSG[%0d]: %h", i, msg);
+
+        reg_write(KRZ_MBOX_MSG + 6'(i), msg);
+        ##1 assert(cb.msip == 2'(1<<i));
+
+        reg_read(KRZ_MBOX_STATUS, data);
+        assert(data == 1<<i);
+
+        // reading the message clears it
+        reg_read(KRZ_MBOX_MSG + 6'(i), data);
+        assert(data == msg);
+        assert(cb.msip == 2'b00);
+
+        reg_read(KRZ_MBOX_MSG + 6'(i), data);
+        assert(data == 0);
+      end
+    end
+
+    ##64;
+  end
+
+  `TEST_CASE("run") begin
+    logic [31:0] data;
+
+    // core0 always runs
+    ##1 assert(cb.run == 2'b01);
+
+    reg_write(KRZ_MBOX_RUN, 2);
+    ##1 assert(cb.run == 2'b11);
+
+    reg_read(KRZ_MBOX_RUN, data);
+    assert(data == 3);
+
+    reg_write(KRZ_MBOX_RUN, 0);
+    ##1 assert(cb.run == 2'b01);
+
+    ##64;
+  end
+end
+
+`WATCHDOG(1ms);
+
+// ============================================================
+// METHODS
+// ============================================================
+
+task automatic reg_write(input logic [5:0] addr, input logic [31:0] data);
+  @(cb);
+  cb.adr <= addr;
+  cb.wdat <= data;
+  cb.we <= 1'b1;
+  cb.stb <= 1'b1;
+  @(cb);
+  cb.stb <= 1'b0;
+  cb.we <= 1'b0;
+endtask
+
+task automatic reg_read(input logic [5:0] addr, output logic [31:0] data);
+  @(cb);
+  cb.adr <= addr;
+  cb.we <= 1'b0;
+  cb.stb <= 1'b1;
+  @(cb);
+  cb.stb <= 1'b0;
+  @(cb);
+  assert(cb.ack);
+  data = cb.rdat;
+endtask
+
+endmodule
@@ -21,6 +21,7 @@ logic [5:0] perif_adr;
 logic [2:0][31:0] perif_rdat;
 logic [31:0] perif_wdat;
 logic perif_we;
+logic [3:0] perif_sel;
 logic [2:0] perif_stb;
 logic [2:0] perif_ack;
 
@@ -31,12 +32,14 @@ krz_sysbus u_sysbus (
     .sys_dat_i  (sys_wdat  ),
     .sys_dat_o  (sys_rdat  ),
     .sys_we_i   (sys_we    ),
+    .sys_sel_i  (4'hF      ),
     .sys_stb_i  (sys_stb   ),
     .sys_ack_o  (sys_ack   ),
     .perif_adr_o(perif_adr ),
     .perif_dat_i(perif_rdat),
     .perif_dat_o(perif_wdat),
     .perif_we_o (perif_we  ),
+    .perif_sel_o(perif_sel ),
     .perif_stb_o(perif_stb ),
     .perif_ack_o(perif_ack )
 );
@@ -53,31 +56,48 @@ logic spim_cpol;
 logic spim_cpha;
 logic spim_tx_clear;
 logic spim_rx_clear;
-logic [7:0] spim_tx_size;
-logic [7:0] spim_rx_size;
+logic [9:0] spim_tx_size;
+logic [9:0] spim_rx_size;
+logic spim_xfer_mode;
+logic [15:0] spim_xfer_len;
+logic spim_xfer_hold;
+logic spim_xfer_start;
+logic spim_cs_sel;
+logic [1:0] spim_xfer_width;
+logic spim_xfer_rd;
 
 krz_gpreg u_gpr (
-    .clk           (clk           ),
-    .rstz          (rstz          ),
-    .adr_i         (perif_adr     ),
-    .dat_i         (perif_wdat    ),
-    .dat_o         (perif_rdat[0] ),
-    .we_i          (perif_we      ),
-    .stb_i         (perif_stb[0]  ),
-    .ack_o         (perif_ack[0]  ),
-    .gpio_dir      (gpio_dir      ),
-    .gpio_write    (gpio_write    ),
-    .gpio_read     (gpio_read     ),
-    .uart_prescaler(uart_prescaler),
-    .uart_tx_clear (uart_tx_clear ),
-    .uart_tx_size  (uart_tx_size  ),
-    .spim_prescaler(spim_prescaler),
-    .spim_cpol     (spim_cpol     ),
-    .spim_cpha     (spim_cpha     ),
-    .spim_tx_clear (spim_tx_clear ),
-    .spim_rx_clear (spim_rx_clear ),
-    .spim_tx_size  (spim_tx_size  ),
-    .spim_rx_size  (spim_rx_size  )
+    .clk            (clk            ),
+    .rstz           (rstz           ),
+    .adr_i          (perif_adr      ),
+    .dat_i          (perif_wdat     ),
+    .dat_o          (perif_rdat[0]  ),
+    .we_i           (perif_we       ),
+    .stb_i          (perif_stb[0]   ),
+    .ack_o          (perif_ack[0]   ),
+    .gpio_dir       (gpio_dir       ),
+    .gpio_write     (gpio_write     ),
+    .gpio_read      (gpio_read      ),
+    .uart_prescaler (uart_prescaler ),
+    .uart_tx_clear  (uart_tx_clear  ),
+    .uart_tx_size   (uart_tx_size   ),
+    .spim_prescaler (spim_prescaler ),
+    .spim_cpol      (spim_cpol      ),
+    .spim_cpha      (spim_cpha      ),
+    .spim_tx_clear  (spim_tx_clear  ),
+    .spim_rx_clear  (spim_rx_clear  ),
+    .spim_xfer_mode (spim_xfer_mode ),
+    .spim_tx_size   (spim_tx_size   ),
+    .spim_rx_size   (spim_rx_size   ),
+    .spim_xfer_len  (spim_xfer_len  ),
+    .spim_xfer_hold (spim_xfer_hold ),
+    .spim_xfer_start(spim_xfer_start),
+    .spim_cs_sel    (spim_cs_sel    ),
+    .spim_xfer_width(spim_xfer_width),
+    .spim_xfer_rd   (spim_xfer_rd   ),
+    .spim_xfer_left ('0             ),
+    .spim_xfer_busy (1'b0           ),
+    .xbar_stats     ('0             )
 );
 
 default clocking cb @(posedge clk);
@@ -137,7 +157,11 @@ logic [7:0] TX [$], RX [$];
             $display("sys_wdat = %h", write_data);
             $display("sys_we = %h", is_write);
 
-            @(cb iff cb.sys_ack);
+            // Single cycle access
+            @(cb);
+            assert(~cb.sys_ack);
+            @(cb);
+            assert(cb.sys_ack);
             cb.sys_stb <= 1'b0;
 
             // check registers
@@ -0,0 +1,424 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+`include "vunit_defines.svh"
+
+module tb_krz_xbar_dual_ut;
+
+logic clk;
+logic rstz;
+
+// Per core (0, 1) instr and data interfaces
+logic [1:0][23:0] i_addr;
+logic [1:0][31:0] i_data;
+logic [1:0] i_hold, i_req, i_ack;
+
+logic [1:0][23:0] d_addr;
+logic [1:0][31:0] d_rd_data;
+logic [1:0][31:0] d_wr_data;
+logic [1:0][3:0] d_mask;
+logic [1:0] d_wr_en;
+logic [1:0] d_hold, d_req, d_ack;
+
+logic dma_ack;
+logic [23:0] bootrom_addr;
+logic [31:0] bootrom_rd_data;
+logic bootrom_en;
+logic [23:0] mem0_addr;
+logic [31:0] mem0_rd_data;
+logic [31:0] mem0_wr_data;
+logic mem0_en;
+logic mem0_wr_en;
+logic [3:0] mem0_mask;
+logic [23:0] mem1_addr;
+logic [31:0] mem1_rd_data;
+logic [31:0] mem1_wr_data;
+logic mem1_en;
+logic mem1_wr_en;
+logic [3:0] mem1_mask;
+logic [23:0] sys_adr_o;
+logic [31:0] sys_dat_i;
+logic [31:0] sys_dat_o;
+logic sys_stb_o;
+logic sys_we_o;
+logic [3:0] sys_sel_o;
+logic sys_ack_i;
+logic [7:0][31:0] stats;
+
+krz_xbar #(.CORES(2)) u_dut (
+    .clk            (clk            ),
+    .rstz           (rstz           ),
+    .instr_addr     (i_addr[0]      ),
+    .instr_data     (i_data[0]      ),
+    .instr_req      (i_req[0]       ),
+    .instr_ack      (i_ack[0]       ),
+    .data_addr      (d_addr[0]      ),
+    .data_rd_data   (d_rd_data[0]   ),
+    .data_wr_data   (d_wr_data[0]   ),
+    .data_mask      (d_mask[0]      ),
+    .data_wr_en     (d_wr_en[0]     ),
+    .data_req       (d_req[0]       ),
+    .data_ack       (d_ack[0]       ),
+    .instr1_addr    (i_addr[1]      ),
+    .instr1_data    (i_data[1]      ),
+    .instr1_req     (i_req[1]       ),
+    .instr1_ack     (i_ack[1]       ),
+    .data1_addr     (d_addr[1]      ),
+    .data1_rd_data  (d_rd_data[1]   ),
+    .data1_wr_data  (d_wr_data[1]   ),
+    .data1_mask     (d_mask[1]      ),
+    .data1_wr_en    (d_wr_en[1]     ),
+    .data1_req      (d_req[1]       ),
+    .data1_ack      (d_ack[1]       ),
+    .dma_addr       (24'h0          ),
+    .dma_rd_data    (               ),
+    .dma_wr_data    (32'h0          ),
+    .dma_mask       (4'h0           ),
+    .dma_wr_en      (1'b0           ),
+    .dma_req        (1'b0           ),
+    .dma_ack        (dma_ack        ),
+    .bootrom_addr   (bootrom_addr   ),
+    .bootrom_rd_data(bootrom_rd_data),
+    .bootrom_en     (bootrom_en     ),
+    .mem0_addr      (mem0_addr      ),
+    .mem0_rd_data   (mem0_rd_data   ),
+    .mem0_wr_data   (mem0_wr_data   ),
+    .mem0_en        (mem0_en        ),
+    .mem0_wr_en     (mem0_wr_en     ),
+    .mem0_mask      (mem0_mask      ),
+    .mem1_addr      (mem1_addr      ),
+    .mem1_rd_data   (mem1_rd_data   ),
+    .mem1_wr_data   (mem1_wr_data   ),
+    .mem1_en        (mem1_en        ),
+    .mem1_wr_en     (mem1_wr_en     ),
+    .mem1_mask      (mem1_mask      ),
+    .sys_adr_o      (sys_adr_o      ),
+    .sys_dat_i      (sys_dat_i      ),
+    .sys_dat_o      (sys_dat_o      ),
+    .sys_we_o       (sys_we_o       ),
+    .sys_sel_o      (sys_sel_o      ),
+    .sys_stb_o      (sys_stb_o      ),
+    .sys_ack_i      (sys_ack_i      ),
+    .stats          (stats          )
+);
+
+spsram32_model #(.WORDS(256), .AWIDTH(24), .MASK_WR_ONLY(1)) u_bootrom (
+    .clk  (clk            ),
+    .addr (bootrom_addr   ),
+    .wdata(32'b0          ),
+    .rdata(bootrom_rd_data),
+    .en   (bootrom_en     ),
+    .wr_en(1'b0           ),
+    .mask (4'b0           )
+);
+
+spsram32_model #(.WORDS(1024), .AWIDTH(24), .MASK_WR_ONLY(1)) u_mem0 (
+    .clk  (clk         ),
+    .addr (mem0_addr   ),
+    .wdata(mem0_wr_data),
+    .rdata(mem0_rd_data),
+    .en   (mem0_en     ),
+    .wr_en(mem0_wr_en  ),
+    .mask (mem0_mask   )
+);
+
+spsram32_model #(.WORDS(1024), .AWIDTH(24), .MASK_WR_ONLY(1)) u_mem1 (
+    .clk  (clk         ),
+    .addr (mem1_addr   ),
+    .wdata(mem1_wr_data),
+    .rdata(mem1_rd_data),
+    .en   (mem1_en     ),
+    .wr_en(mem1_wr_en  ),
+    .mask (mem1_mask   )
+);
+
+// Like the Kronos LSU and IF, a request is held until it is acked, and
+// dropped in the ack cycle
+assign i_req = i_hold & ~i_ack;
+assign d_req = d_hold & ~d_ack;
+
+default clocking cb @(posedge clk);
+    default input #10ps output #10ps;
+    input i_ack, i_data;
+    input d_ack, d_rd_data;
+    output i_hold, i_addr;
+    output d_hold, d_addr, d_wr_data, d_mask, d_wr_en;
+endclocking
+
+// ============================================================
+// Data requests to the memories wait at most a cycle, for the other core,
+// as the cores are served round-robin, and data has priority over instr
+
+int d_wait [2];
+logic check_wait;
+
+always @(posedge clk) begin
+    for (int c=0; c<2; c++) begin
+        if (d_req[c]) begin
+            d_wait[c]++;
+            if (check_wait) assert(d_wait[c] <= 2)
+                else $error("core%0d data request waited %0d cycles", c, d_wait[c]);
+        end
+        else d_wait[c] = 0;
+    end
+end
+
+// ============================================================
+// Peripheral model on the system bus, acks after 0-3 wait cycles, with
+// the read data derived from the address. Notes the order of the cores
+
+logic perif_busy;
+int perif_wait;
+logic [23:0] perif_adr;
+logic [31:0] perif_wr [logic [23:0]];
+int last_core;
+
+function automatic logic [31:0] perif_data(logic [23:0] addr);
+    return {8'h0, addr} ^ 32'h5a5a5a5a;
+endfunction
+
+// The addresses of core1 are in the upper half of the 1KB window
+function automatic int perif_core(logic [23:0] addr);
+    return addr[9];
+endfunction
+
+always @(posedge clk or negedge rstz) begin
+    if (~rstz) begin
+        sys_ack_i <= 1'b0;
+        perif_busy <= 1'b0;
+        last_core = -1;
+    end
+    else begin
+        sys_ack_i <= 1'b0;
+
+        if (~perif_busy && ~sys_ack_i && sys_stb_o) begin
+            // round-robin, when both cores are waiting
+            if (d_hold == 2'b11 && last_core >= 0)
+                assert(perif_core(sys_adr_o) != last_core)
+                    else $error("core%0d took the system bus twice", last_core);
+            last_core = perif_core(sys_adr_o);
+
+            if (sys_we_o) perif_wr[sys_adr_o] = sys_dat_o;
+            perif_adr <= sys_adr_o;
+            perif_wait <= $urandom_range(0, 3);
+            perif_busy <= 1'b1;
+        end
+        else if (perif_busy) begin
+            // The owner holds the system bus until the ack
+            assert(sys_stb_o && sys_adr_o == perif_adr);
+
+            if (perif_wait == 0) begin
+                sys_ack_i <= 1'b1;
+                sys_dat_i <= perif_data(perif_adr);
+                perif_busy <= 1'b0;
+            end
+            else perif_wait <= perif_wait - 1;
+        end
+    end
+end
+
+// ============================================================
+
+`TEST_SUITE begin
+    `TEST_SUITE_SETUP begin
+        clk = 0;
+        rstz = 0;
+
+        i_hold = 0;
+        d_hold = 0;
+        check_wait = 0;
+
+        for(int i=0; i<256; i++)
+            u_bootrom.MEM[i] = $urandom;
+
+        for(int i=0; i<1024; i++) begin
+            u_mem0.MEM[i] = $urandom;
+            u_mem1.MEM[i] = $urandom;
+        end
+
+        fork
+            forever #1ns clk = ~clk;
+        join_none
+
+        ##4 rstz = 1;
+    end
+
+    `TEST_CASE("contend") begin
+        logic [7:0][31:0] prev_stats;
+
+        // Both cores, fetching and accessing data at once, on the Boot ROM
+        // and both banks. Each core writes its own words, and the fetches
+        // read the words that aren't written
+        prev_stats = stats;
+        check_wait = 1;
+
+        fork
+            data_traffic(0, 512);
+            data_traffic(1, 512);
+            instr_traffic(0, 512);
+            instr_traffic(1, 512);
+        join
+
+        check_wait = 0;
+
+        // Every access is granted once
+        $display("Conflicts: %0d", stats[0] - prev_stats[0]);
+        assert(stats[1] - prev_stats[1] == 2 * 512);
+        assert(stats[2] - prev_stats[2] == 2 * 512);
+
+        ##64;
+    end
+
+    `TEST_CASE("same_bank") begin
+        // Both data interfaces on the same bank, in every cycle. The cores
+        // take turns, so neither waits more than a cycle, and the fetches
+        // of both cores (data has priority) complete in the gaps
+        check_wait = 1;
+
+        fork
+            data_traffic(0, 256, 1);
+            data_traffic(1, 256, 1);
+            instr_traffic(0, 64, 1);
+            instr_traffic(1, 64, 1);
+        join
+
+        check_wait = 0;
+
+        ##64;
+    end
+
+    `TEST_CASE("system") begin
+        logic [7:0][31:0] prev_stats;
+
+        // Both cores on the system bus, with wait states. The owner holds it
+        // until its ack, and the cores take turns
+        prev_stats = stats;
+
+        fork
+            sys_traffic(0, 256);
+            sys_traffic(1, 256);
+        join
+
+        assert(stats[2] - prev_stats[2] == 2 * 256);
+
+        ##64;
+    end
+end
+
+`WATCHDOG(1ms);
+
+// ============================================================
+// METHODS
+// ============================================================
+
+// Word in the memories: 0 Boot ROM, 1 Bank0, 2 Bank1
+function automatic logic [31:0] peek(int res, int word);
+    if (res == 0) return u_bootrom.MEM[word];
+    else if (res == 1) return u_mem0.MEM[word];
+    else return u_mem1.MEM[word];
+endfunction
+
+function automatic logic [23:0] res_addr(int res, int word);
+    return (word << 2) + res * 24'h10000;
+endfunction
+
+// Random data accesses of a core. Core0 writes words 0-255 of each bank,
+// core1 writes words 256-511. With `bank1`, all accesses go to Bank1
+task automatic data_traffic(input int c, input int n, input bit bank1 = 0);
+    int res, word;
+    logic write;
+    logic [3:0] mask;
+    logic [31:0] wdata, expected;
+
+    repeat (n) begin
+        res = bank1 ? 2 : $urandom_range(0, 2);
+        if (res == 0) word = $urandom_range(0, 255);
+        else word = c * 256 + $urandom_range(0, 255);
+
+        write = (res == 0) ? 0 : $urandom_range(0, 1);
+        wdata = $urandom;
+        mask = write ? $urandom : 4'hF;
+
+        expected = peek(res, word);
+        for (int i=0; i<4; i++)
+            if (write && mask[i]) expected[i*8 +: 8] = wdata[i*8 +: 8];
+
+        cb.d_hold[c] <= 1'b1;
+        cb.d_addr[c] <= res_addr(res, word);
+        cb.d_wr_en[c] <= write;
+        cb.d_wr_data[c] <= wdata;
+        cb.d_mask[c] <= mask;
+
+        do @(cb); while (~cb.d_ack[c]);
+        cb.d_hold[c] <= 1'b0;
+
+        if (write) begin
+            ##1;
+            assert(peek(res, word) == expected)
+                else $error("core%0d write %h: %h != %h", c, res_addr(res, word), peek(res, word), expected);
+        end
+        else begin
+            assert(cb.d_rd_data[c] == expected)
+                else $error("core%0d read %h: %h != %h", c, res_addr(res, word), cb.d_rd_data[c], expected);
+        end
+
+        // back-to-back, or a random gap
+        if ($urandom_range(0, 1)) ##($urandom_range(1, 3));
+    end
+endtask
+
+// Random fetches of a core, from the words that aren't written
+task automatic instr_traffic(input int c, input int n, input bit bank1 = 0);
+    int res, word;
+    logic [31:0] expected;
+
+    repeat (n) begin
+        res = bank1 ? 2 : $urandom_range(0, 2);
+        if (res == 0) word = $urandom_range(0, 255);
+        else word = $urandom_range(512, 1023);
+
+        expected = peek(res, word);
+
+        cb.i_hold[c] <= 1'b1;
+        cb.i_addr[c] <= res_addr(res, word);
+
+        do @(cb); while (~cb.i_ack[c]);
+        cb.i_hold[c] <= 1'b0;
+
+        assert(cb.i_data[c] == expected)
+            else $error("core%0d fetch %h: %h != %h", c, res_addr(res, word), cb.i_data[c], expected);
+    end
+endtask
+
+// Random system accesses of a core, in its half of a 1KB window
+task automatic sys_traffic(input int c, input int n);
+    logic [23:0] addr;
+    logic write;
+    logic [31:0] wdata;
+
+    repeat (n) begin
+        addr = 24'h800000 | (c << 9) | ($urandom_range(0, 127) << 2);
+        write = $urandom_range(0, 1);
+        wdata = $urandom;
+
+        cb.d_hold[c] <= 1'b1;
+        cb.d_addr[c] <= addr;
+        cb.d_wr_en[c] <= write;
+        cb.d_wr_data[c] <= wdata;
+        cb.d_mask[c] <= 4'hF;
+
+        do @(cb); while (~cb.d_ack[c]);
+        cb.d_hold[c] <= 1'b0;
+
+        if (write) begin
+            assert(perif_wr.exists(addr) && perif_wr[addr] == wdata)
+                else $error("core%0d system write %h lost", c, addr);
+        end
+        else begin
+            assert(cb.d_rd_data[c] == perif_data(addr))
+                else $error("core%0d system read %h: %h", c, addr, cb.d_rd_data[c]);
+        end
+    end
+endtask
+
+endmodule
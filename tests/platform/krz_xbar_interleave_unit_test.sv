@@ -0,0 +1,309 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+`include "vunit_defines.svh"
+
+module tb_krz_xbar_interleave_ut;
+
+// Word interleaved banks
+localparam INTERLEAVE = 2;
+
+logic clk;
+logic rstz;
+logic [23:0] instr_addr;
+logic [31:0] instr_data;
+logic instr_req;
+logic instr_ack;
+logic [23:0] data_addr;
+logic [31:0] data_rd_data;
+logic [31:0] data_wr_data;
+logic [3:0] data_mask;
+logic data_wr_en;
+logic data_req;
+logic data_ack;
+logic dma_ack;
+logic [23:0] bootrom_addr;
+logic [31:0] bootrom_rd_data;
+logic bootrom_en;
+logic [23:0] mem0_addr;
+logic [31:0] mem0_rd_data;
+logic [31:0] mem0_wr_data;
+logic mem0_en;
+logic mem0_wr_en;
+logic [3:0] mem0_mask;
+logic [23:0] mem1_addr;
+logic [31:0] mem1_rd_data;
+logic [31:0] mem1_wr_data;
+logic mem1_en;
+logic mem1_wr_en;
+logic [3:0] mem1_mask;
+logic [23:0] sys_adr_o;
+logic [31:0] sys_dat_i;
+logic [31:0] sys_dat_o;
+logic sys_stb_o;
+logic sys_we_o;
+logic [3:0] sys_sel_o;
+logic sys_ack_i;
+logic [7:0][31:0] stats;
+
+krz_xbar #(.MEM_INTERLEAVE(INTERLEAVE)) u_dut (
+    .clk            (clk            ),
+    .rstz           (rstz           ),
+    .instr_addr     (instr_addr     ),
+    .instr_data     (instr_data     ),
+    .instr_req      (instr_req      ),
+    .instr_ack      (instr_ack      ),
+    .data_addr      (data_addr      ),
+    .data_rd_data   (data_rd_data   ),
+    .data_wr_data   (data_wr_data   ),
+    .data_mask      (data_mask      ),
+    .data_wr_en     (data_wr_en     ),
+    .data_req       (data_req       ),
+    .data_ack       (data_ack       ),
+    .instr1_addr    (24'h0          ),
+    .instr1_data    (               ),
+    .instr1_req     (1'b0           ),
+    .instr1_ack     (               ),
+    .data1_addr     (24'h0          ),
+    .data1_rd_data  (               ),
+    .data1_wr_data  (32'h0          ),
+    .data1_mask     (4'h0           ),
+    .data1_wr_en    (1'b0           ),
+    .data1_req      (1'b0           ),
+    .data1_ack      (               ),
+    .dma_addr       (24'h0          ),
+    .dma_rd_data    (               ),
+    .dma_wr_data    (32'h0          ),
+    .dma_mask       (4'h0           ),
+    .dma_wr_en      (1'b0           ),
+    .dma_req        (1'b0           ),
+    .dma_ack        (dma_ack        ),
+    .bootrom_addr   (bootrom_addr   ),
+    .bootrom_rd_data(bootrom_rd_data),
+    .bootrom_en     (bootrom_en     ),
+    .mem0_addr      (mem0_addr      ),
+    .mem0_rd_data   (mem0_rd_data   ),
+    .mem0_wr_data   (mem0_wr_data   ),
+    .mem0_en        (mem0_en        ),
+    .mem0_wr_en     (mem0_wr_en     ),
+    .mem0_mask      (mem0_mask      ),
+    .mem1_addr      (mem1_addr      ),
+    .mem1_rd_data   (mem1_rd_data   ),
+    .mem1_wr_data   (mem1_wr_data   ),
+    .mem1_en        (mem1_en        ),
+    .mem1_wr_en     (mem1_wr_en     ),
+    .mem1_mask      (mem1_mask      ),
+    .sys_adr_o      (sys_adr_o      ),
+    .sys_dat_i      (sys_dat_i      ),
+    .sys_dat_o      (sys_dat_o      ),
+    .sys_we_o       (sys_we_o       ),
+    .sys_sel_o      (sys_sel_o      ),
+    .sys_stb_o      (sys_stb_o      ),
+    .sys_ack_i      (sys_ack_i      ),
+    .stats          (stats          )
+);
+
+spsram32_model #(.WORDS(256), .AWIDTH(24), .MASK_WR_ONLY(1)) u_bootrom (
+    .clk  (clk            ),
+    .addr (bootrom_addr   ),
+    .wdata(32'b0          ),
+    .rdata(bootrom_rd_data),
+    .en   (bootrom_en     ),
+    .wr_en(1'b0           ),
+    .mask (4'b0           )
+);
+
+spsram32_model #(.WORDS(1024), .AWIDTH(24), .MASK_WR_ONLY(1)) u_mem0 (
+    .clk  (clk         ),
+    .addr (mem0_addr   ),
+    .wdata(mem0_wr_data),
+    .rdata(mem0_rd_data),
+    .en   (mem0_en     ),
+    .wr_en(mem0_wr_en  ),
+    .mask (mem0_mask   )
+);
+
+spsram32_model #(.WORDS(1024), .AWIDTH(24), .MASK_WR_ONLY(1)) u_mem1 (
+    .clk  (clk         ),
+    .addr (mem1_addr   ),
+    .wdata(mem1_wr_data),
+    .rdata(mem1_rd_data),
+    .en   (mem1_en     ),
+    .wr_en(mem1_wr_en  ),
+    .mask (mem1_mask   )
+);
+
+default clocking cb @(posedge clk);
+    default input #10ps output #10ps;
+    input instr_ack, instr_data;
+    input data_ack, data_rd_data;
+    output instr_req, instr_addr;
+    output data_req, data_addr, data_wr_data, data_mask, data_wr_en;
+    output sys_ack_i, sys_dat_i;
+endclocking
+
+// ============================================================
+// The first 8KB of the RAM, in words, alternate between the banks
+// and fill 1K words of each
+
+function automatic logic [23:0] word_addr(int word);
+    return 24'h10000 + (word<<2);
+endfunction
+
+function automatic logic word_bank(int word);
+    return word[0];
+endfunction
+
+function automatic logic [31:0] read_word(int word);
+    if (word_bank(word)) return u_mem1.MEM[word>>1];
+    else return u_mem0.MEM[word>>1];
+endfunction
+
+// ============================================================
+
+`TEST_SUITE begin
+    `TEST_SUITE_SETUP begin
+        clk = 0;
+        rstz = 0;
+
+        instr_req = 0;
+        data_req = 0;
+        sys_ack_i = 0;
+
+        for(int i=0; i<256; i++)
+            u_bootrom.MEM[i] = $urandom;
+
+        for(int i=0; i<1024; i++) begin
+            u_mem0.MEM[i] = $urandom;
+            u_mem1.MEM[i] = $urandom;
+        end
+
+        fork
+            forever #1ns clk = ~clk;
+        join_none
+
+        ##4 rstz = 1;
+    end
+
+    `TEST_CASE("instr_read") begin
+        int word;
+        logic [31:0] check_data;
+
+        repeat (1024) begin
+            $display("\n-----------------------");
+
+            word = $urandom_range(0, 2047);
+            check_data = read_word(word);
+            $display("MEM%0d[%h]: %h", word_bank(word), word_addr(word), check_data);
+
+            @(cb);
+            cb.instr_req <= 1'b1;
+            cb.instr_addr <= word_addr(word);
+            @(cb);
+            cb.instr_req <= 1'b0;
+            $display("instr_data: %h", instr_data);
+            assert(instr_ack);
+            assert(instr_data == check_data);
+        end
+
+        ##64;
+    end
+
+    `TEST_CASE("data_readwrite") begin
+        int word;
+        logic write;
+        logic [31:0] check_data;
+        logic [31:0] write_data, written_data;
+        logic [3:0] mask;
+
+        repeat (1024) begin
+            $display("\n-----------------------");
+
+            word = $urandom_range(0, 2047);
+            write = $urandom_range(0,1);
+            write_data = $urandom();
+            mask = (write) ? $urandom() : '1;
+
+            written_data = read_word(word);
+            for (int i=0; i<4; i++)
+                if (mask[i]) written_data[i*8+:8] = write_data[i*8+:8];
+
+            @(cb);
+            cb.data_req <= 1'b1;
+            cb.data_addr <= word_addr(word);
+            cb.data_wr_en <= write;
+            cb.data_wr_data <= write_data;
+            cb.data_mask <= mask;
+
+            @(cb);
+            cb.data_req <= 1'b0;
+            assert(data_ack);
+
+            check_data = read_word(word);
+            $display("MEM%0d[%h]: %h", word_bank(word), word_addr(word), check_data);
+
+            if (write) begin
+                $display("written data: %h", written_data);
+                assert(written_data == check_data);
+            end
+            else begin
+                $display("data_rd_data: %h", data_rd_data);
+                assert(data_rd_data == check_data);
+            end
+        end
+
+        ##64;
+    end
+
+    `TEST_CASE("arbitrate") begin
+        int Iword, Dword;
+        logic [31:0] Iread_data, Dread_data;
+        logic [31:0] count;
+
+        repeat (1024) begin
+            $display("\n-----------------------");
+
+            Iword = $urandom_range(0, 2047);
+            Dword = $urandom_range(0, 2047);
+            Iread_data = read_word(Iword);
+            Dread_data = read_word(Dword);
+            count = stats[0];
+
+            @(cb);
+            cb.instr_req <= 1'b1;
+            cb.instr_addr <= word_addr(Iword);
+
+            cb.data_req <= 1'b1;
+            cb.data_addr <= word_addr(Dword);
+            cb.data_wr_en <= 1'b0;
+
+            @(cb)
+            cb.instr_req <= 1'b0;
+            cb.data_req <= 1'b0;
+
+            $display("I: MEM%0d, D: MEM%0d", word_bank(Iword), word_bank(Dword));
+
+            assert(data_ack);
+            assert(data_rd_data == Dread_data);
+
+            // Only the bank matters, not the 64KB half of the RAM
+            if (word_bank(Iword) != word_bank(Dword)) begin
+                $display("NO CONFLICT");
+                assert(instr_ack);
+                assert(instr_data == Iread_data);
+                assert(stats[0] == count);
+            end
+            else begin
+                $display("DATA WINS");
+                assert(~instr_ack);
+                assert(stats[0] == count + 1);
+            end
+        end
+
+        ##64;
+    end
+end
+
+`WATCHDOG(1ms);
+
+endmodule
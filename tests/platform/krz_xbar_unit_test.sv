@@ -18,6 +18,7 @@ logic [3:0] data_mask;
 logic data_wr_en;
 logic data_req;
 logic data_ack;
+logic dma_ack;
 logic [23:0] bootrom_addr;
 logic [31:0] bootrom_rd_data;
 logic bootrom_en;
@@ -40,6 +41,7 @@ logic sys_stb_o;
 logic sys_we_o;
 logic [3:0] sys_sel_o;
 logic sys_ack_i;
+logic [7:0][31:0] stats;
 
 krz_xbar u_dut (
     .clk            (clk            ),
@@ -55,6 +57,24 @@ krz_xbar u_dut (
     .data_wr_en     (data_wr_en     ),
     .data_req       (data_req       ),
     .data_ack       (data_ack       ),
+    .instr1_addr    (24'h0          ),
+    .instr1_data    (               ),
+    .instr1_req     (1'b0           ),
+    .instr1_ack     (               ),
+    .data1_addr     (24'h0          ),
+    .data1_rd_data  (               ),
+    .data1_wr_data  (32'h0          ),
+    .data1_mask     (4'h0           ),
+    .data1_wr_en    (1'b0           ),
+    .data1_req      (1'b0           ),
+    .data1_ack      (               ),
+    .dma_addr       (24'h0          ),
+    .dma_rd_data    (               ),
+    .dma_wr_data    (32'h0          ),
+    .dma_mask       (4'h0           ),
+    .dma_wr_en      (1'b0           ),
+    .dma_req        (1'b0           ),
+    .dma_ack        (dma_ack        ),
     .bootrom_addr   (bootrom_addr   ),
     .bootrom_rd_data(bootrom_rd_data),
     .bootrom_en     (bootrom_en     ),
@@ -76,7 +96,8 @@ krz_xbar u_dut (
     .sys_we_o       (sys_we_o       ),
     .sys_sel_o      (sys_sel_o      ),
     .sys_stb_o      (sys_stb_o      ),
-    .sys_ack_i      (sys_ack_i      )
+    .sys_ack_i      (sys_ack_i      ),
+    .stats          (stats          )
 );
 
 spsram32_model #(.WORDS(256), .AWIDTH(24), .MASK_WR_ONLY(1)) u_bootrom (
@@ -281,6 +302,7 @@ endclocking
 
         logic arb;
         logic [31:0] Iread_data, Dread_data, Dwritten_data, Dwr_check_data;
+        logic [7:0][31:0] prev_stats;
 
         repeat (1024) begin
             $display("\n-----------------------");
@@ -341,6 +363,8 @@ endclocking
             // ----------------------------------------------------
             // Drive both requests
 
+            prev_stats = stats;
+
             @(cb);
             cb.instr_req <= 1'b1;
             cb.instr_addr <= Iaddr;
@@ -385,6 +409,14 @@ endclocking
 
             if (!arb) $display("GOT I RD: %h", instr_data);
 
+            // Statistics
+            assert(stats[0] == prev_stats[0] + arb);
+            assert(stats[1] == prev_stats[1] + !arb);
+            assert(stats[2] == prev_stats[2] + 1);
+            for (int i=0; i<3; i++)
+                assert(stats[3+i] == prev_stats[3+i] + (Ichoice == i || Dchoice == i));
+            assert(stats[6] == prev_stats[6]);
+
             if (Dwrite) begin
                 $display("GOT D WR: %h", Dwr_check_data);
             end
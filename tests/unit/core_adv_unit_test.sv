@@ -29,10 +29,21 @@ logic data_wr_en;
 logic data_req;
 logic data_ack;
 
+logic [1:0] rvfi_valid;
+logic [1:0][63:0] rvfi_order;
+logic [1:0][31:0] rvfi_insn;
+logic [1:0] rvfi_trap;
+logic [1:0][31:0] rvfi_pc_rdata;
+logic [1:0][4:0] rvfi_rd_addr;
+logic [1:0][31:0] rvfi_rd_wdata;
+
 logic run;
+logic irq;
 
 kronos_core #(
-  .FAST_BRANCH   (1)
+  .FAST_BRANCH   (1),
+  .EN_FUSION     (1),
+  .EN_RVFI       (1)
 ) u_dut (
   .clk               (clk            ),
   .rstz              (rstz           ),
@@ -49,7 +60,20 @@ kronos_core #(
   .data_ack          (data_ack       ),
   .software_interrupt(1'b0           ),
   .timer_interrupt   (1'b0           ),
-  .external_interrupt(1'b0           )
+  .external_interrupt(irq            ),
+  .rvfi_valid        (rvfi_valid     ),
+  .rvfi_order        (rvfi_order     ),
+  .rvfi_insn         (rvfi_insn      ),
+  .rvfi_trap         (rvfi_trap      ),
+  .rvfi_pc_rdata     (rvfi_pc_rdata  ),
+  .rvfi_pc_wdata     (               ),
+  .rvfi_rd_addr      (rvfi_rd_addr   ),
+  .rvfi_rd_wdata     (rvfi_rd_wdata  ),
+  .rvfi_mem_addr     (               ),
+  .rvfi_mem_rmask    (               ),
+  .rvfi_mem_wmask    (               ),
+  .rvfi_mem_rdata    (               ),
+  .rvfi_mem_wdata    (               )
 );
 
 `define REG u_dut.u_if.u_rf.REG
@@ -90,6 +114,27 @@ always_ff @(posedge clk) begin
   data_ack <= data_req;
 end
 
+// Collect the retirement trace, both lanes in program order
+typedef struct {
+  logic [63:0] order;
+  logic [31:0] insn;
+  logic trap;
+  logic [31:0] pc_rdata;
+  logic [4:0] rd_addr;
+  logic [31:0] rd_wdata;
+} retired_t;
+
+retired_t trace [$];
+
+always @(posedge clk) begin
+  for (int i=0; i<2; i++) begin
+    if (rvfi_valid[i]) begin
+      trace.push_back('{rvfi_order[i], rvfi_insn[i], rvfi_trap[i], rvfi_pc_rdata[i],
+        rvfi_rd_addr[i], rvfi_rd_wdata[i]});
+    end
+  end
+end
+
 default clocking cb @(posedge clk);
   default input #10ps output #10ps;
   input instr_req, instr_addr, instr_ack;
@@ -104,6 +149,7 @@ endclocking
     rstz = 0;
 
     run = 0;
+    irq = 0;
 
     fork 
       forever #1ns clk = ~clk;
@@ -271,6 +317,282 @@ endclocking
 
     ##64;
   end
+
+  `TEST_CASE("fusion") begin
+    instr_t instr;
+    int index, addr;
+    int nfused;
+    logic [31:0] gdata;
+
+    // setup program with fusable pairs
+    u_mem.MEM[0]  = rv32_lui(x5, 32'h12345000);
+    u_mem.MEM[1]  = rv32_addi(x5, x5, 32'h678);
+    // negative lower immediate
+    u_mem.MEM[2]  = rv32_lui(x6, 32'hABCDF000);
+    u_mem.MEM[3]  = rv32_addi(x6, x6, -256);
+    // zero-extend lower half
+    u_mem.MEM[4]  = rv32_slli(x7, x5, 16);
+    u_mem.MEM[5]  = rv32_srli(x7, x7, 16);
+    // global load, from 960
+    u_mem.MEM[6]  = rv32_auipc(x8, 0);
+    u_mem.MEM[7]  = rv32_lw(x8, x8, 960-24);
+    // not a pair, different rd
+    u_mem.MEM[8]  = rv32_lui(x9, 32'h55555000);
+    u_mem.MEM[9]  = rv32_addi(x10, x9, 1);
+    // far call, to 800
+    u_mem.MEM[10] = rv32_auipc(x1, 0);
+    u_mem.MEM[11] = rv32_jalr(x1, x1, 800-40);
+
+    // store results, and j 944
+    u_mem.MEM[200] = rv32_sw(x0, x5, 964);
+    u_mem.MEM[201] = rv32_sw(x0, x6, 968);
+    u_mem.MEM[202] = rv32_sw(x0, x7, 972);
+    u_mem.MEM[203] = rv32_sw(x0, x8, 976);
+    u_mem.MEM[204] = rv32_sw(x0, x10, 980);
+    u_mem.MEM[205] = rv32_jal(x0, 944-820);
+
+    // while(1); at 944
+    u_mem.MEM[944>>2] = rv32_jal(x0, 0);
+
+    gdata = $urandom();
+    u_mem.MEM[960>>2] = gdata;
+
+    // Run
+    $display("\n\nEXEC\n\n");
+    nfused = 0;
+    fork 
+      begin
+        @(cb) cb.run <= 1;
+      end
+
+      forever @(cb) begin
+        if (u_dut.decode_vld && u_dut.decode_rdy && u_dut.decode.fused) nfused++;
+
+        if (instr_req && instr_ack) begin
+          addr = cb.instr_addr;
+          instr = u_mem.MEM[addr>>2];
+          $display("[%0d] ADDR=%0d, INSTR=%h", index, addr, instr);
+          index++;
+          if (addr == 944) begin
+            cb.run <= 0;
+            break;
+          end
+        end
+      end
+    join
+
+    // let the pipeline drain
+    ##16;
+    $display("\n\n");
+
+    //-------------------------------
+    // check
+    // The pairs in the straight-line code at boot are always fused. The
+    // later pairs are only fused if the lookahead isn't held up by data access.
+    $display("FUSED: %0d", nfused);
+    assert(nfused >= 2);
+
+    assert(u_mem.MEM[964>>2] == 32'h12345678);
+    assert(u_mem.MEM[968>>2] == 32'hABCDEF00);
+    assert(u_mem.MEM[972>>2] == 32'h00005678);
+    assert(u_mem.MEM[976>>2] == gdata);
+    assert(u_mem.MEM[980>>2] == 32'h55555001);
+    assert(`REG[x1] == 48);
+
+    // Both halves of the fused pairs are traced
+    foreach (trace[i]) begin
+      $display("[%0d] PC=%0d, INSN=%h, RD=x%0d:%h",
+        trace[i].order, trace[i].pc_rdata, trace[i].insn, trace[i].rd_addr, trace[i].rd_wdata);
+      assert(trace[i].order == i);
+    end
+
+    for (int i=0; i<12; i++) begin
+      assert(trace[i].pc_rdata == i*4);
+      assert(trace[i].insn == u_mem.MEM[i]);
+    end
+
+    assert(trace[0].rd_addr == x5 && trace[0].rd_wdata == 32'h12345000);
+    assert(trace[1].rd_addr == x5 && trace[1].rd_wdata == 32'h12345678);
+    assert(trace[2].rd_addr == x6 && trace[2].rd_wdata == 32'hABCDF000);
+    assert(trace[3].rd_addr == x6 && trace[3].rd_wdata == 32'hABCDEF00);
+    assert(trace[4].rd_addr == x7 && trace[4].rd_wdata == 32'h56780000);
+    assert(trace[5].rd_addr == x7 && trace[5].rd_wdata == 32'h00005678);
+    assert(trace[6].rd_addr == x8 && trace[6].rd_wdata == 24);
+    assert(trace[7].rd_addr == x8 && trace[7].rd_wdata == gdata);
+    assert(trace[10].rd_addr == x1 && trace[10].rd_wdata == 40);
+    assert(trace[11].rd_addr == x1 && trace[11].rd_wdata == 48);
+
+    ##64;
+  end
+
+  `TEST_CASE("fusion_trap") begin
+    instr_t instr;
+    int index, addr;
+    int nfused;
+
+    // trap handler at 900
+    u_mem.MEM[0]  = rv32_addi(x6, x0, 900);
+    u_mem.MEM[1]  = rv32_csrrw(x0, x6, MTVEC);
+    // far call to a misaligned target, 802. Not fused, the jalr traps
+    u_mem.MEM[2]  = rv32_auipc(x1, 0);
+    u_mem.MEM[3]  = rv32_jalr(x1, x1, 802-8);
+    u_mem.MEM[4]  = rv32_addi(x9, x0, 1);
+
+    // handler: mcause, mepc, and j 944
+    u_mem.MEM[900>>2] = rv32_csrrs(x2, x0, MCAUSE);
+    u_mem.MEM[904>>2] = rv32_csrrs(x3, x0, MEPC);
+    u_mem.MEM[908>>2] = rv32_jal(x0, 944-908);
+
+    // while(1); at 944
+    u_mem.MEM[944>>2] = rv32_jal(x0, 0);
+
+    for (int i=0; i<32; i++) `REG[i] = '0;
+
+    // Run
+    $display("\n\nEXEC\n\n");
+    nfused = 0;
+    fork
+      begin
+        @(cb) cb.run <= 1;
+      end
+
+      forever @(cb) begin
+        if (u_dut.decode_vld && u_dut.decode_rdy && u_dut.decode.fused) nfused++;
+
+        if (instr_req && instr_ack) begin
+          addr = cb.instr_addr;
+          instr = u_mem.MEM[addr>>2];
+          $display("[%0d] ADDR=%0d, INSTR=%h", index, addr, instr);
+          index++;
+          if (addr == 944) begin
+            cb.run <= 0;
+            break;
+          end
+        end
+      end
+    join
+
+    // let the pipeline drain
+    ##16;
+    $display("\n\n");
+
+    //-------------------------------
+    // check
+    foreach (trace[i]) begin
+      $display("[%0d] PC=%0d, INSN=%h, TRAP=%b, RD=x%0d:%h", trace[i].order,
+        trace[i].pc_rdata, trace[i].insn, trace[i].trap, trace[i].rd_addr, trace[i].rd_wdata);
+      assert(trace[i].order == i);
+    end
+
+    assert(nfused == 0);
+
+    // The auipc retires on its own, and the jalr traps without a write back
+    assert(trace[2].pc_rdata == 8 && ~trace[2].trap);
+    assert(trace[2].rd_addr == x1 && trace[2].rd_wdata == 8);
+    assert(trace[3].pc_rdata == 12 && trace[3].trap);
+    assert(trace[3].insn == u_mem.MEM[3]);
+
+    assert(`REG[x1] == 8);
+    assert(`REG[x2] == 0); // Instruction address misaligned
+    assert(`REG[x3] == 12);
+    assert(`REG[x9] == 0);
+
+    ##64;
+  end
+
+  `TEST_CASE("fusion_irq") begin
+    instr_t instr;
+    int index, addr;
+    int delay, nhandler;
+
+    // trap handler at 900
+    u_mem.MEM[0]  = rv32_addi(x6, x0, 900);
+    u_mem.MEM[1]  = rv32_csrrw(x0, x6, MTVEC);
+    // enable the external interrupt, mie.meie and mstatus.mie
+    u_mem.MEM[2]  = rv32_addi(x7, x0, 1);
+    u_mem.MEM[3]  = rv32_slli(x7, x7, 11);
+    u_mem.MEM[4]  = rv32_csrrw(x0, x7, MIE);
+    u_mem.MEM[5]  = rv32_csrrsi(x0, 8, MSTATUS);
+    // loop over fused pairs, at 24 and 32, until interrupted
+    u_mem.MEM[6]  = rv32_lui(x5, 32'h12345000);
+    u_mem.MEM[7]  = rv32_addi(x5, x5, 32'h678);
+    u_mem.MEM[8]  = rv32_slli(x8, x5, 16);
+    u_mem.MEM[9]  = rv32_srli(x8, x8, 16);
+    u_mem.MEM[10] = rv32_addi(x4, x4, 1);
+    u_mem.MEM[11] = rv32_jal(x0, 24-44);
+
+    // handler: mcause, mepc, and j 944
+    u_mem.MEM[900>>2] = rv32_csrrs(x2, x0, MCAUSE);
+    u_mem.MEM[904>>2] = rv32_csrrs(x3, x0, MEPC);
+    u_mem.MEM[908>>2] = rv32_jal(x0, 944-908);
+
+    // while(1); at 944
+    u_mem.MEM[944>>2] = rv32_jal(x0, 0);
+
+    for (int i=0; i<32; i++) `REG[i] = '0;
+
+    // The interrupt lands somewhere in the loop
+    delay = $urandom_range(32, 96);
+    $display("IRQ after %0d cycles", delay);
+
+    // Run
+    $display("\n\nEXEC\n\n");
+    fork
+      begin
+        @(cb) cb.run <= 1;
+        ##(delay);
+        irq = 1;
+      end
+
+      forever @(cb) begin
+        if (instr_req && instr_ack) begin
+          addr = cb.instr_addr;
+          instr = u_mem.MEM[addr>>2];
+          $display("[%0d] ADDR=%0d, INSTR=%h", index, addr, instr);
+          index++;
+          if (addr == 944) begin
+            cb.run <= 0;
+            break;
+          end
+        end
+      end
+    join
+
+    // let the pipeline drain
+    ##16;
+    irq = 0;
+    $display("\n\n");
+
+    //-------------------------------
+    // check
+    $display("MEPC=%0d, LOOPS=%0d", `REG[x3], `REG[x4]);
+    assert(`REG[x2] == 32'h8000000B); // Machine external interrupt
+
+    // The interrupt is taken in the loop, but never between the halves of a
+    // fused pair (28, 36)
+    assert(`REG[x3] inside {24, 32, 40, 44});
+
+    // Each pair has completed as a whole, or not started
+    assert(`REG[x5] inside {0, 32'h12345678});
+    assert(`REG[x8] inside {0, 32'h00005678});
+
+    // Retired in order, with both halves of a pair back to back
+    foreach (trace[i]) begin
+      assert(trace[i].order == i);
+      assert(~trace[i].trap);
+      if (trace[i].pc_rdata inside {24, 32}) begin
+        assert(i+1 < trace.size());
+        assert(trace[i+1].pc_rdata == trace[i].pc_rdata + 4);
+      end
+    end
+
+    // The handler runs once
+    nhandler = 0;
+    foreach (trace[i]) if (trace[i].pc_rdata == 900) nhandler++;
+    assert(nhandler == 1);
+
+    ##64;
+  end
 end
 
 `WATCHDOG(1ms);
@@ -0,0 +1,440 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+
+`include "vunit_defines.svh"
+
+module tb_core_dual_ut;
+
+/*
+Kronos with DUAL_ISSUE, and a 64b instruction interface
+
+For this test suite, the memory is limited to 4KB (1024 words)
+
+The results will be stored in the .data section starting at 960 (0x3C0, word 240)
+*/
+
+import kronos_types::*;
+import rv32_assembler::*;
+
+logic clk;
+logic rstz;
+logic [31:0] instr_addr;
+logic [63:0] instr_data;
+logic instr_req;
+logic instr_ack;
+logic [31:0] data_addr;
+logic [31:0] data_rd_data;
+logic [31:0] data_wr_data;
+logic [3:0] data_mask;
+logic data_wr_en;
+logic data_req;
+logic data_ack;
+
+logic run;
+
+kronos_core #(
+  .FAST_BRANCH   (1),
+  .DUAL_ISSUE    (1)
+) u_dut (
+  .clk               (clk            ),
+  .rstz              (rstz           ),
+  .instr_addr        (instr_addr     ),
+  .instr_data        (instr_data     ),
+  .instr_req         (instr_req      ),
+  .instr_ack         (instr_ack & run),
+  .data_addr         (data_addr      ),
+  .data_rd_data      (data_rd_data   ),
+  .data_wr_data      (data_wr_data   ),
+  .data_mask         (data_mask      ),
+  .data_wr_en        (data_wr_en     ),
+  .data_req          (data_req       ),
+  .data_ack          (data_ack       ),
+  .software_interrupt(1'b0           ),
+  .timer_interrupt   (1'b0           ),
+  .external_interrupt(1'b0           )
+);
+
+`define REG u_dut.u_if.u_rf.REG
+
+// Behavioral memory with a 64b instruction port and a 32b data port
+logic [31:0] MEM [1024];
+
+always_ff @(posedge clk) begin
+  instr_ack <= instr_req & run;
+  instr_data <= {MEM[(instr_addr>>2) | 1], MEM[instr_addr>>2]};
+
+  data_ack <= data_req;
+  if (data_req) begin
+    data_rd_data <= MEM[data_addr>>2];
+    if (data_wr_en) begin
+      for (int i=0; i<4; i++) begin
+        if (data_mask[i]) MEM[data_addr>>2][i*8+:8] <= data_wr_data[i*8+:8];
+      end
+    end
+  end
+end
+
+default clocking cb @(posedge clk);
+  default input #10ps output #10ps;
+  input instr_req, instr_addr, instr_ack;
+  output negedge run;
+endclocking
+
+// ============================================================
+
+`TEST_SUITE begin
+  `TEST_SUITE_SETUP begin
+    clk = 0;
+    rstz = 0;
+
+    run = 0;
+
+    for (int i=0; i<1024; i++) MEM[i] = '0;
+
+    fork 
+      forever #1ns clk = ~clk;
+    join_none
+
+    ##4 rstz = 1;
+  end
+
+  `TEST_CASE("doubler") begin
+    int index, addr;
+    int n;
+    int r_exp, r_got;
+
+    // setup program: doubler.c
+    $readmemh("../../../data/doubler.mem", MEM);
+
+    // ABI --------------------------------
+    // Setup Return Address (ra/x1)
+    `REG[x1] = 944;
+
+    // Store while(1); at 944
+    MEM[944>>2] = rv32_jal(x0, 0); // j 1b
+
+    // Setup Frame Pointer (s0/x8)
+    `REG[x8] = 0;
+
+    // Setup Stack Pointer (sp/x2) to the end of the memory (4KB), 0x1000
+    `REG[x2] = 4096;
+
+    // Setup Function Argument - "n" - at a0 (x10)
+    n = $urandom_range(1,31);
+    $display("\n\nARG: n = %0d", n);
+    `REG[x10] = n;
+
+    // Run
+    $display("\n\nEXEC\n\n");
+    fork 
+      begin
+        @(cb) cb.run <= 1;
+      end
+
+      forever @(cb) begin
+        if (instr_req && instr_ack) begin
+          addr = cb.instr_addr;
+          $display("[%0d] ADDR=%0d, INSTR=%h, %h", index, addr, MEM[addr>>2], MEM[(addr>>2)|1]);
+          index++;
+          if (addr == 944) begin
+            cb.run <= 0;
+            break;
+          end
+        end
+      end
+    join
+    $display("\n\n");
+
+    //-------------------------------
+    // check
+    r_exp = 2**n;
+    r_got = MEM[960>>2];
+    $display("RESULT: %d vs %d", r_exp, r_got);
+    assert(r_exp == r_got);
+
+    ##64;
+  end
+
+  `TEST_CASE("pairs") begin
+    int index, addr;
+    int npairs;
+    logic [31:0] gdata;
+
+    // independent pair
+    MEM[0]  = rv32_addi(x1, x0, 1);
+    MEM[1]  = rv32_addi(x2, x0, 2);
+    // depends on the previous pair
+    MEM[2]  = rv32_addi(x3, x1, 3);
+    MEM[3]  = rv32_add(x4, x2, x2);
+    // dependency within the pair, issued one at a time
+    MEM[4]  = rv32_add(x5, x3, x4);
+    MEM[5]  = rv32_add(x6, x5, x0);
+    // load + alu
+    MEM[6]  = rv32_lw(x7, x0, 960);
+    MEM[7]  = rv32_xori(x8, x1, -1);
+    // store + alu
+    MEM[8]  = rv32_sw(x0, x7, 964);
+    MEM[9]  = rv32_slli(x9, x2, 4);
+    // taken branch to 52, the second instruction is dropped
+    MEM[10] = rv32_beq(x0, x0, 12);
+    MEM[11] = rv32_addi(x10, x0, 55);
+    MEM[12] = rv32_addi(x10, x0, 66);
+    // branch target is the upper word of a block
+    MEM[13] = rv32_addi(x12, x0, 88);
+    // branch not taken
+    MEM[14] = rv32_bne(x0, x0, 12);
+    MEM[15] = rv32_addi(x11, x0, 77);
+    // j 944
+    MEM[16] = rv32_jal(x0, 944-64);
+
+    // while(1); at 944
+    MEM[944>>2] = rv32_jal(x0, 0);
+
+    gdata = $urandom();
+    MEM[960>>2] = gdata;
+
+    for (int i=0; i<32; i++) `REG[i] = '0;
+
+    // Run
+    $display("\n\nEXEC\n\n");
+    npairs = 0;
+    fork 
+      begin
+        @(cb) cb.run <= 1;
+      end
+
+      forever @(cb) begin
+        if (u_dut.decode_vld && u_dut.decode_rdy && u_dut.decode1_vld) npairs++;
+
+        if (instr_req && instr_ack) begin
+          addr = cb.instr_addr;
+          $display("[%0d] ADDR=%0d, INSTR=%h, %h", index, addr, MEM[addr>>2], MEM[(addr>>2)|1]);
+          index++;
+          if (addr == 944) begin
+            cb.run <= 0;
+            break;
+          end
+        end
+      end
+    join
+
+    // let the pipeline drain
+    ##16;
+    $display("\n\n");
+
+    //-------------------------------
+    // check
+    $display("PAIRS: %0d", npairs);
+    assert(npairs >= 4);
+
+    assert(`REG[x1] == 1);
+    assert(`REG[x2] == 2);
+    assert(`REG[x3] == 4);
+    assert(`REG[x4] == 4);
+    assert(`REG[x5] == 8);
+    assert(`REG[x6] == 8);
+    assert(`REG[x7] == gdata);
+    assert(`REG[x8] == 32'hFFFFFFFE);
+    assert(`REG[x9] == 32);
+    assert(`REG[x10] == 0);
+    assert(`REG[x11] == 77);
+    assert(`REG[x12] == 88);
+    assert(MEM[964>>2] == gdata);
+
+    ##64;
+  end
+
+  `TEST_CASE("odd_slot") begin
+    int index, addr;
+    logic [31:0] gdata;
+
+    // Unpaired instructions in the upper word of a block, which move up to the
+    // first lane. Each depends on the instruction before it
+    // sw, with an S immediate
+    MEM[0]  = rv32_addi(x1, x0, 960);
+    MEM[1]  = rv32_sw(x1, x1, 8);
+    // lw
+    MEM[2]  = rv32_addi(x2, x0, 4);
+    MEM[3]  = rv32_lw(x3, x2, 960);
+    // taken branch to 32, with a B immediate
+    MEM[4]  = rv32_addi(x4, x0, 5);
+    MEM[5]  = rv32_bne(x4, x0, 12);
+    MEM[6]  = rv32_addi(x10, x0, 55);
+    MEM[7]  = rv32_addi(x10, x0, 55);
+    // jal to 48, with a J immediate
+    MEM[8]  = rv32_addi(x5, x0, 64);
+    MEM[9]  = rv32_jal(x6, 12);
+    MEM[10] = rv32_addi(x10, x0, 66);
+    MEM[11] = rv32_addi(x10, x0, 66);
+    // jalr to 72
+    MEM[12] = rv32_addi(x7, x5, 0);
+    MEM[13] = rv32_jalr(x8, x7, 8);
+    MEM[14] = rv32_addi(x10, x0, 77);
+    MEM[15] = rv32_addi(x10, x0, 77);
+    MEM[16] = rv32_addi(x10, x0, 77);
+    MEM[17] = rv32_addi(x10, x0, 77);
+    // j 944
+    MEM[18] = rv32_jal(x0, 944-72);
+
+    // while(1); at 944
+    MEM[944>>2] = rv32_jal(x0, 0);
+
+    gdata = $urandom();
+    MEM[964>>2] = gdata;
+    MEM[968>>2] = '0;
+
+    for (int i=0; i<32; i++) `REG[i] = '0;
+
+    // Run
+    $display("\n\nEXEC\n\n");
+    fork 
+      begin
+        @(cb) cb.run <= 1;
+      end
+
+      forever @(cb) begin
+        if (instr_req && instr_ack) begin
+          addr = cb.instr_addr;
+          $display("[%0d] ADDR=%0d, INSTR=%h, %h", index, addr, MEM[addr>>2], MEM[(addr>>2)|1]);
+          index++;
+          if (addr == 944) begin
+            cb.run <= 0;
+            break;
+          end
+        end
+      end
+    join
+
+    // let the pipeline drain
+    ##16;
+    $display("\n\n");
+
+    //-------------------------------
+    // check
+    assert(MEM[968>>2] == 960);
+    assert(`REG[x3] == gdata);
+    assert(`REG[x4] == 5);
+    assert(`REG[x6] == 40);
+    assert(`REG[x7] == 64);
+    assert(`REG[x8] == 56);
+    assert(`REG[x10] == 0);
+
+    ##64;
+  end
+
+  `TEST_CASE("hazards") begin
+    int index, addr;
+    logic [31:0] gdata, gdata2;
+    int paired [$];
+
+    // Pairing in the second lane, and the hazards that split a pair
+    // WAW within the block, not paired
+    MEM[0]  = rv32_addi(x1, x0, 1);
+    MEM[1]  = rv32_addi(x1, x0, 2);
+    // RAW on rs2 within the block, not paired
+    MEM[2]  = rv32_addi(x2, x0, 5);
+    MEM[3]  = rv32_add(x3, x0, x2);
+    // independent, paired (16)
+    MEM[4]  = rv32_addi(x4, x0, 7);
+    MEM[5]  = rv32_addi(x5, x0, 9);
+    // both lanes use both write backs of the previous pair
+    MEM[6]  = rv32_add(x6, x5, x4);
+    MEM[7]  = rv32_sub(x7, x5, x4);
+    // the second lane uses the load of the first, not paired (32)
+    MEM[8]  = rv32_lw(x8, x0, 960);
+    MEM[9]  = rv32_addi(x9, x8, 1);
+    // load + alu, paired (40)
+    MEM[10] = rv32_lw(x10, x0, 964);
+    MEM[11] = rv32_addi(x11, x0, 3);
+    // the second lane waits for the load in flight
+    MEM[12] = rv32_addi(x12, x0, 1);
+    MEM[13] = rv32_add(x13, x10, x11);
+    // the second lane writes x0, paired (56)
+    MEM[14] = rv32_addi(x14, x0, 960);
+    MEM[15] = rv32_addi(x0, x0, 5);
+    // a store in the second lane, not paired (64)
+    MEM[16] = rv32_addi(x15, x0, 123);
+    MEM[17] = rv32_sw(x14, x15, 12);
+    // a jump in the first lane, not paired (72), the second is skipped
+    MEM[18] = rv32_jal(x16, 8);
+    MEM[19] = rv32_addi(x17, x0, 1);
+    // RAW on rs2 of an R-type, not paired (80)
+    MEM[20] = rv32_addi(x18, x0, -1);
+    MEM[21] = rv32_sltu(x19, x0, x18);
+    // j 944
+    MEM[22] = rv32_jal(x0, 944-88);
+
+    // while(1); at 944
+    MEM[944>>2] = rv32_jal(x0, 0);
+
+    gdata = $urandom();
+    gdata2 = $urandom();
+    MEM[960>>2] = gdata;
+    MEM[964>>2] = gdata2;
+    MEM[972>>2] = '0;
+
+    for (int i=0; i<32; i++) `REG[i] = '0;
+
+    // Run
+    $display("\n\nEXEC\n\n");
+    fork
+      begin
+        @(cb) cb.run <= 1;
+      end
+
+      forever @(cb) begin
+        if (u_dut.decode_vld && u_dut.decode_rdy && u_dut.decode1_vld) begin
+          $display("PAIR at %0d", u_dut.decode.pc);
+          paired.push_back(u_dut.decode.pc);
+        end
+
+        if (instr_req && instr_ack) begin
+          addr = cb.instr_addr;
+          $display("[%0d] ADDR=%0d, INSTR=%h, %h", index, addr, MEM[addr>>2], MEM[(addr>>2)|1]);
+          index++;
+          if (addr == 944) begin
+            cb.run <= 0;
+            break;
+          end
+        end
+      end
+    join
+
+    // let the pipeline drain
+    ##16;
+    $display("\n\n");
+
+    //-------------------------------
+    // check
+    assert(`REG[x1] == 2);
+    assert(`REG[x3] == 5);
+    assert(`REG[x6] == 16);
+    assert(`REG[x7] == 2);
+    assert(`REG[x9] == gdata + 1);
+    assert(`REG[x10] == gdata2);
+    assert(`REG[x12] == 1);
+    assert(`REG[x13] == gdata2 + 3);
+    assert(`REG[x0] == 0);
+    assert(MEM[972>>2] == 123);
+    assert(`REG[x16] == 76);
+    assert(`REG[x17] == 0);
+    assert(`REG[x19] == 1);
+
+    // The pairs that were issued, and the ones that were split
+    assert(16 inside {paired});
+    assert(40 inside {paired});
+    assert(56 inside {paired});
+    foreach (paired[i]) begin
+      assert(!(paired[i] inside {0, 8, 32, 64, 72, 80}))
+        else $error("split pair issued at %0d", paired[i]);
+    end
+
+    ##64;
+  end
+end
+
+`WATCHDOG(1ms);
+
+
+endmodule
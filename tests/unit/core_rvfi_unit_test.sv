@@ -0,0 +1,350 @@
+// Copyright (c) 2020 Sonal Pinto
+// SPDX-License-Identifier: Apache-2.0
+
+
+`include "vunit_defines.svh"
+
+module tb_core_rvfi_ut;
+
+/*
+Kronos with EN_RVFI
+
+For this test suite, the memory is limited to 4KB (1024 words)
+
+The retirement trace is collected and checked against the program
+*/
+
+import kronos_types::*;
+import rv32_assembler::*;
+
+logic clk;
+logic rstz;
+logic [31:0] instr_addr;
+logic [31:0] instr_data;
+logic instr_req;
+logic instr_ack;
+logic [31:0] data_addr;
+logic [31:0] data_rd_data;
+logic [31:0] data_wr_data;
+logic [3:0] data_mask;
+logic data_wr_en;
+logic data_req;
+logic data_ack;
+
+logic rvfi_valid;
+logic [63:0] rvfi_order;
+logic [31:0] rvfi_insn;
+logic rvfi_trap;
+logic [31:0] rvfi_pc_rdata;
+logic [31:0] rvfi_pc_wdata;
+logic [4:0] rvfi_rd_addr;
+logic [31:0] rvfi_rd_wdata;
+logic [31:0] rvfi_mem_addr;
+logic [3:0] rvfi_mem_rmask;
+logic [3:0] rvfi_mem_wmask;
+logic [31:0] rvfi_mem_rdata;
+logic [31:0] rvfi_mem_wdata;
+
+logic run;
+
+kronos_core #(
+  .FAST_BRANCH       (1),
+  .EN_MISALIGNED_LDST(1),
+  .EN_RVFI           (1)
+) u_dut (
+  .clk               (clk            ),
+  .rstz              (rstz           ),
+  .instr_addr        (instr_addr     ),
+  .instr_data        (instr_data     ),
+  .instr_req         (instr_req      ),
+  .instr_ack         (instr_ack & run),
+  .data_addr         (data_addr      ),
+  .data_rd_data      (data_rd_data   ),
+  .data_wr_data      (data_wr_data   ),
+  .data_mask         (data_mask      ),
+  .data_wr_en        (data_wr_en     ),
+  .data_req          (data_req       ),
+  .data_ack          (data_ack       ),
+  .software_interrupt(1'b0           ),
+  .timer_interrupt   (1'b0           ),
+  .external_interrupt(1'b0           ),
+  .rvfi_valid        (rvfi_valid     ),
+  .rvfi_order        (rvfi_order     ),
+  .rvfi_insn         (rvfi_insn      ),
+  .rvfi_trap         (rvfi_trap      ),
+  .rvfi_pc_rdata     (rvfi_pc_rdata  ),
+  .rvfi_pc_wdata     (rvfi_pc_wdata  ),
+  .rvfi_rd_addr      (rvfi_rd_addr   ),
+  .rvfi_rd_wdata     (rvfi_rd_wdata  ),
+  .rvfi_mem_addr     (rvfi_mem_addr  ),
+  .rvfi_mem_rmask    (rvfi_mem_rmask ),
+  .rvfi_mem_wmask    (rvfi_mem_wmask ),
+  .rvfi_mem_rdata    (rvfi_mem_rdata ),
+  .rvfi_mem_wdata    (rvfi_mem_wdata )
+);
+
+`define REG u_dut.u_if.u_rf.REG
+
+logic [31:0] mem_addr;
+logic [31:0] mem_wdata;
+logic [31:0] mem_rdata;
+logic mem_en, mem_wren;
+logic [3:0] mem_mask;
+
+spsram32_model #(.WORDS(1024)) u_mem (
+  .clk  (~clk     ),
+  .addr (mem_addr ),
+  .wdata(mem_wdata),
+  .rdata(mem_rdata),
+  .en   (mem_en   ),
+  .wr_en(mem_wren ),
+  .mask (mem_mask )
+);
+
+// Data has Priority
+always_comb begin
+  mem_en = instr_req || data_req;
+  mem_wren = data_wr_en;
+
+  mem_addr = 0;
+  mem_addr = data_req ? data_addr : instr_addr;
+
+  instr_data = mem_rdata;
+  data_rd_data = mem_rdata;
+
+  mem_wdata = data_wr_data;
+  mem_mask = data_req ? data_mask : 4'hF;
+end
+
+always_ff @(posedge clk) begin
+  instr_ack <= instr_req & ~data_req & run;
+  data_ack <= data_req;
+end
+
+// Collect the retirement trace
+typedef struct {
+  logic [63:0] order;
+  logic [31:0] insn;
+  logic trap;
+  logic [31:0] pc_rdata;
+  logic [31:0] pc_wdata;
+  logic [4:0] rd_addr;
+  logic [31:0] rd_wdata;
+  logic [31:0] mem_addr;
+  logic [3:0] mem_rmask;
+  logic [3:0] mem_wmask;
+  logic [31:0] mem_rdata;
+  logic [31:0] mem_wdata;
+} retired_t;
+
+retired_t trace [$];
+
+always @(posedge clk) begin
+  if (rvfi_valid) begin
+    trace.push_back('{
+      rvfi_order, rvfi_insn, rvfi_trap, rvfi_pc_rdata, rvfi_pc_wdata,
+      rvfi_rd_addr, rvfi_rd_wdata, rvfi_mem_addr, rvfi_mem_rmask,
+      rvfi_mem_wmask, rvfi_mem_rdata, rvfi_mem_wdata
+    });
+  end
+end
+
+default clocking cb @(posedge clk);
+  default input #10ps output #10ps;
+  input instr_req, instr_addr, instr_ack;
+  output negedge run;
+endclocking
+
+// ============================================================
+
+`TEST_SUITE begin
+  `TEST_SUITE_SETUP begin
+    clk = 0;
+    rstz = 0;
+
+    run = 0;
+
+    fork
+      forever #1ns clk = ~clk;
+    join_none
+
+    ##4 rstz = 1;
+  end
+
+  `TEST_CASE("trace") begin
+    instr_t instr;
+    int index, addr;
+    retired_t r;
+
+    u_mem.MEM[0]  = rv32_addi(x1, x0, 5);
+    u_mem.MEM[1]  = rv32_addi(x2, x1, 3);
+    u_mem.MEM[2]  = rv32_sw(x0, x2, 960);
+    u_mem.MEM[3]  = rv32_lw(x3, x0, 960);
+    // jump to 24, skipping 20
+    u_mem.MEM[4]  = rv32_jal(x4, 8);
+    u_mem.MEM[5]  = rv32_addi(x5, x0, 1);
+    // branch taken to 32, skipping 28
+    u_mem.MEM[6]  = rv32_bne(x3, x0, 8);
+    u_mem.MEM[7]  = rv32_addi(x5, x0, 2);
+    // trap handler at 944
+    u_mem.MEM[8]  = rv32_addi(x6, x0, 944);
+    u_mem.MEM[9]  = rv32_csrrw(x0, x6, MTVEC);
+    // illegal instruction
+    u_mem.MEM[10] = '0;
+
+    // while(1); at 944
+    u_mem.MEM[944>>2] = rv32_jal(x0, 0);
+
+    for (int i=0; i<32; i++) `REG[i] = '0;
+
+    // Run
+    $display("\n\nEXEC\n\n");
+    fork
+      begin
+        @(cb) cb.run <= 1;
+      end
+
+      forever @(cb) begin
+        if (instr_req && instr_ack) begin
+          addr = cb.instr_addr;
+          instr = u_mem.MEM[addr>>2];
+          $display("[%0d] ADDR=%0d, INSTR=%h", index, addr, instr);
+          index++;
+          if (addr == 944) begin
+            cb.run <= 0;
+            break;
+          end
+        end
+      end
+    join
+
+    // let the pipeline drain
+    ##16;
+    $display("\n\n");
+
+    //-------------------------------
+    // check
+    foreach (trace[i]) begin
+      r = trace[i];
+      $display("[%0d] PC=%0d, INSN=%h, TRAP=%b, RD=x%0d:%0d, NEXT=%0d",
+        r.order, r.pc_rdata, r.insn, r.trap, r.rd_addr, r.rd_wdata, r.pc_wdata);
+    end
+
+    assert(trace.size() >= 9);
+
+    foreach (trace[i]) assert(trace[i].order == i);
+
+    // pc, next pc
+    assert(trace[0].pc_rdata == 0  && trace[0].pc_wdata == 4);
+    assert(trace[1].pc_rdata == 4  && trace[1].pc_wdata == 8);
+    assert(trace[2].pc_rdata == 8  && trace[2].pc_wdata == 12);
+    assert(trace[3].pc_rdata == 12 && trace[3].pc_wdata == 16);
+    assert(trace[4].pc_rdata == 16 && trace[4].pc_wdata == 24);
+    assert(trace[5].pc_rdata == 24 && trace[5].pc_wdata == 32);
+    assert(trace[6].pc_rdata == 32 && trace[6].pc_wdata == 36);
+    assert(trace[7].pc_rdata == 36 && trace[7].pc_wdata == 40);
+    assert(trace[8].pc_rdata == 40 && trace[8].pc_wdata == 944);
+
+    // register writes
+    assert(trace[0].rd_addr == x1 && trace[0].rd_wdata == 5);
+    assert(trace[1].rd_addr == x2 && trace[1].rd_wdata == 8);
+    assert(trace[2].rd_addr == x0);
+    assert(trace[3].rd_addr == x3 && trace[3].rd_wdata == 8);
+    assert(trace[4].rd_addr == x4 && trace[4].rd_wdata == 20);
+    assert(trace[5].rd_addr == x0);
+    assert(trace[6].rd_addr == x6 && trace[6].rd_wdata == 944);
+
+    // memory access
+    assert(trace[2].mem_addr == 960 && trace[2].mem_wmask == 4'hF && trace[2].mem_rmask == 4'h0);
+    assert(trace[2].mem_wdata == 8);
+    assert(trace[3].mem_addr == 960 && trace[3].mem_rmask == 4'hF && trace[3].mem_wmask == 4'h0);
+    assert(trace[3].mem_rdata == 8);
+    assert(trace[4].mem_rmask == 4'h0 && trace[4].mem_wmask == 4'h0);
+
+    // trap
+    assert(trace[8].insn == '0 && trace[8].trap);
+    for (int i=0; i<8; i++) assert(~trace[i].trap);
+
+    ##64;
+  end
+
+  `TEST_CASE("split_ecall") begin
+    instr_t instr;
+    int index, addr;
+    retired_t r;
+
+    // trap handler at 944
+    u_mem.MEM[0]  = rv32_addi(x6, x0, 944);
+    u_mem.MEM[1]  = rv32_csrrw(x0, x6, MTVEC);
+    // misaligned load, split over 960 and 964
+    u_mem.MEM[2]  = rv32_lw(x1, x0, 962);
+    // misaligned store, split over 964 and 968
+    u_mem.MEM[3]  = rv32_sh(x0, x1, 967);
+    u_mem.MEM[4]  = rv32_ecall();
+
+    // while(1); at 944
+    u_mem.MEM[944>>2] = rv32_jal(x0, 0);
+
+    u_mem.MEM[960>>2] = 32'h44332211;
+    u_mem.MEM[964>>2] = 32'h88776655;
+    u_mem.MEM[968>>2] = 32'hCCBBAA99;
+
+    for (int i=0; i<32; i++) `REG[i] = '0;
+
+    // Run
+    $display("\n\nEXEC\n\n");
+    fork
+      begin
+        @(cb) cb.run <= 1;
+      end
+
+      forever @(cb) begin
+        if (instr_req && instr_ack) begin
+          addr = cb.instr_addr;
+          instr = u_mem.MEM[addr>>2];
+          $display("[%0d] ADDR=%0d, INSTR=%h", index, addr, instr);
+          index++;
+          if (addr == 944) begin
+            cb.run <= 0;
+            break;
+          end
+        end
+      end
+    join
+
+    // let the pipeline drain
+    ##16;
+    $display("\n\n");
+
+    //-------------------------------
+    // check
+    foreach (trace[i]) begin
+      r = trace[i];
+      $display("[%0d] PC=%0d, INSN=%h, TRAP=%b, MEM=%0d:%b:%h:%b:%h",
+        r.order, r.pc_rdata, r.insn, r.trap, r.mem_addr, r.mem_rmask, r.mem_rdata, r.mem_wmask, r.mem_wdata);
+    end
+
+    assert(trace.size() >= 5);
+
+    // The split accesses are reported by their first word
+    assert(trace[2].rd_addr == x1 && trace[2].rd_wdata == 32'h66554433);
+    assert(trace[2].mem_addr == 960 && trace[2].mem_rmask == 4'hC);
+    assert(trace[2].mem_rdata == 32'h44332211);
+
+    assert(trace[3].mem_addr == 964 && trace[3].mem_wmask == 4'h8);
+    assert(trace[3].mem_wdata[31:24] == 8'h33);
+    assert(u_mem.MEM[964>>2] == 32'h33776655);
+    assert(u_mem.MEM[968>>2] == 32'hCCBBAA44);
+
+    // ecall
+    assert(trace[4].insn == rv32_ecall() && trace[4].trap && trace[4].pc_wdata == 944);
+    for (int i=0; i<4; i++) assert(~trace[i].trap);
+
+    ##64;
+  end
+end
+
+`WATCHDOG(1ms);
+
+
+endmodule
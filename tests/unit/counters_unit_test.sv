@@ -30,7 +30,9 @@ logic software_interrupt;
 logic timer_interrupt;
 logic external_interrupt;
 
-kronos_EX u_ex (
+kronos_EX #(
+  .NUM_HPMCOUNTERS(2)
+) u_ex (
   .clk               (clk               ),
   .rstz              (rstz              ),
   .decode            (decode            ),
@@ -50,7 +52,15 @@ kronos_EX u_ex (
   .data_ack          (data_ack          ),
   .software_interrupt(1'b0              ),
   .timer_interrupt   (1'b0              ),
-  .external_interrupt(1'b0              )
+  .external_interrupt(1'b0              ),
+  .hpm_fetch_miss    (1'b0              ),
+  .hpm_fetch_stall   (1'b0              ),
+  .hpm_hazard_stall  (1'b0              ),
+  .decode1           ('0                ),
+  .decode1_vld       (1'b0              ),
+  .regwr1_data       (                  ),
+  .regwr1_sel        (                  ),
+  .regwr1_en         (                  )
 );
 
 // gray box probes
@@ -313,6 +323,48 @@ endclocking
     join
     ##64;
   end
+
+  `TEST_CASE("mhpmcounter") begin
+    logic [31:0] rdata, count;
+
+    // count CSR instructions on mhpmcounter3
+    csr_exec(rv32_csrrwi(0, HPM_CSR, MHPMEVENT3), rdata);
+    csr_exec(rv32_csrrs(1, 0, MHPMEVENT3), rdata);
+    assert(rdata == HPM_CSR);
+
+    // the read happens before the instruction retires
+    for (int i=1; i<16; i++) begin
+      csr_exec(rv32_csrrs(1, 0, MHPMCOUNTER3), rdata);
+      $display("MHPMCOUNTER3: %0d", rdata);
+      assert(rdata == i);
+    end
+
+    // mhpmcounter4 is not setup, and doesn't count
+    csr_exec(rv32_csrrs(1, 0, MHPMCOUNTER3+1), rdata);
+    assert(rdata == 0);
+
+    // inhibit mhpmcounter3 and mcycle
+    csr_exec(rv32_csrrwi(0, 5'b01001, MCOUNTINHIBIT), rdata);
+    csr_exec(rv32_csrrs(1, 0, MCOUNTINHIBIT), rdata);
+    assert(rdata == 32'b01001);
+
+    csr_exec(rv32_csrrs(1, 0, MCYCLE), count);
+    ##($urandom_range(1,32));
+    csr_exec(rv32_csrrs(1, 0, MCYCLE), rdata);
+    assert(rdata == count);
+
+    csr_exec(rv32_csrrs(1, 0, MHPMCOUNTER3), count);
+    csr_exec(rv32_csrrs(1, 0, MHPMCOUNTER3), rdata);
+    assert(rdata == count);
+
+    // resume
+    csr_exec(rv32_csrrwi(0, 0, MCOUNTINHIBIT), rdata);
+    csr_exec(rv32_csrrs(1, 0, MCYCLE), count);
+    csr_exec(rv32_csrrs(1, 0, MCYCLE), rdata);
+    assert(rdata > count);
+
+    ##64;
+  end
 end
 
 `WATCHDOG(1ms);
@@ -321,6 +373,22 @@ end
 // METHODS
 // ============================================================
 
+task automatic csr_exec(input logic [31:0] ir, output logic [31:0] rdata);
+  pipeIDEX_t tdecode;
+
+  tdecode = '0;
+  tdecode.csr = 1;
+  tdecode.ir = ir;
+
+  @(cb);
+  cb.decode <= tdecode;
+  cb.decode_vld <= 1;
+
+  @(cb iff cb.decode_rdy);
+  cb.decode_vld <= 0;
+  rdata = csr_rd_data;
+endtask
+
 task automatic rand_csr(logic [11:0] csr, output pipeIDEX_t decode, output string optype);
   logic [4:0] rs1, rd;
   logic [4:0] zimm;
@@ -50,7 +50,15 @@ kronos_EX u_ex (
   .data_ack          (data_ack          ),
   .software_interrupt(1'b0              ),
   .timer_interrupt   (1'b0              ),
-  .external_interrupt(1'b0              )
+  .external_interrupt(1'b0              ),
+  .hpm_fetch_miss    (1'b0              ),
+  .hpm_fetch_stall   (1'b0              ),
+  .hpm_hazard_stall  (1'b0              ),
+  .decode1           ('0                ),
+  .decode1_vld       (1'b0              ),
+  .regwr1_data       (                  ),
+  .regwr1_sel        (                  ),
+  .regwr1_en         (                  )
 );
 
 // gray box probes
@@ -41,42 +41,77 @@ logic [31:0] branch_target;
 logic branch;
 
 kronos_RF u_rf (
-  .clk         (clk         ),
-  .rstz        (rstz        ),
-  .instr_data  (instr_data  ),
-  .instr_vld   (instr_vld   ),
-  .fetch_rdy   (fetch_rdy   ),
-  .immediate   (immediate   ),
-  .regrd_rs1   (regrd_rs1   ),
-  .regrd_rs2   (regrd_rs2   ),
-  .regrd_rs1_en(regrd_rs1_en),
-  .regrd_rs2_en(regrd_rs2_en),
-  .regwr_data  (regwr_data  ),
-  .regwr_sel   (regwr_sel   ),
-  .regwr_en    (regwr_en    )
+  .clk          (clk         ),
+  .rstz         (rstz        ),
+  .instr_data   (instr_data  ),
+  .instr_vld    (instr_vld   ),
+  .fetch_rdy    (fetch_rdy   ),
+  .immediate    (immediate   ),
+  .regrd_rs1    (regrd_rs1   ),
+  .regrd_rs2    (regrd_rs2   ),
+  .regrd_rs1_en (regrd_rs1_en),
+  .regrd_rs2_en (regrd_rs2_en),
+  .regwr_data   (regwr_data  ),
+  .regwr_sel    (regwr_sel   ),
+  .regwr_en     (regwr_en    ),
+  .instr1_data  ('0          ),
+  .instr1_vld   (1'b0        ),
+  .fetch_shift  (1'b0        ),
+  .immediate1   (            ),
+  .regrd1_rs1   (            ),
+  .regrd1_rs2   (            ),
+  .regrd1_rs1_en(            ),
+  .regrd1_rs2_en(            ),
+  .regwr1_data  ('0          ),
+  .regwr1_sel   ('0          ),
+  .regwr1_en    (1'b0        )
 );
 
-kronos_ID u_id (
-  .clk         (clk         ),
-  .rstz        (rstz        ),
-  .flush       (flush       ),
-  .fetch       (fetch       ),
-  .immediate   (immediate   ),
-  .regrd_rs1   (regrd_rs1   ),
-  .regrd_rs2   (regrd_rs2   ),
-  .regrd_rs1_en(regrd_rs1_en),
-  .regrd_rs2_en(regrd_rs2_en),
-  .fetch_vld   (fetch_vld   ),
-  .fetch_rdy   (fetch_rdy   ),
-  .decode      (decode      ),
-  .decode_vld  (decode_vld  ),
-  .decode_rdy  (decode_rdy  ),
-  .regwr_data  (regwr_data  ),
-  .regwr_sel   (regwr_sel   ),
-  .regwr_en    (regwr_en    )
+kronos_ID #(
+  .EN_ZBA(1),
+  .EN_ZBB(1),
+  .EN_ZBS(1)
+) u_id (
+  .clk             (clk         ),
+  .rstz            (rstz        ),
+  .flush           (flush       ),
+  .fetch           (fetch       ),
+  .immediate       (immediate   ),
+  .regrd_rs1       (regrd_rs1   ),
+  .regrd_rs2       (regrd_rs2   ),
+  .regrd_rs1_en    (regrd_rs1_en),
+  .regrd_rs2_en    (regrd_rs2_en),
+  .fetch_vld       (fetch_vld   ),
+  .fetch_rdy       (fetch_rdy   ),
+  .lookahead       ('0          ),
+  .lookahead_vld   (1'b0        ),
+  .fuse            (            ),
+  .decode          (decode      ),
+  .decode_vld      (decode_vld  ),
+  .decode_rdy      (decode_rdy  ),
+  .regwr_data      (regwr_data  ),
+  .regwr_sel       (regwr_sel   ),
+  .regwr_en        (regwr_en    ),
+  .fetch1          ('0          ),
+  .immediate1      ('0          ),
+  .regrd1_rs1      ('0          ),
+  .regrd1_rs2      ('0          ),
+  .regrd1_rs1_en   (1'b0        ),
+  .regrd1_rs2_en   (1'b0        ),
+  .fetch1_vld      (1'b0        ),
+  .fetch1_rdy      (            ),
+  .decode1         (            ),
+  .decode1_vld     (            ),
+  .regwr1_data     ('0          ),
+  .regwr1_sel      ('0          ),
+  .regwr1_en       (1'b0        ),
+  .hpm_hazard_stall(            )
 );
 
-kronos_EX u_ex (
+kronos_EX #(
+  .EN_ZBB(1),
+  .EN_ZBS(1)
+) u_ex (
   .clk               (clk               ),
   .rstz              (rstz              ),
   .decode            (decode            ),
@@ -96,7 +131,15 @@ kronos_EX u_ex (
   .data_ack          (data_ack          ),
   .software_interrupt(1'b0              ),
   .timer_interrupt   (1'b0              ),
-  .external_interrupt(1'b0              )
+  .external_interrupt(1'b0              ),
+  .hpm_fetch_miss    (1'b0              ),
+  .hpm_fetch_stall   (1'b0              ),
+  .hpm_hazard_stall  (1'b0              ),
+  .decode1           ('0                ),
+  .decode1_vld       (1'b0              ),
+  .regwr1_data       (                  ),
+  .regwr1_sel        (                  ),
+  .regwr1_en         (                  )
 );
 
 default clocking cb @(posedge clk);
@@ -218,6 +261,58 @@ struct packed {
 
     ##64;
   end
+
+  `TEST_CASE("bitmanip") begin
+    pipeIFID_t tinstr;
+    string optype;
+
+    repeat (1024) begin
+
+      rand_bitmanip(tinstr, optype);
+
+      $display("OPTYPE=%s", optype);
+      $display("IFID: PC=%h, IR=%h", tinstr.pc, tinstr.ir);
+      $display("Expected: ");
+      $display("  regwr_data: %h", expected_wb.regwr_data);
+      $display("  regwr_sel: %h", expected_wb.regwr_sel);
+
+      @(cb);
+      cb.instr_data <= tinstr.ir;
+      cb.instr_vld <= 1;
+      @(cb);
+      cb.fetch <= tinstr;
+      cb.fetch_vld <= 1;
+      cb.instr_vld <= 0;
+      @(cb iff cb.fetch_rdy) cb.fetch_vld <= 0;
+
+      // Wait until EX stage is done, and collect outputs
+      got_wb = '0;
+      repeat (8) begin
+        @(cb) begin
+          if (cb.regwr_en) begin
+            got_wb.regwr_en = 1;
+            got_wb.regwr_data = cb.regwr_data;
+            got_wb.regwr_sel = cb.regwr_sel;
+          end
+        end
+      end
+
+      $display("Got: ");
+      $display("  regwr_data: %h", got_wb.regwr_data);
+      $display("  regwr_sel: %h", got_wb.regwr_sel);
+
+      assert(got_wb.regwr_en && ~got_wb.branch);
+      assert(expected_wb.regwr_data == got_wb.regwr_data);
+      assert(expected_wb.regwr_sel == got_wb.regwr_sel);
+
+      // Update test's REG as required
+      if (got_wb.regwr_en) REG[got_wb.regwr_sel] = got_wb.regwr_data;
+
+      $display("-----------------\n\n");
+    end
+
+    ##64;
+  end
 end
 `WATCHDOG(1ms);
 
@@ -468,4 +563,243 @@ task automatic rand_instr(output pipeIFID_t instr, output string optype);
   endcase // instr
 endtask
 
+task automatic rand_bitmanip(output pipeIFID_t instr, output string optype);
+  int op;
+
+  logic [4:0] rs1, rs2, rd;
+  logic [31:0] imm;
+  logic [31:0] op1, op2, result;
+  logic [4:0] shamt;
+
+  // generate scenario
+  op = $urandom_range(0,29);
+
+  imm = $urandom();
+  rs1 = $urandom();
+  rs2 = $urandom();
+  rd = $urandom_range(1,31);
+
+  instr.pc = $urandom & ~3;
+  op1 = REG[rs1];
+  op2 = REG[rs2];
+
+  $display("op1 = %h", op1);
+  $display("op2 = %h", op2);
+
+  case(op)
+    0: begin
+      optype = "SH1ADD";
+      instr.ir = rv32_sh1add(rd, rs1, rs2);
+      result = (op1 << 1) + op2;
+    end
+
+    1: begin
+      optype = "SH2ADD";
+      instr.ir = rv32_sh2add(rd, rs1, rs2);
+      result = (op1 << 2) + op2;
+    end
+
+    2: begin
+      optype = "SH3ADD";
+      instr.ir = rv32_sh3add(rd, rs1, rs2);
+      result = (op1 << 3) + op2;
+    end
+
+    3: begin
+      optype = "ANDN";
+      instr.ir = rv32_andn(rd, rs1, rs2);
+      result = op1 & ~op2;
+    end
+
+    4: begin
+      optype = "ORN";
+      instr.ir = rv32_orn(rd, rs1, rs2);
+      result = op1 | ~op2;
+    end
+
+    5: begin
+      optype = "XNOR";
+      instr.ir = rv32_xnor(rd, rs1, rs2);
+      result = ~(op1 ^ op2);
+    end
+
+    6: begin
+      optype = "CLZ";
+      // Sprinkle in some leading zeros
+      op1 = op1 >> $urandom_range(0,32);
+      REG[rs1] = rs1 == 0 ? 0 : op1;
+      u_rf.REG[rs1] = REG[rs1];
+      op1 = REG[rs1];
+      instr.ir = rv32_clz(rd, rs1);
+      result = 32;
+      for (int i=0; i<32; i++) begin
+        if (op1[i]) result = 31 - i;
+      end
+    end
+
+    7: begin
+      optype = "CTZ";
+      // Sprinkle in some trailing zeros
+      op1 = op1 << $urandom_range(0,32);
+      REG[rs1] = rs1 == 0 ? 0 : op1;
+      u_rf.REG[rs1] = REG[rs1];
+      op1 = REG[rs1];
+      instr.ir = rv32_ctz(rd, rs1);
+      result = 32;
+      for (int i=31; i>=0; i--) begin
+        if (op1[i]) result = i;
+      end
+    end
+
+    8: begin
+      optype = "CPOP";
+      instr.ir = rv32_cpop(rd, rs1);
+      result = $countones(op1);
+    end
+
+    9: begin
+      optype = "MAX";
+      instr.ir = rv32_max(rd, rs1, rs2);
+      result = signed'(op1) > signed'(op2) ? op1 : op2;
+    end
+
+    10: begin
+      optype = "MAXU";
+      instr.ir = rv32_maxu(rd, rs1, rs2);
+      result = op1 > op2 ? op1 : op2;
+    end
+
+    11: begin
+      optype = "MIN";
+      instr.ir = rv32_min(rd, rs1, rs2);
+      result = signed'(op1) < signed'(op2) ? op1 : op2;
+    end
+
+    12: begin
+      optype = "MINU";
+      instr.ir = rv32_minu(rd, rs1, rs2);
+      result = op1 < op2 ? op1 : op2;
+    end
+
+    13: begin
+      optype = "SEXT.B";
+      instr.ir = rv32_sext_b(rd, rs1);
+      result = {{24{op1[7]}}, op1[7:0]};
+    end
+
+    14: begin
+      optype = "SEXT.H";
+      instr.ir = rv32_sext_h(rd, rs1);
+      result = {{16{op1[15]}}, op1[15:0]};
+    end
+
+    15: begin
+      optype = "ZEXT.H";
+      instr.ir = rv32_zext_h(rd, rs1);
+      result = {16'b0, op1[15:0]};
+    end
+
+    16: begin
+      optype = "ROL";
+      instr.ir = rv32_rol(rd, rs1, rs2);
+      shamt = op2[4:0];
+      result = (op1 << shamt) | (op1 >> (6'd32 - shamt));
+    end
+
+    17: begin
+      optype = "ROR";
+      instr.ir = rv32_ror(rd, rs1, rs2);
+      shamt = op2[4:0];
+      result = (op1 >> shamt) | (op1 << (6'd32 - shamt));
+    end
+
+    18: begin
+      optype = "RORI";
+      instr.ir = rv32_rori(rd, rs1, imm);
+      shamt = imm[4:0];
+      result = (op1 >> shamt) | (op1 << (6'd32 - shamt));
+    end
+
+    19: begin
+      optype = "ORC.B";
+      // Sprinkle in some zero bytes
+      op1 = op1 & {{8{imm[3]}}, {8{imm[2]}}, {8{imm[1]}}, {8{imm[0]}}};
+      REG[rs1] = rs1 == 0 ? 0 : op1;
+      u_rf.REG[rs1] = REG[rs1];
+      op1 = REG[rs1];
+      instr.ir = rv32_orc_b(rd, rs1);
+      for (int i=0; i<4; i++) begin
+        result[i*8+:8] = {8{|op1[i*8+:8]}};
+      end
+    end
+
+    20: begin
+      optype = "REV8";
+      instr.ir = rv32_rev8(rd, rs1);
+      result = {op1[7:0], op1[15:8], op1[23:16], op1[31:24]};
+    end
+
+    21: begin
+      optype = "BCLR";
+      instr.ir = rv32_bclr(rd, rs1, rs2);
+      result = op1 & ~(32'h1 << op2[4:0]);
+    end
+
+    22: begin
+      optype = "BCLRI";
+      instr.ir = rv32_bclri(rd, rs1, imm);
+      result = op1 & ~(32'h1 << imm[4:0]);
+    end
+
+    23: begin
+      optype = "BEXT";
+      instr.ir = rv32_bext(rd, rs1, rs2);
+      result = {31'b0, op1[op2[4:0]]};
+    end
+
+    24: begin
+      optype = "BEXTI";
+      instr.ir = rv32_bexti(rd, rs1, imm);
+      result = {31'b0, op1[imm[4:0]]};
+    end
+
+    25: begin
+      optype = "BINV";
+      instr.ir = rv32_binv(rd, rs1, rs2);
+      result = op1 ^ (32'h1 << op2[4:0]);
+    end
+
+    26: begin
+      optype = "BINVI";
+      instr.ir = rv32_binvi(rd, rs1, imm);
+      result = op1 ^ (32'h1 << imm[4:0]);
+    end
+
+    27: begin
+      optype = "BSET";
+      instr.ir = rv32_bset(rd, rs1, rs2);
+      result = op1 | (32'h1 << op2[4:0]);
+    end
+
+    28: begin
+      optype = "BSETI";
+      instr.ir = rv32_bseti(rd, rs1, imm);
+      result = op1 | (32'h1 << imm[4:0]);
+    end
+
+    29: begin
+      optype = "SLL";
+      // base shifts share the barrel shifter with rotations
+      instr.ir = rv32_sll(rd, rs1, rs2);
+      result = op1 << op2[4:0];
+    end
+  endcase // instr
+
+  expected_wb.regwr_data = result;
+  expected_wb.regwr_sel = rd;
+  expected_wb.regwr_en = 1;
+  expected_wb.branch_target = '0;
+  expected_wb.branch = 0;
+endtask
+
 endmodule
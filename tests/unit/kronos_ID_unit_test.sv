@@ -32,41 +32,69 @@ logic instr_vld;
 logic [31:0] instr_data;
 
 kronos_RF u_rf (
-  .clk         (clk         ),
-  .rstz        (rstz        ),
-  .instr_data  (instr_data  ),
-  .instr_vld   (instr_vld   ),
-  .fetch_rdy   (fetch_rdy   ),
-  .immediate   (immediate   ),
-  .regrd_rs1   (regrd_rs1   ),
-  .regrd_rs2   (regrd_rs2   ),
-  .regrd_rs1_en(regrd_rs1_en),
-  .regrd_rs2_en(regrd_rs2_en),
-  .regwr_data  (regwr_data  ),
-  .regwr_sel   (regwr_sel   ),
-  .regwr_en    (regwr_en    )
+  .clk          (clk         ),
+  .rstz         (rstz        ),
+  .instr_data   (instr_data  ),
+  .instr_vld    (instr_vld   ),
+  .fetch_rdy    (fetch_rdy   ),
+  .immediate    (immediate   ),
+  .regrd_rs1    (regrd_rs1   ),
+  .regrd_rs2    (regrd_rs2   ),
+  .regrd_rs1_en (regrd_rs1_en),
+  .regrd_rs2_en (regrd_rs2_en),
+  .regwr_data   (regwr_data  ),
+  .regwr_sel    (regwr_sel   ),
+  .regwr_en     (regwr_en    ),
+  .instr1_data  ('0          ),
+  .instr1_vld   (1'b0        ),
+  .fetch_shift  (1'b0        ),
+  .immediate1   (            ),
+  .regrd1_rs1   (            ),
+  .regrd1_rs2   (            ),
+  .regrd1_rs1_en(            ),
+  .regrd1_rs2_en(            ),
+  .regwr1_data  ('0          ),
+  .regwr1_sel   ('0          ),
+  .regwr1_en    (1'b0        )
 );
 
 kronos_ID #(
   .CATCH_ILLEGAL_INSTR    (1)
 ) u_id (
-  .clk         (clk         ),
-  .rstz        (rstz        ),
-  .flush       (flush       ),
-  .fetch       (fetch       ),
-  .immediate   (immediate   ),
-  .regrd_rs1   (regrd_rs1   ),
-  .regrd_rs2   (regrd_rs2   ),
-  .regrd_rs1_en(regrd_rs1_en),
-  .regrd_rs2_en(regrd_rs2_en),
-  .fetch_vld   (fetch_vld   ),
-  .fetch_rdy   (fetch_rdy   ),
-  .decode      (decode      ),
-  .decode_vld  (decode_vld  ),
-  .decode_rdy  (decode_rdy  ),
-  .regwr_data  (regwr_data  ),
-  .regwr_sel   (regwr_sel   ),
-  .regwr_en    (regwr_en    )
+  .clk             (clk         ),
+  .rstz            (rstz        ),
+  .flush           (flush       ),
+  .fetch           (fetch       ),
+  .immediate       (immediate   ),
+  .regrd_rs1       (regrd_rs1   ),
+  .regrd_rs2       (regrd_rs2   ),
+  .regrd_rs1_en    (regrd_rs1_en),
+  .regrd_rs2_en    (regrd_rs2_en),
+  .fetch_vld       (fetch_vld   ),
+  .fetch_rdy       (fetch_rdy   ),
+  .lookahead       ('0          ),
+  .lookahead_vld   (1'b0        ),
+  .fuse            (            ),
+  .decode          (decode      ),
+  .decode_vld      (decode_vld  ),
+  .decode_rdy      (decode_rdy  ),
+  .regwr_data      (regwr_data  ),
+  .regwr_sel       (regwr_sel   ),
+  .regwr_en        (regwr_en    ),
+  .fetch1          ('0          ),
+  .immediate1      ('0          ),
+  .regrd1_rs1      ('0          ),
+  .regrd1_rs2      ('0          ),
+  .regrd1_rs1_en   (1'b0        ),
+  .regrd1_rs2_en   (1'b0        ),
+  .fetch1_vld      (1'b0        ),
+  .fetch1_rdy      (            ),
+  .decode1         (            ),
+  .decode1_vld     (            ),
+  .regwr1_data     ('0          ),
+  .regwr1_sel      ('0          ),
+  .regwr1_en       (1'b0        ),
+  .hpm_hazard_stall(            )
 );
 
 default clocking cb @(posedge clk);
@@ -30,25 +30,41 @@ logic regwr_en;
 logic miss;
 
 kronos_IF u_dut (
-  .clk          (clk          ),
-  .rstz         (rstz         ),
-  .instr_addr   (instr_addr   ),
-  .instr_data   (instr_data   ),
-  .instr_req    (instr_req    ),
-  .instr_ack    (instr_ack    ),
-  .fetch        (fetch        ),
-  .immediate    (immediate    ),
-  .regrd_rs1    (regrd_rs1    ),
-  .regrd_rs2    (regrd_rs2    ),
-  .regrd_rs1_en (regrd_rs1_en ),
-  .regrd_rs2_en (regrd_rs2_en ),
-  .fetch_vld    (fetch_vld    ),
-  .fetch_rdy    (fetch_rdy    ),
-  .branch_target(branch_target),
-  .branch       (branch       ),
-  .regwr_data   (regwr_data   ),
-  .regwr_sel    (regwr_sel    ),
-  .regwr_en     (regwr_en     )
+  .clk            (clk          ),
+  .rstz           (rstz         ),
+  .instr_addr     (instr_addr   ),
+  .instr_data     (instr_data   ),
+  .instr_req      (instr_req    ),
+  .instr_ack      (instr_ack    ),
+  .fetch          (fetch        ),
+  .immediate      (immediate    ),
+  .regrd_rs1      (regrd_rs1    ),
+  .regrd_rs2      (regrd_rs2    ),
+  .regrd_rs1_en   (regrd_rs1_en ),
+  .regrd_rs2_en   (regrd_rs2_en ),
+  .fetch_vld      (fetch_vld    ),
+  .fetch_rdy      (fetch_rdy    ),
+  .lookahead      (             ),
+  .lookahead_vld  (             ),
+  .fuse           (1'b0         ),
+  .fetch1         (             ),
+  .immediate1     (             ),
+  .regrd1_rs1     (             ),
+  .regrd1_rs2     (             ),
+  .regrd1_rs1_en  (             ),
+  .regrd1_rs2_en  (             ),
+  .fetch1_vld     (             ),
+  .fetch1_rdy     (1'b0         ),
+  .branch_target  (branch_target),
+  .branch         (branch       ),
+  .regwr_data     (regwr_data   ),
+  .regwr_sel      (regwr_sel    ),
+  .regwr_en       (regwr_en     ),
+  .regwr1_data    ('0           ),
+  .regwr1_sel     ('0           ),
+  .regwr1_en      (1'b0         ),
+  .hpm_fetch_miss (             ),
+  .hpm_fetch_stall(             )
 );
 
 spsram32_model #(.WORDS(256)) u_imem (
@@ -9,6 +9,7 @@ import kronos_types::*;
 import rv32_assembler::*;
 
 logic clk;
+logic rstz;
 
 pipeIDEX_t decode;
 logic lsu_vld;
@@ -23,21 +24,65 @@ logic data_wr_en;
 logic data_req;
 logic data_ack;
 
-kronos_lsu u_dut (
-  .decode      (decode      ),
-  .lsu_vld     (lsu_vld     ),
-  .lsu_rdy     (lsu_rdy     ),
-  .load_data   (load_data   ),
-  .regwr_lsu   (regwr_lsu   ),
-  .data_addr   (data_addr   ),
-  .data_rd_data(data_rd_data),
-  .data_wr_data(data_wr_data),
-  .data_mask   (data_mask   ),
-  .data_wr_en  (data_wr_en  ),
-  .data_req    (data_req    ),
-  .data_ack    (data_ack    )
+// Two configurations share the memory, and the test selects one
+//  - 0: EN_MISALIGNED_LDST(1), word-crossing accesses are split
+//  - 1: default, misaligned accesses trap before they reach the LSU, and
+//       the LSU only ever makes single word transactions
+logic sel;
+logic [1:0] dut_vld, dut_rdy, dut_regwr, dut_wr_en, dut_req, dut_ack;
+logic [31:0] dut_load_data [2];
+logic [31:0] dut_addr [2];
+logic [31:0] dut_wr_data [2];
+logic [3:0] dut_mask [2];
+
+kronos_lsu #(
+  .EN_MISALIGNED_LDST(1)
+) u_dut (
+  .clk         (clk             ),
+  .rstz        (rstz            ),
+  .decode      (decode          ),
+  .lsu_vld     (dut_vld[0]      ),
+  .lsu_rdy     (dut_rdy[0]      ),
+  .load_data   (dut_load_data[0]),
+  .regwr_lsu   (dut_regwr[0]    ),
+  .data_addr   (dut_addr[0]     ),
+  .data_rd_data(data_rd_data    ),
+  .data_wr_data(dut_wr_data[0]  ),
+  .data_mask   (dut_mask[0]     ),
+  .data_wr_en  (dut_wr_en[0]    ),
+  .data_req    (dut_req[0]      ),
+  .data_ack    (dut_ack[0]      )
 );
 
+kronos_lsu u_dut_default (
+  .clk         (clk             ),
+  .rstz        (rstz            ),
+  .decode      (decode          ),
+  .lsu_vld     (dut_vld[1]      ),
+  .lsu_rdy     (dut_rdy[1]      ),
+  .load_data   (dut_load_data[1]),
+  .regwr_lsu   (dut_regwr[1]    ),
+  .data_addr   (dut_addr[1]     ),
+  .data_rd_data(data_rd_data    ),
+  .data_wr_data(dut_wr_data[1]  ),
+  .data_mask   (dut_mask[1]     ),
+  .data_wr_en  (dut_wr_en[1]    ),
+  .data_req    (dut_req[1]      ),
+  .data_ack    (dut_ack[1]      )
+);
+
+assign dut_vld = {sel & lsu_vld, ~sel & lsu_vld};
+assign dut_ack = {sel & data_ack, ~sel & data_ack};
+
+assign lsu_rdy = dut_rdy[sel];
+assign load_data = dut_load_data[sel];
+assign regwr_lsu = dut_regwr[sel];
+assign data_addr = dut_addr[sel];
+assign data_wr_data = dut_wr_data[sel];
+assign data_mask = dut_mask[sel];
+assign data_wr_en = dut_wr_en[sel];
+assign data_req = dut_req[sel];
+
 spsram32_model #(.WORDS(256)) u_dmem (
   .clk  (clk         ),
   .addr (data_addr   ),
@@ -59,6 +104,12 @@ always_ff @(posedge clk) begin
   else data_ack <= 0;
 end
 
+// Memory transactions
+int nreq;
+always @(posedge clk) begin
+  if (data_req) nreq++;
+end
+
 default clocking cb @(posedge clk);
   default input #10ps output #10ps;
   output decode, lsu_vld;
@@ -68,13 +119,16 @@ endclocking
 // ============================================================
 logic [31:0] expected_load_data, got_load_data;
 logic [31:0] store_addr, expected_store_data, got_store_data;
+logic [31:0] expected_store_data2, got_store_data2;
 
 `TEST_SUITE begin
   `TEST_SUITE_SETUP begin
   logic [31:0] data;
 
   clk = 0;
+  rstz = 0;
   lsu_vld = 0;
+  sel = 0;
 
   for(int i=0; i<256; i++)
     `MEM[i] = $urandom;
@@ -83,7 +137,8 @@ logic [31:0] store_addr, expected_store_data, got_store_data;
     forever #1ns clk = ~clk;
   join_none
 
-  ##8;
+  ##4 rstz = 1;
+  ##4;
   end
 
   `TEST_CASE("load") begin
@@ -147,6 +202,167 @@ logic [31:0] store_addr, expected_store_data, got_store_data;
 
     ##64;
   end
+
+  `TEST_CASE("load_misaligned") begin
+    pipeIDEX_t tdecode;
+    string optype;
+
+    repeat (1024) begin
+      rand_load_misaligned(tdecode, optype);
+      $display("OPTYPE=%s", optype);
+      $display("Expected: ");
+      $display("  load_data: %h", expected_load_data);
+
+      @(cb);
+      cb.decode <= tdecode;
+      cb.lsu_vld <= 1;
+
+      repeat (8) begin
+        @(cb) if (cb.lsu_rdy) begin
+          cb.lsu_vld <= 0;
+          assert(cb.regwr_lsu);
+          got_load_data = cb.load_data;
+          $display("Got:");
+          $display("  load_data: %h", got_load_data);
+        end
+      end
+
+      assert(got_load_data == expected_load_data);
+
+      $display("-----------------\n\n");
+    end
+
+    ##64;
+  end
+
+  `TEST_CASE("store_misaligned") begin
+    pipeIDEX_t tdecode;
+    string optype;
+
+    repeat (1024) begin
+      rand_store_misaligned(tdecode, optype);
+      $display("OPTYPE=%s", optype);
+      $display("Expected: ");
+      $display("  store_data: %h %h", expected_store_data2, expected_store_data);
+      $display("  store_addr: %h", store_addr);
+
+      @(cb);
+      cb.decode <= tdecode;
+      cb.lsu_vld <= 1;
+      @(cb iff cb.lsu_rdy);
+      cb.lsu_vld <= 0;
+      
+      ##2;
+      got_store_data = `MEM[store_addr];
+      got_store_data2 = `MEM[store_addr+1];
+      $display("Got:");
+      $display("  store_data: %h %h", got_store_data2, got_store_data);
+
+      assert(got_store_data == expected_store_data);
+      assert(got_store_data2 == expected_store_data2);
+
+      $display("-----------------\n\n");
+    end
+
+    ##64;
+  end
+
+  `TEST_CASE("default_load") begin
+    pipeIDEX_t tdecode;
+    string optype;
+
+    sel = 1;
+
+    repeat (1024) begin
+      rand_load(tdecode, optype);
+      $display("OPTYPE=%s", optype);
+      $display("Expected: ");
+      $display("  load_data: %h", expected_load_data);
+
+      @(cb);
+      cb.decode <= tdecode;
+      cb.lsu_vld <= 1;
+
+      repeat (8) begin
+        @(cb) if (cb.lsu_rdy) begin
+          cb.lsu_vld <= 0;
+          assert(cb.regwr_lsu);
+          got_load_data = cb.load_data;
+          $display("Got:");
+          $display("  load_data: %h", got_load_data);
+        end
+      end
+
+      assert(got_load_data == expected_load_data);
+
+      $display("-----------------\n\n");
+    end
+
+    ##64;
+  end
+
+  `TEST_CASE("default_store") begin
+    pipeIDEX_t tdecode;
+    string optype;
+
+    sel = 1;
+
+    repeat (1024) begin
+      rand_store(tdecode, optype);
+      $display("OPTYPE=%s", optype);
+      $display("Expected: ");
+      $display("  store_data: %h", expected_store_data);
+      $display("  store_addr: %h", store_addr);
+
+      @(cb);
+      cb.decode <= tdecode;
+      cb.lsu_vld <= 1;
+      @(cb iff cb.lsu_rdy);
+      cb.lsu_vld <= 0;
+
+      ##2;
+      got_store_data = `MEM[store_addr];
+      $display("Got:");
+      $display("  store_data: %h", got_store_data);
+
+      assert(got_store_data == expected_store_data);
+
+      $display("-----------------\n\n");
+    end
+
+    ##64;
+  end
+
+  `TEST_CASE("default_no_split") begin
+    pipeIDEX_t tdecode;
+    string optype;
+
+    // A word-crossing access is split into two transactions only with
+    // EN_MISALIGNED_LDST. By default, it traps in EX, and the LSU never
+    // splits it
+    for (int i=0; i<2; i++) begin
+      sel = i;
+
+      repeat (64) begin
+        do rand_load_misaligned(tdecode, optype);
+        while (tdecode.addr[1:0] == 0 || optype inside {"LB", "LBU"} ||
+          (optype inside {"LH", "LHU"} && tdecode.addr[1:0] != 3));
+
+        nreq = 0;
+        @(cb);
+        cb.decode <= tdecode;
+        cb.lsu_vld <= 1;
+        @(cb iff cb.lsu_rdy);
+        cb.lsu_vld <= 0;
+        ##2;
+
+        $display("sel=%0d, OPTYPE=%s addr=%h, transactions=%0d", sel, optype, tdecode.addr, nreq);
+        assert(nreq == (sel ? 1 : 2));
+      end
+    end
+
+    ##64;
+  end
 end
 
 `WATCHDOG(1ms);
@@ -335,4 +551,134 @@ task automatic rand_store(output pipeIDEX_t decode, output string optype);
 
 endtask
 
+task automatic rand_load_misaligned(output pipeIDEX_t decode, output string optype);
+  int op;
+  logic [4:0] rd;
+  int addr;
+  logic [7:0][7:0] mem_dword;
+  int offset;
+  int aligned_addr;
+  logic [7:0] dbyte;
+  logic [15:0] dhalf;
+  logic [31:0] dword;
+
+  // generate scenario, any byte address
+  op = $urandom_range(0,4);
+  rd = $urandom_range(1,31);
+  addr = $urandom_range(0,252);
+
+  // Fetch 4B word and next word from the memory
+  aligned_addr = addr>>2;
+  offset = addr & 3;
+
+  mem_dword = {`MEM[aligned_addr+1], `MEM[aligned_addr]};
+  dbyte = mem_dword >> (8 * offset);
+  dhalf = mem_dword >> (8 * offset);
+  dword = mem_dword >> (8 * offset);
+
+  $display("addr = %h", addr);
+  $display("byte index = %0d", offset);
+  $display("mem[%h]: %h", aligned_addr, mem_dword);
+
+  // clear out decode
+  decode = '0;
+  decode.load = 1;
+  decode.addr = addr;
+  decode.mask = 4'hF;
+
+  case(op)
+    0: begin
+      optype = "LB";
+      decode.ir = rv32_lb(rd, 0, 0);
+      expected_load_data = signed'(dbyte);
+    end
+
+    1: begin
+      optype = "LBU";
+      decode.ir = rv32_lbu(rd, 0, 0);
+      expected_load_data = dbyte;
+    end
+
+    2: begin
+      optype = "LH";
+      decode.ir = rv32_lh(rd, 0, 0);
+      expected_load_data = signed'(dhalf);
+    end
+
+    3: begin
+      optype = "LHU";
+      decode.ir = rv32_lhu(rd, 0, 0);
+      expected_load_data = dhalf;
+    end
+
+    4: begin
+      optype = "LW";
+      decode.ir = rv32_lw(rd, 0, 0);
+      expected_load_data = dword;
+    end
+  endcase // op
+endtask
+
+task automatic rand_store_misaligned(output pipeIDEX_t decode, output string optype);
+  int op;
+  int addr;
+  logic [7:0][7:0] mem_dword;
+  int offset;
+  int aligned_addr;
+  logic [31:0] data;
+  logic [63:0] sdata;
+
+  // generate scenario, any byte address
+  op = $urandom_range(0,2);
+  addr = $urandom_range(0,252);
+  data = $urandom;
+
+  // Fetch 4B word and next word from the memory
+  aligned_addr = addr>>2;
+  offset = addr & 3;
+
+  mem_dword = {`MEM[aligned_addr+1], `MEM[aligned_addr]};
+
+  $display("addr = %h", addr);
+  $display("byte index = %0d", offset);
+  $display("mem[%h]: %h", aligned_addr, mem_dword);
+
+  // clear out decode
+  decode = '0;
+  decode.store = 1;
+  decode.addr = addr;
+  decode.mask = 4'hF;
+
+  // The store data is rotated left by the byte offset in the ID stage
+  sdata = {32'b0, data} << (8 * offset);
+  decode.op2 = sdata[31:0] | sdata[63:32];
+
+  case(op)
+    0: begin
+      optype = "SB";
+      decode.ir = rv32_sb(0, 0, 0);
+      mem_dword[offset] = data[7:0];
+    end
+
+    1: begin
+      optype = "SH";
+      decode.ir = rv32_sh(0, 0, 0);
+      mem_dword[offset] = data[7:0];
+      mem_dword[offset+1] = data[15:8];
+    end
+
+    2: begin
+      optype = "SW";
+      decode.ir = rv32_sw(0, 0, 0);
+      for (int i=0; i<4; i++) mem_dword[offset+i] = data[i*8+:8];
+    end
+  endcase
+
+  // Setup expected stored data at word-aligned address, and the next word
+  store_addr = aligned_addr;
+  expected_store_data = mem_dword[3:0];
+  expected_store_data2 = mem_dword[7:4];
+
+endtask
+
 endmodule
@@ -9,8 +9,12 @@ module tb_spim;
 logic clk;
 logic rstz;
 logic sclk;
-logic mosi;
+wire  mosi;
 logic miso;
+logic [3:0] sio;
+logic [3:0] io_out;
+logic [3:0] io_oe;
+logic [3:0] io_in;
 logic [15:0] prescaler;
 logic cpol;
 logic cpha;
@@ -18,36 +22,62 @@ logic tx_clear;
 logic rx_clear;
 logic [15:0] tx_size;
 logic [15:0] rx_size;
-logic [7:0] dat_i;
-logic [7:0] dat_o;
+logic xfer_mode;
+logic [15:0] xfer_len;
+logic xfer_hold;
+logic [1:0] xfer_width;
+logic xfer_rd;
+logic xfer_start;
+logic [15:0] xfer_left;
+logic xfer_busy;
+logic csn;
+logic [31:0] dat_i;
+logic [31:0] dat_o;
+logic [3:0] sel_i;
 logic we_i;
 logic stb_i;
 logic ack_o;
 
 wb_spi_master u_dut (
-    .clk      (clk      ),
-    .rstz     (rstz     ),
-    .sclk     (sclk     ),
-    .mosi     (mosi     ),
-    .miso     (miso     ),
-    .prescaler(prescaler),
-    .cpol     (cpol     ),
-    .cpha     (cpha     ),
-    .tx_clear (tx_clear ),
-    .rx_clear (rx_clear ),
-    .tx_size  (tx_size  ),
-    .rx_size  (rx_size  ),
-    .dat_i    (dat_i    ),
-    .dat_o    (dat_o    ),
-    .we_i     (we_i     ),
-    .stb_i    (stb_i    ),
-    .ack_o    (ack_o    )
+    .clk       (clk       ),
+    .rstz      (rstz      ),
+    .sclk      (sclk      ),
+    .io_out    (io_out    ),
+    .io_oe     (io_oe     ),
+    .io_in     (io_in     ),
+    .prescaler (prescaler ),
+    .cpol      (cpol      ),
+    .cpha      (cpha      ),
+    .tx_clear  (tx_clear  ),
+    .rx_clear  (rx_clear  ),
+    .tx_size   (tx_size   ),
+    .rx_size   (rx_size   ),
+    .xfer_mode (xfer_mode ),
+    .xfer_len  (xfer_len  ),
+    .xfer_hold (xfer_hold ),
+    .xfer_width(xfer_width),
+    .xfer_rd   (xfer_rd   ),
+    .xfer_start(xfer_start),
+    .xfer_left (xfer_left ),
+    .xfer_busy (xfer_busy ),
+    .csn       (csn       ),
+    .dat_i     (dat_i     ),
+    .dat_o     (dat_o     ),
+    .sel_i     (sel_i     ),
+    .we_i      (we_i      ),
+    .stb_i     (stb_i     ),
+    .ack_o     (ack_o     )
 );
 
+// Single SPI on io0/io1, the slave drives io1 (and the rest in Dual/Quad reads)
+assign mosi = io_out[0];
+assign io_in = {sio[3:2], miso, sio[0]};
+
 default clocking cb @(posedge clk);
     default input #10ps output #10ps;
-    output dat_i, we_i, stb_i;
-    input ack_o, dat_o;
+    output dat_i, sel_i, we_i, stb_i;
+    output xfer_len, xfer_hold, xfer_width, xfer_rd, xfer_start;
+    input ack_o, dat_o, rx_size;
 endclocking
 
 // ============================================================
@@ -61,6 +91,14 @@ logic [7:0] STX [$], SRX [$];
 
         stb_i = 0;
         we_i = 0;
+        sel_i = 0;
+        xfer_mode = 0;
+        xfer_len = 0;
+        xfer_hold = 0;
+        xfer_width = 0;
+        xfer_rd = 0;
+        sio = '1;
+        xfer_start = 0;
         cpol = 0;
         cpha = 0;
         prescaler = 0;
@@ -107,6 +145,198 @@ logic [7:0] STX [$], SRX [$];
 
             assert(MTX == SRX);
             assert(MRX == STX);
+            assert(csn);
+            assert(io_oe == 4'b1101);
+
+            $display("------------------");
+        end
+
+        ##64;
+    end
+
+    `TEST_CASE("word") begin
+        int n;
+
+        repeat (128) begin
+            ##8;
+            cpol = $urandom();
+            cpha = $urandom();
+            prescaler = $urandom_range(0,7);
+            ##8;
+
+            $display("CONFIG: prescaler=%0d, CPOL=%b CPHA=%b", prescaler, cpol, cpha);
+
+            MTX = {};
+            MRX = {};
+            STX = {};
+            SRX = {};
+
+            // Words, 4B per access
+            n = $urandom_range(1,7);
+
+            fork
+                word_driver(n);
+                spi_slave(4*n);
+            join
+
+            ##32;
+            drain_words(n);
+
+            assert(MTX == SRX);
+            assert(MRX == STX);
+
+            $display("------------------");
+        end
+
+        ##64;
+    end
+
+    `TEST_CASE("burst") begin
+        logic [7:0] data;
+        int n, k, peak;
+        logic hold;
+
+        // The TX Queue is only sent by the transfers
+        xfer_mode = 1;
+
+        repeat (32) begin
+            ##8;
+            cpol = $urandom();
+            cpha = $urandom();
+            prescaler = $urandom_range(0,7);
+            ##8;
+
+            MTX = {};
+            MRX = {};
+            STX = {};
+            SRX = {};
+
+            // A few bytes queued, and the rest of the transfer is padded with 0x00
+            // The transfer may outgrow the RX Queue, before it's drained
+            k = $urandom_range(0,8);
+            n = $urandom_range(k+1, 80);
+            hold = $urandom();
+
+            $display("CONFIG: prescaler=%0d, CPOL=%b CPHA=%b", prescaler, cpol, cpha);
+            $display("BURST: %0d bytes, %0d queued, hold=%b", n, k, hold);
+
+            repeat (k) begin
+                @(cb);
+                data = $urandom();
+                MTX.push_back(data);
+                cb.dat_i <= {24'h0, data};
+                cb.sel_i <= 4'b0001;
+                cb.we_i <= 1;
+                cb.stb_i <= 1;
+            end
+            @(cb);
+            cb.stb_i <= 0;
+            cb.we_i <= 0;
+
+            repeat (n-k) MTX.push_back(8'h00);
+
+            @(cb);
+            cb.xfer_len <= n;
+            cb.xfer_hold <= hold;
+            cb.xfer_start <= 1;
+            @(cb);
+            cb.xfer_start <= 0;
+            wait (xfer_busy);
+
+            peak = 0;
+            fork
+                spi_slave(n);
+                begin
+                    ##($urandom_range(0, 4096));
+                    poll_rxq(n);
+                end
+                begin
+                    // The chip select is held through the transfer
+                    while (xfer_busy) begin
+                        @(posedge clk);
+                        assert(~csn);
+                        if (rx_size > peak) peak = rx_size;
+                    end
+                end
+            join
+
+            assert(~xfer_busy && xfer_left == 0);
+            assert(csn == ~hold);
+            assert(peak <= 32);
+
+            assert(MTX == SRX);
+            assert(MRX == STX);
+
+            // release the chip select
+            if (hold) begin
+                @(cb);
+                cb.xfer_len <= 0;
+                cb.xfer_hold <= 0;
+                cb.xfer_start <= 1;
+                @(cb);
+                cb.xfer_start <= 0;
+                ##1 assert(csn);
+            end
+
+            $display("------------------");
+        end
+
+        ##64;
+    end
+    `TEST_CASE("wide") begin
+        logic [7:0] data;
+        int n, w;
+
+        // SPI Mode-0, as the flash
+        xfer_mode = 1;
+        cpol = 0;
+        cpha = 0;
+
+        repeat (64) begin
+            ##8;
+            prescaler = $urandom_range(0,7);
+            w = $urandom_range(0,1) ? 4 : 2;
+            ##8;
+
+            MTX = {};
+            MRX = {};
+            STX = {};
+            SRX = {};
+
+            n = $urandom_range(1,28);
+
+            $display("CONFIG: prescaler=%0d, %0d bits", prescaler, w);
+
+            // Write, the RX Queue is left alone
+            repeat (n) begin
+                @(cb);
+                data = $urandom();
+                MTX.push_back(data);
+                cb.dat_i <= {24'h0, data};
+                cb.sel_i <= 4'b0001;
+                cb.we_i <= 1;
+                cb.stb_i <= 1;
+            end
+            @(cb);
+            cb.stb_i <= 0;
+            cb.we_i <= 0;
+
+            start_xfer(n, w, 0);
+            wide_slave_rx(n, w);
+            wait (~xfer_busy);
+            assert(rx_size == 0);
+
+            // Read
+            start_xfer(n, w, 1);
+            wide_slave_tx(n, w);
+            wait (~xfer_busy);
+
+            ##8;
+            drain_rxq(n);
+
+            assert(MTX == SRX);
+            assert(MRX == STX);
+            assert(csn);
 
             $display("------------------");
         end
@@ -124,43 +354,161 @@ end
 task automatic driver(int N=32);
     logic [7:0] data;
 
-    @(cb);
-    data = $urandom();
-    MTX.push_back(data);
-
-    cb.dat_i <= data;
-    cb.stb_i <= 1;
-    cb.we_i <= 1;
-    $display("tx: %h", data);
-
-    repeat (N-1) begin
-        @(cb iff cb.ack_o);
+    // Pipelined, a write every cycle
+    repeat (N) begin
+        @(cb);
         data = $urandom();
         MTX.push_back(data);
 
-        cb.dat_i <= data;
+        cb.dat_i <= {24'h0, data};
+        cb.sel_i <= 4'b0001;
+        cb.stb_i <= 1;
+        cb.we_i <= 1;
         $display("tx: %h", data);
     end
-    @(cb iff cb.ack_o);
+    @(cb);
     cb.stb_i <= 0;
     cb.we_i <= 0;
+
+    // Every write is acked in the next cycle
+    @(cb);
+    assert(cb.ack_o);
+    @(cb);
+    assert(~cb.ack_o);
 endtask
 
 task automatic drain_rxq(int N=32);
     logic [7:0] data;
 
     cb.stb_i <= 1;
+    cb.sel_i <= 4'b0001;
     cb.we_i <= 0;
 
+    // Pipelined, a read every cycle, with the data on the ack
+    fork
+        begin
+            repeat (N) @(cb);
+            cb.stb_i <= 0;
+        end
+        repeat (N) begin
+            @(cb iff cb.ack_o);
+            data = cb.dat_o[7:0];
+
+            $display("rx: %h", data);
+            MRX.push_back(data);
+        end
+    join
+endtask
+
+task automatic word_driver(int N=8);
+    logic [31:0] data;
+
+    repeat (N) begin
+        @(cb);
+        data = $urandom();
+        for (int i=0; i<4; i++) MTX.push_back(data[i*8 +: 8]);
+
+        cb.dat_i <= data;
+        cb.sel_i <= 4'b1111;
+        cb.stb_i <= 1;
+        cb.we_i <= 1;
+        $display("tx: %h", data);
+
+        @(cb);
+        cb.stb_i <= 0;
+        cb.we_i <= 0;
+
+        // a cycle per byte
+        repeat (3) begin
+            @(cb);
+            assert(~cb.ack_o);
+        end
+        @(cb);
+        assert(cb.ack_o);
+    end
+endtask
+
+task automatic drain_words(int N=8);
+    logic [31:0] data;
+
     repeat (N) begin
+        @(cb);
+        cb.sel_i <= 4'b1111;
+        cb.stb_i <= 1;
+        cb.we_i <= 0;
+
+        @(cb);
+        cb.stb_i <= 0;
+
         @(cb iff cb.ack_o);
         data = cb.dat_o;
 
         $display("rx: %h", data);
-        MRX.push_back(data);
+        for (int i=0; i<4; i++) MRX.push_back(data[i*8 +: 8]);
+    end
+endtask
+
+task automatic poll_rxq(int N=32);
+    repeat (N) begin
+        @(cb iff cb.rx_size != 0);
+        cb.sel_i <= 4'b0001;
+        cb.stb_i <= 1;
+        cb.we_i <= 0;
+
+        @(cb);
+        cb.stb_i <= 0;
+
+        @(cb iff cb.ack_o);
+        MRX.push_back(cb.dat_o[7:0]);
+    end
+endtask
+
+task automatic start_xfer(int N, int W, logic RD);
+    @(cb);
+    cb.xfer_len <= N;
+    cb.xfer_hold <= 0;
+    cb.xfer_width <= (W == 4) ? 2'd2 : 2'd1;
+    cb.xfer_rd <= RD;
+    cb.xfer_start <= 1;
+    @(cb);
+    cb.xfer_start <= 0;
+    wait (xfer_busy);
+endtask
+
+// Dual/Quad slave, in SPI Mode-0. W bits per clock, MSB first
+task automatic wide_slave_rx(int N, int W);
+    logic [7:0] rx_data;
+
+    repeat (N) begin
+        repeat (8/W) begin
+            @(posedge sclk);
+            assert(io_oe == 4'b1111);
+            rx_data = (rx_data << W) | (io_out & 4'((1 << W) - 1));
+        end
+
+        $display("IO OUT = %h", rx_data);
+        SRX.push_back(rx_data);
+    end
+endtask
+
+task automatic wide_slave_tx(int N, int W);
+    logic [7:0] tx_data;
+
+    repeat (N) begin
+        tx_data = $urandom();
+
+        $display("IO IN = %h", tx_data);
+        STX.push_back(tx_data);
+
+        repeat (8/W) begin
+            if (W == 4) {sio[3:2], miso, sio[0]} = tx_data[7:4];
+            else {miso, sio[0]} = tx_data[7:6];
+            tx_data = tx_data << W;
+
+            @(posedge sclk);
+            assert(io_oe == ((W == 4) ? 4'b0000 : 4'b1100));
+        end
     end
-    cb.stb_i <= 0;
-    cb.we_i <= 0;
 endtask
 
 task automatic spi_slave(int N=32);
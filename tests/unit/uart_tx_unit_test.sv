@@ -99,26 +99,26 @@ end
 task automatic driver(int N=32);
     logic [7:0] data;
 
-    @(cb);
-    data = $urandom();
-    TX.push_back(data);
-
-    cb.dat_i <= data;
-    cb.stb_i <= 1;
-    cb.we_i <= 1;
-    $display("tx: %h", data);
-
-    repeat (N-1) begin
-        @(cb iff cb.ack_o);
+    // Pipelined, a write every cycle
+    repeat (N) begin
+        @(cb);
         data = $urandom();
         TX.push_back(data);
 
         cb.dat_i <= data;
+        cb.stb_i <= 1;
+        cb.we_i <= 1;
         $display("tx: %h", data);
     end
-    @(cb iff cb.ack_o);
+    @(cb);
     cb.stb_i <= 0;
     cb.we_i <= 0;
+
+    // Every write is acked in the next cycle
+    @(cb);
+    assert(cb.ack_o);
+    @(cb);
+    assert(~cb.ack_o);
 endtask
 
 task automatic monitor(int N=32);
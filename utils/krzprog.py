@@ -1,11 +1,133 @@
 #!/usr/bin/python3
 
+import os
 import re
+import sys
 import argparse
 
 MAX_PROG_SIZE = 128*1024
 
-def convert_bin(ibinfile):
+# Size header flag, for an LZ4 compressed program
+PROG_LZ4 = 1 << 31
+
+# LZ4 block format
+LZ4_MINMATCH = 4
+LZ4_MAX_OFFSET = 0xFFFF
+LZ4_LAST_LITERALS = 5
+LZ4_MFLIMIT = 12
+LZ4_HASH_BITS = 12
+
+def lz4_length(n):
+    # Length extension bytes, after the 15 in the token
+    out = bytearray()
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+    return out
+
+def lz4_sequence(literals, match_len=None, offset=0):
+    out = bytearray()
+
+    lit_len = len(literals)
+    token = min(lit_len, 15) << 4
+    if match_len is not None:
+        token |= min(match_len - LZ4_MINMATCH, 15)
+
+    out.append(token)
+    if lit_len >= 15:
+        out += lz4_length(lit_len - 15)
+    out += literals
+
+    if match_len is not None:
+        out += offset.to_bytes(2, byteorder='little')
+        if match_len - LZ4_MINMATCH >= 15:
+            out += lz4_length(match_len - LZ4_MINMATCH - 15)
+
+    return out
+
+def lz4_compress(data):
+    # Greedy LZ4 block compressor, with a hash table of the last position of
+    # every 4-byte sequence
+    out = bytearray()
+    size = len(data)
+    table = {}
+
+    anchor = 0
+    i = 0
+    match_limit = size - LZ4_MFLIMIT
+    end_limit = size - LZ4_LAST_LITERALS
+
+    while i < match_limit:
+        key = data[i:i+4]
+        ref = table.get(key)
+        table[key] = i
+
+        if ref is None or i - ref > LZ4_MAX_OFFSET:
+            i += 1
+            continue
+
+        # Extend the match, up to the last literals
+        match_len = LZ4_MINMATCH
+        while i + match_len < end_limit and data[ref + match_len] == data[i + match_len]:
+            match_len += 1
+
+        out += lz4_sequence(data[anchor:i], match_len, i - ref)
+
+        i += match_len
+        anchor = i
+
+    # Last sequence, only literals
+    out += lz4_sequence(data[anchor:])
+
+    return out
+
+def lz4_decompress(data, size):
+    # Reference decompressor, as the bootloader
+    out = bytearray()
+    i = 0
+
+    while True:
+        token = data[i]
+        i += 1
+
+        n = token >> 4
+        if n == 15:
+            while True:
+                b = data[i]
+                i += 1
+                n += b
+                if b != 255: break
+        out += data[i:i+n]
+        i += n
+
+        if len(out) >= size: break
+
+        offset = int.from_bytes(data[i:i+2], byteorder='little')
+        i += 2
+
+        n = token & 0xF
+        if n == 15:
+            while True:
+                b = data[i]
+                i += 1
+                n += b
+                if b != 255: break
+        n += LZ4_MINMATCH
+
+        for _ in range(n):
+            out.append(out[-offset])
+
+    return bytes(out)
+
+def checksum(progbytes):
+    # Sum of the program words
+    total = 0
+    for i in range(0, len(progbytes), 4):
+        total += int.from_bytes(progbytes[i:i+4], byteorder='little')
+    return total & 0xFFFFFFFF
+
+def convert_bin(ibinfile, lz4=False):
     obinfile = re.sub('.bin$', '.krz.bin', ibinfile)
 
     IFILE = open(ibinfile, "rb")
@@ -30,8 +152,35 @@ def convert_bin(ibinfile):
     if (progsize & 0x3):
         print("[ERROR] program is not word-aligned")
 
-    OFILE.write((progsize).to_bytes(4, byteorder='little'))
-    OFILE.write(progbytes);
+    if lz4:
+        # Header: program size (flagged), compressed size and checksum
+        lzbytes = lz4_compress(progbytes)
+        lzsize = len(lzbytes)
+
+        try:
+            verified = lz4_decompress(lzbytes, progsize) == progbytes
+        except IndexError:
+            verified = False
+
+        if not verified:
+            print("[ERROR] compression failed")
+            IFILE.close()
+            OFILE.close()
+            os.remove(obinfile)
+            sys.exit(1)
+
+        print("compressed size: {} bytes ({:.2f}x)".format(lzsize, progsize/lzsize))
+
+        # word-aligned image
+        lzbytes += bytearray(-lzsize & 0x3)
+
+        OFILE.write((progsize | PROG_LZ4).to_bytes(4, byteorder='little'))
+        OFILE.write((lzsize).to_bytes(4, byteorder='little'))
+        OFILE.write(checksum(progbytes).to_bytes(4, byteorder='little'))
+        OFILE.write(lzbytes);
+    else:
+        OFILE.write((progsize).to_bytes(4, byteorder='little'))
+        OFILE.write(progbytes);
 
     IFILE.close()
     OFILE.close()
@@ -41,7 +190,8 @@ def convert_bin(ibinfile):
 if __name__ == '__main__':
     parser = argparse.ArgumentParser(description='RISCV Binary formatter for KRZ')
     parser.add_argument('--bin', default=None, help="--bin <file.bin> Specify binary file to be processed")
+    parser.add_argument('--lz4', action='store_true', help="--lz4 Compress the program, for a faster boot")
 
     args = parser.parse_args()
 
-    convert_bin(args.bin)
+    convert_bin(args.bin, args.lz4)